@@ -6,46 +6,48 @@ Bag& Bag::operator=(const Bag& a)
 {
 	if (this != &a)
 	{
-		delete [] m_bag; //cleanup left side
-		m_bagElements = a.m_bagElements; //copies # of elements from right to left
-		m_bag = new BagItem[m_bagElements]; //creates a new array to hold old elements
-		for (int i = 0; i < m_bagElements; i++) //copies over a into the new array
-			m_bag[i] = a.m_bag[i];
+		Bag temp(a); //copies a first, so this bag is untouched if that fails
+		swap(temp); //then takes the copy; temp cleans up the old items
 	}
 	return *this;
 }
 
-Bag::Bag(int size)
+Bag::Bag(int size) : m_bag(m_inline), m_finger(0), m_bagElements(0), m_capacity(INLINE_ITEMS)
 {
 	if (size < 0)
 	{
 		cout << "Bag cannot have a negative size!" << endl;
 		exit(0);
 	}
-	m_bagElements = size;
-	m_bag = new BagItem[size];
-	for (int i = 0; i < size; i++)
-		m_bag[i].count = 0;
+	if (size > INLINE_ITEMS) //too big for the inline items, so start on the heap
+	{
+		m_bag = new BagItem[size];
+		m_capacity = size;
+	}
 }
 
-Bag::Bag(const Bag&)
+Bag::Bag(const Bag& a) : m_bag(m_inline), m_finger(0), m_bagElements(a.m_bagElements), m_capacity(INLINE_ITEMS)
 {
-	m_bag = new BagItem[m_bagElements];
-	//copy constructor
+	if (m_bagElements > INLINE_ITEMS) //only as much room as the items need
+	{
+		m_capacity = m_bagElements;
+		m_bag = new BagItem[m_capacity];
+	}
+	for (int i = 0; i < m_bagElements; i++) //copies over a into the new array
+		m_bag[i] = a.m_bag[i];
 }
 
 Bag::~Bag()
 {
-	delete [] m_bag; //removes m_bag's resources
+	if (!isInline())
+		delete [] m_bag; //removes m_bag's resources
 	m_bagElements = 0;
 }
 
 bool Bag::empty() const
 {
 	//if the bag is empty, this function returns true
-	if (m_bag[0].count == 0) //1st count has no value
-		return true;
-	return false;
+	return m_bagElements == 0;
 }
 
 int Bag::size() const
@@ -59,112 +61,126 @@ int Bag::size() const
 
 int Bag::uniqueSize() const
 {
-	int totalUniqueItems = 0;
-	for (int i = 0; i < m_bagElements && m_bag[i].count != 0; i++) 
-		totalUniqueItems++;
-	return totalUniqueItems;
+	return m_bagElements;
 	//returns the number of unique items in the bag
 }
 
-bool Bag::insert(const ItemType& value)
+int Bag::find(const ItemType& value) const
 {
-	//inserts a value into the bag, returns true if success
-	for (int i = 0; i < m_bagElements; i++)
+	//binary search of the sorted items
+	int lo = 0;
+	int hi = m_bagElements;
+	while (lo < hi)
 	{
-		if (m_bag[i].item == value) //if the value to be added matches an item already in the bag, just increment the count
-		{
-			m_bag[i].count++;
-			return true;
-		}
+		int mid = (lo + hi) / 2;
+		if (m_bag[mid].item < value)
+			lo = mid + 1;
+		else
+			hi = mid;
 	}
+	return lo;
+}
 
-	for (int j = 0; j < m_bagElements; j++)
+void Bag::grow()
+{
+	//doubling keeps the total cost of copying linear in the number of inserts
+	int newCapacity = 2 * m_capacity;
+	BagItem* newBag = new BagItem[newCapacity];
+	for (int i = 0; i < m_bagElements; i++)
+		newBag[i] = m_bag[i];
+	if (!isInline())
+		delete [] m_bag;
+	m_bag = newBag;
+	m_capacity = newCapacity;
+}
+
+bool Bag::insert(const ItemType& value)
+{
+	//inserts a value into the bag, returns true if success
+	int pos = find(value);
+	if (pos < m_bagElements && m_bag[pos].item == value) //if the value to be added matches an item already in the bag, just increment the count
 	{
-		if (m_bag[j].count == 0) //if the value doesn't match, create a new element with count 1
-		{
-			m_bag[j].item = value;
-			m_bag[j].count++;
-			return true;
-		}
+		m_bag[pos].count++;
+		return true;
 	}
-	return false;	//if loop reaches the end of the array, no room left in bag
+
+	if (m_bagElements == m_capacity) //no room left in bag, so make some
+		grow();
+	for (int i = m_bagElements; i > pos; i--) //shifts the later items over to open a "hole" at pos
+		m_bag[i] = m_bag[i-1];
+	m_bag[pos].item = value; //create a new element with count 1
+	m_bag[pos].count = 1;
+	m_bagElements++;
+	return true;
 }
 
 int Bag::erase(const ItemType& value)
 {
-	for (start(); !ended(); next())
-	{
-		if (m_bag[m_finger].item == value)
-		{
-			m_bag[m_finger].count--; //decrements the count by 1
-			if (m_bag[m_finger].count == 0) //if this takes the count to 0, remove the entry and shift the array over
-			{
-				do //shifts the elements over
-				{
-					m_bag[m_finger].item = m_bag[m_finger+1].item;
-					m_bag[m_finger].count = m_bag[m_finger+1].count;
-					next();
-				} while (!ended());
-			}
-			return 1;
-		}
-	}
-	return 0;
+	int pos = find(value);
+	if (pos == m_bagElements || m_bag[pos].item != value)
+		return 0; //no matches
+
+	if (m_bag[pos].count > 1)
+		m_bag[pos].count--; //decrements the count by 1
+	else
+		eraseAll(value); //if this takes the count to 0, remove the entry
+	return 1;
 }
 
 int Bag::eraseAll(const ItemType& value)
 {
-	for (start(); !ended(); next())
-	{
-		if (m_bag[m_finger].item == value)
-		{
-			int numberErased = m_bag[m_finger].count; //logs the # of elements erased first
-			do //shifts the elements over to fill the "hole."
-			{
-				m_bag[m_finger].item = m_bag[m_finger+1].item;
-				m_bag[m_finger].count = m_bag[m_finger+1].count;
-				next();
-			} while (!ended());
-			return numberErased;
-		}
-	}
-	return 0; //no matches
+	int pos = find(value);
+	if (pos == m_bagElements || m_bag[pos].item != value)
+		return 0; //no matches
+
+	int numberErased = m_bag[pos].count; //logs the # of elements erased first
+	m_bagElements--;
+	for (int i = pos; i < m_bagElements; i++) //shifts the elements over to fill the "hole."
+		m_bag[i] = m_bag[i+1];
+	return numberErased;
 }
 
 bool Bag::contains(const ItemType& value) const
 {
-	for (int i = 0; i < m_bagElements && m_bag[i].count != 0; i++) //checks every item
-	{
-		if (m_bag[i].item == value)
-			return true;
-	}
-	return false;
+	int pos = find(value);
+	return pos < m_bagElements && m_bag[pos].item == value;
 }
 
 int Bag::count(const ItemType& value) const
 {
-	for (int i = 0; i < m_bagElements; i++)
+	int pos = find(value);
+	if (pos < m_bagElements && m_bag[pos].item == value) //if the element is found, return the count
+		return m_bag[pos].count;
+	return 0; //no matches
+}
+
+void Bag::moveFrom(Bag& src)
+{
+	//this bag must be empty and using its inline items
+	if (src.isInline())
 	{
-		if (m_bag[i].item == value) //if the element is found, return the count
-			return m_bag[i].count;
+		for (int i = 0; i < src.m_bagElements; i++) //inline items have to be copied over
+			m_inline[i] = src.m_inline[i];
 	}
-	return 0; //no matches
+	else
+	{
+		m_bag = src.m_bag; //takes the heap array by pointer
+		m_capacity = src.m_capacity;
+		src.m_bag = src.m_inline; //and src goes back to its inline items
+		src.m_capacity = INLINE_ITEMS;
+	}
+	m_bagElements = src.m_bagElements;
+	src.m_bagElements = 0;
 }
 
 void Bag::swap(Bag& other)
 {
 	//exchanges the contents of the bag with the contents of another bag
-	/*Bag temp; //temp bag to hold transfers
-	temp.m_bag = this->m_bag;  //loads first bag element into temp
-	temp.m_bagElements = this->m_bagElements;
-	this->m_bag = other.m_bag;//loads second bag element into first
-	this->m_bagElements = other.m_bagElements;
-	other.m_bag = temp.m_bag; //loads temp bag element into second
-	other.m_bagElements = temp.m_bagElements; */
+	//heap arrays are swapped by pointer; only inline items get copied
 	Bag temp;
-	temp = *this;
-	*this = other;
-	other = temp;
+	temp.moveFrom(*this);
+	moveFrom(other);
+	other.moveFrom(temp);
 }
 
 void Bag::start()
@@ -179,9 +195,7 @@ void Bag::next()
 
 bool Bag::ended()
 {
-	if (m_bag[m_finger].count == 0) //checks if the current item in the bag array exists
-		return true;
-	return false;
+	return m_finger >= m_bagElements; //checks if the finger has passed the last item in the bag array
 }
 
 const ItemType& Bag::currentValue() //returns a reference to the current item being pointed
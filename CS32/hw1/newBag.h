@@ -1,7 +1,7 @@
 #ifndef NEWBAG_H_DEFINED
 #define NEWBAG_H_DEFINED
 
-const int DEFAULT_MAX_ITEMS = 200;
+const int INLINE_ITEMS = 4; //distinct items kept in the Bag itself before it needs the heap
 typedef unsigned long ItemType;
 
 
@@ -18,7 +18,7 @@ class Bag
 		  
 		Bag& operator=(const Bag& a); //operator
 
-		Bag(int size = DEFAULT_MAX_ITEMS); //Create a new bag with a set size.
+		Bag(int size = INLINE_ITEMS); //Create a new bag with room for size distinct items. It grows as needed.
 
 		Bag(const Bag&); //copy constructor
 
@@ -37,8 +37,8 @@ class Bag
      
         bool insert(const ItemType& value);
           // Insert value into the bag.  Return true if the value was
-          // actually inserted.  Return false if the value was not inserted
-          // (perhaps because the bag has a fixed capacity and is full).
+          // actually inserted.  (The bag has no fixed capacity, so this
+          // always returns true.)
      
         int erase(const ItemType& value);
           // Remove one instance of value from the bag if present.
@@ -57,7 +57,7 @@ class Bag
         void swap(Bag& other);
           // Exchange the contents of this bag with the other one.
 
-   //iteration functions
+   //iteration functions (items come in increasing order)
         void start();
         void next();
         bool ended();
@@ -65,9 +65,16 @@ class Bag
         int currentCount();
 
 	private:
-		BagItem* m_bag; //actually holds the data members of the bag
+		int find(const ItemType& value) const; //position of the first item not less than value
+		void grow(); //doubles the room for items, moving them to the heap
+		void moveFrom(Bag& src); //takes srcs items into this empty inline bag, leaving src empty
+		bool isInline() const { return m_bag == m_inline; }
+
+		BagItem m_inline[INLINE_ITEMS]; //small bags keep their items here
+		BagItem* m_bag; //actually holds the data members of the bag; m_inline or the heap, sorted by item
 		int m_finger; //what the iteration functions use to "point"
-		int m_bagElements;
+		int m_bagElements; //number of distinct items
+		int m_capacity; //number of distinct items m_bag has room for
 	};
 
 #endif
\ No newline at end of file
@@ -5,9 +5,9 @@ using namespace std;
 
 int main()
 {
-	 Bag a(1000);   // a can hold at most 1000 distinct items
-     Bag b(5);      // b can hold at most 5 distinct items
-     Bag c;         // c can hold at most DEFAULT_MAX_ITEMS distinct items
+	 Bag a(1000);   // a starts with room for 1000 distinct items
+     Bag b(5);      // b starts with room for 5 distinct items
+     Bag c;         // c starts with room for INLINE_ITEMS distinct items
      ItemType v[6] = {1, 2, 3, 4, 5, 6};
        // No failures inserting 5 distinct items twice each into b
      for (int k = 0; k < 5; k++)
@@ -16,12 +16,35 @@ int main()
          assert(b.insert(v[k]));
      }
      assert(b.size() == 10  &&  b.uniqueSize() == 5  &&  b.count(v[0]) == 2);
-       // Failure if we try to insert a sixth distinct item into b
-     assert(!b.insert(v[5]));
+       // A sixth distinct item makes b grow instead of failing
+     assert(b.insert(v[5])  &&  b.uniqueSize() == 6);
 
-       // When two Bags' contents are swapped, their capacities are swapped
-       // as well:
+       // Swapping exchanges the contents whether they're inline or not
      a.swap(b);
-     assert(!a.insert(v[5]));
+     assert(a.size() == 11  &&  b.empty()  &&  a.count(v[5]) == 1);
+     c.insert(v[0]);
+     c.swap(a);
+     assert(c.size() == 11  &&  a.size() == 1);
+
+       // Thousands of items stay sorted and findable, and erase works on them
+     for (ItemType k = 0; k < 5000; k++)
+         assert(c.insert((k * 7919) % 5000 + 10));
+     assert(c.uniqueSize() == 5006  &&  c.count(17) == 1);
+     ItemType prev = 0;
+     int total = 0;
+     for (c.start(); !c.ended(); c.next())
+     {
+         assert(c.currentValue() > prev);
+         prev = c.currentValue();
+         total += c.currentCount();
+     }
+     assert(total == c.size());
+     assert(c.erase(v[0]) == 1  &&  c.count(v[0]) == 1  &&  c.eraseAll(v[0]) == 1);
+     assert(!c.contains(v[0])  &&  c.eraseAll(20000) == 0);
+     Bag d(c);
+     assert(d.erase(17) == 1  &&  c.contains(17)  &&  !d.contains(17));
+     a = d;
+     d = Bag();
+     assert(a.uniqueSize() == 5004  &&  d.empty());
 	 cout << "All tests succeeded" << endl;
 }
\ No newline at end of file
@@ -0,0 +1,310 @@
+#ifndef NODEPOOL_INCLUDED
+#define NODEPOOL_INCLUDED
+
+// The services this header provides:
+//
+//  NodePool<T> pool;
+//    A source of storage for single objects of type T.  The storage is
+//    carved out of slabs of many objects each, and storage given back with
+//    deallocate is kept on a free list for reuse rather than returned to
+//    the heap.  When the pool is destroyed, every slab is freed at once,
+//    whether or not the objects in it were given back.
+//  pool.allocate()
+//    Return a pointer to uninitialized storage for one T.
+//  pool.deallocate(p)
+//    Give back storage that came from pool.allocate().
+//
+//  PoolAllocator<T>
+//    A standard allocator (usable wherever std::allocator<T> is) whose
+//    one-object requests come from a NodePool shared by the whole program.
+//    Each thread keeps a small cache of free objects of its own and moves
+//    them to and from the shared pool in batches, so most allocations and
+//    deallocations take no lock.  Requests for more than one object go to
+//    operator new.  A container that uses it for its nodes gets them
+//    packed into slabs instead of scattered across the heap.
+//
+//    The shared pool lasts as long as the program, and storage given back
+//    to it is kept for reuse, never returned to the heap.  So a container
+//    using PoolAllocator does not free its slabs when it is destroyed; the
+//    program keeps as many slabs of each node type as it ever needed at
+//    once.  Only a NodePool of your own frees its slabs in bulk.  The
+//    containers don't each own one, because their allocators must be
+//    stateless (copies of a Map with PersistentStorage share nodes).  A
+//    long-running program that must give memory back can give them
+//    std::allocator instead.
+
+#include <cstddef>
+#include <vector>
+#include <new>
+#include <mutex>
+#include <algorithm>
+
+template <typename T>
+class NodePool
+{
+  public:
+    explicit NodePool(size_t objectsPerSlab = 256);
+    ~NodePool();
+    NodePool(const NodePool&) = delete;
+    NodePool& operator=(const NodePool&) = delete;
+
+    T* allocate();
+    void deallocate(T* p);
+    void swap(NodePool& other);
+    size_t slabCount() const { return m_slabs.size(); }
+
+  private:
+      // Representation:
+      //   Each slab is an array of Slots.  A Slot is big enough and aligned
+      //   well enough for a T, and while it's free it holds the link to the
+      //   next free Slot.
+      //   m_free is the list of Slots given back by deallocate.  Slots from
+      //   m_unused up to m_slabEnd in the newest slab have never been handed
+      //   out.
+
+    union Slot
+    {
+        Slot* m_next;
+        alignas(T) unsigned char m_storage[sizeof(T)];
+    };
+
+    std::vector<Slot*> m_slabs;
+    Slot*              m_free;
+    Slot*              m_unused;
+    Slot*              m_slabEnd;
+    size_t             m_objectsPerSlab;
+};
+
+template <typename T>
+class PoolAllocator
+{
+  public:
+    typedef T value_type;
+
+    PoolAllocator() {}
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U>&) {}
+
+    T* allocate(size_t n);
+    void deallocate(T* p, size_t n);
+
+      // Every PoolAllocator<T> draws on the same pools, so storage from one
+      // can be given back through any other
+    template <typename U>
+    bool operator==(const PoolAllocator<U>&) const { return true; }
+    template <typename U>
+    bool operator!=(const PoolAllocator<U>&) const { return false; }
+
+  private:
+    static const int CACHE_SIZE = 64;  // objects moved per batch
+
+    struct FreeObject
+    {
+        FreeObject* m_next;
+    };
+
+    struct SharedPool
+    {
+        std::mutex  m_lock;
+        NodePool<T> m_pool;
+    };
+
+    struct ThreadCache
+    {
+        FreeObject* m_free;
+        int         m_count;
+
+        ThreadCache() : m_free(NULL), m_count(0) {}
+        ~ThreadCache();
+    };
+
+      // NodePool<T> slots are at least as big as a pointer, so a free object
+      // can always hold the link to the next one
+    static T* fromShared();
+    static void toShared(ThreadCache& cache, int n);
+    static SharedPool& shared();
+    static ThreadCache* cache();
+};
+
+//========================================================================
+// NodePool implementation
+//========================================================================
+
+template <typename T>
+NodePool<T>::NodePool(size_t objectsPerSlab)
+ : m_free(NULL), m_unused(NULL), m_slabEnd(NULL),
+   m_objectsPerSlab(objectsPerSlab > 0 ? objectsPerSlab : 1)
+{
+}
+
+template <typename T>
+NodePool<T>::~NodePool()
+{
+    for (size_t k = 0; k != m_slabs.size(); k++)
+        ::operator delete(m_slabs[k]);
+}
+
+template <typename T>
+T* NodePool<T>::allocate()
+{
+    Slot* s;
+    if (m_free != NULL)  // reuse a slot given back earlier
+    {
+        s = m_free;
+        m_free = s->m_next;
+    }
+    else
+    {
+        if (m_unused == m_slabEnd)  // start a new slab
+        {
+            m_unused = static_cast<Slot*>(::operator new(m_objectsPerSlab * sizeof(Slot)));
+            m_slabEnd = m_unused + m_objectsPerSlab;
+            m_slabs.push_back(m_unused);
+        }
+        s = m_unused;
+        m_unused++;
+    }
+    return reinterpret_cast<T*>(s->m_storage);
+}
+
+template <typename T>
+inline
+void NodePool<T>::deallocate(T* p)
+{
+    Slot* s = reinterpret_cast<Slot*>(p);
+    s->m_next = m_free;
+    m_free = s;
+}
+
+template <typename T>
+void NodePool<T>::swap(NodePool& other)
+{
+    m_slabs.swap(other.m_slabs);
+    std::swap(m_free, other.m_free);
+    std::swap(m_unused, other.m_unused);
+    std::swap(m_slabEnd, other.m_slabEnd);
+    std::swap(m_objectsPerSlab, other.m_objectsPerSlab);
+}
+
+//========================================================================
+// PoolAllocator implementation
+//========================================================================
+
+  // The shared pool is never destroyed:  containers that are themselves
+  // static objects may give back their nodes after any static pool would
+  // have been destroyed.  Its slabs are reclaimed when the program ends.
+
+template <typename T>
+typename PoolAllocator<T>::SharedPool& PoolAllocator<T>::shared()
+{
+    static SharedPool* pool = new SharedPool;
+    return *pool;
+}
+
+  // Return this thread's cache, or NULL once the thread is shutting down
+  // and its cache has been destroyed
+
+template <typename T>
+typename PoolAllocator<T>::ThreadCache* PoolAllocator<T>::cache()
+{
+    static thread_local bool destroyed = false;
+    if (destroyed)
+        return NULL;
+    static thread_local struct Holder
+    {
+        ThreadCache cache;
+        ~Holder() { destroyed = true; }
+    } holder;
+    return &holder.cache;
+}
+
+template <typename T>
+T* PoolAllocator<T>::allocate(size_t n)
+{
+    if (n != 1)
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+
+    ThreadCache* c = cache();
+    if (c == NULL)
+        return fromShared();
+
+    if (c->m_free == NULL)
+    {
+          // Refill the cache with a batch from the shared pool, taking the
+          // lock once for the whole batch
+
+        SharedPool& s = shared();
+        std::lock_guard<std::mutex> guard(s.m_lock);
+        for (int k = 0; k < CACHE_SIZE; k++)
+        {
+            FreeObject* f = reinterpret_cast<FreeObject*>(s.m_pool.allocate());
+            f->m_next = c->m_free;
+            c->m_free = f;
+        }
+        c->m_count = CACHE_SIZE;
+    }
+    FreeObject* f = c->m_free;
+    c->m_free = f->m_next;
+    c->m_count--;
+    return reinterpret_cast<T*>(f);
+}
+
+template <typename T>
+void PoolAllocator<T>::deallocate(T* p, size_t n)
+{
+    if (n != 1)
+    {
+        ::operator delete(p);
+        return;
+    }
+
+    FreeObject* f = reinterpret_cast<FreeObject*>(p);
+    ThreadCache* c = cache();
+    if (c == NULL)
+    {
+        SharedPool& s = shared();
+        std::lock_guard<std::mutex> guard(s.m_lock);
+        s.m_pool.deallocate(reinterpret_cast<T*>(f));
+        return;
+    }
+
+    f->m_next = c->m_free;
+    c->m_free = f;
+    c->m_count++;
+
+      // A thread that only frees (say, one consuming what another built)
+      // would hoard objects; hand a batch back once the cache is too full
+
+    if (c->m_count > 2 * CACHE_SIZE)
+        toShared(*c, CACHE_SIZE);
+}
+
+template <typename T>
+T* PoolAllocator<T>::fromShared()
+{
+    SharedPool& s = shared();
+    std::lock_guard<std::mutex> guard(s.m_lock);
+    return s.m_pool.allocate();
+}
+
+template <typename T>
+void PoolAllocator<T>::toShared(ThreadCache& cache, int n)
+{
+    SharedPool& s = shared();
+    std::lock_guard<std::mutex> guard(s.m_lock);
+    for ( ; n > 0  &&  cache.m_free != NULL; n--)
+    {
+        FreeObject* f = cache.m_free;
+        cache.m_free = f->m_next;
+        cache.m_count--;
+        s.m_pool.deallocate(reinterpret_cast<T*>(f));
+    }
+}
+
+template <typename T>
+PoolAllocator<T>::ThreadCache::~ThreadCache()
+{
+    toShared(*this, m_count);
+}
+
+#endif // NODEPOOL_INCLUDED
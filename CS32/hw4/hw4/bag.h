@@ -4,8 +4,17 @@
 #define BAG_INCLUDED
 
 #include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <iterator>
+#include "NodePool.h"
 
-template<class ItemType>
+  // Nodes are obtained from an Allocator (rebound to the node type), which
+  // must be default-constructible and stateless, like std::allocator or
+  // PoolAllocator.  By default they come from the slabs of a PoolAllocator.
+
+template<class ItemType, class Allocator = PoolAllocator<ItemType> >
 class Bag
 {
   public:
@@ -22,9 +31,18 @@ class Bag
       // "turmeric" is 2.
 
     bool insert(const ItemType& value);
+    bool insert(ItemType&& value);
       // Insert value into the bag.  Return true if the value was
       // actually inserted.  (For a linked list implementation, insert
-      // always returns true.)
+      // always returns true.)  The second form moves value into the bag
+      // instead of copying it if it isn't already there.
+
+    template<class... Args>
+    bool emplace(Args&&... args);
+      // Insert the item constructed from args, building it in the bag
+      // rather than copying it in.  (The item must exist to be compared,
+      // so if the bag already contains it, the new one is built and then
+      // thrown away.)
 
     int erase(const ItemType& value);
       // Remove one instance of value from the bag if present.
@@ -50,10 +68,25 @@ class Bag
     const ItemType& currentValue() const;  // item at current position
     int currentCount() const;              // count of current item
 
+      // Iterators visit each distinct item once, in the same order as the
+      // iteration functions but without disturbing them.  *it is a
+      // reference to the item, and it.count() is how many instances of it
+      // the bag holds.  Items can't be changed through an iterator.
+      // Inserting or erasing invalidates every iterator.
+    class const_iterator;  // bidirectional
+    typedef const_iterator iterator;
+    const_iterator begin() const;
+    const_iterator end() const;
+
       // Housekeeping functions
     ~Bag();
     Bag(const Bag& other);
+    Bag(Bag&& other);
     Bag& operator=(const Bag& rhs);
+    Bag& operator=(Bag&& rhs);
+      // A bag that has been moved from is usable:  the move constructor
+      // leaves it empty, and move assignment swaps, so after a = move(b),
+      // b holds what a held.
 
   private:
       // Representation:
@@ -72,6 +105,12 @@ class Bag
         int      m_count;
         Node*    m_next;
         Node*    m_prev;
+
+        Node() {}  // the dummy node
+        template<class... Args>
+        Node(Args&&... args)
+         : m_value(std::forward<Args>(args)...), m_count(1)
+        {}
     };
 
     Node* m_head;
@@ -87,88 +126,156 @@ class Bag
       // Remove one or all instances of value from the bag if present,
       // depending on the second parameter.  Return the number of instances
       // removed.
+
+    void addNode(Node* p);
+      // Link a new node holding one instance of an item not in the bag
+
+    typedef typename std::allocator_traits<Allocator>::template rebind_alloc<Node> NodeAllocator;
+    template<class... Args>
+    static Node* newNode(Args&&... args)
+    {
+          // Construct the node from args directly in the allocated storage,
+          // giving the storage back if the construction throws
+        Node* p = NodeAllocator().allocate(1);
+        try
+        {
+            return new (p) Node(std::forward<Args>(args)...);
+        }
+        catch (...)
+        {
+            NodeAllocator().deallocate(p, 1);
+            throw;
+        }
+    }
+    static void deleteNode(Node* p)
+    {
+        p->~Node();
+        NodeAllocator().deallocate(p, 1);
+    }
+};
+
+template<class ItemType, class Allocator>
+class Bag<ItemType, Allocator>::const_iterator
+{
+  public:
+    typedef std::bidirectional_iterator_tag iterator_category;
+    typedef ItemType                        value_type;
+    typedef std::ptrdiff_t                  difference_type;
+    typedef const ItemType*                 pointer;
+    typedef const ItemType&                 reference;
+
+    const_iterator() : m_node(NULL) {}
+
+    const ItemType& operator*() const { return m_node->m_value; }
+    const ItemType* operator->() const { return &m_node->m_value; }
+    int count() const { return m_node->m_count; }
+
+    const_iterator& operator++() { m_node = m_node->m_next; return *this; }
+    const_iterator& operator--() { m_node = m_node->m_prev; return *this; }
+    const_iterator operator++(int) { const_iterator old(*this); ++*this; return old; }
+    const_iterator operator--(int) { const_iterator old(*this); --*this; return old; }
+    bool operator==(const const_iterator& other) const { return m_node == other.m_node; }
+    bool operator!=(const const_iterator& other) const { return m_node != other.m_node; }
+
+  private:
+    const Node* m_node;  // the dummy node for end()
+
+    explicit const_iterator(const Node* p) : m_node(p) {}
+    friend class Bag;
 };
 
 // Declarations of non-member functions
-template<class ItemType>
-void combine(Bag<ItemType>& b1, Bag<ItemType>& b2, Bag<ItemType>& result); 
+template<class ItemType, class Allocator>
+void combine(const Bag<ItemType, Allocator>& b1, const Bag<ItemType, Allocator>& b2, Bag<ItemType, Allocator>& result); 
       // If a value occurs n1 times in b1 and n2 times in b2, then
       // it will occur n1+n2 times in result upon return from this function.
 
-template<class ItemType>
-void subtract(Bag<ItemType>& b1, Bag<ItemType>& b2, Bag<ItemType>& result); 
+template<class ItemType, class Allocator>
+void subtract(const Bag<ItemType, Allocator>& b1, const Bag<ItemType, Allocator>& b2, Bag<ItemType, Allocator>& result); 
       // If a value occurs n1 times in b1 and n2 times in b2, then
       // it will occur n1-n2 times in result upon return from this function
       // if n1 >= n2.  If n1 <= n2, it will not occur in result.
 
 // Inline implementations
 
-template<class ItemType>
-inline int Bag<ItemType>::size() const
+template<class ItemType, class Allocator>
+inline int Bag<ItemType, Allocator>::size() const
 {
     return m_size;
 }
 
-template<class ItemType>
-inline int Bag<ItemType>::uniqueSize() const
+template<class ItemType, class Allocator>
+inline int Bag<ItemType, Allocator>::uniqueSize() const
 {
     return m_uniqueSize;
 }
 
-template<class ItemType>
-inline bool Bag<ItemType>::empty() const
+template<class ItemType, class Allocator>
+inline bool Bag<ItemType, Allocator>::empty() const
 {
     return size() == 0;
 }
 
-template<class ItemType>
-inline int Bag<ItemType>::erase(const ItemType& value)
+template<class ItemType, class Allocator>
+inline int Bag<ItemType, Allocator>::erase(const ItemType& value)
 {
     return doErase(value, false);
 }
 
-template<class ItemType>
-inline int Bag<ItemType>::eraseAll(const ItemType& value)
+template<class ItemType, class Allocator>
+inline int Bag<ItemType, Allocator>::eraseAll(const ItemType& value)
 {
     return doErase(value, true);
 }
 
-template<class ItemType>
-inline bool Bag<ItemType>::contains(const ItemType& value) const
+template<class ItemType, class Allocator>
+inline bool Bag<ItemType, Allocator>::contains(const ItemType& value) const
 {
     return find(value) != m_head;
 }
 
-template<class ItemType>
-inline void Bag<ItemType>::start()
+template<class ItemType, class Allocator>
+inline void Bag<ItemType, Allocator>::start()
 {
     m_current = m_head->m_next;
 }
 
-template<class ItemType>
-inline void Bag<ItemType>::next()
+template<class ItemType, class Allocator>
+inline void Bag<ItemType, Allocator>::next()
 {
     m_current = m_current->m_next;
 }
 
-template<class ItemType>
-inline bool Bag<ItemType>::ended() const
+template<class ItemType, class Allocator>
+inline bool Bag<ItemType, Allocator>::ended() const
 {
     return m_current == m_head;
 }
 
-template<class ItemType>
-inline const ItemType& Bag<ItemType>::currentValue() const
+template<class ItemType, class Allocator>
+inline const ItemType& Bag<ItemType, Allocator>::currentValue() const
 {
     return m_current->m_value;
 }
 
-template<class ItemType>
-inline int Bag<ItemType>::currentCount() const
+template<class ItemType, class Allocator>
+inline int Bag<ItemType, Allocator>::currentCount() const
 {
     return m_current->m_count;
 }
 
+template<class ItemType, class Allocator>
+inline typename Bag<ItemType, Allocator>::const_iterator Bag<ItemType, Allocator>::begin() const
+{
+    return const_iterator(m_head->m_next);
+}
+
+template<class ItemType, class Allocator>
+inline typename Bag<ItemType, Allocator>::const_iterator Bag<ItemType, Allocator>::end() const
+{
+    return const_iterator(m_head);
+}
+
 void exchange(int& a, int& b)
 {
     int t = a;
@@ -180,18 +287,18 @@ void exchange(int& a, int& b)
 // whenever we can, we invalidate access through the m_current pointer
 // by setting it to NULL whenever the state of the iteration is not defined.
 
-template<class ItemType>
-Bag<ItemType>::Bag()
+template<class ItemType, class Allocator>
+Bag<ItemType, Allocator>::Bag()
  : m_uniqueSize(0), m_size(0), m_current(NULL)
 {
       // create dummy node
-    m_head = new Node;
+    m_head = newNode();
     m_head->m_next = m_head;
     m_head->m_prev = m_head;
 }
 
-template<class ItemType>
-Bag<ItemType>::~Bag()
+template<class ItemType, class Allocator>
+Bag<ItemType, Allocator>::~Bag()
 {
       // Delete the m_uniqueSize non-dummy nodes plus the dummy node
 
@@ -199,17 +306,17 @@ Bag<ItemType>::~Bag()
     {
 	Node* toBeDeleted = p;
 	p = p->m_prev;
-	delete toBeDeleted;
+	deleteNode(toBeDeleted);
     }
 }
 
-template<class ItemType>
-Bag<ItemType>::Bag(const Bag& other)
+template<class ItemType, class Allocator>
+Bag<ItemType, Allocator>::Bag(const Bag& other)
  : m_uniqueSize(other.m_uniqueSize), m_size(other.m_size), m_current(NULL)
 {
       // Create dummy node; don't initialize its m_next
 
-    m_head = new Node;
+    m_head = newNode();
     m_head->m_prev = m_head;
 
       // Copy each node from the other list; each iteration will set the
@@ -218,8 +325,7 @@ Bag<ItemType>::Bag(const Bag& other)
     for (Node* p = other.m_head->m_next ; p != other.m_head; p = p->m_next)
     {
 	  // Create a copy of the node p points to
-	Node* pnew = new Node;
-	pnew->m_value = p->m_value;
+	Node* pnew = newNode(p->m_value);
 	pnew->m_count = p->m_count;
 	
 	  // Connect the m_prev pointers
@@ -234,8 +340,21 @@ Bag<ItemType>::Bag(const Bag& other)
     m_head->m_prev->m_next = m_head;
 }
 
-template<class ItemType>
-Bag<ItemType>& Bag<ItemType>::operator=(const Bag& rhs)
+template<class ItemType, class Allocator>
+Bag<ItemType, Allocator>::Bag(Bag&& other)
+ : m_uniqueSize(0), m_size(0), m_current(NULL)
+{
+      // Take the other bag's nodes, leaving it an empty list of its own
+      // (every list needs a dummy node)
+
+    m_head = newNode();
+    m_head->m_next = m_head;
+    m_head->m_prev = m_head;
+    swap(other);
+}
+
+template<class ItemType, class Allocator>
+Bag<ItemType, Allocator>& Bag<ItemType, Allocator>::operator=(const Bag& rhs)
 {
     if (this != &rhs)
     {
@@ -245,46 +364,91 @@ Bag<ItemType>& Bag<ItemType>::operator=(const Bag& rhs)
     return *this;
 }
 
-template<class ItemType>
-bool Bag<ItemType>::insert(const ItemType& value)
+template<class ItemType, class Allocator>
+Bag<ItemType, Allocator>& Bag<ItemType, Allocator>::operator=(Bag&& rhs)
+{
+      // rhs gets our old nodes, which it destroys when it goes away
+    swap(rhs);
+    return *this;
+}
+
+template<class ItemType, class Allocator>
+bool Bag<ItemType, Allocator>::insert(const ItemType& value)
 {
     Node* p = find(value);
 
     if (p != m_head)  // found
+    {
         p->m_count++;
+        m_size++;
+        m_current = NULL;  // invalidate iteration -- list changed
+    }
     else
-    {
-	  // Create a new node
-	p = new Node;
-	p->m_value = value;
-	p->m_count = 1;
+	addNode(newNode(value));
+    return true;
+}
 
-	  // Insert new item at tail of list (arbitrary choice of position)
-	  //     Connect it to tail
-	p->m_prev = m_head->m_prev;
-	p->m_prev->m_next = p;
+template<class ItemType, class Allocator>
+bool Bag<ItemType, Allocator>::insert(ItemType&& value)
+{
+    Node* p = find(value);
 
-	  //     Connect it to dummy node
-	p->m_next = m_head;
-	m_head->m_prev = p;
+    if (p != m_head)  // found
+    {
+        p->m_count++;
+        m_size++;
+        m_current = NULL;  // invalidate iteration -- list changed
+    }
+    else
+	addNode(newNode(std::move(value)));
+    return true;
+}
 
-	m_uniqueSize++;
+template<class ItemType, class Allocator>
+template<class... Args>
+bool Bag<ItemType, Allocator>::emplace(Args&&... args)
+{
+    Node* pnew = newNode(std::forward<Args>(args)...);
+    Node* p = find(pnew->m_value);
+
+    if (p != m_head)  // found; the new node isn't needed
+    {
+        deleteNode(pnew);
+        p->m_count++;
+        m_size++;
+        m_current = NULL;  // invalidate iteration -- list changed
     }
+    else
+	addNode(pnew);
+    return true;
+}
 
+template<class ItemType, class Allocator>
+void Bag<ItemType, Allocator>::addNode(Node* p)
+{
+      // Insert new item at tail of list (arbitrary choice of position)
+      //     Connect it to tail
+    p->m_prev = m_head->m_prev;
+    p->m_prev->m_next = p;
+
+      //     Connect it to dummy node
+    p->m_next = m_head;
+    m_head->m_prev = p;
+
+    m_uniqueSize++;
     m_size++;
     m_current = NULL;  // invalidate iteration -- list changed
-    return true;
 }
 
-template<class ItemType>
-int Bag<ItemType>::count(const ItemType& value) const
+template<class ItemType, class Allocator>
+int Bag<ItemType, Allocator>::count(const ItemType& value) const
 {
     Node* p = find(value);
     return p == m_head ? 0 : p->m_count;
 }
 
-template<class ItemType>
-void Bag<ItemType>::swap(Bag& other)
+template<class ItemType, class Allocator>
+void Bag<ItemType, Allocator>::swap(Bag& other)
 {
       // swap head pointers
     Node* temp = m_head;
@@ -300,8 +464,8 @@ void Bag<ItemType>::swap(Bag& other)
     other.m_current = NULL;
 }
 
-template<class ItemType>
-typename Bag<ItemType>::Node* Bag<ItemType>::find(const ItemType& value) const
+template<class ItemType, class Allocator>
+typename Bag<ItemType, Allocator>::Node* Bag<ItemType, Allocator>::find(const ItemType& value) const
 {
       // Do a linear search through the list
 
@@ -311,8 +475,8 @@ typename Bag<ItemType>::Node* Bag<ItemType>::find(const ItemType& value) const
     return p;
 }
 
-template<class ItemType>
-int Bag<ItemType>::doErase(const ItemType& value, bool all)
+template<class ItemType, class Allocator>
+int Bag<ItemType, Allocator>::doErase(const ItemType& value, bool all)
 {
     Node* p = find(value);
 
@@ -331,7 +495,7 @@ int Bag<ItemType>::doErase(const ItemType& value, bool all)
     {
         p->m_prev->m_next = p->m_next;
         p->m_next->m_prev = p->m_prev;
-        delete p;
+        deleteNode(p);
 
         m_uniqueSize--;
     }
@@ -341,8 +505,8 @@ int Bag<ItemType>::doErase(const ItemType& value, bool all)
     return nErased;
 }
 
-template<class ItemType>
-void combine(Bag<ItemType>& b1, Bag<ItemType>& b2, Bag<ItemType>& result)
+template<class ItemType, class Allocator>
+void combine(const Bag<ItemType, Allocator>& b1, const Bag<ItemType, Allocator>& b2, Bag<ItemType, Allocator>& result)
 {
       // Guard against the case that result is an alias for b1 or b2
       // (i.e., that result is a reference to the same bag that b1 or b2
@@ -350,29 +514,29 @@ void combine(Bag<ItemType>& b1, Bag<ItemType>& b2, Bag<ItemType>& result)
       // done, swap res with result; the old value of result (now in res) will
       // be destroyed when res is destroyed.
 
-    Bag<ItemType> res(b1);
-    for (b2.start(); !b2.ended(); b2.next())
+    Bag<ItemType, Allocator> res(b1);
+    for (typename Bag<ItemType, Allocator>::const_iterator p = b2.begin(); p != b2.end(); p++)
     {
-	for (int k = 0; k < b2.currentCount(); k++)
-	    res.insert(b2.currentValue());
+	for (int k = 0; k < p.count(); k++)
+	    res.insert(*p);
     }
     result.swap(res);
 }
 
-template<class ItemType>
-void subtract(Bag<ItemType>& b1, Bag<ItemType>& b2, Bag<ItemType>& result)
+template<class ItemType, class Allocator>
+void subtract(const Bag<ItemType, Allocator>& b1, const Bag<ItemType, Allocator>& b2, Bag<ItemType, Allocator>& result)
 {
       // Guard against the case that result is an alias for b1 or b2
       // by building the answer in a local variable res.  When done, swap res
       // with result; the old value of result (now in res) will be destroyed
       // when res is destroyed.
 
-    Bag<ItemType> res;
-    for (b1.start(); !b1.ended(); b1.next())
+    Bag<ItemType, Allocator> res;
+    for (typename Bag<ItemType, Allocator>::const_iterator p = b1.begin(); p != b1.end(); p++)
     {
-        int n = b1.currentCount() - b2.count(b1.currentValue());
+        int n = p.count() - b2.count(*p);
 	for (int k = 0; k < n; k++)
-	    res.insert(b1.currentValue());
+	    res.insert(*p);
     }
     result.swap(res);
 }
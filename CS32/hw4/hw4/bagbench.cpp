@@ -0,0 +1,346 @@
+// Timing tests for Bag with nodes from a PoolAllocator (the default) and
+// with nodes straight from the heap, and counts of the allocations it takes
+// to copy strings into a bag, move them in, or build them in place.  The
+// same churn is timed on a HashBag, and last, word counts made by several
+// threads are merged with combine, one bag at a time, and with
+// combineParallel.  Copying is also timed on a copy-on-write CowBag, both
+// alone and followed by a change to the copy.  Build it on its own (it has its own main), e.g.
+//     g++ -O2 -pthread bagbench.cpp
+// and run it as
+//     bagbench [uniqueItems] [threads]
+
+#include "bag.h"
+#include "hashbag.h"
+#include "cowbag.h"
+#include <iostream>
+#include <vector>
+#include <string>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <utility>
+#include <new>
+#include <cstdlib>  // for std::rand, std::atoi, std::malloc, std::free
+#include <cassert>
+
+using namespace std;
+
+//========================================================================
+// TimerType            - a type to hold a timer reading
+// TimerType getTimer() - get the current timer reading
+// double interval(TimerType start, TimerType end) - milliseconds between
+//                                                   two readings
+//========================================================================
+
+#ifdef _MSC_VER  // If we're compiling for Windows
+
+#include <windows.h>
+
+typedef LARGE_INTEGER TimerType;
+inline TimerType getTimer()
+{
+    LARGE_INTEGER t;
+    QueryPerformanceCounter(&t);
+    return t;
+}
+
+inline double interval(TimerType start, TimerType end)
+{
+    LARGE_INTEGER ticksPerSecond;
+    QueryPerformanceFrequency(&ticksPerSecond);
+    return (1000.0 * (end.QuadPart - start.QuadPart)) / ticksPerSecond.QuadPart;
+}
+
+#else // If we're not compiling for Windows, use Standard C
+
+#include <ctime>
+
+typedef clock_t TimerType;
+inline TimerType getTimer() { return clock(); }
+inline double interval(TimerType start, TimerType end)
+{
+    return (1000.0 * (end - start)) / CLOCKS_PER_SEC;
+}
+
+#endif  // ifdef _MSC_VER
+
+//========================================================================
+// Count every allocation the program makes
+//========================================================================
+
+static atomic<size_t> allocations(0);
+
+void* operator new(size_t size)
+{
+    allocations++;
+    void* p = malloc(size > 0 ? size : 1);
+    if (p == NULL)
+        throw bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    free(p);
+}
+
+//========================================================================
+
+typedef Bag<int> PoolBag;
+typedef Bag<int, allocator<int> > HeapBag;
+
+  // Report the results of a timing test
+
+void report(string caption, double ms)
+{
+    cout << ms << " milliseconds; " << caption << endl;
+}
+
+void reportAllocations(string caption, size_t allocs, int items)
+{
+    cout << double(allocs) / items << " allocations per item; " << caption << endl;
+}
+
+  // Long enough that no implementation keeps it in the string object itself
+
+string makeItem(int k)
+{
+    return "an item long enough to need the heap #" + to_string(k);
+}
+
+  // Fill a bag of strings by copying nUnique items in, by moving them in,
+  // and by building them in place from a count and a character, counting
+  // the allocations made by the inserts alone.
+
+void countStringInserts(int nUnique)
+{
+    vector<string> items;
+    for (int k = 0; k < nUnique; k++)
+        items.push_back(makeItem(k));
+
+    Bag<string> copied;
+    size_t before = allocations;
+    for (int k = 0; k < nUnique; k++)
+        copied.insert(items[k]);
+    reportAllocations("insert copy", allocations - before, nUnique);
+
+    Bag<string> moved;
+    before = allocations;
+    for (int k = 0; k < nUnique; k++)
+        moved.insert(std::move(items[k]));
+    reportAllocations("insert move", allocations - before, nUnique);
+    assert(moved.uniqueSize() == nUnique);
+
+      // (only the string's own buffer is left to allocate)
+    Bag<string> emplaced;
+    before = allocations;
+    for (int k = 0; k < nUnique; k++)
+        emplaced.emplace(40 + k % 1000, char('a' + k / 1000 % 26));
+    reportAllocations("emplace", allocations - before, nUnique);
+
+    before = allocations;
+    Bag<string> copy(copied);
+    reportAllocations("copy bag", allocations - before, nUnique);
+
+    before = allocations;
+    Bag<string> taken(std::move(copy));
+    reportAllocations("move bag", allocations - before, nUnique);
+    assert(taken.uniqueSize() == nUnique  &&  copy.empty());
+}
+
+  // Keep a bag of nUnique distinct items, and repeatedly remove every
+  // instance of one item and put it back, so each round frees a node and
+  // allocates one.  Return a total so the work isn't optimized away.
+
+template<class BagType>
+int churn(int nUnique, int rounds, unsigned seed)
+{
+    BagType b;
+    for (int k = 0; k < nUnique; k++)
+        b.insert(k);
+    for (int r = 0; r < rounds; r++)
+    {
+        int item = int(seed % unsigned(nUnique));
+        seed = seed * 1103515245 + 12345;
+        b.eraseAll(item);
+        b.insert(item);
+    }
+    return b.uniqueSize();
+}
+
+  // Copy a bag of nUnique items and destroy the copy, several times
+
+template<class BagType>
+int copyAndDestroy(int nUnique, int times)
+{
+    BagType b;
+    for (int k = 0; k < nUnique; k++)
+        b.insert(k);
+    int total = 0;
+    for (int t = 0; t < times; t++)
+    {
+        BagType copy(b);
+        total += copy.uniqueSize();
+    }
+    return total;
+}
+
+  // Copy a bag of nUnique items, insert one more item into the copy, and
+  // destroy the copy, several times.  A CowBag's copy has to copy the items
+  // when it changes, so this shows what copy-on-write costs when a copy
+  // doesn't stay unchanged.
+
+template<class BagType>
+int copyChangeAndDestroy(int nUnique, int times)
+{
+    BagType b;
+    for (int k = 0; k < nUnique; k++)
+        b.insert(k);
+    int total = 0;
+    for (int t = 0; t < times; t++)
+    {
+        BagType copy(b);
+        copy.insert(t % nUnique);
+        total += copy.uniqueSize();
+    }
+    return total;
+}
+
+  // Run churn on its own bag in each of nThreads threads.  Each thread's
+  // PoolAllocator cache serves its own nodes without taking a lock.
+
+template<class BagType>
+void churnInThreads(int nUnique, int rounds, int nThreads)
+{
+    vector<thread> threads;
+    for (int t = 0; t < nThreads; t++)
+        threads.push_back(thread([=]() { churn<BagType>(nUnique, rounds, t + 1); }));
+    for (int t = 0; t < nThreads; t++)
+        threads[t].join();
+}
+
+  // Have each of nThreads threads count nWords words, drawn from nUnique
+  // distinct ones with the low numbers far more common, into its own
+  // HashBag, then merge the counts into one bag, first with combine and
+  // then with combineParallel.
+
+void mergeWordCounts(int nUnique, int nWords, int nThreads)
+{
+    vector<HashBag<string> > counts(nThreads);
+    vector<thread> threads;
+    for (int t = 0; t < nThreads; t++)
+    {
+        threads.push_back(thread([&, t]() {
+            unsigned seed = t + 1;
+            for (int k = 0; k < nWords; k++)
+            {
+                seed = seed * 1103515245 + 12345;
+                unsigned r = (seed >> 8) % unsigned(nUnique);
+                counts[t].insert(makeItem(int(r * (r % 16 + 1) / 16)));
+            }
+        }));
+    }
+    for (int t = 0; t < nThreads; t++)
+        threads[t].join();
+
+    TimerType start = getTimer();
+    HashBag<string> merged;
+    for (int t = 0; t < nThreads; t++)
+        combine(merged, counts[t], merged);
+    TimerType end = getTimer();
+    report("merge word counts, combine", interval(start, end));
+    assert(merged.size() == nWords * nThreads);
+
+      // (With clock(), this reports processor time summed over threads.)
+    start = getTimer();
+    HashBag<string> mergedInParallel;
+    combineParallel(counts, mergedInParallel, nThreads);
+    end = getTimer();
+    report("merge word counts, combineParallel", interval(start, end));
+    assert(mergedInParallel.size() == merged.size()  &&
+           mergedInParallel.uniqueSize() == merged.uniqueSize());
+}
+
+int main(int argc, char* argv[])
+{
+    int nUnique = (argc > 1 ? atoi(argv[1]) : 1000);
+    int nThreads = (argc > 2 ? atoi(argv[2]) : 4);
+    if (nUnique <= 0  ||  nThreads <= 0)
+    {
+        cout << "usage: " << argv[0] << " [uniqueItems] [threads]" << endl;
+        return 1;
+    }
+
+      // Bag searches its list on every insert and erase, so keep the
+      // number of rounds proportional to 1/nUnique
+    int rounds = int(2000000000LL / nUnique / nUnique) + 1;
+    int copies = int(10000000LL / nUnique) + 1;
+
+    TimerType start;
+    TimerType end;
+
+    start = getTimer();
+    assert(churn<PoolBag>(nUnique, rounds, 1) == nUnique);
+    end = getTimer();
+    report("erase/insert churn, pool", interval(start, end));
+
+    start = getTimer();
+    assert(churn<HeapBag>(nUnique, rounds, 1) == nUnique);
+    end = getTimer();
+    report("erase/insert churn, heap", interval(start, end));
+
+    start = getTimer();
+    assert(copyAndDestroy<PoolBag>(nUnique, copies) == nUnique * copies);
+    end = getTimer();
+    report("copy and destroy, pool", interval(start, end));
+
+    start = getTimer();
+    assert(copyAndDestroy<HeapBag>(nUnique, copies) == nUnique * copies);
+    end = getTimer();
+    report("copy and destroy, heap", interval(start, end));
+
+    start = getTimer();
+    assert(churn<HashBag<int> >(nUnique, rounds, 1) == nUnique);
+    end = getTimer();
+    report("erase/insert churn, hash", interval(start, end));
+
+    start = getTimer();
+    assert(copyAndDestroy<HashBag<int> >(nUnique, copies) == nUnique * copies);
+    end = getTimer();
+    report("copy and destroy, hash", interval(start, end));
+
+    start = getTimer();
+    assert(copyAndDestroy<CowBag<int> >(nUnique, copies) == nUnique * copies);
+    end = getTimer();
+    report("copy and destroy, copy-on-write", interval(start, end));
+
+    start = getTimer();
+    assert(copyChangeAndDestroy<PoolBag>(nUnique, copies) == nUnique * copies);
+    end = getTimer();
+    report("copy, change and destroy, pool", interval(start, end));
+
+    start = getTimer();
+    assert(copyChangeAndDestroy<CowBag<int> >(nUnique, copies) == nUnique * copies);
+    end = getTimer();
+    report("copy, change and destroy, copy-on-write", interval(start, end));
+
+      // (With clock(), these report processor time summed over threads.)
+
+    start = getTimer();
+    churnInThreads<PoolBag>(nUnique, rounds, nThreads);
+    end = getTimer();
+    report("erase/insert churn in threads, pool", interval(start, end));
+
+    start = getTimer();
+    churnInThreads<HeapBag>(nUnique, rounds, nThreads);
+    end = getTimer();
+    report("erase/insert churn in threads, heap", interval(start, end));
+
+    countStringInserts(nUnique);
+    mergeWordCounts(nUnique, 1000000, nThreads);
+}
@@ -0,0 +1,353 @@
+// CowBag.h
+
+#ifndef COWBAG_INCLUDED
+#define COWBAG_INCLUDED
+
+#include <cstddef>
+#include <atomic>
+#include <utility>
+#include "bag.h"
+
+  // A CowBag has the same interface as a Bag, but copies of it share one
+  // bag (a Bag by default, or a HashBag, say) until one of them changes.
+  // Copying, assigning, or passing a CowBag by value just counts one more
+  // CowBag sharing the items, so it takes constant time.  The first change
+  // to a CowBag that shares its items (insert, erase, and so on) copies
+  // them all, and later changes to it are made in place.  Lookups and
+  // iteration never copy, and neither do erases of items that aren't
+  // there.  CowBags sharing items may be used in different threads at
+  // once; the count of sharers is atomic.
+
+template<class ItemType, class BagType = Bag<ItemType> >
+class CowBag
+{
+  public:
+    CowBag();            // Create an empty bag.
+    bool empty() const;  // Return true if the bag is empty, otherwise false.
+
+    int size() const;
+      // Return the number of items in the bag.  For example, the size
+      // of a bag containing "cumin", "cumin", "cumin", "turmeric" is 4.
+
+    int uniqueSize() const;
+      // Return the number of distinct items in the bag.  For example,
+      // the uniqueSize of a bag containing "cumin", "cumin", "cumin",
+      // "turmeric" is 2.
+
+    bool insert(const ItemType& value);
+    bool insert(ItemType&& value);
+    template<class... Args>
+    bool emplace(Args&&... args);
+      // As in the bag that holds the items.
+
+    int erase(const ItemType& value);
+      // Remove one instance of value from the bag if present.
+      // Return the number of instances removed, which will be 1 or 0.
+
+    int eraseAll(const ItemType& value);
+      // Remove all instances of value from the bag if present.
+      // Return the number of instances removed.
+
+    bool contains(const ItemType& value) const;
+      // Return true if the value is in the bag, otherwise false.
+
+    int count(const ItemType& value) const;
+      // Return the number of instances of value in the bag.
+
+    void swap(CowBag& other);
+      // Exchange the contents of this bag with the other one.
+
+      // Iteration functions
+    void start();                          // start an iteration
+    void next();                           // advance to next item
+    bool ended() const;                    // iteration has passed end
+    const ItemType& currentValue() const;  // item at current position
+    int currentCount() const;              // count of current item
+
+      // Iterators are those of the bag that holds the items.  Inserting or
+      // erasing invalidates every iterator.
+    typedef typename BagType::const_iterator const_iterator;
+    typedef const_iterator iterator;
+    const_iterator begin() const;
+    const_iterator end() const;
+
+      // Housekeeping functions
+    ~CowBag();
+    CowBag(const CowBag& other);
+    CowBag(CowBag&& other);
+    CowBag& operator=(const CowBag& rhs);
+    CowBag& operator=(CowBag&& rhs);
+      // A bag that has been moved from is usable:  the move constructor
+      // leaves it empty, and move assignment swaps, so after a = move(b),
+      // b holds what a held.
+
+  private:
+      // Representation:
+      //   m_shared points to the items and the number of CowBags sharing
+      //   them, or is NULL if the bag is empty.  Items whose m_refs is 1
+      //   belong to this CowBag alone and may be changed; any others are
+      //   never changed, and own() gives the CowBag a copy of them first.
+      //   m_current is the position of the iteration functions in the
+      //   items.
+
+    struct Shared
+    {
+        BagType          m_bag;
+        std::atomic<int> m_refs;
+
+        Shared() : m_refs(1) {}
+        Shared(const BagType& bag) : m_bag(bag), m_refs(1) {}
+    };
+
+    Shared*        m_shared;
+    const_iterator m_current;
+
+    static void retain(Shared* p)
+    {
+        if (p != NULL)
+            p->m_refs.fetch_add(1, std::memory_order_relaxed);
+    }
+    static void release(Shared* p)
+    {
+          // The last CowBag to let go deletes the items, after every change
+          // the others made to them is visible
+        if (p != NULL  &&  p->m_refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            delete p;
+    }
+    const BagType& items() const
+    {
+        static const BagType none;
+        return m_shared == NULL ? none : m_shared->m_bag;
+    }
+    BagType& own();
+      // Return the items, first copying them if another CowBag shares them
+
+    template<class T, class B>
+    friend void combine(const CowBag<T, B>& b1, const CowBag<T, B>& b2, CowBag<T, B>& result);
+    template<class T, class B>
+    friend void subtract(const CowBag<T, B>& b1, const CowBag<T, B>& b2, CowBag<T, B>& result);
+};
+
+// Declarations of non-member functions
+
+template<class ItemType, class BagType>
+void combine(const CowBag<ItemType, BagType>& b1, const CowBag<ItemType, BagType>& b2, CowBag<ItemType, BagType>& result);
+      // If a value occurs n1 times in b1 and n2 times in b2, then
+      // it will occur n1+n2 times in result upon return from this function.
+      // If either bag is empty, result shares the items of the other.
+
+template<class ItemType, class BagType>
+void subtract(const CowBag<ItemType, BagType>& b1, const CowBag<ItemType, BagType>& b2, CowBag<ItemType, BagType>& result);
+      // If a value occurs n1 times in b1 and n2 times in b2, then
+      // it will occur n1-n2 times in result upon return from this function
+      // if n1 >= n2.  If n1 <= n2, it will not occur in result.  If b2 is
+      // empty, result shares the items of b1.
+
+// Inline implementations
+
+template<class ItemType, class BagType>
+inline CowBag<ItemType, BagType>::CowBag()
+ : m_shared(NULL)
+{
+}
+
+template<class ItemType, class BagType>
+inline CowBag<ItemType, BagType>::~CowBag()
+{
+    release(m_shared);
+}
+
+template<class ItemType, class BagType>
+inline CowBag<ItemType, BagType>::CowBag(const CowBag& other)
+ : m_shared(other.m_shared)
+{
+    retain(m_shared);
+}
+
+template<class ItemType, class BagType>
+inline CowBag<ItemType, BagType>::CowBag(CowBag&& other)
+ : m_shared(other.m_shared)
+{
+    other.m_shared = NULL;
+}
+
+template<class ItemType, class BagType>
+inline CowBag<ItemType, BagType>& CowBag<ItemType, BagType>::operator=(const CowBag& rhs)
+{
+    retain(rhs.m_shared);  // before the release, in case this is rhs
+    release(m_shared);
+    m_shared = rhs.m_shared;
+    return *this;
+}
+
+template<class ItemType, class BagType>
+inline CowBag<ItemType, BagType>& CowBag<ItemType, BagType>::operator=(CowBag&& rhs)
+{
+    swap(rhs);
+    return *this;
+}
+
+template<class ItemType, class BagType>
+inline int CowBag<ItemType, BagType>::size() const
+{
+    return items().size();
+}
+
+template<class ItemType, class BagType>
+inline int CowBag<ItemType, BagType>::uniqueSize() const
+{
+    return items().uniqueSize();
+}
+
+template<class ItemType, class BagType>
+inline bool CowBag<ItemType, BagType>::empty() const
+{
+    return size() == 0;
+}
+
+template<class ItemType, class BagType>
+inline bool CowBag<ItemType, BagType>::insert(const ItemType& value)
+{
+    return own().insert(value);
+}
+
+template<class ItemType, class BagType>
+inline bool CowBag<ItemType, BagType>::insert(ItemType&& value)
+{
+    return own().insert(std::move(value));
+}
+
+template<class ItemType, class BagType>
+template<class... Args>
+inline bool CowBag<ItemType, BagType>::emplace(Args&&... args)
+{
+    return own().emplace(std::forward<Args>(args)...);
+}
+
+template<class ItemType, class BagType>
+inline int CowBag<ItemType, BagType>::erase(const ItemType& value)
+{
+    if (!items().contains(value))  // not found; copy nothing
+        return 0;
+    return own().erase(value);
+}
+
+template<class ItemType, class BagType>
+inline int CowBag<ItemType, BagType>::eraseAll(const ItemType& value)
+{
+    if (!items().contains(value))  // not found; copy nothing
+        return 0;
+    return own().eraseAll(value);
+}
+
+template<class ItemType, class BagType>
+inline bool CowBag<ItemType, BagType>::contains(const ItemType& value) const
+{
+    return items().contains(value);
+}
+
+template<class ItemType, class BagType>
+inline int CowBag<ItemType, BagType>::count(const ItemType& value) const
+{
+    return items().count(value);
+}
+
+template<class ItemType, class BagType>
+inline void CowBag<ItemType, BagType>::swap(CowBag& other)
+{
+    std::swap(m_shared, other.m_shared);
+}
+
+  // The iteration functions use an iterator of their own, so they never
+  // change the shared items' iteration state
+
+template<class ItemType, class BagType>
+inline void CowBag<ItemType, BagType>::start()
+{
+    m_current = items().begin();
+}
+
+template<class ItemType, class BagType>
+inline void CowBag<ItemType, BagType>::next()
+{
+    ++m_current;
+}
+
+template<class ItemType, class BagType>
+inline bool CowBag<ItemType, BagType>::ended() const
+{
+    return m_current == items().end();
+}
+
+template<class ItemType, class BagType>
+inline const ItemType& CowBag<ItemType, BagType>::currentValue() const
+{
+    return *m_current;
+}
+
+template<class ItemType, class BagType>
+inline int CowBag<ItemType, BagType>::currentCount() const
+{
+    return m_current.count();
+}
+
+template<class ItemType, class BagType>
+inline typename CowBag<ItemType, BagType>::const_iterator CowBag<ItemType, BagType>::begin() const
+{
+    return items().begin();
+}
+
+template<class ItemType, class BagType>
+inline typename CowBag<ItemType, BagType>::const_iterator CowBag<ItemType, BagType>::end() const
+{
+    return items().end();
+}
+
+template<class ItemType, class BagType>
+BagType& CowBag<ItemType, BagType>::own()
+{
+      // The acquire load makes the changes of a CowBag that just let go of
+      // the items visible before this one changes them in place
+
+    if (m_shared == NULL)
+        m_shared = new Shared;
+    else if (m_shared->m_refs.load(std::memory_order_acquire) != 1)
+    {
+        Shared* copy = new Shared(m_shared->m_bag);
+        release(m_shared);
+        m_shared = copy;
+    }
+    return m_shared->m_bag;
+}
+
+template<class ItemType, class BagType>
+void combine(const CowBag<ItemType, BagType>& b1, const CowBag<ItemType, BagType>& b2, CowBag<ItemType, BagType>& result)
+{
+    if (b2.empty())
+        result = b1;
+    else if (b1.empty())
+        result = b2;
+    else
+    {
+          // Build the answer in res, in case result is b1 or b2
+        CowBag<ItemType, BagType> res;
+        combine(b1.items(), b2.items(), res.own());
+        result.swap(res);
+    }
+}
+
+template<class ItemType, class BagType>
+void subtract(const CowBag<ItemType, BagType>& b1, const CowBag<ItemType, BagType>& b2, CowBag<ItemType, BagType>& result)
+{
+    if (b2.empty())
+        result = b1;
+    else
+    {
+        CowBag<ItemType, BagType> res;
+        if (!b1.empty()  &&  b1.m_shared != b2.m_shared)  // else nothing is left
+            subtract(b1.items(), b2.items(), res.own());
+        result.swap(res);
+    }
+}
+
+#endif // COWBAG_INCLUDED
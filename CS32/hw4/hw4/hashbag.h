@@ -0,0 +1,610 @@
+// HashBag.h
+
+#ifndef HASHBAG_INCLUDED
+#define HASHBAG_INCLUDED
+
+#include <cstddef>
+#include <vector>
+#include <functional>
+#include <algorithm>
+#include <iterator>
+#include <thread>
+#include <utility>
+
+  // A HashBag has the same interface as a Bag, but it keeps each distinct
+  // item and its count in a dense array indexed by an open-addressing hash
+  // table, so insert, erase, contains and count take constant expected
+  // time, and combine and subtract take time proportional to the sum of
+  // the sizes.  Items need std::hash<ItemType> and operator==.
+  // combineParallel merges many bags at once, say the word counts of the
+  // threads that each scanned part of a text.
+
+template<class ItemType>
+class HashBag
+{
+  public:
+    HashBag();           // Create an empty bag.
+    bool empty() const;  // Return true if the bag is empty, otherwise false.
+
+    int size() const;
+      // Return the number of items in the bag.  For example, the size
+      // of a bag containing "cumin", "cumin", "cumin", "turmeric" is 4.
+
+    int uniqueSize() const;
+      // Return the number of distinct items in the bag.  For example,
+      // the uniqueSize of a bag containing "cumin", "cumin", "cumin",
+      // "turmeric" is 2.
+
+    bool insert(const ItemType& value);
+    bool insert(ItemType&& value);
+      // Insert value into the bag.  Return true if the value was
+      // actually inserted.  (Like a linked list implementation, a
+      // HashBag has no fixed capacity, so insert always returns true.)
+      // The second form moves value into the bag instead of copying it if
+      // it isn't already there.
+
+    template<class... Args>
+    bool emplace(Args&&... args);
+      // Insert the item constructed from args.  (The item must exist to
+      // be hashed, so if the bag already contains it, the new one is built
+      // and then thrown away.)
+
+    int erase(const ItemType& value);
+      // Remove one instance of value from the bag if present.
+      // Return the number of instances removed, which will be 1 or 0.
+
+    int eraseAll(const ItemType& value);
+      // Remove all instances of value from the bag if present.
+      // Return the number of instances removed.
+
+    bool contains(const ItemType& value) const;
+      // Return true if the value is in the bag, otherwise false.
+
+    int count(const ItemType& value) const;
+      // Return the number of instances of value in the bag.
+
+    void swap(HashBag& other);
+      // Exchange the contents of this bag with the other one.
+
+      // Iteration functions
+    void start();                          // start an iteration
+    void next();                           // advance to next item
+    bool ended() const;                    // iteration has passed end
+    const ItemType& currentValue() const;  // item at current position
+    int currentCount() const;              // count of current item
+
+      // Iterators visit each distinct item once, in the same order as the
+      // iteration functions but without disturbing them.  *it is a
+      // reference to the item, and it.count() is how many instances of it
+      // the bag holds.  Items can't be changed through an iterator.
+      // Inserting or erasing invalidates every iterator.
+    class const_iterator;  // random access
+    typedef const_iterator iterator;
+    const_iterator begin() const;
+    const_iterator end() const;
+
+      // Housekeeping functions (the vectors do the copying and destruction)
+    HashBag(const HashBag& other) = default;
+    HashBag& operator=(const HashBag& rhs) = default;
+    HashBag(HashBag&& other);
+    HashBag& operator=(HashBag&& rhs);
+      // A bag that has been moved from is usable:  the move constructor
+      // leaves it empty, and move assignment swaps, so after a = move(b),
+      // b holds what a held.
+
+  private:
+      // Representation:
+      //   m_entries holds each distinct item with its count (always at
+      //   least 1) and its hash, with no gaps.  Erasing the last instance
+      //   of an item moves the last entry into its place.
+      //   m_slots is a table of linear-probing slots whose size is a power
+      //   of 2 and at least twice the number of entries.  Each slot is
+      //   EMPTY or the index in m_entries of an item whose home slot is at
+      //   or cyclically before it, with no EMPTY slot in between.  Erasing
+      //   shifts later slots back instead of leaving tombstones, so a
+      //   failed search stops at the first EMPTY slot.
+      //   m_current is the index of the current entry during an iteration,
+      //   or -1 when the iteration has been invalidated.
+
+    struct Entry
+    {
+        ItemType m_value;
+        int      m_count;
+        size_t   m_hash;  // saved so growing the table needn't rehash items
+
+        Entry(size_t hash, int count, const ItemType& value)
+         : m_value(value), m_count(count), m_hash(hash)
+        {}
+        Entry(size_t hash, int count, ItemType&& value)
+         : m_value(std::move(value)), m_count(count), m_hash(hash)
+        {}
+    };
+
+    static const int EMPTY = -1;
+
+    std::vector<Entry> m_entries;
+    std::vector<int>   m_slots;
+    int                m_size;
+    int                m_current;
+
+    static size_t hashOf(const ItemType& value)
+    {
+          // std::hash of an integer is often the integer itself; mix the
+          // bits so items with a common stride don't share low bits
+        size_t h = std::hash<ItemType>()(value);
+        h ^= h >> 15;
+        h *= 0x2c1b3c6dU;
+        h ^= h >> 12;
+        return h;
+    }
+    size_t mask() const { return m_slots.size() - 1; }
+    size_t findSlot(const ItemType& value, size_t hash) const;
+      // Return the slot holding value's index, or the EMPTY slot where it
+      // would go
+    size_t findSlotOf(int index) const;
+      // Return the slot holding the given entry index
+    void growSlots();
+    void reserve(size_t n);
+      // Make the table big enough for n entries
+    template<class V>
+    void add(V&& value, size_t hash, int n);
+      // Add n instances of value, whose hash is given
+    int doErase(const ItemType& value, bool all);
+      // Remove one or all instances of value from the bag if present,
+      // depending on the second parameter.  Return the number of instances
+      // removed.
+    void adopt(std::vector<HashBag>& parts);
+      // Take the entries of all the parts, which have disjoint items
+    static size_t partition(size_t hash, int nParts)
+    {
+          // the low bits pick the slot, so use higher ones here
+        return (hash >> 20) % nParts;
+    }
+
+    template<class T>
+    friend void combine(const HashBag<T>& b1, const HashBag<T>& b2, HashBag<T>& result);
+    template<class T>
+    friend void subtract(const HashBag<T>& b1, const HashBag<T>& b2, HashBag<T>& result);
+    template<class T>
+    friend void combineParallel(const std::vector<HashBag<T> >& bags, HashBag<T>& result, int nThreads);
+};
+
+template<class ItemType>
+class HashBag<ItemType>::const_iterator
+{
+  public:
+    typedef std::random_access_iterator_tag iterator_category;
+    typedef ItemType                        value_type;
+    typedef std::ptrdiff_t                  difference_type;
+    typedef const ItemType*                 pointer;
+    typedef const ItemType&                 reference;
+
+    const_iterator() : m_entry(NULL) {}
+
+    const ItemType& operator*() const { return m_entry->m_value; }
+    const ItemType* operator->() const { return &m_entry->m_value; }
+    const ItemType& operator[](difference_type n) const { return m_entry[n].m_value; }
+    int count() const { return m_entry->m_count; }
+
+    const_iterator& operator++() { ++m_entry; return *this; }
+    const_iterator& operator--() { --m_entry; return *this; }
+    const_iterator operator++(int) { const_iterator old(*this); ++m_entry; return old; }
+    const_iterator operator--(int) { const_iterator old(*this); --m_entry; return old; }
+    const_iterator& operator+=(difference_type n) { m_entry += n; return *this; }
+    const_iterator& operator-=(difference_type n) { m_entry -= n; return *this; }
+    const_iterator operator+(difference_type n) const { return const_iterator(m_entry + n); }
+    const_iterator operator-(difference_type n) const { return const_iterator(m_entry - n); }
+    friend const_iterator operator+(difference_type n, const const_iterator& it) { return it + n; }
+    difference_type operator-(const const_iterator& other) const { return m_entry - other.m_entry; }
+
+    bool operator==(const const_iterator& other) const { return m_entry == other.m_entry; }
+    bool operator!=(const const_iterator& other) const { return m_entry != other.m_entry; }
+    bool operator<(const const_iterator& other) const  { return m_entry < other.m_entry; }
+    bool operator>(const const_iterator& other) const  { return m_entry > other.m_entry; }
+    bool operator<=(const const_iterator& other) const { return m_entry <= other.m_entry; }
+    bool operator>=(const const_iterator& other) const { return m_entry >= other.m_entry; }
+
+  private:
+    const Entry* m_entry;
+
+    explicit const_iterator(const Entry* p) : m_entry(p) {}
+    friend class HashBag;
+};
+
+// Declarations of non-member functions
+template<class ItemType>
+void combine(const HashBag<ItemType>& b1, const HashBag<ItemType>& b2, HashBag<ItemType>& result);
+      // If a value occurs n1 times in b1 and n2 times in b2, then
+      // it will occur n1+n2 times in result upon return from this function.
+
+template<class ItemType>
+void subtract(const HashBag<ItemType>& b1, const HashBag<ItemType>& b2, HashBag<ItemType>& result);
+      // If a value occurs n1 times in b1 and n2 times in b2, then
+      // it will occur n1-n2 times in result upon return from this function
+      // if n1 >= n2.  If n1 <= n2, it will not occur in result.
+
+template<class ItemType>
+void combineParallel(const std::vector<HashBag<ItemType> >& bags, HashBag<ItemType>& result,
+                     int nThreads = std::thread::hardware_concurrency());
+      // If a value occurs n1, n2, ... times in the bags, then it will occur
+      // n1+n2+... times in result upon return from this function.  The
+      // items are split by hash value into nThreads groups, and each group
+      // is merged in its own thread.  result may be one of the bags.
+
+// Inline implementations
+
+template<class ItemType>
+inline int HashBag<ItemType>::size() const
+{
+    return m_size;
+}
+
+template<class ItemType>
+inline int HashBag<ItemType>::uniqueSize() const
+{
+    return int(m_entries.size());
+}
+
+template<class ItemType>
+inline bool HashBag<ItemType>::empty() const
+{
+    return size() == 0;
+}
+
+template<class ItemType>
+inline bool HashBag<ItemType>::insert(const ItemType& value)
+{
+    add(value, hashOf(value), 1);
+    return true;
+}
+
+template<class ItemType>
+inline bool HashBag<ItemType>::insert(ItemType&& value)
+{
+    size_t hash = hashOf(value);
+    add(std::move(value), hash, 1);
+    return true;
+}
+
+template<class ItemType>
+template<class... Args>
+inline bool HashBag<ItemType>::emplace(Args&&... args)
+{
+    return insert(ItemType(std::forward<Args>(args)...));
+}
+
+template<class ItemType>
+inline int HashBag<ItemType>::erase(const ItemType& value)
+{
+    return doErase(value, false);
+}
+
+template<class ItemType>
+inline int HashBag<ItemType>::eraseAll(const ItemType& value)
+{
+    return doErase(value, true);
+}
+
+template<class ItemType>
+inline bool HashBag<ItemType>::contains(const ItemType& value) const
+{
+    return m_slots[findSlot(value, hashOf(value))] != EMPTY;
+}
+
+template<class ItemType>
+inline int HashBag<ItemType>::count(const ItemType& value) const
+{
+    int index = m_slots[findSlot(value, hashOf(value))];
+    return index == EMPTY ? 0 : m_entries[index].m_count;
+}
+
+template<class ItemType>
+inline void HashBag<ItemType>::start()
+{
+    m_current = 0;
+}
+
+template<class ItemType>
+inline void HashBag<ItemType>::next()
+{
+    m_current++;
+}
+
+template<class ItemType>
+inline bool HashBag<ItemType>::ended() const
+{
+    return m_current == int(m_entries.size());
+}
+
+template<class ItemType>
+inline const ItemType& HashBag<ItemType>::currentValue() const
+{
+    return m_entries[m_current].m_value;
+}
+
+template<class ItemType>
+inline int HashBag<ItemType>::currentCount() const
+{
+    return m_entries[m_current].m_count;
+}
+
+template<class ItemType>
+inline typename HashBag<ItemType>::const_iterator HashBag<ItemType>::begin() const
+{
+    return const_iterator(m_entries.data());
+}
+
+template<class ItemType>
+inline typename HashBag<ItemType>::const_iterator HashBag<ItemType>::end() const
+{
+    return const_iterator(m_entries.data() + m_entries.size());
+}
+
+template<class ItemType>
+const int HashBag<ItemType>::EMPTY;
+
+// As with Bag, to help clients detect any reliance on undefined iteration
+// behavior, m_current is set to -1 whenever the state of the iteration is
+// not defined.
+
+template<class ItemType>
+HashBag<ItemType>::HashBag()
+ : m_slots(16, EMPTY), m_size(0), m_current(-1)
+{
+}
+
+template<class ItemType>
+HashBag<ItemType>::HashBag(HashBag&& other)
+ : m_entries(std::move(other.m_entries)), m_slots(16, EMPTY), m_size(other.m_size), m_current(-1)
+{
+      // The other bag keeps a fresh empty table, since an empty m_slots
+      // has no mask
+    m_slots.swap(other.m_slots);
+    other.m_entries.clear();
+    other.m_size = 0;
+    other.m_current = -1;
+}
+
+template<class ItemType>
+inline HashBag<ItemType>& HashBag<ItemType>::operator=(HashBag&& rhs)
+{
+    swap(rhs);
+    return *this;
+}
+
+template<class ItemType>
+void HashBag<ItemType>::swap(HashBag& other)
+{
+    m_entries.swap(other.m_entries);
+    m_slots.swap(other.m_slots);
+    std::swap(m_size, other.m_size);
+
+      // iterator state after swap is undefined.  Invalidate iteration.
+    m_current = -1;
+    other.m_current = -1;
+}
+
+template<class ItemType>
+size_t HashBag<ItemType>::findSlot(const ItemType& value, size_t hash) const
+{
+    size_t s = hash & mask();
+    while (m_slots[s] != EMPTY  &&  !(m_entries[m_slots[s]].m_value == value))
+        s = (s + 1) & mask();
+    return s;
+}
+
+template<class ItemType>
+size_t HashBag<ItemType>::findSlotOf(int index) const
+{
+    size_t s = m_entries[index].m_hash & mask();
+    while (m_slots[s] != index)
+        s = (s + 1) & mask();
+    return s;
+}
+
+template<class ItemType>
+void HashBag<ItemType>::growSlots()
+{
+      // Double the table and put each entry back in its new probe run
+
+    std::vector<int> newSlots(2 * m_slots.size(), EMPTY);
+    m_slots.swap(newSlots);
+    for (size_t k = 0; k != m_entries.size(); k++)
+    {
+        size_t s = m_entries[k].m_hash & mask();
+        while (m_slots[s] != EMPTY)
+            s = (s + 1) & mask();
+        m_slots[s] = int(k);
+    }
+}
+
+template<class ItemType>
+void HashBag<ItemType>::reserve(size_t n)
+{
+    while (2 * n > m_slots.size())
+        growSlots();
+    m_entries.reserve(n);
+}
+
+template<class ItemType>
+template<class V>
+void HashBag<ItemType>::add(V&& value, size_t hash, int n)
+{
+    size_t s = findSlot(value, hash);
+    if (m_slots[s] != EMPTY)  // found
+        m_entries[m_slots[s]].m_count += n;
+    else
+    {
+          // Add the entry first, so the table is untouched if that throws
+        m_entries.push_back(Entry(hash, n, std::forward<V>(value)));
+        if (2 * m_entries.size() > m_slots.size())
+            growSlots();  // puts the new entry in too
+        else
+            m_slots[s] = int(m_entries.size()) - 1;
+    }
+    m_size += n;
+    m_current = -1;  // invalidate iteration -- bag changed
+}
+
+template<class ItemType>
+int HashBag<ItemType>::doErase(const ItemType& value, bool all)
+{
+    size_t s = findSlot(value, hashOf(value));
+    int index = m_slots[s];
+    if (index == EMPTY)  // not found
+        return 0;
+
+    int nErased = (all ? m_entries[index].m_count : 1);  // number to erase
+    m_size -= nErased;
+    m_current = -1;  // invalidate iteration -- bag changed
+
+      // If erasing one, and there are more than one, just decrement
+
+    if (!all  &&  m_entries[index].m_count > 1)
+    {
+        m_entries[index].m_count--;
+        return nErased;
+    }
+
+      // Otherwise empty the slot, then walk the rest of the probe run,
+      // moving back into the hole any entry whose home slot doesn't lie
+      // between the hole and where the entry sits now
+
+    size_t hole = s;
+    for (size_t t = (s + 1) & mask(); m_slots[t] != EMPTY; t = (t + 1) & mask())
+    {
+        size_t home = m_entries[m_slots[t]].m_hash & mask();
+        if (((t - home) & mask()) >= ((t - hole) & mask()))
+        {
+            m_slots[hole] = m_slots[t];
+            hole = t;
+        }
+    }
+    m_slots[hole] = EMPTY;
+
+      // Fill the gap in m_entries with the last entry
+
+    int last = int(m_entries.size()) - 1;
+    if (index != last)
+    {
+        m_slots[findSlotOf(last)] = index;
+        m_entries[index] = std::move(m_entries[last]);
+    }
+    m_entries.pop_back();
+    return nErased;
+}
+
+template<class ItemType>
+void HashBag<ItemType>::adopt(std::vector<HashBag>& parts)
+{
+    size_t total = 0;
+    for (size_t p = 0; p != parts.size(); p++)
+        total += parts[p].m_entries.size();
+    reserve(total);
+    for (size_t p = 0; p != parts.size(); p++)
+    {
+        m_entries.insert(m_entries.end(), std::make_move_iterator(parts[p].m_entries.begin()),
+                                          std::make_move_iterator(parts[p].m_entries.end()));
+        m_size += parts[p].m_size;
+        std::vector<Entry>().swap(parts[p].m_entries);  // free it now
+    }
+
+      // Every entry is new to the table, so there's nothing to compare;
+      // just put each index in the first free slot of its probe run
+
+    for (size_t k = 0; k != m_entries.size(); k++)
+    {
+        size_t s = m_entries[k].m_hash & mask();
+        while (m_slots[s] != EMPTY)
+            s = (s + 1) & mask();
+        m_slots[s] = int(k);
+    }
+    m_current = -1;
+}
+
+template<class ItemType>
+void combine(const HashBag<ItemType>& b1, const HashBag<ItemType>& b2, HashBag<ItemType>& result)
+{
+      // Guard against the case that result is an alias for b1 or b2 by
+      // building the answer in a local variable res.  Each item of b2 is
+      // looked up with the hash saved with it.
+
+    HashBag<ItemType> res(b1);
+    res.reserve(b1.m_entries.size() + b2.m_entries.size());
+    for (size_t k = 0; k != b2.m_entries.size(); k++)
+    {
+        const typename HashBag<ItemType>::Entry& e = b2.m_entries[k];
+        res.add(e.m_value, e.m_hash, e.m_count);
+    }
+    result.swap(res);
+}
+
+template<class ItemType>
+void subtract(const HashBag<ItemType>& b1, const HashBag<ItemType>& b2, HashBag<ItemType>& result)
+{
+    HashBag<ItemType> res;
+    res.reserve(b1.m_entries.size());
+    for (size_t k = 0; k != b1.m_entries.size(); k++)
+    {
+        const typename HashBag<ItemType>::Entry& e = b1.m_entries[k];
+        int index = b2.m_slots[b2.findSlot(e.m_value, e.m_hash)];
+        int n = e.m_count - (index == HashBag<ItemType>::EMPTY ? 0 : b2.m_entries[index].m_count);
+        if (n > 0)
+            res.add(e.m_value, e.m_hash, n);
+    }
+    result.swap(res);
+}
+
+template<class ItemType>
+void combineParallel(const std::vector<HashBag<ItemType> >& bags, HashBag<ItemType>& result, int nThreads)
+{
+    if (nThreads < 1)
+        nThreads = 1;
+
+      // First each thread s deals the entries of its own slice of every bag
+      // into buckets by partition, so that between them the threads look at
+      // each entry once.  Then thread t adds up the entries in partition t.
+      // Equal items have equal hashes, so each item is counted by exactly
+      // one thread, and the parts have no items in common.
+
+    typedef typename HashBag<ItemType>::Entry Entry;
+    typedef std::vector<std::vector<const Entry*> > Buckets;  // by partition
+    std::vector<Buckets> buckets(nThreads, Buckets(nThreads));
+    std::vector<std::thread> threads;
+    for (int s = 0; s < nThreads; s++)
+    {
+        threads.push_back(std::thread([&, s]() {
+            for (size_t b = 0; b != bags.size(); b++)
+            {
+                const std::vector<Entry>& entries = bags[b].m_entries;
+                size_t n = entries.size();
+                for (size_t k = n * s / nThreads; k != n * (s+1) / nThreads; k++)
+                    buckets[s][HashBag<ItemType>::partition(entries[k].m_hash, nThreads)].push_back(&entries[k]);
+            }
+        }));
+    }
+    for (int s = 0; s < nThreads; s++)
+        threads[s].join();
+
+    std::vector<HashBag<ItemType> > parts(nThreads);
+    threads.clear();
+    for (int t = 0; t < nThreads; t++)
+    {
+        threads.push_back(std::thread([&, t]() {
+            for (int s = 0; s < nThreads; s++)
+            {
+                const std::vector<const Entry*>& b = buckets[s][t];
+                for (size_t k = 0; k != b.size(); k++)
+                    parts[t].add(b[k]->m_value, b[k]->m_hash, b[k]->m_count);
+            }
+        }));
+    }
+    for (int t = 0; t < nThreads; t++)
+        threads[t].join();
+
+    HashBag<ItemType> res;
+    res.adopt(parts);
+    result.swap(res);
+}
+
+#endif // HASHBAG_INCLUDED
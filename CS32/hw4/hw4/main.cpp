@@ -1,9 +1,13 @@
 //TEST FUNCTIONS DO NOT TURN IN
 
 #include "Bag.h"
+#include "hashbag.h"
+#include "cowbag.h"
 #include <iostream>
 #include <string>
 #include <cassert>
+#include <algorithm>
+#include <vector>
 using namespace std;
 
 int main()
@@ -32,5 +36,154 @@ int main()
     combine(bs,bs2,bs);
     subtract(bi,bi,bi);
     subtract(bs,bs2,bs);
+
+      // the same bag with nodes straight from the heap
+    Bag<int, allocator<int> > bh;
+    for (int k = 0; k < 1000; k++)
+        assert(bh.insert(k % 100));
+    assert(bh.uniqueSize() == 100 && bh.count(7) == 10);
+    Bag<int, allocator<int> > bh2(bh);
+    assert(bh2.eraseAll(7) == 10 && bh.count(7) == 10);
+    combine(bh, bh2, bh2);
+    assert(bh2.size() == 1990);
+
+      // moving items in, building them in place, and moving bags
+    Bag<string> bm;
+    string word = "a word long enough to need its own buffer";
+    assert(bm.insert(std::move(word)) && word.empty());
+    word = "a word long enough to need its own buffer";
+    assert(bm.insert(std::move(word)) && bm.count("a word long enough to need its own buffer") == 2);
+    assert(bm.emplace(3, 'x') && bm.emplace("xxx") && bm.count("xxx") == 2);
+    assert(bm.size() == 4 && bm.uniqueSize() == 2);
+    Bag<string> bm2(std::move(bm));
+    assert(bm2.size() == 4 && bm.empty() && bm.uniqueSize() == 0);
+    assert(bm.insert("again") && bm.size() == 1);
+    bm = std::move(bm2);
+    assert(bm.size() == 4 && bm.count("xxx") == 2);
+    assert(bm2.size() == 1 && bm2.count("again") == 1);  // move assignment swaps
+
+      // iterators visit each distinct item with its count, leaving the
+      // start/next iteration alone
+    Bag<string> bw;
+    assert(bw.begin() == bw.end());
+    const char* words[] = { "cumin", "turmeric", "cumin", "cumin", "fennel" };
+    for (int k = 0; k < 5; k++)
+        bw.insert(words[k]);
+    bw.start();
+    bw.next();
+    int total = 0;
+    int distinct = 0;
+    for (Bag<string>::const_iterator it = bw.begin(); it != bw.end(); it++)
+    {
+        assert(it.count() == bw.count(*it) && it->size() >= 5);
+        total += it.count();
+        distinct++;
+    }
+    assert(total == bw.size() && distinct == bw.uniqueSize());
+    assert(bw.currentValue() == "turmeric");
+    assert(find(bw.begin(), bw.end(), "fennel") != bw.end() &&
+           find(bw.begin(), bw.end(), "cloves") == bw.end());
+    Bag<string>::const_iterator last = bw.end();
+    assert(*--last == "fennel");
+    string all;
+    for (const string& w : bw)
+        all += w;
+    assert(all == "cuminturmericfennel");  // new items go at the end
+
+      // a HashBag does what a Bag does
+    HashBag<string> hb;
+    assert(hb.empty() && hb.begin() == hb.end());
+    for (int k = 0; k < 5; k++)
+        assert(hb.insert(words[k]));
+    assert(hb.size() == 5 && hb.uniqueSize() == 3 && hb.count("cumin") == 3);
+    assert(hb.emplace(3, 'x') && hb.insert(string("xxx")) && hb.count("xxx") == 2);
+    assert(hb.erase("cumin") == 1 && hb.count("cumin") == 2 && hb.erase("cloves") == 0);
+    assert(hb.eraseAll("turmeric") == 1 && !hb.contains("turmeric"));
+    total = 0;
+    for (hb.start(); !hb.ended(); hb.next())
+        total += hb.currentCount() * (hb.currentValue() == "xxx" ? 10 : 1);
+    assert(total == 2 + 20 + 1);
+    total = 0;
+    for (HashBag<string>::const_iterator it = hb.begin(); it != hb.end(); ++it)
+        total += it.count();
+    assert(total == hb.size() && hb.end() - hb.begin() == hb.uniqueSize());
+
+      // erasing keeps every other item findable, at every table size
+    HashBag<int> hi;
+    for (int k = 0; k < 5000; k++)
+        hi.insert(k % 1000 * 7);
+    for (int k = 0; k < 1000; k += 3)
+        assert(hi.eraseAll(k * 7) == 5);
+    for (int k = 0; k < 1000; k++)
+        assert(hi.count(k * 7) == (k % 3 == 0 ? 0 : 5) && !hi.contains(k * 7 + 1));
+    HashBag<int> hi2(hi);
+    assert(hi2.erase(7) == 1 && hi.count(7) == 5);
+    combine(hi, hi2, hi2);
+    assert(hi2.count(7) == 9 && hi2.count(14) == 10 && hi2.size() == 2 * hi.size() - 1);
+    subtract(hi2, hi, hi2);
+    assert(hi2.count(7) == 4 && hi2.count(14) == 5 && hi2.uniqueSize() == hi.uniqueSize());
+    subtract(hi, hi2, hi2);
+    assert(hi2.size() == 1 && hi2.count(7) == 1);
+    HashBag<int> hi3(std::move(hi2));
+    assert(hi3.size() == 1 && hi2.empty() && hi2.insert(3) && hi2.count(3) == 1);
+    hi3 = std::move(hi2);
+    assert(hi3.count(3) == 1 && hi2.size() == 1 && hi2.count(7) == 1);  // swapped
+
+      // merging many bags in parallel gives the same counts as combine
+    vector<HashBag<int> > parts(6);
+    for (int k = 0; k < 60000; k++)
+        parts[k % 6].insert(k * 7 % 10007);
+    HashBag<int> serial;
+    for (int p = 0; p < 6; p++)
+        combine(serial, parts[p], serial);
+    HashBag<int> parallel;
+    combineParallel(parts, parallel, 4);
+    assert(parallel.size() == 60000 && parallel.uniqueSize() == serial.uniqueSize());
+    for (HashBag<int>::const_iterator it = serial.begin(); it != serial.end(); ++it)
+        assert(parallel.count(*it) == it.count());
+    combineParallel(parts, parts[0]);  // result may be one of the bags
+    assert(parts[0].size() == 60000);
+
+      // copy-on-write bags share their items until one of them changes
+    CowBag<string> cw;
+    for (int k = 0; k < 5; k++)
+        cw.insert(words[k]);
+    CowBag<string> cw2(cw);
+    CowBag<string> cw3;
+    cw3 = cw2;
+    assert(&*cw2.begin() == &*cw.begin() && cw3.count("cumin") == 3);
+    assert(cw3.erase("cloves") == 0 && &*cw3.begin() == &*cw.begin());
+    assert(cw2.insert("cloves") && &*cw2.begin() != &*cw.begin());
+    assert(cw2.uniqueSize() == 4 && cw.uniqueSize() == 3 && !cw3.contains("cloves"));
+    assert(cw3.eraseAll("cumin") == 3 && cw.count("cumin") == 3);
+    total = 0;
+    for (cw.start(); !cw.ended(); cw.next())
+        total += cw.currentCount();
+    assert(total == 5);
+    CowBag<string> cw4;
+    combine(cw, cw4, cw4);  // shares cw's items
+    assert(&*cw4.begin() == &*cw.begin());
+    combine(cw, cw2, cw4);
+    assert(cw4.size() == 11 && cw4.count("cumin") == 6);
+    subtract(cw4, cw, cw4);
+    assert(cw4.size() == 6 && cw4.count("cloves") == 1);
+    subtract(cw, cw, cw);
+    assert(cw.empty() && cw4.size() == 6);
+    CowBag<int, HashBag<int> > ch;
+    ch.insert(1);
+    CowBag<int, HashBag<int> > ch2(std::move(ch));
+    assert(ch.empty() && ch2.count(1) == 1);
+    ch.insert(2);
+    ch2 = std::move(ch);
+    assert(ch2.count(2) == 1 && ch.size() == 1 && ch.count(1) == 1);  // swapped
+
+      // a pool hands back the storage it was given
+    NodePool<double> pool(4);
+    double* p = pool.allocate();
+    pool.deallocate(p);
+    assert(pool.allocate() == p);
+    for (int k = 0; k < 10; k++)
+        pool.allocate();
+    assert(pool.slabCount() == 3);
     cout << "Passed all tests" << endl;
 }
\ No newline at end of file
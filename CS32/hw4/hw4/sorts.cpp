@@ -9,6 +9,8 @@
 #include <string>
 #include <cstdlib>  // for std::rand
 #include <cassert>
+#include <cstdint>  // for uint64_t, uint32_t
+#include <cstring>  // for std::memcpy
 
 using namespace std;
 
@@ -156,6 +158,94 @@ void insertion_sort(vector<Store>& s, bool comp(const Store&, const Store&))
 	}
 }
 
+  // A radix sort for the same order as compareStore.  Each Store gets a key
+  // that compares as unsigned integers the way the Store does: the total's
+  // bits made to sort in descending order, then the id.  (A double and an
+  // id don't both fit in 64 bits without losing order, so the id is kept
+  // beside the key as four more digits, which the sort takes first.)  An
+  // LSD radix sort orders the small (key, id, index) items a byte at a
+  // time, never touching a Store, and then the Stores are moved into their
+  // sorted places once.
+
+struct RadixItem
+{
+    uint64_t key;    // the total, encoded for descending order
+    uint32_t id;     // the id, encoded for ascending order
+    uint32_t index;  // where the Store is in the vector being sorted
+};
+
+  // An unsigned integer that is larger for a smaller d, so that sorting
+  // these keys in increasing order sorts the doubles in decreasing order
+
+inline
+uint64_t descendingKey(double d)
+{
+    if (d == 0)  // -0.0 ties with 0.0
+        d = 0;
+    uint64_t bits;
+    memcpy(&bits, &d, sizeof(bits));
+    const uint64_t signBit = uint64_t(1) << 63;
+    uint64_t ascending = (bits & signBit) ? ~bits : (bits | signBit);
+    return ~ascending;
+}
+
+  // Digits 0 to 3 are the bytes of the id, least significant first;
+  // digits 4 to 11 are the bytes of the key
+
+inline
+unsigned radixDigit(const RadixItem& item, int digit)
+{
+    if (digit < 4)
+        return (item.id >> (8 * digit)) & 0xff;
+    return unsigned(item.key >> (8 * (digit - 4))) & 0xff;
+}
+
+void radix_sort(vector<Store>& s)
+{
+    size_t n = s.size();
+    if (n < 2)
+        return;
+    vector<RadixItem> items(n);
+    for (size_t k = 0; k < n; k++)
+    {
+        items[k].key = descendingKey(s[k].total);
+        items[k].id = uint32_t(s[k].id) ^ 0x80000000u;  // so negative ids come first
+        items[k].index = uint32_t(k);
+    }
+
+      // Each pass is a stable counting sort on one digit.  A digit that
+      // every item has the same value for (the high bytes of the ids, say)
+      // can't change the order, so its pass is skipped.
+
+    vector<RadixItem> buffer(n);
+    for (int digit = 0; digit < 12; digit++)
+    {
+        size_t count[256] = { 0 };
+        for (size_t k = 0; k < n; k++)
+            count[radixDigit(items[k], digit)]++;
+        if (count[radixDigit(items[0], digit)] == n)
+            continue;
+        size_t next = 0;
+        for (int b = 0; b < 256; b++)
+        {
+            size_t c = count[b];
+            count[b] = next;  // now where the first item with this digit goes
+            next += c;
+        }
+        for (size_t k = 0; k < n; k++)
+            buffer[count[radixDigit(items[k], digit)]++] = items[k];
+        items.swap(buffer);
+    }
+
+      // Move each Store once, into its sorted place
+
+    vector<Store> sorted;
+    sorted.reserve(n);
+    for (size_t k = 0; k < n; k++)
+        sorted.push_back(std::move(s[items[k].index]));
+    s.swap(sorted);
+}
+
   // Report the results of a timing test
 void report(string caption, double t, const vector<Store>& s)
 {
@@ -280,4 +370,13 @@ int main()
     endSort = getTimer();
     report("STL sort of pointers", interval(startSort, endSort), stores);
     assert(isSorted(stores));
+
+      // The radix sort on encoded keys.  It compares no Stores at all.
+
+    stores = unorderedStores;
+    startSort = getTimer();
+    radix_sort(stores);
+    endSort = getTimer();
+    report("radix sort of encoded keys", interval(startSort, endSort), stores);
+    assert(isSorted(stores));
 }
\ No newline at end of file
@@ -0,0 +1,444 @@
+#ifndef CONCURRENTSKIPLIST_H
+#define CONCURRENTSKIPLIST_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <iterator>
+#include <atomic>
+#include <thread>
+#include <new>
+
+//A sorted set, like SortedLinkedList, that any number of threads may use at
+//once.  It is a skip list: every item is in the bottom list, and each list
+//above it skips about half the items of the one below, so insert, contains
+//and remove take O(log n) expected time instead of O(n).
+//
+//contains() and iteration take no locks.  insert() and remove() lock only
+//the few nodes just before the place they change (a "lazy" skip list, as in
+//Herlihy and Shavit, The Art of Multiprocessor Programming, chapter 14), so
+//threads changing different parts of the set don't wait for each other.
+//Those locks are held for a few pointer stores, so each is a one-byte spin
+//lock rather than a std::mutex, which would more than double a node.
+//A removed item is first marked, which removes it as far as every other
+//call is concerned, and then unlinked.
+//
+//Nodes are never freed while the list exists, since a thread may still be
+//walking through one that was just removed; removed nodes are kept and
+//freed by the destructor.  So memory grows with the number of removes.
+//
+//ItemType needs operator< (two items are equal if neither is less than the
+//other) and a default constructor (for the head node).
+
+const int SKIPLIST_MAX_LEVEL = 24; //plenty for 2^24 items
+
+template <typename ItemType>
+class ConcurrentSkipList
+{
+	public:
+		ConcurrentSkipList();
+		~ConcurrentSkipList();
+		ConcurrentSkipList(const ConcurrentSkipList&) = delete;
+		ConcurrentSkipList& operator=(const ConcurrentSkipList&) = delete;
+
+		bool insert(const ItemType& value);
+		//If value is not in the list, insert it and return true.  Otherwise
+		//return false.
+
+		bool contains(const ItemType& value) const;
+		//Return true if value is in the list.
+
+		bool remove(const ItemType& value);
+		//If value is in the list, remove it and return true.  Otherwise
+		//return false.  (Unlike SortedLinkedList, callers never see a Node,
+		//so they can't change a value and break the order.)
+
+		int size() const { return m_size.load(std::memory_order_relaxed); }
+
+		void printIncreasingOrder() const;
+		//Print the items in increasing order, one on each line.
+
+		//Iterators visit the items in increasing order.  Other threads may
+		//insert and remove while one iterates; it sees every item that is in
+		//the list for the whole iteration, and may or may not see the ones
+		//that come and go meanwhile.  Items can't be changed through one.
+		class const_iterator;
+		typedef const_iterator iterator;
+		const_iterator begin() const;
+		const_iterator end() const;
+
+	private:
+		class SpinLock
+		{
+			public:
+				SpinLock() : m_held(false) {}
+				void lock()
+				{
+					//wait without writing, and give up the processor, in case the holder is waiting for it
+					while (m_held.exchange(true, std::memory_order_acquire))
+						while (m_held.load(std::memory_order_relaxed))
+							std::this_thread::yield();
+				}
+				void unlock() { m_held.store(false, std::memory_order_release); }
+			private:
+				std::atomic<bool> m_held;
+		};
+
+		struct Node
+		{
+			ItemType				m_value;
+			int						m_topLevel; //the node is in the lists 0 through m_topLevel
+			SpinLock				m_lock;
+			std::atomic<bool>		m_marked; //removed, though maybe still linked
+			std::atomic<bool>		m_fullyLinked; //in every one of its lists
+			Node*					m_nextRetired; //links the removed nodes
+
+			Node(const ItemType& value, int topLevel)
+			 : m_value(value), m_topLevel(topLevel), m_marked(false), m_fullyLinked(false), m_nextRetired(NULL)
+			{}
+			Node(int topLevel) //the head node
+			 : m_value(), m_topLevel(topLevel), m_marked(false), m_fullyLinked(true), m_nextRetired(NULL)
+			{}
+
+			//the next pointers, one for each level, are allocated right after the node
+			std::atomic<Node*>& next(int level) { return reinterpret_cast<std::atomic<Node*>*>(this + 1)[level]; }
+			const std::atomic<Node*>& next(int level) const { return reinterpret_cast<const std::atomic<Node*>*>(this + 1)[level]; }
+		};
+
+		Node*				m_head; //comes before every item, in every list; a NULL next pointer is the end
+		std::atomic<int>	m_size;
+		std::atomic<int>	m_levels; //the highest list that has ever had an item; searches start there
+		std::atomic<Node*>	m_retired; //removed nodes, freed by the destructor
+
+		template <typename... Args>
+		static Node* newNode(int topLevel, Args&&... args);
+		static void deleteNode(Node* p);
+		static int randomLevel();
+
+		int find(const ItemType& value, Node* preds[], Node* succs[]) const;
+		//Fill preds and succs with the nodes just before and at or after value in
+		//every list, and return the highest level whose list has value in it, or
+		//-1 if none has.
+
+		static void unlock(Node* preds[], int highestLocked);
+		//Unlock the distinct nodes among preds[0] through preds[highestLocked]
+};
+
+template <typename ItemType>
+class ConcurrentSkipList<ItemType>::const_iterator
+{
+	public:
+		typedef std::forward_iterator_tag	iterator_category;
+		typedef ItemType					value_type;
+		typedef std::ptrdiff_t				difference_type;
+		typedef const ItemType*				pointer;
+		typedef const ItemType&				reference;
+
+		const_iterator() : m_node(NULL) {}
+
+		const ItemType& operator*() const { return m_node->m_value; }
+		const ItemType* operator->() const { return &m_node->m_value; }
+		const_iterator& operator++() { m_node = skipRemoved(m_node->next(0).load(std::memory_order_acquire)); return *this; }
+		const_iterator operator++(int) { const_iterator old(*this); ++*this; return old; }
+		bool operator==(const const_iterator& other) const { return m_node == other.m_node; }
+		bool operator!=(const const_iterator& other) const { return m_node != other.m_node; }
+
+	private:
+		const Node* m_node; //NULL at the end
+
+		explicit const_iterator(const Node* p) : m_node(skipRemoved(p)) {}
+		static const Node* skipRemoved(const Node* p)
+		{
+			//skip nodes that are removed or not yet all the way in
+			while (p != NULL && (p->m_marked.load(std::memory_order_acquire) || !p->m_fullyLinked.load(std::memory_order_acquire)))
+				p = p->next(0).load(std::memory_order_acquire);
+			return p;
+		}
+		friend class ConcurrentSkipList;
+};
+
+template <typename ItemType>
+template <typename... Args>
+typename ConcurrentSkipList<ItemType>::Node* ConcurrentSkipList<ItemType>::newNode(int topLevel, Args&&... args)
+{
+	//one allocation holds the node and its topLevel+1 next pointers
+	void* p = ::operator new(sizeof(Node) + (topLevel + 1) * sizeof(std::atomic<Node*>));
+	Node* n;
+	try
+	{
+		n = new (p) Node(std::forward<Args>(args)..., topLevel);
+	}
+	catch (...)
+	{
+		::operator delete(p);
+		throw;
+	}
+	for (int level = 0; level <= topLevel; level++)
+		new (&n->next(level)) std::atomic<Node*>(NULL);
+	return n;
+}
+
+template <typename ItemType>
+void ConcurrentSkipList<ItemType>::deleteNode(Node* p)
+{
+	p->~Node(); //the atomic pointers need no destruction
+	::operator delete(p);
+}
+
+template <typename ItemType>
+int ConcurrentSkipList<ItemType>::randomLevel()
+{
+	//each level up has half the chance of the one below; every thread has its own generator
+	thread_local unsigned long long state = 0x9E3779B97F4A7C15ULL ^ reinterpret_cast<std::uintptr_t>(&state);
+	state ^= state << 13;
+	state ^= state >> 7;
+	state ^= state << 17;
+	int level = 0;
+	unsigned long long bits = state;
+	while ((bits & 1) && level < SKIPLIST_MAX_LEVEL - 1)
+	{
+		level++;
+		bits >>= 1;
+	}
+	return level;
+}
+
+template <typename ItemType>
+ConcurrentSkipList<ItemType>::ConcurrentSkipList()
+ : m_head(newNode(SKIPLIST_MAX_LEVEL - 1)), m_size(0), m_levels(0), m_retired(NULL)
+{
+}
+
+template <typename ItemType>
+ConcurrentSkipList<ItemType>::~ConcurrentSkipList()
+{
+	//free everything still in the bottom list, then everything removed from it
+	Node* p = m_head;
+	while (p != NULL)
+	{
+		Node* next = p->next(0).load(std::memory_order_relaxed);
+		deleteNode(p);
+		p = next;
+	}
+	p = m_retired.load(std::memory_order_relaxed);
+	while (p != NULL)
+	{
+		Node* next = p->m_nextRetired;
+		deleteNode(p);
+		p = next;
+	}
+}
+
+template <typename ItemType>
+int ConcurrentSkipList<ItemType>::find(const ItemType& value, Node* preds[], Node* succs[]) const
+{
+	int levelFound = -1;
+	Node* pred = m_head;
+	Node* stop = NULL; //the node the search stopped at on the level above; it isn't less than value
+	int top = m_levels.load(std::memory_order_acquire);
+	for (int level = SKIPLIST_MAX_LEVEL - 1; level > top; level--)
+	{
+		preds[level] = m_head; //the lists up here are empty
+		succs[level] = NULL;
+	}
+	for (int level = top; level >= 0; level--)
+	{
+		//go right while the next item is smaller, then drop down a level
+		Node* curr = pred->next(level).load(std::memory_order_acquire);
+		while (curr != NULL && curr != stop && curr->m_value < value)
+		{
+			pred = curr;
+			curr = pred->next(level).load(std::memory_order_acquire);
+		}
+		stop = curr;
+		if (levelFound == -1 && curr != NULL && !(value < curr->m_value))
+			levelFound = level;
+		preds[level] = pred;
+		succs[level] = curr;
+	}
+	return levelFound;
+}
+
+template <typename ItemType>
+void ConcurrentSkipList<ItemType>::unlock(Node* preds[], int highestLocked)
+{
+	Node* prevPred = NULL;
+	for (int level = 0; level <= highestLocked; level++)
+	{
+		if (preds[level] != prevPred) //the same node may be the pred at several levels
+		{
+			preds[level]->m_lock.unlock();
+			prevPred = preds[level];
+		}
+	}
+}
+
+template <typename ItemType>
+bool ConcurrentSkipList<ItemType>::insert(const ItemType& value)
+{
+	int topLevel = randomLevel();
+	int levels = m_levels.load(std::memory_order_relaxed);
+	while (levels < topLevel && !m_levels.compare_exchange_weak(levels, topLevel, std::memory_order_acq_rel))
+		;  //raise m_levels first, so every search that could find the new node starts high enough
+	//build the node before taking any locks, so that if allocating it or copying
+	//value throws, no lock is left held; it's kept across retries
+	Node* n = newNode(topLevel, value);
+	Node* preds[SKIPLIST_MAX_LEVEL];
+	Node* succs[SKIPLIST_MAX_LEVEL];
+	for (;;)
+	{
+		int levelFound = find(value, preds, succs);
+		if (levelFound != -1)
+		{
+			Node* found = succs[levelFound];
+			if (!found->m_marked.load(std::memory_order_acquire))
+			{
+				//already there; wait until it's all the way in, so a contains() after this returns true
+				while (!found->m_fullyLinked.load(std::memory_order_acquire))
+					std::this_thread::yield();
+				deleteNode(n); //no other thread ever saw it
+				return false;
+			}
+			std::this_thread::yield();
+			continue; //it's being removed; try again once it's gone
+		}
+
+		//lock the preds from the bottom up and check that nothing changed
+		//between them and their succs since find looked
+		int highestLocked = -1;
+		bool valid = true;
+		Node* prevPred = NULL;
+		for (int level = 0; valid && level <= topLevel; level++)
+		{
+			Node* pred = preds[level];
+			Node* succ = succs[level];
+			if (pred != prevPred)
+			{
+				pred->m_lock.lock();
+				prevPred = pred;
+			}
+			highestLocked = level;
+			valid = !pred->m_marked.load(std::memory_order_acquire) &&
+					(succ == NULL || !succ->m_marked.load(std::memory_order_acquire)) &&
+					pred->next(level).load(std::memory_order_acquire) == succ;
+		}
+		if (!valid)
+		{
+			unlock(preds, highestLocked);
+			continue;
+		}
+
+		//link the new node in from the bottom up; it's in the set once it's in the bottom list
+		for (int level = 0; level <= topLevel; level++)
+			n->next(level).store(succs[level], std::memory_order_relaxed);
+		for (int level = 0; level <= topLevel; level++)
+			preds[level]->next(level).store(n, std::memory_order_release);
+		n->m_fullyLinked.store(true, std::memory_order_release);
+		unlock(preds, highestLocked);
+		m_size.fetch_add(1, std::memory_order_relaxed);
+		return true;
+	}
+}
+
+template <typename ItemType>
+bool ConcurrentSkipList<ItemType>::contains(const ItemType& value) const
+{
+	Node* preds[SKIPLIST_MAX_LEVEL];
+	Node* succs[SKIPLIST_MAX_LEVEL];
+	int levelFound = find(value, preds, succs);
+	return levelFound != -1 &&
+		   succs[levelFound]->m_fullyLinked.load(std::memory_order_acquire) &&
+		   !succs[levelFound]->m_marked.load(std::memory_order_acquire);
+}
+
+template <typename ItemType>
+bool ConcurrentSkipList<ItemType>::remove(const ItemType& value)
+{
+	Node* victim = NULL;
+	bool isMarked = false;
+	int topLevel = -1;
+	Node* preds[SKIPLIST_MAX_LEVEL];
+	Node* succs[SKIPLIST_MAX_LEVEL];
+	for (;;)
+	{
+		int levelFound = find(value, preds, succs);
+		if (!isMarked)
+		{
+			//only a node that's all the way in and not already removed will do
+			if (levelFound == -1)
+				return false;
+			victim = succs[levelFound];
+			if (!victim->m_fullyLinked.load(std::memory_order_acquire) || victim->m_marked.load(std::memory_order_acquire))
+				return false;
+			if (victim->m_topLevel != levelFound)
+				continue; //the search began below its top (m_levels was read just before it rose); look again
+
+			//marking it is what removes it; whoever marks it first wins
+			topLevel = victim->m_topLevel;
+			victim->m_lock.lock();
+			if (victim->m_marked.load(std::memory_order_relaxed))
+			{
+				victim->m_lock.unlock();
+				return false;
+			}
+			victim->m_marked.store(true, std::memory_order_release);
+			isMarked = true;
+		}
+
+		//lock the preds and check they still point at the victim
+		int highestLocked = -1;
+		bool valid = true;
+		Node* prevPred = NULL;
+		for (int level = 0; valid && level <= topLevel; level++)
+		{
+			Node* pred = preds[level];
+			if (pred != prevPred)
+			{
+				pred->m_lock.lock();
+				prevPred = pred;
+			}
+			highestLocked = level;
+			valid = !pred->m_marked.load(std::memory_order_acquire) &&
+					pred->next(level).load(std::memory_order_acquire) == victim;
+		}
+		if (!valid)
+		{
+			unlock(preds, highestLocked);
+			continue;
+		}
+
+		//unlink it from the top down, then keep it for the destructor
+		for (int level = topLevel; level >= 0; level--)
+			preds[level]->next(level).store(victim->next(level).load(std::memory_order_relaxed), std::memory_order_release);
+		victim->m_lock.unlock();
+		unlock(preds, highestLocked);
+
+		Node* retired = m_retired.load(std::memory_order_relaxed);
+		do
+			victim->m_nextRetired = retired;
+		while (!m_retired.compare_exchange_weak(retired, victim, std::memory_order_release, std::memory_order_relaxed));
+		m_size.fetch_sub(1, std::memory_order_relaxed);
+		return true;
+	}
+}
+
+template <typename ItemType>
+void ConcurrentSkipList<ItemType>::printIncreasingOrder() const
+{
+	for (const_iterator it = begin(); it != end(); ++it)
+		std::cout << *it << std::endl;
+}
+
+template <typename ItemType>
+inline typename ConcurrentSkipList<ItemType>::const_iterator ConcurrentSkipList<ItemType>::begin() const
+{
+	return const_iterator(m_head->next(0).load(std::memory_order_acquire));
+}
+
+template <typename ItemType>
+inline typename ConcurrentSkipList<ItemType>::const_iterator ConcurrentSkipList<ItemType>::end() const
+{
+	return const_iterator(NULL);
+}
+
+#endif
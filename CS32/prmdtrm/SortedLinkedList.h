@@ -0,0 +1,118 @@
+#ifndef SORTEDLINKEDLIST_H
+#define SORTEDLINKEDLIST_H
+
+#include <cstddef>
+#include <iostream>
+
+//The SortedLinkedList of the practice midterm (pmdtrm.cpp), working: a sorted
+//set in a doubly linked list, with the midterm's interface.  search hands back
+//the node holding a value, and remove takes such a node.  first() starts a walk
+//through the list in increasing order.  skiplistbench and containerbench both
+//time this one.
+//
+//ItemType needs operator< and operator==.
+
+template <typename ItemType>
+class SortedLinkedList
+{
+	public:
+		struct Node
+		{
+			ItemType	m_value;
+			Node*		m_prev;
+			Node*		m_next;
+		};
+
+		SortedLinkedList() : m_head(NULL), m_tail(NULL), m_size(0) {}
+		~SortedLinkedList();
+		SortedLinkedList(const SortedLinkedList&) = delete;
+		SortedLinkedList& operator=(const SortedLinkedList&) = delete;
+
+		bool insert(const ItemType& value);
+		//If value is not in the list, insert it in order and return true.
+		//Otherwise return false.
+
+		Node* search(const ItemType& value) const;
+		//Return the node holding value, or NULL if there is none.
+
+		void remove(Node* node);
+		//Unlink node, which must be in this list, and delete it.
+
+		int size() const { return m_size; }
+		const Node* first() const { return m_head; } //NULL if the list is empty
+		void printIncreasingOrder() const;
+
+	private:
+		Node*	m_head;
+		Node*	m_tail;
+		int		m_size;
+};
+
+template <typename ItemType>
+SortedLinkedList<ItemType>::~SortedLinkedList()
+{
+	while (m_head != NULL)
+	{
+		Node* next = m_head->m_next;
+		delete m_head;
+		m_head = next;
+	}
+}
+
+template <typename ItemType>
+bool SortedLinkedList<ItemType>::insert(const ItemType& value)
+{
+	Node* after = m_head; //the first node not less than value
+	while (after != NULL && after->m_value < value)
+		after = after->m_next;
+	if (after != NULL && after->m_value == value)
+		return false;
+
+	Node* n = new Node;
+	n->m_value = value;
+	n->m_next = after;
+	n->m_prev = (after != NULL ? after->m_prev : m_tail);
+	if (n->m_prev != NULL)
+		n->m_prev->m_next = n;
+	else
+		m_head = n;
+	if (after != NULL)
+		after->m_prev = n;
+	else
+		m_tail = n;
+	m_size++;
+	return true;
+}
+
+template <typename ItemType>
+typename SortedLinkedList<ItemType>::Node* SortedLinkedList<ItemType>::search(const ItemType& value) const
+{
+	Node* p = m_head;
+	while (p != NULL && p->m_value < value) //the list is sorted, so stop at the first node not less
+		p = p->m_next;
+	return (p != NULL && p->m_value == value ? p : NULL);
+}
+
+template <typename ItemType>
+void SortedLinkedList<ItemType>::remove(Node* node)
+{
+	if (node->m_prev != NULL)
+		node->m_prev->m_next = node->m_next;
+	else
+		m_head = node->m_next;
+	if (node->m_next != NULL)
+		node->m_next->m_prev = node->m_prev;
+	else
+		m_tail = node->m_prev;
+	delete node;
+	m_size--;
+}
+
+template <typename ItemType>
+void SortedLinkedList<ItemType>::printIncreasingOrder() const
+{
+	for (const Node* p = m_head; p != NULL; p = p->m_next)
+		std::cout << p->m_value << std::endl;
+}
+
+#endif // SORTEDLINKEDLIST_H
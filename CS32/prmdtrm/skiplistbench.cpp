@@ -0,0 +1,253 @@
+// Contention benchmark for ConcurrentSkipList.  Build it on its own (it has
+// its own main), e.g.
+//     g++ -O2 -pthread skiplistbench.cpp
+// and run it as
+//     skiplistbench [keys] [maxThreads] [readPercent]
+// For 1, 2, 4, ... up to maxThreads (default 32) threads, the set starts with
+// half of the keys 0 to keys-1 (default 100000), and every thread makes
+// OPS_PER_THREAD calls on randomly chosen keys, readPercent of them
+// contains() and the rest split between insert() and remove().  A last
+// thread scans the set in order the whole time.  (With fewer cores than
+// threads, that scanner takes processor time from the others, and more of it
+// with the skip list, whose scans never wait for a lock.)  It reports the
+// total calls per second (not counting the scanner) for
+//   list+mutex  the SortedLinkedList from the practice midterm, behind one
+//               mutex (only when keys <= MAX_LIST_KEYS, since each call is a
+//               linear search)
+//   set+mutex   a std::set behind one mutex
+//   skiplist    a ConcurrentSkipList
+
+#include "ConcurrentSkipList.h"
+#include "SortedLinkedList.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <set>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <cstdlib>  // for std::atoi
+#include <cassert>
+
+using namespace std;
+
+const int OPS_PER_THREAD = 200000;
+const int MAX_LIST_KEYS = 20000;
+
+//========================================================================
+// TimerType            - a type to hold a timer reading
+// TimerType getTimer() - get the current timer reading
+// double interval(TimerType start, TimerType end) - milliseconds between
+//                                                   two readings
+//
+// Threads run at the same time, so this needs elapsed time; clock() would
+// add up the processor time of every thread.
+//========================================================================
+
+#ifdef _MSC_VER  // If we're compiling for Windows
+
+#include <windows.h>
+
+typedef LARGE_INTEGER TimerType;
+inline TimerType getTimer()
+{
+    LARGE_INTEGER t;
+    QueryPerformanceCounter(&t);
+    return t;
+}
+
+inline double interval(TimerType start, TimerType end)
+{
+    LARGE_INTEGER ticksPerSecond;
+    QueryPerformanceFrequency(&ticksPerSecond);
+    return (1000.0 * (end.QuadPart - start.QuadPart)) / ticksPerSecond.QuadPart;
+}
+
+#else // If we're not compiling for Windows, use the standard steady clock
+
+#include <chrono>
+
+typedef std::chrono::steady_clock::time_point TimerType;
+inline TimerType getTimer() { return std::chrono::steady_clock::now(); }
+inline double interval(TimerType start, TimerType end)
+{
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+#endif  // ifdef _MSC_VER
+
+//========================================================================
+
+  // The SortedLinkedList of the practice midterm, made safe for threads the
+  // simple way
+
+class LockedSortedList
+{
+  public:
+    bool insert(int value)
+    {
+        lock_guard<mutex> guard(m_lock);
+        return m_list.insert(value);
+    }
+    bool contains(int value) const
+    {
+        lock_guard<mutex> guard(m_lock);
+        return m_list.search(value) != NULL;
+    }
+    bool remove(int value)
+    {
+        lock_guard<mutex> guard(m_lock);
+        SortedLinkedList<int>::Node* p = m_list.search(value);
+        if (p == NULL)
+            return false;
+        m_list.remove(p);
+        return true;
+    }
+    long long scan() const  // sum of the items, in increasing order
+    {
+        lock_guard<mutex> guard(m_lock);
+        long long sum = 0;
+        for (const SortedLinkedList<int>::Node* p = m_list.first(); p != NULL; p = p->m_next)
+            sum += p->m_value;
+        return sum;
+    }
+
+  private:
+    mutable mutex         m_lock;
+    SortedLinkedList<int> m_list;
+};
+
+  // A std::set behind one mutex
+
+class LockedSet
+{
+  public:
+    bool insert(int value)
+    {
+        lock_guard<mutex> guard(m_lock);
+        return m_set.insert(value).second;
+    }
+    bool contains(int value) const
+    {
+        lock_guard<mutex> guard(m_lock);
+        return m_set.count(value) != 0;
+    }
+    bool remove(int value)
+    {
+        lock_guard<mutex> guard(m_lock);
+        return m_set.erase(value) != 0;
+    }
+    long long scan() const
+    {
+        lock_guard<mutex> guard(m_lock);
+        long long sum = 0;
+        for (set<int>::const_iterator it = m_set.begin(); it != m_set.end(); ++it)
+            sum += *it;
+        return sum;
+    }
+
+  private:
+    mutable mutex m_lock;
+    set<int>      m_set;
+};
+
+  // The skip list needs no lock, even to scan
+
+class SkipListSet
+{
+  public:
+    bool insert(int value) { return m_list.insert(value); }
+    bool contains(int value) const { return m_list.contains(value); }
+    bool remove(int value) { return m_list.remove(value); }
+    long long scan() const
+    {
+        long long sum = 0;
+        for (ConcurrentSkipList<int>::const_iterator it = m_list.begin(); it != m_list.end(); ++it)
+            sum += *it;
+        return sum;
+    }
+
+  private:
+    ConcurrentSkipList<int> m_list;
+};
+
+  // Report the results of a test
+
+void report(string setKind, int nKeys, int nThreads, double ms)
+{
+    double calls = double(nThreads) * OPS_PER_THREAD;
+    cout << setKind << "," << nKeys << "," << nThreads << ","
+         << (calls / ms * 1000) << endl;
+}
+
+  // Fill s with half the keys, then run nThreads threads of calls on it,
+  // and one more that scans it until they finish; report the calls per
+  // second
+
+template <class SetType>
+void timeSet(string setKind, int nKeys, int nThreads, int readPercent)
+{
+    SetType s;
+    for (int k = 0; k < nKeys; k += 2)
+        assert(s.insert(k));
+
+    atomic<bool> done(false);
+    long long scanned = 0;
+    thread scanner([&]() {
+        while (!done.load())
+            scanned += s.scan();
+    });
+
+    vector<thread> threads;
+    TimerType start = getTimer();
+    for (int t = 0; t < nThreads; t++)
+    {
+        threads.push_back(thread([&, t]() {
+            unsigned seed = 12345 + t;
+            int found = 0;
+            for (int i = 0; i < OPS_PER_THREAD; i++)
+            {
+                seed = seed * 1103515245 + 12345;
+                int key = int((seed >> 8) % unsigned(nKeys));
+                int op = int((seed >> 24) % 100);
+                if (op < readPercent)
+                    found += s.contains(key);
+                else if (op % 2 == 0)
+                    s.insert(key);
+                else
+                    s.remove(key);
+            }
+            if (found < 0)  // never true; keeps the reads from being optimized away
+                cout << found << endl;
+        }));
+    }
+    for (int t = 0; t < nThreads; t++)
+        threads[t].join();
+    TimerType end = getTimer();
+    done = true;
+    scanner.join();
+    report(setKind, nKeys, nThreads, interval(start, end));
+    if (scanned < 0)
+        cout << scanned << endl;
+}
+
+int main(int argc, char* argv[])
+{
+    int nKeys = (argc > 1 ? atoi(argv[1]) : 100000);
+    int maxThreads = (argc > 2 ? atoi(argv[2]) : 32);
+    int readPercent = (argc > 3 ? atoi(argv[3]) : 80);
+    if (nKeys <= 0  ||  maxThreads <= 0  ||  readPercent < 0  ||  readPercent > 100)
+    {
+        cout << "usage: " << argv[0] << " [keys] [maxThreads] [readPercent]" << endl;
+        return 1;
+    }
+
+    cout << "set,keys,threads,calls per second" << endl;
+    for (int nThreads = 1; nThreads <= maxThreads; nThreads *= 2)
+    {
+        if (nKeys <= MAX_LIST_KEYS)
+            timeSet<LockedSortedList>("list+mutex", nKeys, nThreads, readPercent);
+        timeSet<LockedSet>("set+mutex", nKeys, nThreads, readPercent);
+        timeSet<SkipListSet>("skiplist", nKeys, nThreads, readPercent);
+    }
+}
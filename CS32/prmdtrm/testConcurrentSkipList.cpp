@@ -0,0 +1,136 @@
+#include "ConcurrentSkipList.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <set>
+#include <thread>
+#include <cassert>
+
+using namespace std;
+
+void test()
+{
+	ConcurrentSkipList<int> s;
+	assert(s.size() == 0 && s.begin() == s.end());
+	assert(s.insert(30));
+	assert(s.insert(10));
+	assert(s.insert(20));
+	assert(!s.insert(10)); //already there
+	assert(s.size() == 3 && s.contains(20) && !s.contains(15));
+	assert(s.remove(20) && !s.remove(20) && !s.contains(20));
+	assert(s.size() == 2);
+	vector<int> v(s.begin(), s.end());
+	assert(v.size() == 2 && v[0] == 10 && v[1] == 30);
+
+	//agrees with a std::set on lots of random changes, and stays sorted
+	ConcurrentSkipList<string> ss;
+	set<string> expected;
+	unsigned seed = 1;
+	for (int i = 0; i < 20000; i++)
+	{
+		seed = seed * 1103515245 + 12345;
+		string key = to_string((seed >> 8) % 3000);
+		if (seed % 3 == 0)
+			assert(ss.remove(key) == (expected.erase(key) == 1));
+		else
+			assert(ss.insert(key) == expected.insert(key).second);
+	}
+	assert(ss.size() == int(expected.size()));
+	assert(vector<string>(ss.begin(), ss.end()) == vector<string>(expected.begin(), expected.end()));
+}
+
+void testThreads()
+{
+	//threads insert and remove their own items, fight over shared ones, and
+	//scan in order, all at once
+	const int nThreads = 4;
+	const int perThread = 2000;
+	ConcurrentSkipList<int> s;
+	vector<thread> threads;
+	for (int t = 0; t < nThreads; t++)
+	{
+		threads.push_back(thread([&s, t]() {
+			for (int i = 0; i < perThread; i++)
+			{
+				int mine = (i * nThreads + t) * 2 + 1; //odd items belong to one thread
+				assert(s.insert(mine) && s.contains(mine));
+				if (i % 2 == 0)
+					assert(s.remove(mine) && !s.contains(mine));
+				s.insert(i % 100 * 2); //even items are shared
+				s.remove((i + 50) % 100 * 2);
+			}
+		}));
+	}
+	threads.push_back(thread([&s]() {
+		for (int r = 0; r < 20; r++)
+		{
+			int prev = -1;
+			for (ConcurrentSkipList<int>::const_iterator it = s.begin(); it != s.end(); ++it)
+			{
+				assert(*it > prev);
+				prev = *it;
+			}
+		}
+	}));
+	for (size_t t = 0; t < threads.size(); t++)
+		threads[t].join();
+
+	int odd = 0;
+	int prev = -1;
+	for (ConcurrentSkipList<int>::const_iterator it = s.begin(); it != s.end(); ++it)
+	{
+		assert(*it > prev);
+		prev = *it;
+		if (*it % 2 == 1)
+		{
+			assert((*it / 2) / nThreads % 2 == 1); //the ones never removed
+			odd++;
+		}
+	}
+	assert(odd == nThreads * perThread / 2);
+	int n = 0;
+	for (ConcurrentSkipList<int>::const_iterator it = s.begin(); it != s.end(); ++it)
+		n++;
+	assert(n == s.size());
+}
+
+//an item whose copies can be made to fail
+struct Fussy
+{
+	static bool failCopies;
+	int n;
+	Fussy(int n = 0) : n(n) {}
+	Fussy(const Fussy& other) : n(other.n) { if (failCopies) throw 1; }
+	bool operator<(const Fussy& other) const { return n < other.n; }
+};
+bool Fussy::failCopies = false;
+
+void testThrowingCopy()
+{
+	//an insert whose copy throws leaves no node locked, so later changes
+	//near the same place still go through
+	ConcurrentSkipList<Fussy> s;
+	assert(s.insert(Fussy(10)) && s.insert(Fussy(20)));
+	Fussy::failCopies = true;
+	bool threw = false;
+	try
+	{
+		s.insert(Fussy(15));
+	}
+	catch (int)
+	{
+		threw = true;
+	}
+	Fussy::failCopies = false;
+	assert(threw && s.size() == 2 && !s.contains(Fussy(15)));
+	assert(s.insert(Fussy(15)) && s.remove(Fussy(10)) && !s.insert(Fussy(20)));
+	assert(s.size() == 2 && s.contains(Fussy(15)));
+}
+
+int main()
+{
+	test();
+	testThreads();
+	testThrowingCopy();
+	cout << "Passed all tests" << endl;
+}
@@ -0,0 +1,109 @@
+#ifndef _CLUSTERINDEX_H_
+#define _CLUSTERINDEX_H_
+
+// ClusterIndex tells the clustering loop (clusterStories in NewsCluster.cpp)
+// which clusters a story could join, so that it need not submit every story
+// to every cluster.  It keeps, for each word, the clusters with a member
+// headline holding that word.  A cluster takes a story only if the story
+// shares requiredInCommon words with one of its members, so it can't take a
+// story that shares fewer with all of its members together; submitting the
+// story to just the clusters candidates() returns gives the same clusters as
+// submitting it to all.
+//
+//    ClusterIndex index(clusters.size(), MIN_WORD_SIZE, REQUIRED_WORDS_IN_COMMON);
+//    clusters[c].submitKernelStory(headline, url);
+//    index.addStory(c, headline);
+//    ...
+//    index.candidates(headline, candidates);
+//    for each c in candidates
+//        if clusters[c].submitStory(headline, url) made it grow
+//            index.addStory(c, headline);
+//
+// Words are compared as they are, with the same WordScanner NewsCluster
+// uses, so the index sees exactly the words a cluster compares.
+
+#include "WordScanner.h"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <algorithm>
+
+class ClusterIndex
+{
+public:
+    ClusterIndex(size_t nClusters, size_t minWordLength, int requiredInCommon)
+     : m_minWordLength(minWordLength), m_requiredInCommon(requiredInCommon),
+       m_counts(nClusters, 0)
+    {}
+
+      // Record that cluster now has a member with this headline.
+    void addStory(size_t cluster, const std::string& headline)
+    {
+        WordScanner ws(headline, m_minWordLength);
+        std::string_view word;
+        while (ws.getNextWord(word))
+        {
+            std::pair<std::unordered_map<std::string, size_t>::iterator, bool> found =
+                m_wordNumbers.insert(std::make_pair(std::string(word), m_clustersWith.size()));
+            if (found.second)  // a word no cluster has had
+                m_clustersWith.push_back(std::vector<size_t>());
+            size_t w = found.first->second;
+            if (m_has.insert(key(cluster, w)).second)
+                m_clustersWith[w].push_back(cluster);
+        }
+    }
+
+      // Set result to the clusters, in increasing order, whose members
+      // together hold at least requiredInCommon of the distinct words of
+      // headline.
+    void candidates(const std::string& headline, std::vector<size_t>& result)
+    {
+        result.clear();
+        m_wordsSeen.clear();
+        WordScanner ws(headline, m_minWordLength);
+        std::string_view word;
+        while (ws.getNextWord(word))
+        {
+            std::unordered_map<std::string, size_t>::const_iterator found =
+                m_wordNumbers.find(std::string(word));
+            if (found == m_wordNumbers.end())  // no cluster has it
+                continue;
+            size_t w = found->second;
+            if (std::find(m_wordsSeen.begin(), m_wordsSeen.end(), w) != m_wordsSeen.end())
+                continue;  // count each distinct word once
+            m_wordsSeen.push_back(w);
+            const std::vector<size_t>& clusters = m_clustersWith[w];
+            for (size_t k = 0; k < clusters.size(); k++)
+            {
+                size_t c = clusters[k];
+                if (m_counts[c] == 0)
+                    m_touched.push_back(c);
+                if (++m_counts[c] == m_requiredInCommon)
+                    result.push_back(c);
+            }
+        }
+        for (size_t k = 0; k < m_touched.size(); k++)
+            m_counts[m_touched[k]] = 0;
+        m_touched.clear();
+        std::sort(result.begin(), result.end());
+    }
+
+private:
+    size_t m_minWordLength;
+    int    m_requiredInCommon;
+    std::unordered_map<std::string, size_t> m_wordNumbers;  // each word seen, numbered from 0
+    std::vector<std::vector<size_t> > m_clustersWith;  // by word number
+    std::unordered_set<unsigned long long> m_has;  // key(cluster, word) for each pair indexed
+    std::vector<int> m_counts;  // by cluster; all 0 between calls to candidates
+    std::vector<size_t> m_touched;  // clusters whose counts candidates() made nonzero
+    std::vector<size_t> m_wordsSeen;  // word numbers of the headline being looked up
+
+    static unsigned long long key(size_t cluster, size_t word)
+    {
+        return (static_cast<unsigned long long>(cluster) << 32) | word;
+    }
+};
+
+#endif // _CLUSTERINDEX_H_
@@ -1,18 +1,36 @@
 #ifndef _MAPPER_H_
 #define _MAPPER_H_
 
-template<typename T>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <string>
+#include <utility>
+#include <iterator>
+#include "NodePool.h"
+
+//nodes come from the Allocator (rebound to each node type), which has to be
+//default constructible and stateless like std::allocator or PoolAllocator.
+//by default they come from PoolAllocator's slabs
+template<typename T, typename Allocator = PoolAllocator<T> >
 class StringMapper
 {
 public:
     StringMapper();
     ~StringMapper();
+    StringMapper(const StringMapper& other);
+    StringMapper& operator=(const StringMapper& rhs);
     void insert(std::string from, const T& to);
     bool find(std::string from, T& to) const;
     bool getFirstPair(std::string& from, T& to);
     bool getNextPair(std::string& from, T& to);
     int size() const;
 
+    class const_iterator; //forward, in the order the pairs were inserted
+    typedef const_iterator iterator; //the pairs can't be changed in place
+    const_iterator begin() const;
+    const_iterator end() const;
+
 private:
 	struct SearchNode //used for the binary search tree
 	{
@@ -31,41 +49,119 @@ private:
 	ListNode* m_listHead; //points to the first value in the linked list
 	ListNode* m_listCurr; //points to the current iteration in the list
 	SearchNode* m_searchHead; //points to the first value in the search tree
+	int m_size; //number of nodes in the list, kept so size() needn't walk it
+
+	template<typename Node>
+	static Node* newNode() //gets storage for a node from the allocator and constructs it there
+	{
+		typedef typename std::allocator_traits<Allocator>::template rebind_alloc<Node> NodeAllocator;
+		return new (NodeAllocator().allocate(1)) Node;
+	}
+	template<typename Node>
+	static void deleteNode(Node* p) //destroys the node and gives its storage back
+	{
+		typedef typename std::allocator_traits<Allocator>::template rebind_alloc<Node> NodeAllocator;
+		p->~Node();
+		NodeAllocator().deallocate(p, 1);
+	}
 };
 
-template<typename T>
-StringMapper<typename T>::StringMapper()
+//*it refers to a pair in the mapper without copying it out: it->first is the
+//string and it->second the value. the pairs come in the same order as
+//getFirstPair/getNextPair, and since insert only adds to the end of the list,
+//inserting leaves iterators valid
+template<typename T, typename Allocator>
+class StringMapper<T, Allocator>::const_iterator
+{
+public:
+	struct reference
+	{
+		const std::string& first;
+		const T& second;
+
+		reference(const std::string& from, const T& to) : first(from), second(to) {}
+		const reference* operator->() const { return this; } //lets it->first reach through the iterator
+		operator std::pair<std::string, T>() const { return std::pair<std::string, T>(first, second); } //copies the pair out
+	};
+
+	typedef std::forward_iterator_tag iterator_category;
+	typedef std::pair<std::string, T> value_type;
+	typedef std::ptrdiff_t difference_type;
+	typedef reference pointer;
+
+	const_iterator() : m_node(NULL) {}
+	reference operator*() const { return reference(m_node->value->stringValue, m_node->value->TValue); }
+	pointer operator->() const { return **this; }
+	const_iterator& operator++() { m_node = m_node->next; return *this; }
+	const_iterator operator++(int) { const_iterator old(*this); m_node = m_node->next; return old; }
+	bool operator==(const const_iterator& other) const { return m_node == other.m_node; }
+	bool operator!=(const const_iterator& other) const { return m_node != other.m_node; }
+
+private:
+	const ListNode* m_node; //NULL once past the last pair
+
+	explicit const_iterator(const ListNode* node) : m_node(node) {}
+	friend class StringMapper;
+};
+
+template<typename T, typename Allocator>
+StringMapper<T, Allocator>::StringMapper()
 {
 	m_searchHead = NULL; //currently no values in the binary search tree
 	m_listHead = NULL; //no values in the list
+	m_size = 0;
 }
 
-template<typename T>
-StringMapper<typename T>::~StringMapper()
+template<typename T, typename Allocator>
+StringMapper<T, Allocator>::~StringMapper()
 {
 	ListNode* temp = m_listHead;
 	while (temp) //deletes every value in the binary search tree
 	{
 		ListNode* nextNode = temp->next;
-		delete temp->value;
-		delete temp;
+		deleteNode(temp->value);
+		deleteNode(temp);
 		temp = nextNode;
 	}
 }
 
-template<typename T>
-void StringMapper<typename T>::insert(std::string from, const T& to)
+template<typename T, typename Allocator>
+StringMapper<T, Allocator>::StringMapper(const StringMapper& other)
+{
+	m_searchHead = NULL;
+	m_listHead = NULL;
+	m_size = 0;
+	for (ListNode* temp = other.m_listHead; temp != NULL; temp = temp->next) //replays the other mapper's inserts in order
+		insert(temp->value->stringValue, temp->value->TValue);
+}
+
+template<typename T, typename Allocator>
+StringMapper<T, Allocator>& StringMapper<T, Allocator>::operator=(const StringMapper& rhs)
+{
+	if (this != &rhs)
+	{
+		StringMapper temp(rhs);
+		std::swap(m_searchHead, temp.m_searchHead);
+		std::swap(m_listHead, temp.m_listHead); //temp now holds the old values and destroys them
+		std::swap(m_size, temp.m_size);
+	}
+	return *this;
+}
+
+template<typename T, typename Allocator>
+void StringMapper<T, Allocator>::insert(std::string from, const T& to)
 {
 	if (m_searchHead == NULL) //if there are no values yet
 	{
-		m_searchHead = new SearchNode;
+		m_searchHead = newNode<SearchNode>();
 		m_searchHead->stringValue = from;
 		m_searchHead->TValue = to;
 		m_searchHead->greater = NULL;
 		m_searchHead->less = NULL; //initializes the first value
-		m_listHead = new ListNode;
+		m_listHead = newNode<ListNode>();
 		m_listHead->value = m_searchHead;
 		m_listHead->next = NULL;
+		m_size = 1;
 		return;
 	}
 	SearchNode* searchIter = m_searchHead;
@@ -93,7 +189,7 @@ void StringMapper<typename T>::insert(std::string from, const T& to)
 		return;
 	if (from < searchIter->stringValue)
 	{
-		searchIter->less = new SearchNode; 
+		searchIter->less = newNode<SearchNode>(); 
 		searchIter->less->stringValue = from;
 		searchIter->less->TValue = to;
 		searchIter->less->less = NULL;
@@ -102,7 +198,7 @@ void StringMapper<typename T>::insert(std::string from, const T& to)
 	}
 	else //from is greater than searchIter's stringValue
 	{
-		searchIter->greater = new SearchNode;
+		searchIter->greater = newNode<SearchNode>();
 		searchIter->greater->stringValue = from;
 		searchIter->greater->TValue = to;
 		searchIter->greater->less = NULL;
@@ -114,13 +210,14 @@ void StringMapper<typename T>::insert(std::string from, const T& to)
 	while (listIter->next) //gets to the end of the linked list
 		listIter = listIter->next;
 
-	listIter->next = new ListNode;
+	listIter->next = newNode<ListNode>();
 	listIter->next->value = a; //a was the newly inserted search node
 	listIter->next->next = NULL; //last item in the list
+	m_size++;
 }
 
-template<typename T>
-bool StringMapper<typename T>::find(std::string from, T& to) const
+template<typename T, typename Allocator>
+bool StringMapper<T, Allocator>::find(std::string from, T& to) const
 {
 	SearchNode* searchIter = m_searchHead;
 	while (searchIter)		//runs through the whole tree
@@ -140,8 +237,8 @@ bool StringMapper<typename T>::find(std::string from, T& to) const
 	return false; //didn't find it if it gets here
 }
 
-template<typename T>
-bool StringMapper<typename T>::getFirstPair(std::string& from, T& to)
+template<typename T, typename Allocator>
+bool StringMapper<T, Allocator>::getFirstPair(std::string& from, T& to)
 {
 	if (! m_listHead) //returns false if no values
 		return false;
@@ -152,8 +249,8 @@ bool StringMapper<typename T>::getFirstPair(std::string& from, T& to)
 	return true;
 }
 
-template<typename T>
-bool StringMapper<typename T>::getNextPair(std::string& from, T& to)
+template<typename T, typename Allocator>
+bool StringMapper<T, Allocator>::getNextPair(std::string& from, T& to)
 {
 	m_listCurr = m_listCurr->next;
 	if (! m_listCurr) //returns false if last value
@@ -164,12 +261,21 @@ bool StringMapper<typename T>::getNextPair(std::string& from, T& to)
 	return true;
 }
 
-template<typename T>
-int StringMapper<typename T>::size() const
+template<typename T, typename Allocator>
+typename StringMapper<T, Allocator>::const_iterator StringMapper<T, Allocator>::begin() const
+{
+	return const_iterator(m_listHead);
+}
+
+template<typename T, typename Allocator>
+typename StringMapper<T, Allocator>::const_iterator StringMapper<T, Allocator>::end() const
+{
+	return const_iterator(NULL); //the last list node's next
+}
+
+template<typename T, typename Allocator>
+int StringMapper<T, Allocator>::size() const
 {
-	int count = 0; //keeps track of the number of nodes
-	for (ListNode* temp = m_listHead; temp != NULL; temp = temp->next) //goes through the list and adds one for each item
-		count++;
-	return count;
+	return m_size; //counted as nodes are added, since clustering asks after every submitted story
 }
 #endif // _MAPPER_H_
@@ -1,9 +1,72 @@
 #include "provided.h"
 #include "Mapper.h"
+#include "MappedFile.h"
 #include <string>
+#include <map>
+#include <fstream>
+#include <cstring>
+#include <cstdio>
 #include <algorithm>
 using namespace std;
 
+const char SNAPSHOT_MAGIC[] = "NAGS";  // first four bytes of every snapshot file
+const unsigned SNAPSHOT_VERSION = 1;   // bump whenever the snapshot layout changes
+
+#ifdef _MSC_VER  // Windows
+
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+
+static size_t currentMemoryUsage()
+{ //bytes in the process working set right now
+	PROCESS_MEMORY_COUNTERS pmc;
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+		return 0;
+	return pmc.WorkingSetSize;
+}
+
+static size_t peakMemoryUsage()
+{ //largest working set the process has had
+	PROCESS_MEMORY_COUNTERS pmc;
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+		return 0;
+	return pmc.PeakWorkingSetSize;
+}
+
+#else  //  Mac OS X and LINUX
+
+#include <cstdio>
+#include <unistd.h>
+#include <sys/resource.h>
+
+static size_t currentMemoryUsage()
+{ //resident set size right now; only Linux exposes this cheaply
+	FILE* f = fopen("/proc/self/statm", "r");
+	if (f == NULL)
+		return 0;
+	long pages = 0, residentPages = 0;
+	int got = fscanf(f, "%ld %ld", &pages, &residentPages);
+	fclose(f);
+	if (got != 2)
+		return 0;
+	return size_t(residentPages) * size_t(sysconf(_SC_PAGESIZE));
+}
+
+static size_t peakMemoryUsage()
+{ //largest resident set the process has had
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+		return 0;
+#ifdef __APPLE__
+	return size_t(usage.ru_maxrss); //already in bytes
+#else
+	return size_t(usage.ru_maxrss) * 1024; //reported in kilobytes
+#endif
+}
+
+#endif // _MSC_VER
+
 bool KeywordSort(const Keyword& a, const Keyword& b)
 { //sorts by number of uses, except if number is the same -- then sorts by keyword
 	if (a.numUses > b.numUses) 
@@ -31,14 +94,106 @@ public:
     void addSourceRSSFeed(string feed);
     int getTopStoriesAndKeywords(double thresholdPercentage,
                     vector<Cluster>& topStories, vector<Keyword>& topKeywords);
+    int getCachedTopStoriesAndKeywords(double thresholdPercentage,
+                    vector<Cluster>& topStories, vector<Keyword>& topKeywords) const;
+    bool saveSnapshot(string path) const;
+    bool loadSnapshot(string path);
+
+    void getMemoryUsage(size_t& peakBytes, size_t& steadyBytes) const;
 
 private:
+	struct AggregateView //read-only view of the results of a run, in memory or in a mapped snapshot
+	{
+		const char* text; //every headline, url and keyword, back to back
+		const unsigned* storyText; //4 per story: headline offset, headline length, url offset, url length
+		const unsigned* wordText; //2 per keyword: offset, length
+		const unsigned* keywordCounts; //number of clusters each keyword appears in
+		const unsigned* clusterStart; //cluster c's stories are clusterMembers[clusterStart[c]..clusterStart[c+1])
+		const unsigned* clusterMembers; //story numbers; the kernel story comes first
+		unsigned numStories;
+		unsigned numWords;
+		unsigned numClusters;
+	};
+
+	struct SnapshotHeader //written at the front of a snapshot file, followed by the arrays of the view
+	{
+		char magic[4];
+		unsigned version;
+		unsigned numStories;
+		unsigned numWords;
+		unsigned numClusters;
+		unsigned numMembers;
+		unsigned textBytes;
+	};
+
 	set<string> m_sourceRSSFeeds; //holds the feed URLS
-	vector<NewsCluster*> m_cluster; //holds the news clusters
+	size_t m_peakBytes; //largest process footprint seen during any run
+	size_t m_steadyBytes; //process footprint after the last run released its pool
+
+	//results of the last run; m_view points either at these or at m_snapshot
+	string m_text;
+	vector<unsigned> m_storyText;
+	vector<unsigned> m_wordText;
+	vector<unsigned> m_keywordCounts;
+	vector<unsigned> m_clusterStart;
+	vector<unsigned> m_clusterMembers;
+	AggregateView m_view;
+	MappedFile m_snapshot;
+
+	void recordMemoryUsage();
+	unsigned addText(const string& s); //appends s to m_text and returns its offset
+	void useOwnResults();
+	static string viewText(const AggregateView& view, const unsigned* offsetAndLength);
+	static bool viewIsConsistent(const AggregateView& view, unsigned numMembers, unsigned textBytes);
 };
 
 NewsAggregatorImpl::NewsAggregatorImpl()
+ : m_peakBytes(0), m_steadyBytes(0)
+{
+	useOwnResults(); //no results yet
+}
+
+void NewsAggregatorImpl::getMemoryUsage(size_t& peakBytes, size_t& steadyBytes) const
+{
+	peakBytes = m_peakBytes;
+	steadyBytes = m_steadyBytes;
+}
+
+void NewsAggregatorImpl::recordMemoryUsage()
+{
+	size_t peak = peakMemoryUsage();
+	if (peak < currentMemoryUsage()) //some platforms can't report a peak
+		peak = currentMemoryUsage();
+	if (peak > m_peakBytes)
+		m_peakBytes = peak;
+}
+
+unsigned NewsAggregatorImpl::addText(const string& s)
+{
+	unsigned offset = unsigned(m_text.size());
+	m_text += s;
+	return offset;
+}
+
+void NewsAggregatorImpl::useOwnResults()
 {
+	if (m_clusterStart.empty())
+		m_clusterStart.push_back(0); //cluster 0 starts at the first member
+	m_view.text = m_text.data();
+	m_view.storyText = m_storyText.empty() ? NULL : &m_storyText[0];
+	m_view.wordText = m_wordText.empty() ? NULL : &m_wordText[0];
+	m_view.keywordCounts = m_keywordCounts.empty() ? NULL : &m_keywordCounts[0];
+	m_view.clusterStart = &m_clusterStart[0];
+	m_view.clusterMembers = m_clusterMembers.empty() ? NULL : &m_clusterMembers[0];
+	m_view.numStories = unsigned(m_storyText.size() / 4);
+	m_view.numWords = unsigned(m_keywordCounts.size());
+	m_view.numClusters = unsigned(m_clusterStart.size() - 1);
+	m_snapshot.close(); //a snapshot we were answering from is no longer needed
+}
+
+string NewsAggregatorImpl::viewText(const AggregateView& view, const unsigned* offsetAndLength)
+{
+	return string(view.text + offsetAndLength[0], offsetAndLength[1]);
 }
 
 void NewsAggregatorImpl::addSourceRSSFeed(string feed)
@@ -51,7 +206,8 @@ int NewsAggregatorImpl::getTopStoriesAndKeywords(double thresholdPercentage,
 {
 	
 	set<string> tempURLs; //this is used to avoid duplicate urls
-	StringMapper<string> tempData; //holds data temporarily
+	vector<string> headlines; //the deduped stories of this run; story i is headlines[i] at urls[i]
+	vector<string> urls;
 
 	//take all the values from the RSS feeds and insert them into RSSprocessors
 	for (set<string>::const_iterator it = m_sourceRSSFeeds.begin(); it != m_sourceRSSFeeds.end(); it++)
@@ -68,139 +224,136 @@ int NewsAggregatorImpl::getTopStoriesAndKeywords(double thresholdPercentage,
 			int preURLSetSize = tempURLs.size();
 			tempURLs.insert(url); //tries to insert the url into the url set
 			if (preURLSetSize != tempURLs.size()) //if the size of tempURLs set has changed, the insertion was successful
-				tempData.insert(url, title); //this means the URL has not been used yet so green light to insert the story
+			{	//this means the URL has not been used yet so green light to add the story
+				headlines.push_back(title);
+				urls.push_back(url);
+			}
 
 			gotItem = a.getNextItem(url, title); //iterates
 		}
 	} //at this point all of the rss feeds have been sorted into stories, dupes have been removed, and
-		//they have all been inserted into tempData.
+		//they have all been added to headlines and urls.
 
-	//time to cluster them all
-	string headline; string url; //holds each story and url from the vector
-	tempData.getFirstPair(url, headline);
-	NewsCluster* temp;
-	for (int i = 0; i < tempData.size(); i++)
-	{
-		temp = new NewsCluster;
-		temp->submitKernelStory(headline, url); 
-		m_cluster.push_back(temp); //initializes the cluster vector with a bunch of kernels
-		tempData.getNextPair(url, headline); //iterates
-	}
-	//after this loop runs, m_cluster is a vector of NewsClusters, each cluster containing a single
-	//news story as its kernel
+	//time to cluster them all.  The clusters live in one pool that is sized once up front
+	//and released when this function returns, so nothing outlives the run.
+	vector<NewsCluster> clusters;
+	clusterStories(headlines, urls, clusters);
+	//now every cluster is filled and no longer changing
+	//Now, need to get rid of the duplicate clusters, to be used for rest of function
 
-	bool continueIteration = true; //this tracks whether or not to stop the next loop
-	while (continueIteration)
+	set<unsigned long long> duplicateCheck; //clusters with the same member stories share a fingerprint
+	int keptClusters = 0; //clusters before this index are the unique ones
+	for (int i = 0; i < clusters.size(); i++)
 	{
-		continueIteration = false;
-		bool c = tempData.getFirstPair(url, headline);
-		while (c) //submits every story to every cluster
+		int preCheckSize = duplicateCheck.size();
+		duplicateCheck.insert(clusters[i].getFingerprint());
+		if (preCheckSize != duplicateCheck.size()) //if the size of the set changed, the cluster is new
 		{
-			for (int j = 0; j < m_cluster.size(); j++)
-			{
-				int preClusterSize = m_cluster[j]->size(); //tracks whether the cluster accepted the new story
-				m_cluster[j]->submitStory(headline, url);
-				if (preClusterSize != m_cluster[j]->size()) //if the cluster grew, it accepted the story
-					continueIteration = true;
-			}
-			c = tempData.getNextPair(url, headline);
+			if (keptClusters != i)
+				clusters[keptClusters].swap(clusters[i]); //slides it down over the duplicates
+			keptClusters++;
 		}
 	}
-	//when this loop completes all the clusters will be filled and no longer changing
-	//Now, need to get rid of all but one cluster, to be used for rest of function
+	clusters.erase(clusters.begin() + keptClusters, clusters.end()); //drops the duplicates in one pass
+	recordMemoryUsage();
+
+	//flatten the stories, clusters and keywords into this run's results
+	m_text.clear();
+	m_storyText.clear();
+	m_wordText.clear();
+	m_keywordCounts.clear();
+	m_clusterStart.clear();
+	m_clusterMembers.clear();
 
-	set<string> duplicateCheck;
-	string identifier = m_cluster[0]->getIdentifier();
-	for (int i = 0; i < m_cluster.size(); i++)
+	map<string, unsigned> storyNumbers; //url -> story number, to turn cluster members into numbers
+	for (int i = 0; i < headlines.size(); i++)
 	{
-		NewsCluster* curr = m_cluster[i];
-		int preCheckSize = duplicateCheck.size();
-		string currIden = curr->getIdentifier();
-		duplicateCheck.insert(currIden);
-		if (preCheckSize == duplicateCheck.size()) //if the size of the set didnt change, the identifier is a duplicate
-		{
-			m_cluster.erase(m_cluster.begin() + i);
-			i--;
-		}
+		storyNumbers[urls[i]] = unsigned(i);
+		m_storyText.push_back(addText(headlines[i]));
+		m_storyText.push_back(unsigned(headlines[i].size()));
+		m_storyText.push_back(addText(urls[i]));
+		m_storyText.push_back(unsigned(urls[i].size()));
+	}
 
-	} 
-	//now have to get all the words from the cluster and count them
-	vector<Keyword> wordCount;
-	for (int k = 0; k != m_cluster.size(); k++)
+	map<string, unsigned> wordNumbers; //interns every keyword once
+	m_clusterStart.push_back(0);
+	for (int k = 0; k != clusters.size(); k++)
 	{
-		set<string> currentStoryWordCount;
-		WordExtractor we(m_cluster[k]->getIdentifier()); //uses the identifier b/c W.E. gets rid of the +s
-		string currentWord;
-		while (we.getNextWord(currentWord))
+		string url; string headline;
+		bool gotItem = clusters[k].getFirstNewsItem(headline, url); //the kernel comes first
+		while (gotItem)
 		{
-			if (currentWord.size() < MIN_WORD_SIZE)
-				continue; //skip the words less than 4 letters
-
-			bool found = false;
-			for (set<string>::const_iterator it = currentStoryWordCount.begin(); it != currentStoryWordCount.end(); it++)
-			{
-				if (*it == currentWord) //if the current word is in the vector
-				{
-					found = true;
-					break;
-				}
-			}
-
-			if (!found) //if word wasn't found, add it to the back
-				currentStoryWordCount.insert(currentWord);
+			m_clusterMembers.push_back(storyNumbers[url]);
+			gotItem = clusters[k].getNextNewsItem(headline, url);
 		}
+		m_clusterStart.push_back(unsigned(m_clusterMembers.size()));
 
-		for (set<string>::const_iterator it = currentStoryWordCount.begin(); it != currentStoryWordCount.end(); it++)
+		//the cluster already knows its distinct words of MIN_WORD_SIZE or more
+		string currentWord;
+		bool gotWord = clusters[k].getFirstKeyword(currentWord);
+		while (gotWord)
 		{
-			bool found = false;
-			for (int p = 0; p < wordCount.size(); p++)
+			map<string, unsigned>::iterator found = wordNumbers.find(currentWord);
+			if (found != wordNumbers.end())
+				m_keywordCounts[found->second]++;
+			else //first time the word is seen, so give it the next number
 			{
-				if (*it == wordCount[p].keyword)
-				{
-					wordCount[p].numUses++;
-					found = true;
-				}
-			} //else doesnt exist in the wordCount vector yet, so add it
-			if (!found)
-			{
-				Keyword key;
-				key.keyword = *it;
-				key.numUses = 1;
-				wordCount.push_back(key);
+				wordNumbers[currentWord] = unsigned(m_keywordCounts.size());
+				m_wordText.push_back(addText(currentWord));
+				m_wordText.push_back(unsigned(currentWord.size()));
+				m_keywordCounts.push_back(1);
 			}
+			gotWord = clusters[k].getNextKeyword(currentWord);
 		}
 	}
-	
-	//wordCount should contain all the words, grouped into keywords and counts
+	useOwnResults();
+
+	vector<NewsCluster>().swap(clusters); //releases the cluster pool and the story records
+	vector<string>().swap(headlines);
+	vector<string>().swap(urls);
+	m_steadyBytes = currentMemoryUsage(); //whatever is still held now is the steady state between runs
+
+	return getCachedTopStoriesAndKeywords(thresholdPercentage, topStories, topKeywords);
+}
+
+int NewsAggregatorImpl::getCachedTopStoriesAndKeywords(double thresholdPercentage,
+                    vector<Cluster>& topStories, vector<Keyword>& topKeywords) const
+{
+	const AggregateView& v = m_view;
+
 	int clusterCount = 0;
-	for (int i = 0; i < m_cluster.size(); i++)
-		clusterCount += m_cluster[i]->size(); //adds every story to the count of total stories
+	for (unsigned i = 0; i < v.numClusters; i++)
+		clusterCount += v.clusterStart[i+1] - v.clusterStart[i]; //adds every story to the count of total stories
 	int minimumStories = clusterCount * thresholdPercentage * .01; //min number of stories required to be passed back
 
-	for (int i = 0; i < m_cluster.size(); i++)
+	for (unsigned i = 0; i < v.numClusters; i++)
 	{
-		if (m_cluster[i]->size() >=  minimumStories) // if the current cluster has enough stories, add it to the vector
+		int clusterSize = v.clusterStart[i+1] - v.clusterStart[i];
+		if (clusterSize >= minimumStories) // if the current cluster has enough stories, add it to the vector
 		{
-			string url; string headline;
-			m_cluster[i]->getFirstNewsItem(headline, url);
-			Cluster temp(headline); //title is the kernel value
-			temp.addRelatedURL(url);
-			while (m_cluster[i]->getNextNewsItem(headline, url))
-				temp.addRelatedURL(url);
+			const unsigned* kernel = v.storyText + 4 * v.clusterMembers[v.clusterStart[i]];
+			Cluster temp(viewText(v, kernel)); //title is the kernel value
+			for (unsigned m = v.clusterStart[i]; m < v.clusterStart[i+1]; m++)
+				temp.addRelatedURL(viewText(v, v.storyText + 4 * v.clusterMembers[m] + 2));
 			topStories.push_back(temp);
 		}
 	}
 	//now topStories should contain all the cluster stories with their associated urls
 
 	int keywordCount = 0;
-	for (int i = 0; i < wordCount.size(); i++)
-		keywordCount += wordCount[i].numUses;
+	for (unsigned i = 0; i < v.numWords; i++)
+		keywordCount += v.keywordCounts[i];
 
 	int minimumKeywords = keywordCount * thresholdPercentage * .01;
-	for (int i = 0; i < wordCount.size(); i++)
+	for (unsigned i = 0; i < v.numWords; i++)
 	{
-		if (wordCount[i].numUses >= minimumKeywords)
-			topKeywords.push_back(wordCount[i]);
+		if (int(v.keywordCounts[i]) >= minimumKeywords)
+		{
+			Keyword key;
+			key.keyword = viewText(v, v.wordText + 2 * i);
+			key.numUses = v.keywordCounts[i];
+			topKeywords.push_back(key);
+		}
 	}
 
 	//now have to sort the vectors
@@ -211,6 +364,116 @@ int NewsAggregatorImpl::getTopStoriesAndKeywords(double thresholdPercentage,
     return 0;
 }
 
+bool NewsAggregatorImpl::saveSnapshot(string path) const
+{
+	const AggregateView& v = m_view;
+	SnapshotHeader header;
+	memcpy(header.magic, SNAPSHOT_MAGIC, 4);
+	header.version = SNAPSHOT_VERSION;
+	header.numStories = v.numStories;
+	header.numWords = v.numWords;
+	header.numClusters = v.numClusters;
+	header.numMembers = v.clusterStart[v.numClusters];
+	header.textBytes = 0;
+	for (unsigned i = 0; i < v.numStories; i++) //the text block ends after the last string anyone refers to
+		header.textBytes = max(header.textBytes, max(v.storyText[4*i] + v.storyText[4*i+1], v.storyText[4*i+2] + v.storyText[4*i+3]));
+	for (unsigned i = 0; i < v.numWords; i++)
+		header.textBytes = max(header.textBytes, v.wordText[2*i] + v.wordText[2*i+1]);
+
+	//the view may be a mapping of path itself, after loadSnapshot(path), and truncating
+	//path would pull the bytes out from under it; so write a new file and swap it in
+	string tempPath = path + ".tmp";
+	ofstream out(tempPath.c_str(), ios::binary | ios::trunc);
+	if (!out)
+		return false;
+	out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	out.write(reinterpret_cast<const char*>(v.storyText), 4 * sizeof(unsigned) * header.numStories);
+	out.write(reinterpret_cast<const char*>(v.wordText), 2 * sizeof(unsigned) * header.numWords);
+	out.write(reinterpret_cast<const char*>(v.keywordCounts), sizeof(unsigned) * header.numWords);
+	out.write(reinterpret_cast<const char*>(v.clusterStart), sizeof(unsigned) * (header.numClusters + 1));
+	out.write(reinterpret_cast<const char*>(v.clusterMembers), sizeof(unsigned) * header.numMembers);
+	out.write(v.text, header.textBytes);
+	out.close();
+	if (!out  ||  !MappedFile::replace(tempPath, path))
+	{
+		remove(tempPath.c_str());
+		return false;
+	}
+	return true;
+}
+
+bool NewsAggregatorImpl::viewIsConsistent(const AggregateView& v, unsigned numMembers, unsigned textBytes)
+{ //true if every offset and index in v stays inside the arrays and text it refers to
+	for (unsigned i = 0; i < 2 * v.numStories; i++) //headline and url of each story
+	{
+		if (0ULL + v.storyText[2*i] + v.storyText[2*i+1] > textBytes)
+			return false;
+	}
+	for (unsigned i = 0; i < v.numWords; i++)
+	{
+		if (0ULL + v.wordText[2*i] + v.wordText[2*i+1] > textBytes)
+			return false;
+	}
+	//every cluster has at least its kernel, so the starts strictly increase from 0 to numMembers
+	if (v.clusterStart[0] != 0  ||  v.clusterStart[v.numClusters] != numMembers)
+		return false;
+	for (unsigned i = 0; i < v.numClusters; i++)
+	{
+		if (v.clusterStart[i] >= v.clusterStart[i+1])
+			return false;
+	}
+	for (unsigned m = 0; m < numMembers; m++)
+	{
+		if (v.clusterMembers[m] >= v.numStories)
+			return false;
+	}
+	return true;
+}
+
+bool NewsAggregatorImpl::loadSnapshot(string path)
+{
+	//the snapshot is mapped, not read: the arrays in the file are used where they lie, so
+	//answering from it only touches the pages a query actually needs
+	MappedFile file;
+	if (!file.open(path)  ||  file.size() < sizeof(SnapshotHeader))
+		return false;
+
+	SnapshotHeader header;
+	memcpy(&header, file.data(), sizeof(header));
+	if (memcmp(header.magic, SNAPSHOT_MAGIC, 4) != 0  ||  header.version != SNAPSHOT_VERSION)
+		return false; //not a snapshot, or one written by an incompatible version
+
+	unsigned long long expectedSize = sizeof(SnapshotHeader) + header.textBytes +
+		sizeof(unsigned) * (4ULL * header.numStories + 3ULL * header.numWords + header.numClusters + 1 + header.numMembers);
+	if (file.size() != expectedSize)
+		return false; //truncated or padded
+
+	const unsigned* arrays = reinterpret_cast<const unsigned*>(file.data() + sizeof(SnapshotHeader));
+	AggregateView v;
+	v.numStories = header.numStories;
+	v.numWords = header.numWords;
+	v.numClusters = header.numClusters;
+	v.storyText = arrays;
+	v.wordText = v.storyText + 4 * v.numStories;
+	v.keywordCounts = v.wordText + 2 * v.numWords;
+	v.clusterStart = v.keywordCounts + v.numWords;
+	v.clusterMembers = v.clusterStart + v.numClusters + 1;
+	v.text = reinterpret_cast<const char*>(v.clusterMembers + header.numMembers);
+	if (!viewIsConsistent(v, header.numMembers, header.textBytes))
+		return false; //damaged: something in it points outside the file
+
+	//the snapshot is good, so drop the results of any earlier run and answer from the file
+	m_text.clear();
+	m_storyText.clear();
+	m_wordText.clear();
+	m_keywordCounts.clear();
+	m_clusterStart.clear();
+	m_clusterMembers.clear();
+	m_view = v;
+	m_snapshot.swap(file);
+	return true;
+}
+
 //******************** NewsAggregator functions *******************************
 
 // These functions simply delegate to NewsAggregatorImpl's functions.
@@ -230,9 +493,31 @@ void NewsAggregator::addSourceRSSFeed(string feed)
     m_impl->addSourceRSSFeed(feed);
 }
 
+void NewsAggregator::getMemoryUsage(size_t& peakBytes, size_t& steadyBytes) const
+{
+    m_impl->getMemoryUsage(peakBytes, steadyBytes);
+}
+
 int NewsAggregator::getTopStoriesAndKeywords(double thresholdPercentage,
                     vector<Cluster>& topStories, vector<Keyword>& topKeywords)
 {
     return m_impl->getTopStoriesAndKeywords(thresholdPercentage, topStories,
                                                                   topKeywords);
 }
+
+int NewsAggregator::getCachedTopStoriesAndKeywords(double thresholdPercentage,
+                    vector<Cluster>& topStories, vector<Keyword>& topKeywords) const
+{
+    return m_impl->getCachedTopStoriesAndKeywords(thresholdPercentage, topStories,
+                                                                        topKeywords);
+}
+
+bool NewsAggregator::saveSnapshot(string path) const
+{
+    return m_impl->saveSnapshot(path);
+}
+
+bool NewsAggregator::loadSnapshot(string path)
+{
+    return m_impl->loadSnapshot(path);
+}
@@ -0,0 +1,417 @@
+// Offline benchmark for the NewsAgg pieces.  It writes synthetic RSS feeds
+// to local files and reads them back through file:// URLs, so no network is
+// needed and every run sees the same headlines.  Build it on its own (it has
+// its own main), e.g.
+//     g++ -O2 -pthread NewsAggBench.cpp NewsCluster.cpp RSSProcessor.cpp NewsAgg.cpp
+// and run it as
+//     NewsAggBench [maxHeadlines] [vocabularySize] [topicOverlapPercent]
+//                  [maxClusterHeadlines] [maxMapperHeadlines]
+// The last two override the limits below, so that the clustering and
+// StringMapper phases can be timed at larger sizes too, e.g.
+//     NewsAggBench 100000 50000 50 100000 100000
+// asks for their 100k rows.  Expect those to take a long time: clusters keep
+// growing as stories join, and StringMapper is quadratic.
+
+#include "provided.h"
+#include "Mapper.h"
+#include "FrozenMap.h"
+#include "MappedMap.h"
+#include "WordScanner.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <cstdio>
+#include <cstdlib>
+using namespace std;
+
+//========================================================================
+//  StringMapper walks its whole list on each insert, so it's quadratic.
+//  Clustering submits each story only to the clusters a ClusterIndex says
+//  could take it, but repeats passes over every story until no cluster
+//  grows, and its clusters grow with the number of headlines, so it too
+//  gets slow at the largest sizes.  By default, sizes above these limits
+//  skip those phases (reporting -1); raise them on the command line if
+//  you're willing to wait.  Up to MAX_CHECK_HEADLINES, the stories are
+//  clustered a second time, untimed, submitting every story to every
+//  cluster, and the two sets of clusters must be the same.
+
+const int MAX_MAPPER_HEADLINES = 20000;
+const int MAX_CLUSTER_HEADLINES = 10000;
+const int MAX_CHECK_HEADLINES = 1000;
+//========================================================================
+
+const int ITEMS_PER_FEED = 4000;     // keeps each feed well under MAX_PAGE_SIZE
+const int WORDS_PER_HEADLINE = 7;
+const int HEADLINES_PER_TOPIC = 20;
+const int TOPIC_WORDS = 6;
+
+//========================================================================
+// TimerType            - a type to hold a timer reading
+// TimerType getTimer() - get the current timer reading
+// double interval(TimerType start, TimerType end) - milliseconds between
+//                                                   two readings
+//========================================================================
+
+#ifdef _MSC_VER  // If we're compiling for Windows
+
+#include <windows.h>
+#include <direct.h>
+
+typedef LARGE_INTEGER TimerType;
+inline TimerType getTimer()
+{
+    LARGE_INTEGER t;
+    QueryPerformanceCounter(&t);
+    return t;
+}
+
+inline double interval(TimerType start, TimerType end)
+{
+    LARGE_INTEGER ticksPerSecond;
+    QueryPerformanceFrequency(&ticksPerSecond);
+    return (1000.0 * (end.QuadPart - start.QuadPart)) / ticksPerSecond.QuadPart;
+}
+
+inline string currentDirectory()
+{
+    char buffer[4096];
+    return _getcwd(buffer, sizeof(buffer)) != NULL ? string(buffer) + "\\" : string();
+}
+
+#else // If we're not compiling for Windows, use Standard C
+
+#include <ctime>
+#include <unistd.h>
+
+typedef clock_t TimerType;
+inline TimerType getTimer() { return clock(); }
+inline double interval(TimerType start, TimerType end)
+{
+    return (1000.0 * (end - start)) / CLOCKS_PER_SEC;
+}
+
+inline string currentDirectory()
+{
+    char buffer[4096];
+    return getcwd(buffer, sizeof(buffer)) != NULL ? string(buffer) + "/" : string();
+}
+
+#endif  // ifdef _MSC_VER
+
+//========================================================================
+
+struct Story
+{
+    string headline;
+    string url;
+};
+
+  // Make a pronounceable lowercase word out of two to four syllables, so
+  // most words pass the MIN_WORD_SIZE filter the way real headlines do.
+
+string makeWord(int n)
+{
+    static const char* const syllables[] = {
+        "ka", "lo", "mi", "ten", "ra", "sul", "po", "ve", "dan", "shi",
+        "tor", "gu", "bel", "no", "fra", "xi", "cor", "de", "lum", "ha"
+    };
+    const int numSyllables = sizeof(syllables) / sizeof(syllables[0]);
+    string word;
+    int length = 2 + n % 3;
+    for (int k = 0; k < length; k++)
+    {
+        word += syllables[n % numSyllables];
+        n = n / numSyllables + k * 7 + 1;
+    }
+    return word;
+}
+
+  // Generate nHeadlines stories.  Each belongs to a topic that has a few
+  // core words; every word of a headline is one of its topic's core words
+  // with probability overlapPercent, and otherwise a random vocabulary word.
+
+void makeStories(int nHeadlines, int vocabularySize, int overlapPercent, vector<Story>& stories)
+{
+    vector<string> vocabulary;
+    for (int k = 0; k < vocabularySize; k++)
+        vocabulary.push_back(makeWord(k));
+
+    int nTopics = nHeadlines / HEADLINES_PER_TOPIC + 1;
+    stories.clear();
+    for (int i = 0; i < nHeadlines; i++)
+    {
+        int topic = rand() % nTopics;
+        Story s;
+        for (int w = 0; w < WORDS_PER_HEADLINE; w++)
+        {
+            int word;
+            if (rand() % 100 < overlapPercent)
+                word = (topic * TOPIC_WORDS + rand() % TOPIC_WORDS) % vocabularySize;
+            else
+                word = rand() % vocabularySize;
+            if (w != 0)
+                s.headline += ' ';
+            s.headline += vocabulary[word];
+        }
+        ostringstream url;
+        url << "http://bench.example.com/topic" << topic << "/story" << i << ".html";
+        s.url = url.str();
+        stories.push_back(s);
+    }
+}
+
+  // Write the stories as RSS files of ITEMS_PER_FEED items each and return
+  // the file:// URLs of the feeds.
+
+vector<string> writeFeeds(const vector<Story>& stories, string prefix)
+{
+    vector<string> feeds;
+    for (size_t first = 0; first < stories.size(); first += ITEMS_PER_FEED)
+    {
+        ostringstream path;
+        path << prefix << feeds.size() << ".xml";
+        ofstream out(path.str().c_str());
+        out << "<?xml version=\"1.0\"?>\n<rss version=\"2.0\">\n<channel>\n<title>bench</title>\n";
+        for (size_t k = first; k < stories.size()  &&  k < first + ITEMS_PER_FEED; k++)
+        {
+            out << "<item>\n<title>" << stories[k].headline << "</title>\n"
+                << "<link>" << stories[k].url << "</link>\n</item>\n";
+        }
+        out << "</channel>\n</rss>\n";
+        feeds.push_back("file://" + path.str());
+    }
+    return feeds;
+}
+
+void removeFeeds(const vector<string>& feeds)
+{
+    for (size_t k = 0; k < feeds.size(); k++)
+        remove(feeds[k].substr(7).c_str());
+}
+
+int main(int argc, char* argv[])
+{
+    int maxHeadlines = (argc > 1 ? atoi(argv[1]) : 1000000);
+    int vocabularySize = (argc > 2 ? atoi(argv[2]) : 5000);
+    int overlapPercent = (argc > 3 ? atoi(argv[3]) : 50);
+    int maxClusterHeadlines = (argc > 4 ? atoi(argv[4]) : MAX_CLUSTER_HEADLINES);
+    int maxMapperHeadlines = (argc > 5 ? atoi(argv[5]) : MAX_MAPPER_HEADLINES);
+    if (maxHeadlines <= 0  ||  vocabularySize <= 0  ||  overlapPercent < 0  ||  overlapPercent > 100  ||
+        maxClusterHeadlines < 0  ||  maxMapperHeadlines < 0)
+    {
+        cout << "usage: " << argv[0] << " [maxHeadlines] [vocabularySize] [topicOverlapPercent]"
+             << " [maxClusterHeadlines] [maxMapperHeadlines]" << endl;
+        return 1;
+    }
+
+    cout << "vocabulary " << vocabularySize << " words, topic overlap " << overlapPercent << "%" << endl;
+    cout << "clustering up to " << maxClusterHeadlines << " headlines, StringMapper up to "
+         << maxMapperHeadlines << endl;
+    cout << "headlines,parse ms,mapper insert ms,mapper insert (heap nodes) ms,mapper find ms,frozen find ms,mapped save ms,mapped open ms,mapped find ms,word extraction ms,word scanner ms,clustering ms,keyword extraction ms" << endl;
+
+    string prefix = currentDirectory() + "newsaggbench_feed";
+    for (int n = 1000; n <= maxHeadlines; n *= 10)
+    {
+        srand(n);  // same headlines for the same size every run
+        vector<Story> generated;
+        makeStories(n, vocabularySize, overlapPercent, generated);
+        vector<string> feeds = writeFeeds(generated, prefix);
+
+        TimerType start;
+        TimerType end;
+
+          // Phase 1: fetch and parse every feed with RSSProcessor
+
+        vector<Story> stories;
+        start = getTimer();
+        for (size_t f = 0; f < feeds.size(); f++)
+        {
+            RSSProcessor rss(feeds[f]);
+            rss.getData();
+            Story s;
+            bool gotItem = rss.getFirstItem(s.url, s.headline);
+            while (gotItem)
+            {
+                stories.push_back(s);
+                gotItem = rss.getNextItem(s.url, s.headline);
+            }
+        }
+        end = getTimer();
+        double parseTime = interval(start, end);
+        removeFeeds(feeds);
+
+          // Phase 2: insert url -> headline pairs into a StringMapper, then destroy it
+
+        double mapperTime = -1;
+        double heapMapperTime = -1;
+        double findTime = -1;
+        double frozenFindTime = -1;
+        double mappedSaveTime = -1;
+        double mappedOpenTime = -1;
+        double mappedFindTime = -1;
+        if (n <= maxMapperHeadlines)
+        {
+            start = getTimer();
+            {
+                StringMapper<string> mapper;
+                for (size_t k = 0; k < stories.size(); k++)
+                    mapper.insert(stories[k].url, stories[k].headline);
+            }
+            end = getTimer();
+            mapperTime = interval(start, end);
+
+              // the same, with nodes straight from the heap instead of from
+              // PoolAllocator's slabs (destruction is timed in both)
+
+            start = getTimer();
+            {
+                StringMapper<string, allocator<string> > mapper;
+                for (size_t k = 0; k < stories.size(); k++)
+                    mapper.insert(stories[k].url, stories[k].headline);
+            }
+            end = getTimer();
+            heapMapperTime = interval(start, end);
+
+              // look up every url in a StringMapper and in a FrozenMap made
+              // from it
+
+            StringMapper<string> mapper;
+            for (size_t k = 0; k < stories.size(); k++)
+                mapper.insert(stories[k].url, stories[k].headline);
+            FrozenMap<string, string> frozen(mapper);
+            size_t found = 0;
+            string headline;
+            start = getTimer();
+            for (size_t k = 0; k < stories.size(); k++)
+                found += mapper.find(stories[k].url, headline);
+            end = getTimer();
+            findTime = interval(start, end);
+            start = getTimer();
+            for (size_t k = 0; k < stories.size(); k++)
+                found -= frozen.contains(stories[k].url);
+            end = getTimer();
+            frozenFindTime = interval(start, end);
+            if (found != 0)
+                cerr << "warning: FrozenMap and StringMapper found different urls" << endl;
+
+              // save the StringMapper to a file, map it back in, and look up
+              // every url in the mapped image
+
+            string mappedPath = prefix + "map.bin";
+            start = getTimer();
+            bool saved = MappedMap<string>::save(mappedPath, mapper);
+            end = getTimer();
+            mappedSaveTime = interval(start, end);
+            MappedMap<string> mapped;
+            start = getTimer();
+            bool opened = saved  &&  mapped.open(mappedPath);
+            end = getTimer();
+            mappedOpenTime = interval(start, end);
+            start = getTimer();
+            for (size_t k = 0; k < stories.size(); k++)
+                found += mapped.contains(stories[k].url);
+            end = getTimer();
+            mappedFindTime = interval(start, end);
+            if (!opened  ||  mapped.size() != frozen.size()  ||  found != stories.size())
+                cerr << "warning: MappedMap and StringMapper found different urls" << endl;
+            mapped.close();
+            remove(mappedPath.c_str());
+        }
+
+          // Phase 3: split every headline into words of MIN_WORD_SIZE or more
+
+        start = getTimer();
+        size_t wordsFound = 0;
+        for (size_t k = 0; k < stories.size(); k++)
+        {
+            WordExtractor we(stories[k].headline);
+            string word;
+            while (we.getNextWord(word))
+            {
+                if (word.size() >= MIN_WORD_SIZE)
+                    wordsFound++;
+            }
+        }
+        end = getTimer();
+        double wordTime = interval(start, end);
+
+          // Phase 3b: the same split with WordScanner, which hands back views
+          // and drops short words inside the scan
+
+        start = getTimer();
+        size_t wordsScanned = 0;
+        for (size_t k = 0; k < stories.size(); k++)
+        {
+            WordScanner ws(stories[k].headline, MIN_WORD_SIZE);
+            string_view word;
+            while (ws.getNextWord(word))
+                wordsScanned++;
+        }
+        end = getTimer();
+        double scanTime = interval(start, end);
+
+          // Phases 4 and 5: cluster the stories with the code NewsAggregator
+          // uses, then count in how many clusters each keyword appears
+
+        double clusterTime = -1;
+        double keywordTime = -1;
+        if (n <= maxClusterHeadlines)
+        {
+            vector<string> headlines;
+            vector<string> urls;
+            for (size_t k = 0; k < stories.size(); k++)
+            {
+                headlines.push_back(stories[k].headline);
+                urls.push_back(stories[k].url);
+            }
+
+            start = getTimer();
+            vector<NewsCluster> clusters;
+            clusterStories(headlines, urls, clusters);
+            end = getTimer();
+            clusterTime = interval(start, end);
+
+            if (n <= MAX_CHECK_HEADLINES)
+            {
+                vector<NewsCluster> allClusters;
+                clusterStories(headlines, urls, allClusters, true);
+                bool same = (allClusters.size() == clusters.size());
+                for (size_t c = 0; same  &&  c < clusters.size(); c++)
+                    same = (allClusters[c].size() == clusters[c].size()  &&
+                            allClusters[c].getFingerprint() == clusters[c].getFingerprint());
+                if (!same)
+                    cerr << "warning: submitting every story to every cluster gave different clusters" << endl;
+            }
+
+            start = getTimer();
+            map<string, int> keywordCounts;
+            for (size_t c = 0; c < clusters.size(); c++)
+            {
+                string word;
+                bool gotWord = clusters[c].getFirstKeyword(word);
+                while (gotWord)
+                {
+                    keywordCounts[word]++;
+                    gotWord = clusters[c].getNextKeyword(word);
+                }
+            }
+            end = getTimer();
+            keywordTime = interval(start, end);
+        }
+
+          // A time of -1 means the phase was skipped at this size
+
+        cout << n << "," << parseTime << "," << mapperTime << "," << heapMapperTime << "," << findTime << ","
+             << frozenFindTime << "," << mappedSaveTime << "," << mappedOpenTime << ","
+             << mappedFindTime << "," << wordTime << ","
+             << scanTime << "," << clusterTime << "," << keywordTime << endl;
+        if (wordsScanned != wordsFound)
+            cerr << "warning: WordScanner found " << wordsScanned << " words, WordExtractor " << wordsFound << endl;
+        if (stories.size() != generated.size()  ||  wordsFound == 0)
+            cerr << "warning: parsed " << stories.size() << " of " << generated.size() << " stories" << endl;
+    }
+}
@@ -1,8 +1,34 @@
 #include "provided.h"
 #include "Mapper.h"
+#include "WordScanner.h"
+#include "ClusterIndex.h"
 #include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
 using namespace std;
 
+static unsigned long long hashHeadline(const string& headline)
+{ //64-bit FNV-1a hash of the headline, used as the story's id
+	unsigned long long h = 14695981039346656037ULL;
+	for (size_t i = 0; i < headline.size(); i++)
+	{
+		h ^= (unsigned char)headline[i];
+		h *= 1099511628211ULL;
+	}
+	return h;
+}
+
+static unsigned long long mixID(unsigned long long x)
+{ //scrambles the bits of an id so that the fingerprint depends on every bit
+	x ^= x >> 33;
+	x *= 0xff51afd7ed558ccdULL;
+	x ^= x >> 33;
+	x *= 0xc4ceb9fe1a85ec53ULL;
+	x ^= x >> 33;
+	return x;
+}
+
 
 class NewsClusterImpl
 {
@@ -11,6 +37,9 @@ public:
     bool submitKernelStory(string headline, string url);
     bool submitStory(string headline, string url);
     string getIdentifier() const;
+    unsigned long long getFingerprint() const;
+    bool getFirstKeyword(string& word);
+    bool getNextKeyword(string& word);
     bool getFirstNewsItem(string& headline, string& url);
     bool getNextNewsItem(string& headline, string& url);
     int size() const;
@@ -19,6 +48,13 @@ private:
 	StringMapper<string> m_cluster; //holds the cluster stories
 	string m_kernel; //holds the initial kernel story for reference
 	set<string> m_headlineSet; //holds the headlines for alphabetical reference
+	set<unsigned long long> m_storyIDs; //sorted ids of the member stories, used for the fingerprint
+	set<string> m_keywords; //every word of MIN_WORD_SIZE or more in any member headline
+	set<string>::const_iterator m_keywordIter; //used for getFirstKeyword, getNextKeyword
+	vector<vector<string> > m_memberWords; //sorted distinct words of each member headline, scanned once
+
+	void addMember(const string& headline, const set<string_view>& words);
+	static int wordsInCommon(const vector<string>& memberWords, const set<string_view>& words);
 };
 
 NewsClusterImpl::NewsClusterImpl()
@@ -31,58 +67,36 @@ bool NewsClusterImpl::submitKernelStory(string headline, string url)
 		return false;
 	m_cluster.insert(headline, url);
 	m_kernel = headline; //keeps track of the kernel story
-	m_headlineSet.insert(headline); //set tracks only headlines
+
+	WordScanner ws(headline, MIN_WORD_SIZE); //only hands back words of MIN_WORD_SIZE or more
+	string_view word;
+	set<string_view> words;
+	while (ws.getNextWord(word))
+		words.insert(word);
+	addMember(headline, words);
 	return true;
 }
 
 bool NewsClusterImpl::submitStory(string headline, string url)
 {
 	//breaks the inputted headline into word chunks, and stores them in a set.
-	WordExtractor current(headline);
-	string tempCurr;
-	set<string> concatenatedCurrentHeadline;
+	//the words are views into headline, so nothing is copied
+	WordScanner current(headline, MIN_WORD_SIZE);
+	string_view tempCurr;
+	set<string_view> concatenatedCurrentHeadline;
 	while(current.getNextWord(tempCurr))
-	{
-		if (tempCurr.size() >= MIN_WORD_SIZE)
-			concatenatedCurrentHeadline.insert(tempCurr);
-	}
+		concatenatedCurrentHeadline.insert(tempCurr);
 	
-	string from; string to; //strings to hold the values from the cluster
-	m_cluster.getFirstPair(from, to);
-
-	do //repeats this step for every story in the cluster
+	for (size_t m = 0; m < m_memberWords.size(); m++) //repeats this step for every story in the cluster
 	{
-		WordExtractor base(from);
-		//use wordextractor to split the current story up into words and stores them in a seperate set
-		string tempBase;
-		set<string> concatenatedBaseHeadline;
-		while (base.getNextWord(tempBase))
-		{
-			if (tempBase.size() >= MIN_WORD_SIZE)
-				concatenatedBaseHeadline.insert(tempBase); 
-		}
-	
-		//now we have 2 sets containing all the words greater than 4 letters in the current word in the cluster
-		//and the compared headline
-		int identicalWordCount = 0; //counter to keep track of the matching words
-		for (set<string>::const_iterator it1 = concatenatedBaseHeadline.begin(); it1 != concatenatedBaseHeadline.end(); it1++)
-		{
-			for (set<string>::const_iterator it2 = concatenatedCurrentHeadline.begin(); it2 != concatenatedCurrentHeadline.end(); it2++)
-			{
-				if (*it1 == *it2)
-				{
-					identicalWordCount++;
-					break;
-				}
-			}
-		}
-		if (identicalWordCount >= REQUIRED_WORDS_IN_COMMON) //if the current headline has enough in common with the cluster headline
-		{
+		//the member's words were scanned and sorted when it joined, so this is one merge of two sorted lists
+		if (wordsInCommon(m_memberWords[m], concatenatedCurrentHeadline) >= REQUIRED_WORDS_IN_COMMON)
+		{ //the current headline has enough in common with the cluster headline
 			m_cluster.insert(headline, url);
-			m_headlineSet.insert(headline);
+			addMember(headline, concatenatedCurrentHeadline);
 			return true; //value was successfully inserted
 		}
-	} while (m_cluster.getNextPair(from, to));
+	}
 	return false; //didn't insert the value
 }
 
@@ -95,6 +109,64 @@ string NewsClusterImpl::getIdentifier() const
 	return holder;
 }
 
+unsigned long long NewsClusterImpl::getFingerprint() const
+{
+	//folds the sorted member ids together, so two clusters holding the same stories
+	//get the same fingerprint no matter what order the stories were submitted in
+	unsigned long long fingerprint = 0x9e3779b97f4a7c15ULL;
+	for (set<unsigned long long>::const_iterator it = m_storyIDs.begin(); it != m_storyIDs.end(); it++)
+		fingerprint = mixID(fingerprint ^ *it) + 0x9e3779b97f4a7c15ULL;
+	return fingerprint;
+}
+
+bool NewsClusterImpl::getFirstKeyword(string& word)
+{
+	m_keywordIter = m_keywords.begin();
+	return getNextKeyword(word);
+}
+
+bool NewsClusterImpl::getNextKeyword(string& word)
+{
+	if (m_keywordIter == m_keywords.end())
+		return false;
+	word = *m_keywordIter;
+	m_keywordIter++;
+	return true;
+}
+
+void NewsClusterImpl::addMember(const string& headline, const set<string_view>& words)
+{
+	if (!m_headlineSet.insert(headline).second) //set tracks only headlines
+		return; //a member resubmitted; its id and words are already here
+	m_memberWords.push_back(vector<string>(words.begin(), words.end())); //set order is sorted order
+	m_storyIDs.insert(hashHeadline(headline));
+	for (set<string_view>::const_iterator it = words.begin(); it != words.end(); it++)
+		m_keywords.insert(string(*it)); //keeps the cluster's keywords current
+}
+
+int NewsClusterImpl::wordsInCommon(const vector<string>& memberWords, const set<string_view>& words)
+{ //both are sorted, so walk them together, stopping once enough words match
+	int identicalWordCount = 0;
+	vector<string>::const_iterator it1 = memberWords.begin();
+	set<string_view>::const_iterator it2 = words.begin();
+	while (it1 != memberWords.end()  &&  it2 != words.end())
+	{
+		int c = string_view(*it1).compare(*it2);
+		if (c < 0)
+			it1++;
+		else if (c > 0)
+			it2++;
+		else
+		{
+			if (++identicalWordCount == REQUIRED_WORDS_IN_COMMON)
+				break;
+			it1++;
+			it2++;
+		}
+	}
+	return identicalWordCount;
+}
+
 bool NewsClusterImpl::getFirstNewsItem(string& headline, string& url)
 {
 	return (m_cluster.getFirstPair(headline, url) );
@@ -110,6 +182,52 @@ int NewsClusterImpl::size() const
     return m_cluster.size();
 }
 
+//******************** clusterStories ******************************************
+
+void clusterStories(const vector<string>& headlines, const vector<string>& urls,
+                    vector<NewsCluster>& clusters, bool submitToAll)
+{
+	//the clusters live in one vector that is sized once up front
+	vector<NewsCluster>(headlines.size()).swap(clusters);
+	ClusterIndex index(clusters.size(), MIN_WORD_SIZE, REQUIRED_WORDS_IN_COMMON);
+	for (size_t i = 0; i < headlines.size(); i++)
+	{
+		clusters[i].submitKernelStory(headlines[i], urls[i]); //each cluster starts with a single kernel
+		index.addStory(i, headlines[i]);
+	}
+	//after this loop runs, clusters is a vector of NewsClusters, each cluster containing a single
+	//news story as its kernel
+
+	bool continueIteration = true; //this tracks whether or not to stop the next loop
+	vector<size_t> candidates; //clusters the current story could join
+	while (continueIteration)
+	{
+		continueIteration = false;
+		for (size_t i = 0; i < headlines.size(); i++) //submits every story to every cluster that could take it
+		{
+			if (submitToAll) //the slow way, kept so the fast way can be checked against it
+			{
+				candidates.clear();
+				for (size_t j = 0; j < clusters.size(); j++)
+					candidates.push_back(j);
+			}
+			else //the others share too few words with the whole cluster to share enough with any one member
+				index.candidates(headlines[i], candidates);
+			for (size_t k = 0; k < candidates.size(); k++)
+			{
+				size_t j = candidates[k];
+				int preClusterSize = clusters[j].size(); //tracks whether the cluster accepted the new story
+				clusters[j].submitStory(headlines[i], urls[i]);
+				if (preClusterSize != clusters[j].size()) //if the cluster grew, it accepted the story
+				{
+					continueIteration = true;
+					index.addStory(j, headlines[i]);
+				}
+			}
+		}
+	}
+}
+
 //******************** NewsCluster functions **********************************
 
 // These functions simply delegate to NewsClusterImpl's functions.
@@ -154,6 +272,21 @@ string NewsCluster::getIdentifier() const
     return m_impl->getIdentifier();
 }
 
+unsigned long long NewsCluster::getFingerprint() const
+{
+    return m_impl->getFingerprint();
+}
+
+bool NewsCluster::getFirstKeyword(string& word)
+{
+    return m_impl->getFirstKeyword(word);
+}
+
+bool NewsCluster::getNextKeyword(string& word)
+{
+    return m_impl->getNextKeyword(word);
+}
+
 bool NewsCluster::getFirstNewsItem(string& headline, string& url)
 {
     return m_impl->getFirstNewsItem(headline, url);
@@ -168,3 +301,8 @@ int NewsCluster::size() const
 {
     return m_impl->size();
 }
+
+void NewsCluster::swap(NewsCluster& other)
+{
+    std::swap(m_impl, other.m_impl);
+}
@@ -0,0 +1,154 @@
+#ifndef _WORDSCANNER_H_
+#define _WORDSCANNER_H_
+
+// WordScanner finds the same words WordExtractor does (maximal runs of the
+// ASCII letters A-Z and a-z), but without copying the text: each word comes
+// back as a std::string_view into the caller's string, which must outlive
+// the scanner.  Letters are classified 16 bytes at a time with SSE2, or 32
+// with AVX2, and words shorter than minLength are skipped inside the scan,
+// so callers that only want words of MIN_WORD_SIZE or more never see the
+// short ones.
+//
+//    WordScanner ws(headline, MIN_WORD_SIZE);
+//    std::string_view word;
+//    while (ws.getNextWord(word))
+//        ...
+
+#include <string>
+#include <string_view>
+#include <cstddef>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define WORDSCANNER_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define WORDSCANNER_SSE2
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+class WordScanner
+{
+public:
+    WordScanner(std::string_view text, size_t minLength = 1)
+     : m_text(text), m_next(0), m_minLength(minLength)
+    {}
+
+    bool getNextWord(std::string_view& word)
+    {
+        for (;;)
+        {
+            size_t start = findLetter(m_next);
+            if (start == m_text.size())
+            {
+                m_next = start;
+                word = std::string_view();
+                return false;
+            }
+            m_next = findNonLetter(start + 1);
+            if (m_next - start >= m_minLength)
+            {
+                word = m_text.substr(start, m_next - start);
+                return true;
+            }
+        }
+    }
+
+    bool getNextWord(std::string& word)
+    {
+        std::string_view w;
+        bool found = getNextWord(w);
+        word.assign(w.data(), w.size());
+        return found;
+    }
+
+private:
+    std::string_view m_text;
+    size_t           m_next;
+    size_t           m_minLength;
+
+    static bool isLetter(char ch)
+    {
+          // same set as isascii(ch) && isalpha(ch) in the "C" locale
+        return static_cast<unsigned char>((ch | 0x20) - 'a') < 26;
+    }
+
+    static unsigned lowestBit(unsigned mask)
+    {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward(&index, mask);
+        return index;
+#else
+        return __builtin_ctz(mask);
+#endif
+    }
+
+#if defined(WORDSCANNER_AVX2)
+    static const size_t BLOCK = 32;
+
+    static unsigned letterMask(const char* p)
+    {
+          // (ch | 0x20) - 'a' is below 26 exactly for letters; flipping the
+          // sign bit turns that unsigned test into a signed compare
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i lower = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+        __m256i biased = _mm256_add_epi8(lower, _mm256_set1_epi8(char(0x80 - 'a')));
+        __m256i letters = _mm256_cmpgt_epi8(_mm256_set1_epi8(char(0x80 + 26)), biased);
+        return unsigned(_mm256_movemask_epi8(letters));
+    }
+#elif defined(WORDSCANNER_SSE2)
+    static const size_t BLOCK = 16;
+
+    static unsigned letterMask(const char* p)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+        __m128i biased = _mm_add_epi8(lower, _mm_set1_epi8(char(0x80 - 'a')));
+        __m128i letters = _mm_cmplt_epi8(biased, _mm_set1_epi8(char(0x80 + 26)));
+        return unsigned(_mm_movemask_epi8(letters));
+    }
+#endif
+
+      // Return the position of the first letter at or after pos, or the
+      // length of the text if there is none.
+    size_t findLetter(size_t pos) const
+    {
+#if defined(WORDSCANNER_AVX2) || defined(WORDSCANNER_SSE2)
+        for ( ; pos + BLOCK <= m_text.size(); pos += BLOCK)
+        {
+            unsigned mask = letterMask(m_text.data() + pos);
+            if (mask != 0)
+                return pos + lowestBit(mask);
+        }
+#endif
+        for ( ; pos != m_text.size(); pos++)
+            if (isLetter(m_text[pos]))
+                break;
+        return pos;
+    }
+
+      // Return the position of the first non-letter at or after pos, or
+      // the length of the text if there is none.
+    size_t findNonLetter(size_t pos) const
+    {
+#if defined(WORDSCANNER_AVX2) || defined(WORDSCANNER_SSE2)
+        const unsigned allLetters = (BLOCK == 32 ? 0xFFFFFFFFu : 0xFFFFu);
+        for ( ; pos + BLOCK <= m_text.size(); pos += BLOCK)
+        {
+            unsigned mask = ~letterMask(m_text.data() + pos) & allLetters;
+            if (mask != 0)
+                return pos + lowestBit(mask);
+        }
+#endif
+        for ( ; pos != m_text.size(); pos++)
+            if (!isLetter(m_text[pos]))
+                break;
+        return pos;
+    }
+};
+
+#endif // _WORDSCANNER_H_
@@ -18,6 +18,7 @@
 
 #include <windows.h>
 #include <wininet.h>
+#include <cstdio>
 
 #else  //  Mac OS X and LINUX
 
@@ -185,6 +186,18 @@ inline bool HTTPController::doGet(string url, char buffer[], unsigned long maxLe
     if (maxLength == 0)
         return false;
 
+      // WinINet doesn't open file:// URLs, so read local files directly
+    if (url.compare(0, 7, "file://") == 0)
+    {
+        FILE* f = fopen(url.substr(7).c_str(), "rb");
+        if (f == NULL)
+            return false;
+        size_t length = fread(buffer, 1, maxLength-1, f);
+        fclose(f);
+        buffer[length] = '\0';
+        return true;
+    }
+
     HINTERNET wininetHandle = InternetOpenUrl(m_hINet, url.c_str(), NULL, 0, INTERNET_FLAG_DONT_CACHE, 0) ;
     if ( wininetHandle == NULL )
         return false;
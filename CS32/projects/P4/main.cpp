@@ -99,7 +99,15 @@ int main(int argc, char* argv[])
 	nai.addSourceRSSFeed("http://pipes.yahoo.com/pipes/pipe.run?_id=f2f4c27df76c222acfec73277a647631&_render=rss");
 	nai.addSourceRSSFeed("http://feeds.pheedo.com/appleinsider");
 	nai.addSourceRSSFeed("http://feeds.feedburner.com/macstoriesnet?format=xml");
+	if (nai.loadSnapshot("newsagg.snapshot")) //answer from the last run while the feeds are refetched
+	{
+		nai.getCachedTopStoriesAndKeywords(2, cl, kw);
+		cerr << "Snapshot: " << cl.size() << " clusters, " << kw.size() << " keywords" << endl << endl;
+		cl.clear();
+		kw.clear();
+	}
 	nai.getTopStoriesAndKeywords(2, cl, kw);
+	nai.saveSnapshot("newsagg.snapshot");
 	url.clear();
 	for (int i = 0; i < cl.size(); i++)
 	{
@@ -117,6 +125,9 @@ int main(int argc, char* argv[])
 	{
 		cerr << kw[i].keyword << " " << kw[i].numUses << endl;
 	}
+	size_t peakBytes, steadyBytes;
+	nai.getMemoryUsage(peakBytes, steadyBytes);
+	cerr << "peak memory: " << peakBytes / 1024 << " KB, steady state: " << steadyBytes / 1024 << " KB" << endl;
 	StringMapper<string> sm;
 	sm.insert("Zach", "gay");
 	sm.insert("Zachary", "gayer");
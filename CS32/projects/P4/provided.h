@@ -101,14 +101,26 @@ public:
     bool submitKernelStory(std::string headline, std::string url);
     bool submitStory(std::string headline, std::string url);
     std::string getIdentifier() const;
+    unsigned long long getFingerprint() const;
+    bool getFirstKeyword(std::string& word);
+    bool getNextKeyword(std::string& word);
     bool getFirstNewsItem(std::string& headline, std::string& url);
     bool getNextNewsItem(std::string& headline, std::string& url);
     int size() const;
+    void swap(NewsCluster& other);
 
 private:
     NewsClusterImpl* m_impl;
 };
 
+void clusterStories(const std::vector<std::string>& headlines, const std::vector<std::string>& urls,
+                    std::vector<NewsCluster>& clusters, bool submitToAll = false);
+  // Set clusters to one cluster per story, with that story as its kernel,
+  // and submit the stories to them again and again until none grows.  A
+  // story goes only to the clusters whose members hold enough of its words
+  // between them; with submitToAll it goes to every cluster, which is
+  // slower but must give the same clusters.
+
 class Cluster
 {
 public:
@@ -170,6 +182,18 @@ public:
     void addSourceRSSFeed(std::string feed);
     int getTopStoriesAndKeywords(double thresholdPercentage,
             std::vector<Cluster>& topStories, std::vector<Keyword>& topKeywords);
+    int getCachedTopStoriesAndKeywords(double thresholdPercentage,
+            std::vector<Cluster>& topStories, std::vector<Keyword>& topKeywords) const;
+      // Same answer as getTopStoriesAndKeywords, but from the results of the
+      // last call to it (or of the last loaded snapshot) without refetching.
+    bool saveSnapshot(std::string path) const;
+    bool loadSnapshot(std::string path);
+      // Write the deduped stories, clusters and keyword counts of the last
+      // run to a binary file, or map such a file back in so that
+      // getCachedTopStoriesAndKeywords can answer from it right away.
+    void getMemoryUsage(size_t& peakBytes, size_t& steadyBytes) const;
+      // Peak process memory seen during getTopStoriesAndKeywords, and the
+      // memory still in use once the last call released its clusters.
 
 private:
     // NewsAggregator can not be copied or assigned.  We enforce this by declaring the copy constructor and assignment operator private and
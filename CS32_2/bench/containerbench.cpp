@@ -0,0 +1,639 @@
+// The same workloads run on every map, bag and set in the two CS 32 trees,
+// and on the std containers, with the results as comma-separated values.
+// Build it from this directory with Project 2's Map and homework 1's newMap,
+// each compiled on its own with its class renamed (see below), e.g.
+//     g++ -O2 -pthread -c -DMap=Proj2Map ../proj_2/Proj2/Map.cpp -o proj2map.o
+//     g++ -O2 -pthread -c -DMap=NewMap ../hw1/hw1/newMap.cpp -o newmap.o
+//     g++ -O2 -pthread containerbench.cpp proj2map.o newmap.o
+// and run it as
+//     containerbench [maxSize]
+// For each size from 1000 up to maxSize (default 1000000), by factors of
+// 10, it reports for each container and workload the milliseconds taken and
+// the most bytes allocated at once during the workload beyond what was
+// allocated when it began.  The workloads are
+//   insert random  insert the keys, in random order, into an empty container
+//   insert sorted  the same, in increasing order
+//   find hit       look up every key
+//   find miss      look up as many keys that aren't there
+//   iterate        add up the values (for bags, the counts) in one pass
+//   copy           copy the container and destroy the copy
+//   combine        combine it with a container of the same size that shares
+//   subtract       half its keys (with the same values), or subtract that
+//                  container from it
+//   erase churn    erase each key, in random order, inserting a new key
+//                  after each erase
+// A container that can't do a workload (MyHashMap and StringMapper can't
+// erase, for example) skips it, and so does one too slow at a size.  The
+// bags take the keys as items and ignore the values.  Containers whose nodes
+// come from a PoolAllocator reuse the slabs earlier workloads left in the
+// pool, so they can show little or no new memory for a workload.
+
+#include <cstddef>
+#include <cstdlib>  // for std::rand, std::srand, std::atoi, std::malloc, std::free
+#include <cctype>
+#include <climits>
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <utility>
+#include <type_traits>
+#include <thread>
+#include <atomic>
+#include <iostream>
+
+  // Project 2's Map and homework 1's newMap are both a class Map with the
+  // same member functions, so one program can't hold both under that name.
+  // Each project's .cpp file is compiled as a translation unit of its own
+  // with Map renamed (as in the build lines above), and its header is
+  // included here with the same name.  Project 2's Map.h doesn't declare
+  // its combine and subtract, so they're declared here.
+
+#define Map Proj2Map
+#include "../proj_2/Proj2/Map.h"
+#undef Map
+bool combine(const Proj2Map& m1, const Proj2Map& m2, Proj2Map& result);
+void subtract(const Proj2Map& m1, const Proj2Map& m2, Proj2Map& result);
+
+#define Map NewMap
+#include "../hw1/hw1/newMap.h"
+#undef Map
+
+#include "../hw4/hw4/Map.h"
+#include "../proj_4/AdHunter/MyHashMap.h"
+#include "../../CS32/projects/P4/Mapper.h"
+#include "../../CS32/hw4/hw4/bag.h"
+#include "../../CS32/hw4/hw4/hashbag.h"
+#include "../../CS32/prmdtrm/SortedLinkedList.h"
+
+using namespace std;
+
+//========================================================================
+//  These containers search a list (or walk one to its end) on every
+//  insert, so filling one of n items takes time proportional to n squared.
+//  Sizes above this limit skip them; raise it if you're willing to wait.
+
+const int MAX_SLOW_SIZE = 20000;
+//========================================================================
+
+//========================================================================
+// TimerType            - a type to hold a timer reading
+// TimerType getTimer() - get the current timer reading
+// double interval(TimerType start, TimerType end) - milliseconds between
+//                                                   two readings
+//========================================================================
+
+#ifdef _MSC_VER  // If we're compiling for Windows
+
+#include <windows.h>
+
+typedef LARGE_INTEGER TimerType;
+inline TimerType getTimer()
+{
+    LARGE_INTEGER t;
+    QueryPerformanceCounter(&t);
+    return t;
+}
+
+inline double interval(TimerType start, TimerType end)
+{
+    LARGE_INTEGER ticksPerSecond;
+    QueryPerformanceFrequency(&ticksPerSecond);
+    return (1000.0 * (end.QuadPart - start.QuadPart)) / ticksPerSecond.QuadPart;
+}
+
+#else // If we're not compiling for Windows, use Standard C
+
+#include <ctime>
+
+typedef clock_t TimerType;
+inline TimerType getTimer() { return clock(); }
+inline double interval(TimerType start, TimerType end)
+{
+    return (1000.0 * (end - start)) / CLOCKS_PER_SEC;
+}
+
+#endif  // ifdef _MSC_VER
+
+//========================================================================
+// Keep track of the bytes allocated.  Each block carries its size in front
+// of it, so delete can take it off again.  The workloads run on one thread,
+// so plain counters do.
+//========================================================================
+
+static size_t liveBytes = 0;
+static size_t peakBytes = 0;
+const size_t BLOCK_HEADER = alignof(max_align_t);  // keeps the block aligned
+
+void* operator new(size_t size)
+{
+    char* p = static_cast<char*>(malloc(size + BLOCK_HEADER));
+    if (p == NULL)
+        throw bad_alloc();
+    *reinterpret_cast<size_t*>(p) = size;
+    liveBytes += size;
+    if (liveBytes > peakBytes)
+        peakBytes = liveBytes;
+    return p + BLOCK_HEADER;
+}
+
+void operator delete(void* p) noexcept
+{
+    if (p == NULL)
+        return;
+    char* block = static_cast<char*>(p) - BLOCK_HEADER;
+    liveBytes -= *reinterpret_cast<size_t*>(block);
+    free(block);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    operator delete(p);
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete[](void* p) noexcept
+{
+    operator delete(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+    operator delete(p);
+}
+
+//========================================================================
+
+  // Time one workload from construction until done(), and report it with
+  // the most memory allocated at once beyond what was allocated at the start
+
+class Trial
+{
+  public:
+    Trial(string container, string workload, int n)
+     : m_container(container), m_workload(workload), m_n(n), m_base(liveBytes)
+    {
+        peakBytes = liveBytes;
+        m_start = getTimer();
+    }
+    void done()
+    {
+        TimerType end = getTimer();
+        cout << m_container << "," << m_workload << "," << m_n << ","
+             << interval(m_start, end) << "," << (peakBytes - m_base) << endl;
+    }
+
+  private:
+    string    m_container;
+    string    m_workload;
+    int       m_n;
+    size_t    m_base;
+    TimerType m_start;
+};
+
+  // Return a random number; rand() alone may only produce 15 bits
+
+unsigned bigRand()
+{
+    return (unsigned(rand()) << 15) ^ unsigned(rand());
+}
+
+  // The keys for one size of the workloads
+
+struct Keys
+{
+    vector<pair<string, double> > sorted;    // n pairs in increasing order of key
+    vector<pair<string, double> > shuffled;  // the same pairs in random order
+    vector<pair<string, double> > other;     // n pairs, half of them in shuffled
+    vector<string>                missing;   // n keys not in sorted (or other)
+};
+
+void makeKeys(int n, Keys& keys)
+{
+    for (int k = 0; k < n; k++)
+        keys.sorted.push_back(make_pair("key #" + to_string(k), k + 0.5));
+    keys.shuffled = keys.sorted;
+    for (int k = n - 1; k > 0; k--)
+        swap(keys.shuffled[k], keys.shuffled[bigRand() % (k + 1)]);
+    sort(keys.sorted.begin(), keys.sorted.end());
+    keys.other.assign(keys.shuffled.begin() + n/2, keys.shuffled.end());
+    for (int k = n; int(keys.other.size()) < n; k++)
+        keys.other.push_back(make_pair("key #" + to_string(k), k + 0.5));
+    for (int k = 0; k < n; k++)
+        keys.missing.push_back("no key #" + to_string(k));
+}
+
+//========================================================================
+// Each container is run through a struct of static functions that do the
+// workloads' operations on it:
+//   Container                 the container's type
+//   maxSize()                 the largest size to run it at
+//   insert(c, key, value), find(c, key, value), size(c), sum(c)
+// and, if it can erase, copy, or combine and subtract:
+//   canErase   erase(c, key)
+//   canCopy    copy(c), which copies c, destroys the copy, and returns its size
+//   canCombine combine(c1, c2, result), subtract(c1, c2, result)
+// The ones it can't do come from Basic and are never called.
+//========================================================================
+
+struct Basic
+{
+    static const bool canErase = false;
+    static const bool canCopy = false;
+    static const bool canCombine = false;
+    static int maxSize() { return INT_MAX; }
+    template <typename C> static bool erase(C&, const string&) { return false; }
+    template <typename C> static int copy(const C&) { return 0; }
+    template <typename C> static void combine(const C&, const C&, C&) {}
+    template <typename C> static void subtract(const C&, const C&, C&) {}
+};
+
+  // Project 2's Map:  a hash table over an array of pairs
+
+struct Proj2MapOps : Basic
+{
+    typedef Proj2Map Container;
+    static const bool canErase = true;
+    static const bool canCopy = true;
+    static const bool canCombine = true;
+
+    static void insert(Container& c, const string& key, double value) { c.insert(key, value); }
+    static bool find(const Container& c, const string& key, double& value) { return c.get(key, value); }
+    static bool erase(Container& c, const string& key) { return c.erase(key); }
+    static int size(const Container& c) { return c.size(); }
+    static int copy(const Container& c) { Container copy(c); return copy.size(); }
+    static double sum(const Container& c)
+    {
+        double total = 0;
+        string key;
+        double value;
+        for (int i = 0; i < c.size(); i++)
+        {
+            c.get(i, key, value);
+            total += value;
+        }
+        return total;
+    }
+    static void combine(const Container& c1, const Container& c2, Container& result) { ::combine(c1, c2, result); }
+    static void subtract(const Container& c1, const Container& c2, Container& result) { ::subtract(c1, c2, result); }
+};
+
+  // Homework 1's newMap:  a sorted array
+
+struct NewMapOps : Basic
+{
+    typedef NewMap Container;
+    static const bool canErase = true;
+    static const bool canCopy = true;
+
+    static int maxSize() { return MAX_SLOW_SIZE; }
+    static void insert(Container& c, const string& key, double value) { c.insert(key, value); }
+    static bool find(const Container& c, const string& key, double& value) { return c.get(key, value); }
+    static bool erase(Container& c, const string& key) { return c.erase(key); }
+    static int size(const Container& c) { return c.size(); }
+    static int copy(const Container& c) { Container copy(c); return copy.size(); }
+    static double sum(const Container& c)
+    {
+        double total = 0;
+        string key;
+        double value;
+        for (int i = 0; i < c.size(); i++)
+        {
+            c.get(i, key, value);
+            total += value;
+        }
+        return total;
+    }
+};
+
+  // Homework 4's Map template, with each storage
+
+template <template <typename, typename> class Storage>
+struct TemplateMapOps : Basic
+{
+    typedef ::Map<string, double, Storage> Container;
+    static const bool canErase = true;
+    static const bool canCopy = true;
+    static const bool canCombine = true;
+
+    static int maxSize() { return is_same<Container, ::Map<string, double, ListStorage> >::value ? MAX_SLOW_SIZE : INT_MAX; }
+    static void insert(Container& c, const string& key, double value) { c.insert(key, value); }
+    static bool find(const Container& c, const string& key, double& value) { return c.get(key, value); }
+    static bool erase(Container& c, const string& key) { return c.erase(key); }
+    static int size(const Container& c) { return c.size(); }
+    static int copy(const Container& c) { Container copy(c); return copy.size(); }
+    static double sum(const Container& c)
+    {
+        double total = 0;
+        for (auto e : c)
+            total += e.second;
+        return total;
+    }
+    static void combine(const Container& c1, const Container& c2, Container& result) { ::combine(c1, c2, result); }
+    static void subtract(const Container& c1, const Container& c2, Container& result) { ::subtract(c1, c2, result); }
+};
+
+  // Project 4's MyHashMap (AdHunter).  It has no erase, and no copy
+  // constructor of its own, so copies would share its records.
+
+struct MyHashMapOps : Basic
+{
+    typedef MyHashMap<double> Container;
+
+    static void insert(Container& c, const string& key, double value) { c.associate(key, value); }
+    static bool find(const Container& c, const string& key, double& value)
+    {
+        const double* p = c.find(key);
+        if (p == NULL)
+            return false;
+        value = *p;
+        return true;
+    }
+    static int size(const Container& c) { return c.numItems(); }
+    static double sum(const Container& c)
+    {
+        double total = 0;
+        for (Container::const_iterator it = c.begin(); it != c.end(); ++it)
+            total += it->second;
+        return total;
+    }
+};
+
+  // Project 4's StringMapper (NewsAgg):  a binary search tree, and a list
+  // in insertion order that each insert walks to its end.  It has no erase.
+
+struct StringMapperOps : Basic
+{
+    typedef StringMapper<double> Container;
+    static const bool canCopy = true;
+
+    static int maxSize() { return MAX_SLOW_SIZE; }
+    static void insert(Container& c, const string& key, double value) { c.insert(key, value); }
+    static bool find(const Container& c, const string& key, double& value) { return c.find(key, value); }
+    static int size(const Container& c) { return c.size(); }
+    static int copy(const Container& c) { Container copy(c); return copy.size(); }
+    static double sum(const Container& c)
+    {
+        double total = 0;
+        for (Container::const_iterator it = c.begin(); it != c.end(); ++it)
+            total += it->second;
+        return total;
+    }
+};
+
+  // Homework 4's Bag (a sorted linked list) and HashBag; the value found is
+  // the count, and erase takes out every instance
+
+template <class BagType>
+struct BagOps : Basic
+{
+    typedef BagType Container;
+    static const bool canErase = true;
+    static const bool canCopy = true;
+    static const bool canCombine = true;
+
+    static int maxSize() { return is_same<BagType, Bag<string> >::value ? MAX_SLOW_SIZE : INT_MAX; }
+    static void insert(Container& c, const string& key, double) { c.insert(key); }
+    static bool find(const Container& c, const string& key, double& value)
+    {
+        int n = c.count(key);
+        value = n;
+        return n != 0;
+    }
+    static bool erase(Container& c, const string& key) { return c.eraseAll(key) != 0; }
+    static int size(const Container& c) { return c.uniqueSize(); }
+    static int copy(const Container& c) { Container copy(c); return copy.uniqueSize(); }
+    static double sum(const Container& c)
+    {
+        double total = 0;
+        for (typename Container::const_iterator it = c.begin(); it != c.end(); ++it)
+            total += it.count();
+        return total;
+    }
+    static void combine(const Container& c1, const Container& c2, Container& result) { ::combine(c1, c2, result); }
+    static void subtract(const Container& c1, const Container& c2, Container& result) { ::subtract(c1, c2, result); }
+};
+
+  // The SortedLinkedList of the practice midterm.  It's a set, so it
+  // ignores the values, and it can't be copied.
+
+struct SortedLinkedListOps : Basic
+{
+    typedef SortedLinkedList<string> Container;
+    static const bool canErase = true;
+
+    static int maxSize() { return MAX_SLOW_SIZE; }
+    static void insert(Container& c, const string& key, double) { c.insert(key); }
+    static bool find(const Container& c, const string& key, double& value)
+    {
+        value = 1;
+        return c.search(key) != NULL;
+    }
+    static bool erase(Container& c, const string& key)
+    {
+        Container::Node* p = c.search(key);
+        if (p == NULL)
+            return false;
+        c.remove(p);
+        return true;
+    }
+    static int size(const Container& c) { return c.size(); }
+    static double sum(const Container& c)
+    {
+        double total = 0;
+        for (const Container::Node* p = c.first(); p != NULL; p = p->m_next)
+            total++;
+        return total;
+    }
+};
+
+  // std::map and std::unordered_map, with combine and subtract written as
+  // Map's are specified:  a key in both with different values is left out
+  // of the combination
+
+template <class StdMap>
+struct StdMapOps : Basic
+{
+    typedef StdMap Container;
+    static const bool canErase = true;
+    static const bool canCopy = true;
+    static const bool canCombine = true;
+
+    static void insert(Container& c, const string& key, double value) { c.insert(make_pair(key, value)); }
+    static bool find(const Container& c, const string& key, double& value)
+    {
+        typename Container::const_iterator it = c.find(key);
+        if (it == c.end())
+            return false;
+        value = it->second;
+        return true;
+    }
+    static bool erase(Container& c, const string& key) { return c.erase(key) != 0; }
+    static int size(const Container& c) { return int(c.size()); }
+    static int copy(const Container& c) { Container copy(c); return int(copy.size()); }
+    static double sum(const Container& c)
+    {
+        double total = 0;
+        for (typename Container::const_iterator it = c.begin(); it != c.end(); ++it)
+            total += it->second;
+        return total;
+    }
+    static void combine(const Container& c1, const Container& c2, Container& result)
+    {
+        Container res(c1);
+        for (typename Container::const_iterator it = c2.begin(); it != c2.end(); ++it)
+        {
+            typename Container::iterator there = res.find(it->first);
+            if (there == res.end())
+                res.insert(*it);
+            else if (there->second != it->second)
+                res.erase(there);
+        }
+        result.swap(res);
+    }
+    static void subtract(const Container& c1, const Container& c2, Container& result)
+    {
+        Container res(c1);
+        for (typename Container::const_iterator it = c2.begin(); it != c2.end(); ++it)
+            res.erase(it->first);
+        result.swap(res);
+    }
+};
+
+//========================================================================
+
+  // Run every workload the container can do on the keys
+
+template <class Ops>
+void runWorkloads(string container, const Keys& keys)
+{
+    typedef typename Ops::Container Container;
+    int n = int(keys.sorted.size());
+    if (n > Ops::maxSize())
+        return;
+    double check = 0;  // use the results so the loops aren't optimized away
+
+    {
+        Trial t(container, "insert random", n);
+        Container c;
+        for (int k = 0; k < n; k++)
+            Ops::insert(c, keys.shuffled[k].first, keys.shuffled[k].second);
+        t.done();
+        check += Ops::size(c);
+    }
+    {
+        Trial t(container, "insert sorted", n);
+        Container c;
+        for (int k = 0; k < n; k++)
+            Ops::insert(c, keys.sorted[k].first, keys.sorted[k].second);
+        t.done();
+        check += Ops::size(c);
+    }
+
+    Container c;
+    for (int k = 0; k < n; k++)
+        Ops::insert(c, keys.shuffled[k].first, keys.shuffled[k].second);
+
+    {
+        Trial t(container, "find hit", n);
+        for (int k = 0; k < n; k++)
+        {
+            double value;
+            if (Ops::find(c, keys.shuffled[k].first, value))
+                check += value;
+        }
+        t.done();
+    }
+    {
+        Trial t(container, "find miss", n);
+        for (int k = 0; k < n; k++)
+        {
+            double value;
+            if (Ops::find(c, keys.missing[k], value))
+                check -= value;
+        }
+        t.done();
+    }
+    {
+        Trial t(container, "iterate", n);
+        check += Ops::sum(c);
+        t.done();
+    }
+    if (Ops::canCopy)
+    {
+        Trial t(container, "copy", n);
+        check += Ops::copy(c);
+        t.done();
+    }
+    if (Ops::canCombine)
+    {
+        Container other;
+        for (int k = 0; k < n; k++)
+            Ops::insert(other, keys.other[k].first, keys.other[k].second);
+        Container result;
+        {
+            Trial t(container, "combine", n);
+            Ops::combine(c, other, result);
+            t.done();
+        }
+        check += Ops::size(result);
+        {
+            Trial t(container, "subtract", n);
+            Ops::subtract(c, other, result);
+            t.done();
+        }
+        check += Ops::size(result);
+    }
+    if (Ops::canErase)
+    {
+        Trial t(container, "erase churn", n);
+        for (int k = 0; k < n; k++)
+        {
+            check += Ops::erase(c, keys.shuffled[k].first);
+            Ops::insert(c, keys.missing[k], k);
+        }
+        t.done();
+    }
+
+    if (check < 0)  // never true
+        cout << check << endl;
+}
+
+int main(int argc, char* argv[])
+{
+    int maxSize = (argc > 1 ? atoi(argv[1]) : 1000000);
+    if (maxSize <= 0)
+    {
+        cout << "usage: " << argv[0] << " [maxSize]" << endl;
+        return 1;
+    }
+
+    cout << "container,workload,size,ms,peak bytes" << endl;
+    for (int n = 1000; n <= maxSize; n *= 10)
+    {
+        srand(n);  // same keys for the same size every run
+        Keys keys;
+        makeKeys(n, keys);
+        runWorkloads<StdMapOps<map<string, double> > >("std::map", keys);
+        runWorkloads<StdMapOps<unordered_map<string, double> > >("std::unordered_map", keys);
+        runWorkloads<Proj2MapOps>("proj2 Map", keys);
+        runWorkloads<NewMapOps>("hw1 newMap", keys);
+        runWorkloads<TemplateMapOps<ListStorage> >("Map<ListStorage>", keys);
+        runWorkloads<TemplateMapOps<HashStorage> >("Map<HashStorage>", keys);
+        runWorkloads<TemplateMapOps<BTreeStorage> >("Map<BTreeStorage>", keys);
+        runWorkloads<MyHashMapOps>("MyHashMap", keys);
+        runWorkloads<StringMapperOps>("StringMapper", keys);
+        runWorkloads<BagOps<Bag<string> > >("Bag", keys);
+        runWorkloads<BagOps<HashBag<string> > >("HashBag", keys);
+        runWorkloads<SortedLinkedListOps>("SortedLinkedList", keys);
+    }
+}
@@ -0,0 +1,73 @@
+#include "ConcurrentSalaryMap.h"
+#include <iostream>
+#include <string>
+#include <mutex>
+#include <functional>
+
+using namespace std;
+
+ConcurrentSalaryMap::ConcurrentSalaryMap(int nShards)
+ : m_shards(nShards > 0 ? nShards : 1), m_size(0)
+{}
+
+ConcurrentSalaryMap::Shard& ConcurrentSalaryMap::shardFor(const string& name)
+{
+	return m_shards[hash<string>()(name) % m_shards.size()];
+}
+
+const ConcurrentSalaryMap::Shard& ConcurrentSalaryMap::shardFor(const string& name) const
+{
+	return m_shards[hash<string>()(name) % m_shards.size()];
+}
+
+bool ConcurrentSalaryMap::add(const string& name, double salary)
+{
+	Shard& s = shardFor(name);
+	unique_lock<shared_mutex> guard(s.m_lock); //only this thread may change the shard
+
+	if (!s.m_salaries.emplace(name, salary).second)
+		return false; //the employee was already there
+	m_size++;
+	return true;
+}
+
+bool ConcurrentSalaryMap::raise(const string& name, double pct)
+{
+	if (pct < -100)
+		return false;
+
+	Shard& s = shardFor(name);
+	unique_lock<shared_mutex> guard(s.m_lock);
+
+	auto it = s.m_salaries.find(name);
+	if (it == s.m_salaries.end())
+		return false;
+	it->second += pct*it->second*.01; //updates the salary + the pct, all under one lock
+	return true;
+}
+
+double ConcurrentSalaryMap::salary(const string& name) const
+{
+	const Shard& s = shardFor(name);
+	shared_lock<shared_mutex> guard(s.m_lock); //other readers may share the shard
+
+	auto it = s.m_salaries.find(name);
+	if (it == s.m_salaries.end())
+		return -1; //didn't find the key name
+	return it->second;
+}
+
+int ConcurrentSalaryMap::size() const
+{
+	return m_size;
+}
+
+void ConcurrentSalaryMap::print() const
+{
+	for (size_t k = 0; k < m_shards.size(); k++)
+	{
+		shared_lock<shared_mutex> guard(m_shards[k].m_lock);
+		for (auto it = m_shards[k].m_salaries.begin(); it != m_shards[k].m_salaries.end(); it++)
+			cout << it->first << " " << it->second << endl;
+	}
+}
@@ -0,0 +1,65 @@
+#ifndef CONCURRENTSALARYMAP_H
+#define CONCURRENTSALARYMAP_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <shared_mutex>
+#include <atomic>
+
+const int DEFAULT_SHARDS = 64;
+
+  // A SalaryMap that any number of threads may use at once.  Employees are
+  // spread by a hash of their name over a number of shards, each with its
+  // own lock, so threads working on different employees seldom wait for
+  // each other.  Any number of salary() calls may read a shard together;
+  // add and raise lock it for themselves.  Unlike SalaryMap, it has no
+  // fixed capacity.
+
+class ConcurrentSalaryMap
+{
+    public:
+    ConcurrentSalaryMap(int nShards = DEFAULT_SHARDS);
+        // Create an empty salary map.  With one shard, every call takes the
+        // same lock.
+    ConcurrentSalaryMap(const ConcurrentSalaryMap&) = delete;
+    ConcurrentSalaryMap& operator=(const ConcurrentSalaryMap&) = delete;
+
+    bool add(const std::string& name, double salary);
+        // If an employee with the given name has not previously been added,
+        // add an entry for that employee and salary and return true.
+        // Otherwise make no change to the map and return false.
+
+    bool raise(const std::string& name, double pct);
+        // If no employee with the given name is in the map or if pct is less
+        // than -100, make no change to the map and return false.  Otherwise,
+        // change the salary of the indicated employee by the given
+        // percentage and return true.
+
+    double salary(const std::string& name) const;
+        // If an employee with the given name is in the map, return that
+        // employee's salary; otherwise, return -1.
+
+    int size() const;  // Return the number of employees in the map.
+
+    void print() const;
+        // Write to cout one line for every employee in the map.  Each shard
+        // is printed under its lock, but the shards are printed one after
+        // another, so changes made meanwhile may show up in some shards and
+        // not others.
+
+    private:
+	struct alignas(64) Shard //a cache line each, so locking one shard doesn't slow its neighbours
+	{
+		mutable std::shared_mutex			m_lock;
+		std::unordered_map<std::string, double>	m_salaries;
+	};
+
+	std::vector<Shard>	m_shards;
+	std::atomic<int>	m_size; //kept apart from the shards so size() takes no lock
+
+	Shard& shardFor(const std::string& name);
+	const Shard& shardFor(const std::string& name) const;
+};
+
+#endif
@@ -1,6 +1,9 @@
 #include "SalaryMap.h"
 #include <iostream>
 #include <string>
+#include <vector>
+#include <algorithm>
+#include <cmath>
 
 using namespace std;
 SalaryMap::SalaryMap()
@@ -8,42 +11,135 @@ SalaryMap::SalaryMap()
 
 bool SalaryMap::add(string name, double salary)
 {
-	return (m_salaries.insert(name, salary));
+	if (!m_positions.insert(name, m_salaries.size()))
+		return false; //already there, or the name map is full
+
+	m_salaries.push_back(salary);
+	m_names.push_back(name);
+	return true;
 }
 
 bool SalaryMap::raise(string name, double pct)
 {
-	if (pct < -100 || !m_salaries.contains(name))
+	double pos; //holds the position of the employee's salary
+	if (pct < -100 || !m_positions.get(name, pos))
 		return false;
 
-	double oldSal; //holds the old salary of the employee
-	m_salaries.get(name, oldSal);
-	m_salaries.update(name, oldSal + (pct*oldSal*.01)); //updates the salary + the pct
+	double& sal = m_salaries[int(pos)];
+	sal = sal + (pct*sal*.01); //updates the salary + the pct
 	return true;
 }
 
 double SalaryMap::salary(string name) const
 {
-	double sal;
-	if (m_salaries.get(name, sal))
-		return sal;
+	double pos;
+	if (m_positions.get(name, pos))
+		return m_salaries[int(pos)];
 
 	return -1; //didn't find the key name in the list
 }
 
 int SalaryMap::size() const
 {
-	return m_salaries.size();
+	return int(m_salaries.size());
 }
 
 void SalaryMap::print() const
 {
-	string name;
-	double salary;
-	for (int i = 0; i < size(); i++)
+	for (size_t i = 0; i < m_salaries.size(); i++)
+		cout << m_names[i] << " " << m_salaries[i] << endl;
+}
+
+bool SalaryMap::raiseAll(double pct)
+{
+	if (pct < -100)
+		return false;
+
+	//same arithmetic as raise, so both give identical salaries; nothing but
+	//the multiply in the loop, so the compiler can vectorize it
+	double* sal = m_salaries.data();
+	size_t n = m_salaries.size();
+	for (size_t i = 0; i < n; i++)
+		sal[i] = sal[i] + (pct*sal[i]*.01);
+	return true;
+}
+
+int SalaryMap::raiseAll(const vector<string>& names, double pct)
+{
+	if (pct < -100)
+		return 0;
+
+	//each name costs a lookup, but the raises themselves go in one pass;
+	//a name listed twice is counted twice, as with two calls to raise
+	vector<unsigned char> chosen(m_salaries.size());
+	int count = 0;
+	for (size_t k = 0; k < names.size(); k++)
 	{
-		m_salaries.get(i, name, salary);
-		cout << name << " " << salary << endl;
+		double pos;
+		if (m_positions.get(names[k], pos))
+		{
+			int i = int(pos);
+			if (chosen[i]) //listed again (rare), so give the extra raise now
+				m_salaries[i] = m_salaries[i] + (pct*m_salaries[i]*.01);
+			chosen[i] = 1;
+			count++;
+		}
 	}
+	applyRaise(chosen, pct);
+	return count;
 }
 
+void SalaryMap::applyRaise(const vector<unsigned char>& chosen, double pct)
+{
+	double* sal = m_salaries.data();
+	const unsigned char* pick = chosen.data();
+	size_t n = m_salaries.size();
+	for (size_t i = 0; i < n; i++)
+		sal[i] = pick[i] ? sal[i] + (pct*sal[i]*.01) : sal[i]; //a select, not a branch
+}
+
+double SalaryMap::sum() const
+{
+	//four running totals, so the additions don't all wait on one another
+	//and can be done a vector at a time
+	const double* sal = m_salaries.data();
+	size_t n = m_salaries.size();
+	double t0 = 0, t1 = 0, t2 = 0, t3 = 0;
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4)
+	{
+		t0 += sal[i];
+		t1 += sal[i+1];
+		t2 += sal[i+2];
+		t3 += sal[i+3];
+	}
+	for (; i < n; i++)
+		t0 += sal[i];
+	return (t0 + t1) + (t2 + t3);
+}
+
+double SalaryMap::mean() const
+{
+	if (m_salaries.empty())
+		return 0;
+	return sum() / m_salaries.size();
+}
+
+double SalaryMap::percentile(double p) const
+{
+	if (m_salaries.empty() || p < 0 || p > 100)
+		return -1;
+
+	//nearest rank: the ceil(p% of n)th smallest, but at least the first
+	size_t n = m_salaries.size();
+	size_t rank = size_t(ceil(p / 100 * n));
+	if (rank < 1)
+		rank = 1;
+	if (rank > n)
+		rank = n;
+
+	//partial selection on a copy takes linear time instead of a full sort
+	vector<double> copy(m_salaries);
+	nth_element(copy.begin(), copy.begin() + (rank - 1), copy.end());
+	return copy[rank - 1];
+}
@@ -2,6 +2,8 @@
 #define SALARYMAP_H
 
 #include "Map.h"
+#include <string>
+#include <vector>
 
 class SalaryMap
 {
@@ -32,8 +34,60 @@ class SalaryMap
         // has the employee's name, followed by one space, followed by that
         // employee's salary.
 
+      // Bulk operations.  These work straight through the array of salaries
+      // instead of looking each employee up by name.
+
+    bool raiseAll(double pct);
+        // If pct is less than -100, make no change and return false.
+        // Otherwise give every employee the raise and return true.
+
+    int raiseAll(const std::vector<std::string>& names, double pct);
+        // The same as calling raise(name, pct) for each name in the list.
+        // Return the number of raises given.
+
+    template<typename Predicate>
+    int raiseIf(Predicate pred, double pct);
+        // Give the raise to every employee for whom pred(name, salary) is
+        // true, and return the number of raises given (0 if pct is less
+        // than -100).
+
+    double sum() const;   // Return the total of all the salaries.
+
+    double mean() const;
+        // Return the average salary, or 0 if the map is empty.
+
+    double percentile(double p) const;
+        // Return the smallest salary that at least p percent of the
+        // employees earn at most (the nearest-rank percentile), so 0 gives
+        // the lowest salary, 50 the median and 100 the highest.  If the map
+        // is empty or p is not between 0 and 100, return -1.
+
     private:
-		Map m_salaries;
+		Map m_positions; //name -> position of that employee in the arrays below
+						 //(a double holds any position exactly)
+		std::vector<double> m_salaries; //contiguous, so bulk loops can be vectorized
+		std::vector<std::string> m_names; //m_names[i] is the employee paid m_salaries[i]
+
+		void applyRaise(const std::vector<unsigned char>& chosen, double pct);
+			//raise the salary at every position i where chosen[i] is nonzero
 };
 
+template<typename Predicate>
+int SalaryMap::raiseIf(Predicate pred, double pct)
+{
+	if (pct < -100)
+		return 0;
+
+	//pick the employees first, then raise them in one branch-free loop
+	std::vector<unsigned char> chosen(m_salaries.size());
+	int count = 0;
+	for (size_t i = 0; i < m_salaries.size(); i++)
+	{
+		chosen[i] = pred(m_names[i], m_salaries[i]) ? 1 : 0;
+		count += chosen[i];
+	}
+	applyRaise(chosen, pct);
+	return count;
+}
+
 #endif
\ No newline at end of file
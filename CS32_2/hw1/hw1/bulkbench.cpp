@@ -0,0 +1,157 @@
+// Timing tests for SalaryMap's bulk operations against doing the same work
+// one employee at a time through raise() and salary().  Build it on its own
+// (it has its own main) with SalaryMap.cpp and Map.cpp, e.g.
+//     g++ -O3 -march=native bulkbench.cpp SalaryMap.cpp Map.cpp
+// and run it as
+//     bulkbench [rounds]
+// The map is filled to its capacity of DEFAULT_MAX_ITEMS employees, and
+// each test is repeated rounds times (default 20000).  Times are reported
+// in nanoseconds per employee.
+
+#include "SalaryMap.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdlib>  // for std::atoi
+#include <cassert>
+
+using namespace std;
+
+//========================================================================
+// TimerType            - a type to hold a timer reading
+// TimerType getTimer() - get the current timer reading
+// double interval(TimerType start, TimerType end) - milliseconds between
+//                                                   two readings
+//========================================================================
+
+#ifdef _MSC_VER  // If we're compiling for Windows
+
+#include <windows.h>
+
+typedef LARGE_INTEGER TimerType;
+inline TimerType getTimer()
+{
+    LARGE_INTEGER t;
+    QueryPerformanceCounter(&t);
+    return t;
+}
+
+inline double interval(TimerType start, TimerType end)
+{
+    LARGE_INTEGER ticksPerSecond;
+    QueryPerformanceFrequency(&ticksPerSecond);
+    return (1000.0 * (end.QuadPart - start.QuadPart)) / ticksPerSecond.QuadPart;
+}
+
+#else // If we're not compiling for Windows, use Standard C
+
+#include <ctime>
+
+typedef clock_t TimerType;
+inline TimerType getTimer() { return clock(); }
+inline double interval(TimerType start, TimerType end)
+{
+    return (1000.0 * (end - start)) / CLOCKS_PER_SEC;
+}
+
+#endif  // ifdef _MSC_VER
+
+//========================================================================
+
+  // Report the results of a timing test
+
+void report(string caption, double ms, int rounds, int employees)
+{
+    cout << (ms * 1e6 / rounds / employees) << " ns per employee; " << caption << endl;
+}
+
+int main(int argc, char* argv[])
+{
+    int rounds = (argc > 1 ? atoi(argv[1]) : 20000);
+    if (rounds <= 0)
+    {
+        cout << "usage: " << argv[0] << " [rounds]" << endl;
+        return 1;
+    }
+
+    vector<string> names;
+    vector<string> department;  // every other employee
+    SalaryMap s;
+    for (int k = 0; k < DEFAULT_MAX_ITEMS; k++)
+    {
+        names.push_back("employee" + to_string(k));
+        if (k % 2 == 0)
+            department.push_back(names[k]);
+        assert(s.add(names[k], 40000 + 100 * k));
+    }
+    int n = s.size();
+
+      // Raises alternate between up and down so salaries stay in range
+
+    TimerType start = getTimer();
+    for (int r = 0; r < rounds; r++)
+    {
+        double pct = (r % 2 == 0 ? 1.0 : -1.0);
+        for (int k = 0; k < n; k++)
+            s.raise(names[k], pct);
+    }
+    TimerType end = getTimer();
+    report("raise() each employee", interval(start, end), rounds, n);
+
+    start = getTimer();
+    for (int r = 0; r < rounds; r++)
+        s.raiseAll(r % 2 == 0 ? 1.0 : -1.0);
+    end = getTimer();
+    report("raiseAll(pct)", interval(start, end), rounds, n);
+
+    start = getTimer();
+    for (int r = 0; r < rounds; r++)
+    {
+        double pct = (r % 2 == 0 ? 1.0 : -1.0);
+        for (size_t k = 0; k < department.size(); k++)
+            s.raise(department[k], pct);
+    }
+    end = getTimer();
+    report("raise() each of half the employees", interval(start, end), rounds, n);
+
+    start = getTimer();
+    for (int r = 0; r < rounds; r++)
+        s.raiseAll(department, r % 2 == 0 ? 1.0 : -1.0);
+    end = getTimer();
+    report("raiseAll(names, pct) of half the employees", interval(start, end), rounds, n);
+
+    start = getTimer();
+    for (int r = 0; r < rounds; r++)
+        s.raiseIf([](const string&, double salary) { return salary < 50000; }, r % 2 == 0 ? 1.0 : -1.0);
+    end = getTimer();
+    report("raiseIf(salary < 50000, pct)", interval(start, end), rounds, n);
+
+      // Totals; the checksums keep the work from being optimized away
+
+    double loopTotal = 0;
+    start = getTimer();
+    for (int r = 0; r < rounds; r++)
+    {
+        for (int k = 0; k < n; k++)
+            loopTotal += s.salary(names[k]);
+    }
+    end = getTimer();
+    report("salary() of each employee, summed", interval(start, end), rounds, n);
+
+    double bulkTotal = 0;
+    start = getTimer();
+    for (int r = 0; r < rounds; r++)
+        bulkTotal += s.sum();
+    end = getTimer();
+    report("sum()", interval(start, end), rounds, n);
+
+    double median = 0;
+    start = getTimer();
+    for (int r = 0; r < rounds; r++)
+        median += s.percentile(50);
+    end = getTimer();
+    report("percentile(50)", interval(start, end), rounds, n);
+
+    cout << "checksums: " << loopTotal / rounds << " " << bulkTotal / rounds
+         << " " << median / rounds << " " << s.mean() << endl;
+}
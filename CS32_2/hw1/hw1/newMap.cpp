@@ -1,34 +1,42 @@
 #include <iostream>
+#include <utility>
 #include "newMap.h"
 
 
-Map::Map() : m_size_max(DEFAULT_MAX_ITEMS), m_size_used(0)
+Map::Map() : m_items(m_inline), m_size_max(INLINE_ITEMS), m_size_used(0)
 {
-	m_items = new Pair[DEFAULT_MAX_ITEMS];
+	//starts out in the inline buffer; nothing to allocate
 }
 
-Map::Map(int n) : m_size_max(n), m_size_used(0)
+Map::Map(int n) : m_items(m_inline), m_size_max(INLINE_ITEMS), m_size_used(0)
 {
 	if (n < 0)
 	{
 		std::cout << "Fatal error: array has too few elements. Exiting.\n";
 		exit(0);
-	} 
-	m_items = new Pair[n];
+	}
+	if (n > INLINE_ITEMS)
+	{
+		m_items = new Pair[n];
+		m_size_max = n;
+	}
 	//we leave the array uninitialized because we will only access
 	//elements up to the tracked size of the array
 }
 
 Map::~Map()
 {
-	delete [] m_items;
+	if (!isInline())
+		delete [] m_items;
 }
 
-Map::Map(const Map& src)
+Map::Map(const Map& src) : m_items(m_inline), m_size_max(INLINE_ITEMS), m_size_used(src.m_size_used)
 {
-	m_size_used = src.m_size_used;
-	m_size_max = src.m_size_max;
-	m_items = new Pair[m_size_max];
+	if (m_size_used > INLINE_ITEMS)
+	{	//only as much room as the pairs need; it grows later if needed
+		m_size_max = m_size_used;
+		m_items = new Pair[m_size_max];
+	}
 
 	//copies over all the pairs from the src
 	for(int i = 0; i < m_size_used; i++)
@@ -37,19 +45,12 @@ Map::Map(const Map& src)
 
 Map& Map::operator=(const Map& src)
 {
-	if (m_items == src.m_items)
+	if (this == &src)
 		return (*this); //prevents aliasing
 
-	m_size_max = src.m_size_max;
-	m_size_used = src.m_size_used;
-
-	//need to resize the array, so better to just delete and make again
-	delete [] m_items;
-	m_items = new Pair[m_size_max];
-	//copies over all the pairs from src
-	for(int i = 0; i < m_size_used; i++)
-		m_items[i] = src.m_items[i];
-	
+	//copy first, so *this is untouched if the copy fails
+	Map temp(src);
+	swap(temp);
 	return (*this);
 }
 
@@ -60,40 +61,64 @@ bool Map::empty() const
 
 int Map::size() const
 {
-	return m_size_used; 
+	return m_size_used;
 }
 
-bool Map::insert(const KeyType& key, const ValueType& value)
+int Map::find(const KeyType& key) const
 {
-	if (size() == m_size_max || contains(key))
-		return false; //does not perform the insert if no room or if 
-					  //the key already exists in the array
+	//binary search of the sorted pairs
+	int lo = 0;
+	int hi = m_size_used;
+	while (lo < hi)
+	{
+		int mid = (lo + hi) / 2;
+		if (m_items[mid].m_key < key)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
 
-	//create a new Pair and insert it into the array; increment size
-	Pair p;
-	p.m_key = key;
-	p.m_value = value;
+void Map::grow()
+{
+	//doubling keeps the total cost of copying linear in the number of inserts
+	int newMax = 2 * m_size_max;
+	Pair* newItems = new Pair[newMax];
+	for (int i = 0; i < m_size_used; i++)
+		newItems[i] = std::move(m_items[i]);
+	if (!isInline())
+		delete [] m_items;
+	m_items = newItems;
+	m_size_max = newMax;
+}
 
-	m_items[m_size_used] = p;
+bool Map::insert(const KeyType& key, const ValueType& value)
+{
+	int pos = find(key);
+	if (pos < m_size_used && m_items[pos].m_key == key)
+		return false; //does not perform the insert if the key already exists in the array
+
+	if (m_size_used == m_size_max)
+		grow(); //no room, so make some
+
+	//shift everything after pos over by one to keep the array sorted; increment size
+	for (int i = m_size_used; i > pos; i--)
+		m_items[i] = std::move(m_items[i-1]);
+	m_items[pos].m_key = key;
+	m_items[pos].m_value = value;
 	m_size_used++;
 	return true;
 }
 
 bool Map::update(const KeyType& key, const ValueType& value)
 {
-	if (!contains(key))
+	int pos = find(key);
+	if (pos == m_size_used || !(m_items[pos].m_key == key))
 		return false; //the inputted key is not in the array
 
-	for (int i = 0; i < m_size_used; i++)
-	{
-		if (m_items[i].m_key == key) 
-		{	//if the key matches a key at the current array pos
-			m_items[i].m_value = value; //change the value and return
-			return true;
-		}
-	}
-	return false; //if it somehow made it here there was an error with contains()
-
+	m_items[pos].m_value = value; //change the value and return
+	return true;
 }
 
 bool Map::insertOrUpdate(const KeyType& key, const ValueType& value)
@@ -106,49 +131,32 @@ bool Map::insertOrUpdate(const KeyType& key, const ValueType& value)
 
 bool Map::erase(const KeyType& key)
 {
-	if (empty())	return false;
-	for (int i = 0; i < m_size_used; i++)
-	{
-		if (m_items[i].m_key == key) //this isnt portable; can't change between other key types
-		{	//if the key matches a key at the current array pos
-			m_size_used--;
-			for (i; i < m_size_used; i++)
-			{
-				m_items[i] = m_items[i+1];
-			}
-			return true;
-		}
-	}
-	return false; //didnt find the key
+	int pos = find(key);
+	if (pos == m_size_used || !(m_items[pos].m_key == key))
+		return false; //didnt find the key
+
+	//shift the later pairs down over the erased one
+	m_size_used--;
+	for (int i = pos; i < m_size_used; i++)
+		m_items[i] = std::move(m_items[i+1]);
+	return true;
 }
 
 bool Map::contains(const KeyType& key) const
 {
-	for (int i = 0; i < m_size_used; i++)
-	{
-		if (m_items[i].m_key == key) 
-		{	//if the key matches a key at the current array pos
-			return true;
-		}
-	}
-	return false; //didn't find it
+	int pos = find(key);
+	return (pos < m_size_used && m_items[pos].m_key == key);
 }
 
 bool Map::get(const KeyType& key, ValueType& value) const
 {
-	if (contains(key))
-	{
-		for (int i = 0; i < m_size_used; i++)
-		{
-			if (m_items[i].m_key == key) 
-			{	//if the key matches a key at the current array pos
-				value = m_items[i].m_value; //change the value and return
-				return true;
-			}
-		}
-	}
-	return false;
-}	
+	int pos = find(key);
+	if (pos == m_size_used || !(m_items[pos].m_key == key))
+		return false;
+
+	value = m_items[pos].m_value;
+	return true;
+}
 
 bool Map::get(int i, KeyType& key, ValueType& value) const
 {
@@ -160,20 +168,31 @@ bool Map::get(int i, KeyType& key, ValueType& value) const
 	return true;
 }
 
-void Map::swap(Map& other)
+void Map::moveFrom(Map& src)
 {
-	//swap integers first
-	int sizeUsedHolder = m_size_used;
-	m_size_used = other.m_size_used;
-	other.m_size_used = sizeUsedHolder;
-
-	int sizeMaxHolder = m_size_max;
-	m_size_max = other.m_size_max;
-	other.m_size_max = sizeMaxHolder;
+	//*this must be empty and using its inline buffer
+	if (src.isInline())
+	{	//inline pairs have to be moved one by one
+		for (int i = 0; i < src.m_size_used; i++)
+			m_inline[i] = std::move(src.m_inline[i]);
+	}
+	else
+	{	//take the heap array by pointer, leaving src its inline buffer
+		m_items = src.m_items;
+		m_size_max = src.m_size_max;
+		src.m_items = src.m_inline;
+		src.m_size_max = INLINE_ITEMS;
+	}
+	m_size_used = src.m_size_used;
+	src.m_size_used = 0;
+}
 
-	//swap pointers instead of swapping arrays
-	Pair* p = m_items;
-	m_items = other.m_items;
-	other.m_items = p;
+void Map::swap(Map& other)
+{
+	//heap arrays are swapped by pointer; only inline pairs get moved
+	Map temp;
+	temp.moveFrom(*this);
+	moveFrom(other);
+	other.moveFrom(temp);
 }
 
@@ -4,7 +4,7 @@
 #include <iostream>
 #include <string>
 
-const int DEFAULT_MAX_ITEMS = 200;
+const int INLINE_ITEMS = 4; //pairs kept in the Map itself before it needs the heap
 
 typedef double	ValueType;
 typedef std::string		KeyType;
@@ -21,6 +21,8 @@ class Map
 	Map();
 
     Map(int n);         // Create an empty map (i.e., one with no key/value pairs)
+      // with room for n pairs before it has to grow.  A map grows as
+      // needed, so n is only a hint.
 
 	~Map();			//destructor
 
@@ -36,8 +38,7 @@ class Map
       // If key is not equal to any key currently in the map, and if the
       // key/value pair can be added to the map, then do so and return true.
       // Otherwise, make no change to the map and return false (indicating
-      // that either the key is already in the map, or the map has a fixed
-      // capacity and is full.
+      // that the key is already in the map; the map has no fixed capacity).
 
     bool update(const KeyType& key, const ValueType& value);
       // If key is equal to a key currently in the map, then make that key no
@@ -49,11 +50,8 @@ class Map
       // If key is equal to a key currently in the map, then make that key no
       // longer map to the value it currently maps to, but instead map to
       // the value of the second parameter; return true in this case.
-      // If key is not equal to any key currently in the map, and if the
-      // key/value pair can be added to the map, then do so and return true.
-      // Otherwise, make no change to the map and return false (indicating
-      // that the key is not already in the map and the map has a fixed
-      // capacity and is full.
+      // If key is not equal to any key currently in the map, then add the
+      // key/value pair to the map and return true.
 
     bool erase(const KeyType& key);
       // If key is equal to a key currently in the map, remove the key/value
@@ -74,14 +72,21 @@ class Map
       // If 0 <= i < size(), copy into the key and value parameters the
       // key and value of one of the key/value pairs in the map and return
       // true.  Otherwise, leave the key and value parameters unchanged and
-      // return false.  (See below for details about this function.)
+      // return false.  (The pairs are kept in increasing order of key, so
+      // get(i, ...) gives them in that order.)
 
     void swap(Map& other);
       // Exchange the contents of this map with the other one.
 
 private:
-	Pair* m_items;
-	int m_size_max; //tracks the max amount of pairs that can be in the Map
+	int find(const KeyType& key) const; //position of the first pair whose key isnt less than key
+	void grow(); //doubles the room for pairs, moving them to the heap
+	void moveFrom(Map& src); //takes srcs pairs into this empty inline map, leaving src empty
+	bool isInline() const { return m_items == m_inline; }
+
+	Pair m_inline[INLINE_ITEMS]; //small maps keep their pairs here
+	Pair* m_items; //m_inline, or an array on the heap; sorted by key
+	int m_size_max; //tracks the max amount of pairs that fit in m_items
 	int m_size_used; //tracks the curr amt of pairs
 
 };
@@ -0,0 +1,179 @@
+// Contention benchmark for ConcurrentSalaryMap.  Build it on its own (it has
+// its own main) with SalaryMap.cpp, Map.cpp and ConcurrentSalaryMap.cpp, e.g.
+//     g++ -O2 -pthread salarybench.cpp SalaryMap.cpp Map.cpp ConcurrentSalaryMap.cpp
+// and run it as
+//     salarybench [employees] [maxThreads] [readPercent]
+// For 1, 2, 4, ... up to maxThreads threads, every thread makes OPS_PER_THREAD
+// calls on randomly chosen employees, readPercent of them salary() and the
+// rest raise().  It reports the total calls per second for
+//   salarymap+mutex  the original SalaryMap behind one mutex (only when the
+//                    employees fit in its DEFAULT_MAX_ITEMS)
+//   one lock         a ConcurrentSalaryMap with a single shard
+//   sharded          a ConcurrentSalaryMap with DEFAULT_SHARDS shards
+
+#include "SalaryMap.h"
+#include "ConcurrentSalaryMap.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <cstdlib>  // for std::atoi
+#include <cassert>
+
+using namespace std;
+
+const int OPS_PER_THREAD = 200000;
+
+//========================================================================
+// TimerType            - a type to hold a timer reading
+// TimerType getTimer() - get the current timer reading
+// double interval(TimerType start, TimerType end) - milliseconds between
+//                                                   two readings
+//
+// Threads run at the same time, so this needs elapsed time; clock() would
+// add up the processor time of every thread.
+//========================================================================
+
+#ifdef _MSC_VER  // If we're compiling for Windows
+
+#include <windows.h>
+
+typedef LARGE_INTEGER TimerType;
+inline TimerType getTimer()
+{
+    LARGE_INTEGER t;
+    QueryPerformanceCounter(&t);
+    return t;
+}
+
+inline double interval(TimerType start, TimerType end)
+{
+    LARGE_INTEGER ticksPerSecond;
+    QueryPerformanceFrequency(&ticksPerSecond);
+    return (1000.0 * (end.QuadPart - start.QuadPart)) / ticksPerSecond.QuadPart;
+}
+
+#else // If we're not compiling for Windows, use the standard steady clock
+
+#include <chrono>
+
+typedef std::chrono::steady_clock::time_point TimerType;
+inline TimerType getTimer() { return std::chrono::steady_clock::now(); }
+inline double interval(TimerType start, TimerType end)
+{
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+#endif  // ifdef _MSC_VER
+
+//========================================================================
+
+  // The original SalaryMap, made safe for threads the simple way
+
+class LockedSalaryMap
+{
+  public:
+    bool add(const string& name, double salary)
+    {
+        lock_guard<mutex> guard(m_lock);
+        return m_map.add(name, salary);
+    }
+    bool raise(const string& name, double pct)
+    {
+        lock_guard<mutex> guard(m_lock);
+        return m_map.raise(name, pct);
+    }
+    double salary(const string& name) const
+    {
+        lock_guard<mutex> guard(m_lock);
+        return m_map.salary(name);
+    }
+
+  private:
+    mutable mutex m_lock;
+    SalaryMap     m_map;
+};
+
+  // Report the results of a test
+
+void report(string mapKind, int nThreads, int nEmployees, double ms)
+{
+    double calls = double(nThreads) * OPS_PER_THREAD;
+    cout << mapKind << "," << nEmployees << "," << nThreads << ","
+         << (calls / ms * 1000) << endl;
+}
+
+  // Run nThreads threads of calls on m and return the elapsed time
+
+template <class SalaryMapType>
+double timeThreads(SalaryMapType& m, const vector<string>& names, int nThreads, int readPercent)
+{
+    vector<thread> threads;
+    TimerType start = getTimer();
+    for (int t = 0; t < nThreads; t++)
+    {
+        threads.push_back(thread([&, t]() {
+            unsigned seed = 12345 + t;
+            double total = 0;
+            for (int i = 0; i < OPS_PER_THREAD; i++)
+            {
+                seed = seed * 1103515245 + 12345;
+                const string& name = names[(seed >> 8) % names.size()];
+                if (int((seed >> 24) % 100) < readPercent)
+                    total += m.salary(name);
+                else
+                    m.raise(name, (i % 2 == 0 ? 1.0 : -1.0));  // keeps salaries steady
+            }
+            if (total < 0)  // never true; keeps the reads from being optimized away
+                cout << total << endl;
+        }));
+    }
+    for (int t = 0; t < nThreads; t++)
+        threads[t].join();
+    TimerType end = getTimer();
+    return interval(start, end);
+}
+
+template <class SalaryMapType>
+void timeMap(SalaryMapType& m, string mapKind, const vector<string>& names,
+             int nThreads, int readPercent)
+{
+    for (size_t k = 0; k < names.size(); k++)
+        assert(m.add(names[k], 50000 + 10 * double(k)));
+    report(mapKind, nThreads, int(names.size()), timeThreads(m, names, nThreads, readPercent));
+}
+
+int main(int argc, char* argv[])
+{
+    int nEmployees = (argc > 1 ? atoi(argv[1]) : DEFAULT_MAX_ITEMS);
+    int maxThreads = (argc > 2 ? atoi(argv[2]) : int(thread::hardware_concurrency()));
+    int readPercent = (argc > 3 ? atoi(argv[3]) : 90);
+    if (nEmployees <= 0  ||  maxThreads <= 0  ||  readPercent < 0  ||  readPercent > 100)
+    {
+        cout << "usage: " << argv[0] << " [employees] [maxThreads] [readPercent]" << endl;
+        return 1;
+    }
+
+    vector<string> names;
+    for (int k = 0; k < nEmployees; k++)
+        names.push_back("employee" + to_string(k));
+
+    cout << "map,employees,threads,calls per second" << endl;
+    for (int nThreads = 1; nThreads <= maxThreads; nThreads *= 2)
+    {
+        if (nEmployees <= DEFAULT_MAX_ITEMS)
+        {
+            LockedSalaryMap locked;
+            timeMap(locked, "salarymap+mutex", names, nThreads, readPercent);
+        }
+        {
+            ConcurrentSalaryMap oneLock(1);
+            timeMap(oneLock, "one lock", names, nThreads, readPercent);
+        }
+        {
+            ConcurrentSalaryMap sharded;
+            timeMap(sharded, "sharded", names, nThreads, readPercent);
+        }
+    }
+}
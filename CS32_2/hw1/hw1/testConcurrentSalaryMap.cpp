@@ -0,0 +1,78 @@
+#include "ConcurrentSalaryMap.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <cassert>
+
+using namespace std;
+
+void test()
+{
+	ConcurrentSalaryMap s;
+	assert(s.add("Joe", 20000));
+	assert(s.add("John", 30000));
+	assert(!s.add("Joe", 1)); //already there
+	assert(s.raise("Joe", 5.0) && s.salary("Joe") == 21000);
+	assert(s.raise("John", -50) && s.salary("John") == 15000);
+	assert(!s.raise("John", -101) && s.salary("John") == 15000);
+	assert(!s.raise("Lucy", 10));
+	assert(s.salary("Lucy") == -1);
+	assert(s.size() == 2);
+}
+
+void testThreads(int nShards)
+{
+	//each thread adds its own employees and raises everyone's, while
+	//reading salaries that must never be seen half updated
+	const int nThreads = 4;
+	const int perThread = 500;
+	ConcurrentSalaryMap s(nShards);
+	assert(s.add("Shared", 0));
+	vector<thread> threads;
+	for (int t = 0; t < nThreads; t++)
+	{
+		threads.push_back(thread([&s, t]() {
+			for (int i = 0; i < perThread; i++)
+			{
+				string name = to_string(t) + "-" + to_string(i);
+				assert(s.add(name, 100));
+				assert(s.raise(name, 100) && s.salary(name) == 200);
+				assert(s.raise("Shared", 0));
+				assert(s.salary("Shared") == 0);
+			}
+		}));
+	}
+	for (int t = 0; t < nThreads; t++)
+		threads[t].join();
+	assert(s.size() == nThreads * perThread + 1);
+	for (int t = 0; t < nThreads; t++)
+		assert(s.salary(to_string(t) + "-" + to_string(perThread - 1)) == 200);
+}
+
+void testCounter()
+{
+	//raises of the same employee from many threads are never lost
+	ConcurrentSalaryMap s;
+	s.add("Counter", 1);
+	vector<thread> threads;
+	for (int t = 0; t < 4; t++)
+	{
+		threads.push_back(thread([&s]() {
+			for (int i = 0; i < 10; i++)
+				s.raise("Counter", 100); //doubles it
+		}));
+	}
+	for (int t = 0; t < 4; t++)
+		threads[t].join();
+	assert(s.salary("Counter") == 1099511627776.0); //2 to the 40th
+}
+
+int main()
+{
+	test();
+	testThreads(DEFAULT_SHARDS);
+	testThreads(1);
+	testCounter();
+	cout << "Passed all tests" << endl;
+}
@@ -1,9 +1,53 @@
 #include "SalaryMap.h"
+#include <cassert>
 
 using namespace std;
 
+void testBulk()
+{
+	SalaryMap s;
+	assert(s.mean() == 0 && s.percentile(50) == -1);
+	for (int i = 1; i <= 10; i++)
+		assert(s.add("E" + to_string(i), 1000 * i)); //E1 earns 1000 ... E10 earns 10000
+	assert(s.sum() == 55000 && s.mean() == 5500);
+	assert(s.percentile(0) == 1000 && s.percentile(50) == 5000);
+	assert(s.percentile(55) == 6000 && s.percentile(100) == 10000);
+	assert(s.percentile(101) == -1);
+
+	//a bulk raise gives exactly what raising one at a time does
+	SalaryMap t;
+	for (int i = 1; i <= 10; i++)
+		t.add("E" + to_string(i), 1000 * i);
+	assert(s.raiseAll(3.7) && !s.raiseAll(-101));
+	for (int i = 1; i <= 10; i++)
+		t.raise("E" + to_string(i), 3.7);
+	for (int i = 1; i <= 10; i++)
+		assert(s.salary("E" + to_string(i)) == t.salary("E" + to_string(i)));
+
+	//by name list; unknown names are skipped and repeated ones raised again
+	vector<string> names;
+	names.push_back("E1");
+	names.push_back("Nobody");
+	names.push_back("E2");
+	names.push_back("E1");
+	assert(s.raiseAll(names, 10) == 3);
+	t.raise("E1", 10);
+	t.raise("E2", 10);
+	t.raise("E1", 10);
+	assert(s.salary("E1") == t.salary("E1") && s.salary("E2") == t.salary("E2"));
+	assert(s.salary("E3") == t.salary("E3"));
+
+	//by predicate on name and salary
+	double before = s.salary("E10");
+	assert(s.raiseIf([](const string&, double sal) { return sal > 10000; }, -50) == 1);
+	assert(s.salary("E10") == before / 2 && s.salary("E9") == t.salary("E9"));
+	assert(s.raiseIf([](const string& name, double) { return name == "E5"; }, -101) == 0);
+}
+
 int main()
 {
+	testBulk();
+
 	SalaryMap s;
 	s.add("Joe", 20000);
 	s.add("John", 30000);
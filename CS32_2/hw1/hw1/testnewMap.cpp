@@ -23,8 +23,46 @@
                    x != x2);
         }
 
+        void testGrowth()
+        {
+              // there's no capacity to run out of, and the pairs stay sorted
+            Map m(2);
+            for (int k = 0; k < 1000; k++)
+                assert(m.insert(to_string((k * 7919) % 1000), k));
+            assert(m.size() == 1000  &&  !m.insert("7", 0));
+            KeyType prev = "";
+            for (int i = 0; i < m.size(); i++)
+            {
+                KeyType k;
+                ValueType v;
+                assert(m.get(i, k, v)  &&  prev < k);
+                prev = k;
+            }
+            for (int k = 0; k < 1000; k += 2)
+                assert(m.erase(to_string(k)));
+            assert(m.size() == 500  &&  !m.contains("0")  &&  m.contains("1"));
+            assert(m.insertOrUpdate("1", 1.5)  &&  m.insertOrUpdate("0", 0.5));
+
+              // copies and swaps between inline and heap maps
+            Map small;
+            assert(small.insert("Fred", 2.956));
+            Map big(m);
+            small.swap(big);
+            ValueType v;
+            assert(small.size() == 501  &&  small.get("1", v)  &&  v == 1.5);
+            assert(big.size() == 1  &&  big.get("Fred", v)  &&  v == 2.956);
+            big = small;
+            small = Map();
+            assert(big.size() == 501  &&  small.empty());
+            Map inl;
+            inl.insert("Lucy", 1);
+            inl.swap(small);
+            assert(inl.empty()  &&  small.contains("Lucy"));
+        }
+
         int main()
         {
             test();
+            testGrowth();
             cout << "Passed all tests" << endl;
         }
\ No newline at end of file
@@ -0,0 +1,229 @@
+#ifndef FROZENMAP_INCLUDED
+#define FROZENMAP_INCLUDED
+
+// The services this header provides:
+//
+//  FrozenMap<KeyType, ValueType> f(source);
+//    A read-only copy of the pairs in source, which is a Map<KeyType,
+//    ValueType, Storage> with any storage, or (when KeyType is std::string)
+//    a StringMapper<ValueType>.  Keys need operator<; two keys are equal if
+//    neither is less than the other.  If a StringMapper holds a key more
+//    than once, the first pair it lists wins, as with its find.
+//  f.size(), f.empty(), f.contains(key), f.get(key, value)
+//  f.get(i, key, value)
+//    The same as the Map functions of those names.  get(i, ...) visits the
+//    pairs in no particular order.
+//  f.find(key)
+//    Return a pointer to the value for key, or NULL if key isn't there.
+//
+// The keys are kept in one array in Eytzinger order:  the root of an
+// implicit binary search tree at position 1, and the children of position k
+// at 2k and 2k+1.  A search walks down from the root computing the next
+// position arithmetically instead of branching on the comparison, and while
+// it does, it prefetches the block of keys four levels below, so by the
+// time the walk gets there the keys are usually in cache.  The values are in
+// a separate array and only the matching one is touched.
+
+#include <cstddef>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <utility>
+#include <type_traits>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#include <xmmintrin.h>
+#endif
+
+template <typename KeyType, typename ValueType, template <typename, typename> class Storage>
+class Map;
+template <typename T, typename Allocator>
+class StringMapper;
+
+template <typename KeyType, typename ValueType>
+class FrozenMap
+{
+  public:
+    FrozenMap();  // an empty map
+    template <template <typename, typename> class Storage>
+    explicit FrozenMap(const Map<KeyType, ValueType, Storage>& source);
+    template <typename Allocator>
+    explicit FrozenMap(const StringMapper<ValueType, Allocator>& source);
+
+    bool empty() const { return m_size == 0; }
+    int size() const { return int(m_size); }
+    const ValueType* find(const KeyType& key) const;
+    bool contains(const KeyType& key) const { return find(key) != NULL; }
+    bool get(const KeyType& key, ValueType& value) const;
+    bool get(int i, KeyType& key, ValueType& value) const;
+
+  private:
+      // Representation:
+      //   m_keys[1..m_size] and m_values[1..m_size] hold the pairs, with
+      //   m_values[k] the value for m_keys[k].  Every key in the subtree
+      //   under position 2k is less than m_keys[k], and every key under
+      //   2k+1 is greater.  Position 0 is unused, so the arithmetic works
+      //   out.
+
+    std::vector<KeyType>   m_keys;
+    std::vector<ValueType> m_values;
+    size_t                 m_size;
+
+      // The 16 positions four levels below position k start at 16k; for
+      // small keys they share a cache line or two
+    static const size_t PREFETCH_STRIDE = 16;
+
+    void build(std::vector<std::pair<KeyType, ValueType> >& pairs);
+      // Lay out the pairs, which are in the order they were listed
+    size_t place(std::vector<std::pair<KeyType, ValueType> >& sorted, size_t next, size_t k);
+      // Fill the subtree under position k with sorted pairs from position
+      // next on; return the position after the last one used
+    size_t lowerBound(const KeyType& key) const;
+      // Return the position of the smallest key not less than key, or 0
+
+    template <typename V>
+    friend class MappedMap;  // saves this layout, and searches it the same way
+
+    static void prefetch(const void* p)
+    {
+#if defined(_MSC_VER)
+        _mm_prefetch(static_cast<const char*>(p), _MM_HINT_T0);
+#else
+        __builtin_prefetch(p);
+#endif
+    }
+    static unsigned trailingOnes(size_t k)
+    {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward64(&index, ~static_cast<unsigned long long>(k));
+        return index;
+#else
+        return __builtin_ctzll(~static_cast<unsigned long long>(k));
+#endif
+    }
+};
+
+template <typename KeyType, typename ValueType>
+const size_t FrozenMap<KeyType, ValueType>::PREFETCH_STRIDE;
+
+template <typename KeyType, typename ValueType>
+FrozenMap<KeyType, ValueType>::FrozenMap()
+ : m_keys(1), m_values(1), m_size(0)
+{
+}
+
+template <typename KeyType, typename ValueType>
+template <template <typename, typename> class Storage>
+FrozenMap<KeyType, ValueType>::FrozenMap(const Map<KeyType, ValueType, Storage>& source)
+ : m_size(0)
+{
+    std::vector<std::pair<KeyType, ValueType> > pairs;
+    pairs.reserve(source.size());
+    for (auto e : source)
+        pairs.emplace_back(e.first, e.second);
+    build(pairs);
+}
+
+template <typename KeyType, typename ValueType>
+template <typename Allocator>
+FrozenMap<KeyType, ValueType>::FrozenMap(const StringMapper<ValueType, Allocator>& source)
+ : m_size(0)
+{
+    static_assert(std::is_same<KeyType, std::string>::value,
+                  "a StringMapper's keys are strings");
+    std::vector<std::pair<KeyType, ValueType> > pairs;
+    for (auto e : source)
+        pairs.emplace_back(e.first, e.second);
+    build(pairs);
+}
+
+template <typename KeyType, typename ValueType>
+void FrozenMap<KeyType, ValueType>::build(std::vector<std::pair<KeyType, ValueType> >& pairs)
+{
+      // Sort by key, keeping the first of any pairs with equal keys
+
+    std::stable_sort(pairs.begin(), pairs.end(),
+                     [](const std::pair<KeyType, ValueType>& a, const std::pair<KeyType, ValueType>& b)
+                     { return a.first < b.first; });
+    pairs.erase(std::unique(pairs.begin(), pairs.end(),
+                            [](const std::pair<KeyType, ValueType>& a, const std::pair<KeyType, ValueType>& b)
+                            { return !(a.first < b.first)  &&  !(b.first < a.first); }),
+                pairs.end());
+
+    m_size = pairs.size();
+    m_keys.resize(m_size + 1);
+    m_values.resize(m_size + 1);
+    place(pairs, 0, 1);
+}
+
+template <typename KeyType, typename ValueType>
+size_t FrozenMap<KeyType, ValueType>::place(std::vector<std::pair<KeyType, ValueType> >& sorted,
+                                            size_t next, size_t k)
+{
+      // An in-order walk of the implicit tree visits positions in key
+      // order, so it hands out the sorted pairs in turn.  The recursion is
+      // only as deep as the tree, about log2 of the size.
+
+    if (k > m_size)
+        return next;
+    next = place(sorted, next, 2*k);
+    m_keys[k] = std::move(sorted[next].first);
+    m_values[k] = std::move(sorted[next].second);
+    return place(sorted, next + 1, 2*k + 1);
+}
+
+template <typename KeyType, typename ValueType>
+inline
+size_t FrozenMap<KeyType, ValueType>::lowerBound(const KeyType& key) const
+{
+    const KeyType* keys = m_keys.data();
+    size_t k = 1;
+    while (k <= m_size)
+    {
+          // The positions four levels down start at 16k; clamp so the
+          // address stays inside the array
+        prefetch(keys + std::min(PREFETCH_STRIDE * k, m_size));
+        k = 2*k + (keys[k] < key);  // left if key <= keys[k], else right
+    }
+
+      // Each step right appended a 1 bit to k and each step left a 0.  The
+      // answer is where the walk last went left:  strip the trailing 1s
+      // and that 0.  If it never went left, this leaves 0.
+    return k >> (trailingOnes(k) + 1);
+}
+
+template <typename KeyType, typename ValueType>
+inline
+const ValueType* FrozenMap<KeyType, ValueType>::find(const KeyType& key) const
+{
+    size_t k = lowerBound(key);
+    if (k == 0  ||  key < m_keys[k])
+        return NULL;
+    return &m_values[k];
+}
+
+template <typename KeyType, typename ValueType>
+inline
+bool FrozenMap<KeyType, ValueType>::get(const KeyType& key, ValueType& value) const
+{
+    const ValueType* p = find(key);
+    if (p == NULL)
+        return false;
+    value = *p;
+    return true;
+}
+
+template <typename KeyType, typename ValueType>
+inline
+bool FrozenMap<KeyType, ValueType>::get(int i, KeyType& key, ValueType& value) const
+{
+    if (i < 0  ||  size_t(i) >= m_size)
+        return false;
+    key = m_keys[i+1];
+    value = m_values[i+1];
+    return true;
+}
+
+#endif // FROZENMAP_INCLUDED
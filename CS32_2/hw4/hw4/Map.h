@@ -3,67 +3,127 @@
 #ifndef MAP_INCLUDED
 #define MAP_INCLUDED
 
+#include <cstddef>
+#include <vector>
+#include <functional>
+#include <algorithm>
+#include <thread>
+#include <memory>
+#include <new>
+#include <utility>
+#include <iterator>
+#include <type_traits>
+#include <atomic>
+#include "NodePool.h"
+
+  // Storage policies.  Each one holds the key/value pairs for a Map and
+  // provides
+  //     int size() const;
+  //     ValueType* find(const KeyType& key);         // NULL if not found
+  //     const ValueType* find(const KeyType& key) const;
+  //     template <typename K, typename... Args>
+  //     void emplace(K&& key, Args&&... args);      // key must be absent;
+  //                                                  // the value is built
+  //                                                  // in place from args
+  //     bool erase(const KeyType& key);
+  //     void get(int i, KeyType& key, ValueType& value) const;
+  //                                                  // 0 <= i < size()
+  //     void swap(Storage& other);
+  //     iterator begin();  iterator end();
+  //     const_iterator begin() const;  const_iterator end() const;
+  //                                                  // visit the pairs in
+  //                                                  // the order of get(i)
+  //     static bool combine(const Storage& m1, const Storage& m2, Storage& result);
+  //     static void subtract(const Storage& m1, const Storage& m2, Storage& result);
+  //     static bool combineParallel(const Storage& m1, const Storage& m2,
+  //                                 Storage& result, int nThreads);
+  //     static void subtractParallel(const Storage& m1, const Storage& m2,
+  //                                  Storage& result, int nThreads);
+  //                                                  // result is empty and
+  //                                                  // is neither m1 nor m2
+  // along with copying, moving, assignment and destruction.  A storage that
+  // has been moved from is usable:  the move constructor leaves it empty,
+  // and move assignment swaps, so after a = move(b), b holds what a held.
+  // combine and subtract do the work of the Map functions of the same
+  // names; values are compared with operator!=.
+  //
+  // The list and the B-tree get their nodes from an allocator (rebound to
+  // their node type), which must be default-constructible and stateless,
+  // like std::allocator or PoolAllocator.  ListStorage and BTreeStorage use
+  // a PoolAllocator, so their nodes come from slabs; BasicListStorage and
+  // BasicBTreeStorage let you choose.
+  //
+  // An iterator refers to a MapEntry, whose first member is a reference to
+  // a key and whose second is a reference to its value (a const one for a
+  // const_iterator).  Adding or removing a pair invalidates every iterator.
+
 template <typename KeyType, typename ValueType>
-class Map
+struct MapEntry
 {
-  public:
-    Map();               // Create an empty map.
+    const KeyType& first;
+    ValueType&     second;
 
-    bool empty() const;  // Return true if the map is empty, otherwise false.
-
-    int size() const;    // Return the number of key/value pairs in the map.
+    MapEntry(const KeyType& key, ValueType& value) : first(key), second(value) {}
 
-    bool insert(const KeyType& key, const ValueType& value);
-      // If key is not equal to any key currently in the map, and if the
-      // key/value pair can be added to the map, then do so and return true.
-      // Otherwise, make no change to the map and return false (indicating
-      // that either the key is already in the map, or the map has a fixed
-      // capacity and is full.
+      // Copy the pair out of the map
+    operator std::pair<KeyType, typename std::remove_const<ValueType>::type>() const
+    {
+        return std::pair<KeyType, typename std::remove_const<ValueType>::type>(first, second);
+    }
 
-    bool update(const KeyType& key, const ValueType& value);
-      // If key is equal to a key currently in the map, then make that key no
-      // longer map to the value it currently maps to, but instead map to
-      // the value of the second parameter; return true in this case.
-      // Otherwise, make no change to the map and return false.
+      // An iterator's operator-> returns a MapEntry by value; this lets
+      // it->first and it->second reach through it
+    const MapEntry* operator->() const { return this; }
+};
 
-    bool insertOrUpdate(const KeyType& key, const ValueType& value);
-      // If key is equal to a key currently in the map, then make that key no
-      // longer map to the value it currently maps to, but instead map to
-      // the value of the second parameter; return true in this case.
-      // If key is not equal to any key currently in the map, and if the
-      // key/value pair can be added to the map, then do so and return true.
-      // Otherwise, make no change to the map and return false (indicating
-      // that the key is not already in the map and the map has a fixed
-      // capacity and is full.
+//========================================================================
+// ListStorage:  a circular doubly-linked list, with an array of pointers to
+// its nodes in list order.  Keys need only operator!=.
+//========================================================================
 
+template <typename KeyType, typename ValueType, typename Allocator>
+class BasicListStorage
+{
+  public:
+    BasicListStorage();
+    ~BasicListStorage();
+    BasicListStorage(const BasicListStorage& other);
+    BasicListStorage(BasicListStorage&& other);
+    BasicListStorage& operator=(const BasicListStorage& rhs);
+    BasicListStorage& operator=(BasicListStorage&& rhs);
+
+    int size() const { return m_size; }
+    ValueType* find(const KeyType& key);
+    const ValueType* find(const KeyType& key) const;
+    template <typename K, typename... Args>
+    void emplace(K&& key, Args&&... args);
     bool erase(const KeyType& key);
-      // If key is equal to a key currently in the map, remove the key/value
-      // pair with that key from the map and return true.  Otherwise, make
-      // no change to the map and return false.
-     
-    bool contains(const KeyType& key) const;
-      // Return true if key is equal to a key currently in the map, otherwise
-      // false.
-     
-    bool get(const KeyType& key, ValueType& value) const;
-      // If key is equal to a key currently in the map, set value to the
-      // value in the map that that key maps to and return true.  Otherwise,
-      // make no change to the value parameter of this function and return
-      // false.
-     
-    bool get(int i, KeyType& key, ValueType& value) const;
-      // If 0 <= i < size(), copy into the key and value parameters the
-      // key and value of one of the key/value pairs in the map and return
-      // true.  Otherwise, leave the key and value parameters unchanged and
-      // return false.
-
-    void swap(Map& other);
-      // Exchange the contents of this map with the other one.
-
-      // Housekeeping functions
-    ~Map();
-    Map(const Map& other);
-    Map& operator=(const Map& rhs);
+    void get(int i, KeyType& key, ValueType& value) const;
+    void swap(BasicListStorage& other);
+
+    template <bool IsConst> class Iterator;  // bidirectional
+    typedef Iterator<false> iterator;
+    typedef Iterator<true>  const_iterator;
+    iterator begin();
+    iterator end();
+    const_iterator begin() const;
+    const_iterator end() const;
+
+      // A list can only be searched from end to end, so these look up each
+      // pair of one map in the other and take time proportional to the
+      // product of the sizes.  The parallel versions just call them.
+    static bool combine(const BasicListStorage& m1, const BasicListStorage& m2, BasicListStorage& result);
+    static void subtract(const BasicListStorage& m1, const BasicListStorage& m2, BasicListStorage& result);
+    static bool combineParallel(const BasicListStorage& m1, const BasicListStorage& m2,
+                                BasicListStorage& result, int)
+    {
+        return combine(m1, m2, result);
+    }
+    static void subtractParallel(const BasicListStorage& m1, const BasicListStorage& m2,
+                                 BasicListStorage& result, int)
+    {
+        subtract(m1, m2, result);
+    }
 
   private:
       // Representation:
@@ -75,6 +135,10 @@ class Map
       //       m_head->next points to the node at position 0.
       //       m_head->prev points to the node at position m_size-1.
       //   Nodes are in no particular order.
+      //   m_nodes.size() == m_size, and m_nodes[i] points to the node at
+      //   position i, so get(i) needs no walk and no state of its own.
+      //   Erasing a node moves the last node into its place in the list
+      //   and in m_nodes (so positions of other pairs may change).
 
     struct Node
     {
@@ -82,95 +146,122 @@ class Map
         ValueType m_value;
         Node*     m_next;
         Node*     m_prev;
+
+        Node() {}  // the dummy node
+        template <typename K, typename... Args>
+        Node(K&& key, Args&&... args)
+         : m_key(std::forward<K>(key)), m_value(std::forward<Args>(args)...)
+        {}
     };
 
     Node* m_head;
     int   m_size;
 
-    Node* find(const KeyType& key) const;
+    std::vector<Node*> m_nodes;
+
+    Node* findNode(const KeyType& key) const;
       // Return pointer to Node whose m_key == key if there is one, else m_head
 
-    bool doInsertOrUpdate(const KeyType& key, const ValueType& value,
-                          bool mayInsert, bool mayUpdate);
-      // If the key is not present in the map and if mayInsert is true, insert
-      // the pair if there is room.  If the key is present and mayUpdate is
-      // true, update the pair with the given key.
+    typedef typename std::allocator_traits<Allocator>::template rebind_alloc<Node> NodeAllocator;
+    template <typename... Args>
+    static Node* newNode(Args&&... args)
+    {
+          // Construct the node from args directly in the allocated storage,
+          // giving the storage back if the construction throws
+        Node* p = NodeAllocator().allocate(1);
+        try
+        {
+            return new (p) Node(std::forward<Args>(args)...);
+        }
+        catch (...)
+        {
+            NodeAllocator().deallocate(p, 1);
+            throw;
+        }
+    }
+    static void deleteNode(Node* p)
+    {
+        p->~Node();
+        NodeAllocator().deallocate(p, 1);
+    }
 };
 
-// Declarations of non-member functions
 template <typename KeyType, typename ValueType>
-bool combine(const Map<KeyType, ValueType>& m1,
-			 const Map<KeyType, ValueType>& m2,
-			 Map<KeyType, ValueType>& result); 
-      // If a key/value pair occurs in m1 or m2 or both, then it will occur in
-      // result upon return from this function.  Return true unless m1 and m2
-      // have a pair with the same key but different values; neither such pair
-      // will occur in result upon return.
+using ListStorage = BasicListStorage<KeyType, ValueType, PoolAllocator<KeyType> >;
 
-template <typename KeyType, typename ValueType>
-void subtract(const Map<KeyType, ValueType>& m1,
-			  const Map<KeyType, ValueType>& m2,
-			  Map<KeyType, ValueType>& result); 
-      // Upon return, result contains those pairs in m1 whose keys don't
-      // appear in m2.
+template <typename KeyType, typename ValueType, typename Allocator>
+template <bool IsConst>
+class BasicListStorage<KeyType, ValueType, Allocator>::Iterator
+{
+  public:
+    typedef std::bidirectional_iterator_tag iterator_category;
+    typedef std::pair<KeyType, ValueType>   value_type;
+    typedef std::ptrdiff_t                  difference_type;
+    typedef MapEntry<KeyType, typename std::conditional<IsConst, const ValueType, ValueType>::type> reference;
+    typedef reference                       pointer;
+
+    Iterator() : m_node(NULL) {}
+    Iterator(const Iterator<false>& other) : m_node(other.m_node) {}  // also makes a const_iterator
+
+    reference operator*() const { return reference(m_node->m_key, m_node->m_value); }
+    pointer operator->() const { return **this; }
+    Iterator& operator++() { m_node = m_node->m_next; return *this; }
+    Iterator& operator--() { m_node = m_node->m_prev; return *this; }
+    Iterator operator++(int) { Iterator old(*this); ++*this; return old; }
+    Iterator operator--(int) { Iterator old(*this); --*this; return old; }
+    bool operator==(const Iterator& other) const { return m_node == other.m_node; }
+    bool operator!=(const Iterator& other) const { return m_node != other.m_node; }
 
-// implementations
+  private:
+    typedef typename std::conditional<IsConst, const Node*, Node*>::type NodePtr;
 
-template <typename KeyType, typename ValueType>
-inline
-int Map<KeyType, ValueType>::size() const
-{
-    return m_size;
-}
+    NodePtr m_node;  // the dummy node for end()
 
-template <typename KeyType, typename ValueType>
-inline
-bool Map<KeyType, ValueType>::empty() const
-{
-    return size() == 0;
-}
+    explicit Iterator(NodePtr p) : m_node(p) {}
+    friend class BasicListStorage;
+    friend class Iterator<true>;
+};
 
-template <typename KeyType, typename ValueType>
+template <typename KeyType, typename ValueType, typename Allocator>
 inline
-bool Map<KeyType, ValueType>::contains(const KeyType& key) const
+typename BasicListStorage<KeyType, ValueType, Allocator>::iterator BasicListStorage<KeyType, ValueType, Allocator>::begin()
 {
-    return find(key) != m_head;
+    return iterator(m_head->m_next);
 }
 
-template <typename KeyType, typename ValueType>
+template <typename KeyType, typename ValueType, typename Allocator>
 inline
-bool Map<KeyType, ValueType>::insert(const KeyType& key, const ValueType& value)
+typename BasicListStorage<KeyType, ValueType, Allocator>::iterator BasicListStorage<KeyType, ValueType, Allocator>::end()
 {
-    return doInsertOrUpdate(key, value, true /* insert */, false /* no update */);
+    return iterator(m_head);
 }
 
-template <typename KeyType, typename ValueType>
+template <typename KeyType, typename ValueType, typename Allocator>
 inline
-bool Map<KeyType, ValueType>::update(const KeyType& key, const ValueType& value)
+typename BasicListStorage<KeyType, ValueType, Allocator>::const_iterator BasicListStorage<KeyType, ValueType, Allocator>::begin() const
 {
-    return doInsertOrUpdate(key, value, false /* no insert */, true /* update */);
+    return const_iterator(m_head->m_next);
 }
 
-template <typename KeyType, typename ValueType>
+template <typename KeyType, typename ValueType, typename Allocator>
 inline
-bool Map<KeyType, ValueType>::insertOrUpdate(const KeyType& key, const ValueType& value)
+typename BasicListStorage<KeyType, ValueType, Allocator>::const_iterator BasicListStorage<KeyType, ValueType, Allocator>::end() const
 {
-    return doInsertOrUpdate(key, value, true /* insert */, true /* update */);
+    return const_iterator(m_head);
 }
 
-
-template <typename KeyType, typename ValueType>
-Map<KeyType, ValueType>::Map()
+template <typename KeyType, typename ValueType, typename Allocator>
+BasicListStorage<KeyType, ValueType, Allocator>::BasicListStorage()
  : m_size(0)
 {
       // create dummy node
-    m_head = new Node;
+    m_head = newNode();
     m_head->m_next = m_head;
     m_head->m_prev = m_head;
 }
 
-template <typename KeyType, typename ValueType>
-Map<KeyType, ValueType>::~Map()
+template <typename KeyType, typename ValueType, typename Allocator>
+BasicListStorage<KeyType, ValueType, Allocator>::~BasicListStorage()
 {
       // Delete the m_size non-dummy nodes plus the dummy node
 
@@ -178,17 +269,17 @@ Map<KeyType, ValueType>::~Map()
     {
 	Node* toBeDeleted = p;
 	p = p->m_prev;
-	delete toBeDeleted;
+	deleteNode(toBeDeleted);
     }
 }
 
-template <typename KeyType, typename ValueType>
-Map<KeyType, ValueType>::Map(const Map& other)
+template <typename KeyType, typename ValueType, typename Allocator>
+BasicListStorage<KeyType, ValueType, Allocator>::BasicListStorage(const BasicListStorage& other)
  : m_size(other.m_size)
 {
       // Create dummy node; don't initialize its pointers
 
-    m_head = new Node;
+    m_head = newNode();
 
       // Initialize prev to last node created
 
@@ -197,12 +288,12 @@ Map<KeyType, ValueType>::Map(const Map& other)
       // Copy each non-dummy node from the other list; each iteration will set
       // the m_next of the previous node copied
 
+    m_nodes.reserve(m_size);
     for (Node* p = other.m_head->m_next ; p != other.m_head; p = p->m_next)
     {
 	  // Create a copy of the node p points to
-	Node* pnew = new Node;
-	pnew->m_key = p->m_key;
-	pnew->m_value = p->m_value;
+	Node* pnew = newNode(p->m_key, p->m_value);
+	m_nodes.push_back(pnew);
 	
 	  // Connect the new node to the previous one
 	pnew->m_prev = prev;
@@ -217,51 +308,125 @@ Map<KeyType, ValueType>::Map(const Map& other)
     prev->m_next = m_head;
 }
 
-template <typename KeyType, typename ValueType>
-Map<KeyType, ValueType>& Map<KeyType, ValueType>::operator=(const Map& rhs)
+template <typename KeyType, typename ValueType, typename Allocator>
+BasicListStorage<KeyType, ValueType, Allocator>::BasicListStorage(BasicListStorage&& other)
+ : m_size(0)
+{
+      // Take the other list's nodes, leaving it an empty list of its own
+      // (every list needs a dummy node)
+
+    m_head = newNode();
+    m_head->m_next = m_head;
+    m_head->m_prev = m_head;
+    swap(other);
+}
+
+template <typename KeyType, typename ValueType, typename Allocator>
+BasicListStorage<KeyType, ValueType, Allocator>& BasicListStorage<KeyType, ValueType, Allocator>::operator=(const BasicListStorage& rhs)
 {
     if (this != &rhs)
     {
-	Map temp(rhs);
+	BasicListStorage temp(rhs);
 	swap(temp);
     }
     return *this;
 }
 
-template <typename KeyType, typename ValueType>
-bool Map<KeyType, ValueType>::erase(const KeyType& key)
+template <typename KeyType, typename ValueType, typename Allocator>
+inline
+BasicListStorage<KeyType, ValueType, Allocator>& BasicListStorage<KeyType, ValueType, Allocator>::operator=(BasicListStorage&& rhs)
+{
+      // rhs gets our old nodes, which it destroys when it goes away
+    swap(rhs);
+    return *this;
+}
+
+template <typename KeyType, typename ValueType, typename Allocator>
+inline
+ValueType* BasicListStorage<KeyType, ValueType, Allocator>::find(const KeyType& key)
+{
+    Node* p = findNode(key);
+    return p == m_head ? NULL : &p->m_value;
+}
+
+template <typename KeyType, typename ValueType, typename Allocator>
+inline
+const ValueType* BasicListStorage<KeyType, ValueType, Allocator>::find(const KeyType& key) const
+{
+    Node* p = findNode(key);
+    return p == m_head ? NULL : &p->m_value;
+}
+
+template <typename KeyType, typename ValueType, typename Allocator>
+template <typename K, typename... Args>
+void BasicListStorage<KeyType, ValueType, Allocator>::emplace(K&& key, Args&&... args)
+{
+       // Create a new node, building the pair in place, and make room for
+       // it in m_nodes
+    Node* p = newNode(std::forward<K>(key), std::forward<Args>(args)...);
+    try
+    {
+        m_nodes.push_back(p);
+    }
+    catch (...)
+    {
+        deleteNode(p);
+        throw;
+    }
+
+      // Insert new item at tail of list (arbitrary choice of position)
+      //     Connect it to tail
+    p->m_prev = m_head->m_prev;
+    p->m_prev->m_next = p;
+
+      //     Connect it to dummy node
+    p->m_next = m_head;
+    m_head->m_prev = p;
+
+    m_size++;
+}
+
+template <typename KeyType, typename ValueType, typename Allocator>
+bool BasicListStorage<KeyType, ValueType, Allocator>::erase(const KeyType& key)
 {
-    Node* p = find(key);
+      // Find the position of the node with that key
 
-    if (p == m_head)  // not found
+    int k;
+    for (k = 0; k < m_size && m_nodes[k]->m_key != key; k++)
+	;
+    if (k == m_size)  // not found
 	return false;
 
-      // unlink the node from the list and destroy it
+      // unlink the node from the list
 
+    Node* p = m_nodes[k];
+    Node* before = p->m_prev;
     p->m_prev->m_next = p->m_next;
     p->m_next->m_prev = p->m_prev;
-    delete p;
 
-    m_size--;
-    return true;
-}
+      // move the last node, which follows it, into its place
 
-template <typename KeyType, typename ValueType>
-bool Map<KeyType, ValueType>::get(const KeyType& key, ValueType& value) const
-{
-    Node* p = find(key);
-    if (p == m_head)  // not found
-        return false;
-    value = p->m_value;
+    Node* last = m_nodes[m_size-1];
+    if (last != p)
+    {
+	last->m_prev->m_next = m_head;
+	m_head->m_prev = last->m_prev;
+	last->m_prev = before;
+	last->m_next = before->m_next;
+	before->m_next->m_prev = last;
+	before->m_next = last;
+	m_nodes[k] = last;
+    }
+    m_nodes.pop_back();
+
+    deleteNode(p);
+    m_size--;
     return true;
 }
 
-template <typename KeyType, typename ValueType>
-bool Map<KeyType, ValueType>::get(int i, KeyType& key, ValueType& value) const
+template <typename KeyType, typename ValueType, typename Allocator>
+void BasicListStorage<KeyType, ValueType, Allocator>::get(int i, KeyType& key, ValueType& value) const
 {
-    if (i < 0  ||  i >= m_size)
-        return false;
-
       // Return the key and value at position i.  This is one way of ensuring
       // the required behavior of get:  If the Map doesn't change in the
       // interim,
@@ -269,30 +434,16 @@ bool Map<KeyType, ValueType>::get(int i, KeyType& key, ValueType& value) const
       //   Map pairs, and
       // * calling get with the same value of i each time gets the same pair.
 
-      // If i is closer to the head of the list, go forward to reach that
-      // position; otherwise, start from tail and go backward.
-
-    Node* p;
-    if (i < m_size / 2)  // closer to head
-    {
-        p = m_head->m_next;
-        for (int k = 0; k != i; k++)
-            p = p->m_next;
-    }
-    else  // closer to tail
-    {
-        p = m_head->m_prev;
-        for (int k = m_size-1; k != i; k--)
-            p = p->m_prev;
-    }
+      // m_nodes holds the nodes in list order, so no walk is needed.  Since
+      // nothing is changed, several threads may call get at once.
 
+    const Node* p = m_nodes[i];
     key = p->m_key;
     value = p->m_value;
-    return true;
 }
 
-template <typename KeyType, typename ValueType>
-void Map<KeyType, ValueType>::swap(Map& other)
+template <typename KeyType, typename ValueType, typename Allocator>
+void BasicListStorage<KeyType, ValueType, Allocator>::swap(BasicListStorage& other)
 {
       // swap head pointers
     Node* tempHead = m_head;
@@ -303,10 +454,13 @@ void Map<KeyType, ValueType>::swap(Map& other)
     int t = m_size;
     m_size = other.m_size;
     other.m_size = t;
+
+      // swap node arrays
+    m_nodes.swap(other.m_nodes);
 }
 
-template <typename KeyType, typename ValueType>
-typename Map<KeyType, ValueType>::Node* Map<KeyType, ValueType>::find(const KeyType& key) const
+template <typename KeyType, typename ValueType, typename Allocator>
+typename BasicListStorage<KeyType, ValueType, Allocator>::Node* BasicListStorage<KeyType, ValueType, Allocator>::findNode(const KeyType& key) const
 {
       // Do a linear search through the list
 
@@ -316,129 +470,2553 @@ typename Map<KeyType, ValueType>::Node* Map<KeyType, ValueType>::find(const KeyT
     return p;
 }
 
-template <typename KeyType, typename ValueType>
-bool Map<KeyType, ValueType>::doInsertOrUpdate(const KeyType& key, const ValueType& value,
-                           bool mayInsert, bool mayUpdate)
+template <typename KeyType, typename ValueType, typename Allocator>
+bool BasicListStorage<KeyType, ValueType, Allocator>::combine(const BasicListStorage& m1, const BasicListStorage& m2, BasicListStorage& result)
 {
-    Node* p = find(key);
+      // The bigger list is the basis for the result; look up each pair of
+      // the smaller one
 
-    if (p != m_head)  // found
+    const BasicListStorage* bigger = (m1.size() >= m2.size() ? &m1 : &m2);
+    const BasicListStorage* smaller = (bigger == &m1 ? &m2 : &m1);
+
+    bool status = true;
+    result = *bigger;
+    for (Node* p = smaller->m_head->m_next; p != smaller->m_head; p = p->m_next)
     {
-        if (mayUpdate)
-            p->m_value = value;
-        return mayUpdate;
+        ValueType* vbig = result.find(p->m_key);
+        if (vbig == NULL)               // key in smaller doesn't appear in bigger
+            result.emplace(p->m_key, p->m_value);
+        else if (*vbig != p->m_value)   // same key, different value
+        {
+            result.erase(p->m_key);
+            status = false;
+        }
     }
-    if (!mayInsert)  // not found, and not allowed to insert
-        return false;
-
-       // Create a new node
-    p = new Node;
-    p->m_key = key;
-    p->m_value = value;
-
-      // Insert new item at tail of list (arbitrary choice of position)
-      //     Connect it to tail
-    p->m_prev = m_head->m_prev;
-    p->m_prev->m_next = p;
-
-      //     Connect it to dummy node
-    p->m_next = m_head;
-    m_head->m_prev = p;
+    return status;
+}
 
-    m_size++;
-    return true;
+template <typename KeyType, typename ValueType, typename Allocator>
+void BasicListStorage<KeyType, ValueType, Allocator>::subtract(const BasicListStorage& m1, const BasicListStorage& m2, BasicListStorage& result)
+{
+    for (Node* p = m1.m_head->m_next; p != m1.m_head; p = p->m_next)
+    {
+        if (m2.find(p->m_key) == NULL)
+            result.emplace(p->m_key, p->m_value);
+    }
 }
 
+//========================================================================
+// HashStorage:  the pairs in a dense array, indexed by an open-addressing
+// hash table.  Keys need std::hash<KeyType> and operator==.
+//========================================================================
+
 template <typename KeyType, typename ValueType>
-bool combine(const Map<KeyType, ValueType>& m1,
-			 const Map<KeyType, ValueType>& m2,
-			 Map<KeyType, ValueType>& result)
+class HashStorage
 {
-      // For better performance, the bigger map should be the basis for
-      // the result, and we should iterate over the elements of the
-      // smaller one, adjusting the result as required.
+  public:
+    HashStorage();
+    HashStorage(const HashStorage& other) = default;
+    HashStorage(HashStorage&& other);
+    HashStorage& operator=(const HashStorage& rhs) = default;
+    HashStorage& operator=(HashStorage&& rhs);
+
+    int size() const { return int(m_entries.size()); }
+    ValueType* find(const KeyType& key);
+    const ValueType* find(const KeyType& key) const;
+    template <typename K, typename... Args>
+    void emplace(K&& key, Args&&... args);
+    bool erase(const KeyType& key);
+    void get(int i, KeyType& key, ValueType& value) const;
+    void swap(HashStorage& other);
+
+    template <bool IsConst> class Iterator;  // random access
+    typedef Iterator<false> iterator;
+    typedef Iterator<true>  const_iterator;
+    iterator begin()             { return iterator(m_entries.data()); }
+    iterator end()               { return iterator(m_entries.data() + m_entries.size()); }
+    const_iterator begin() const { return const_iterator(m_entries.data()); }
+    const_iterator end() const   { return const_iterator(m_entries.data() + m_entries.size()); }
+
+      // Hash joins:  each pair of one map is looked up in the other using
+      // the hash saved with it, so these take time proportional to the sum
+      // of the sizes.  The parallel versions split the keys by hash value
+      // into nThreads groups and join each group in its own thread.
+    static bool combine(const HashStorage& m1, const HashStorage& m2, HashStorage& result);
+    static void subtract(const HashStorage& m1, const HashStorage& m2, HashStorage& result);
+    static bool combineParallel(const HashStorage& m1, const HashStorage& m2,
+                                HashStorage& result, int nThreads);
+    static void subtractParallel(const HashStorage& m1, const HashStorage& m2,
+                                 HashStorage& result, int nThreads);
+
+      // Copying, copy assignment and destruction are done by the vectors
+
+  private:
+      // Representation:
+      //   m_entries holds the pairs with no gaps; position i in get is
+      //   simply m_entries[i].  Erasing a pair moves the last entry into
+      //   its place (so positions of other pairs may change).
+      //   m_slots is a table of linear-probing slots whose size is a power
+      //   of 2 and at least twice the number of entries.  Each slot is
+      //   EMPTY or the index in m_entries of a pair whose key's home slot
+      //   is at or cyclically before it, with no EMPTY slot in between.
+      //   Erasing shifts later slots back instead of leaving tombstones,
+      //   so a failed search stops at the first EMPTY slot.
+
+    struct Entry
+    {
+        KeyType   m_key;
+        ValueType m_value;
+        size_t    m_hash;  // saved so growing the table needn't rehash keys
+
+        template <typename K, typename... Args>
+        Entry(size_t hash, K&& key, Args&&... args)
+         : m_key(std::forward<K>(key)), m_value(std::forward<Args>(args)...), m_hash(hash)
+        {}
+    };
+
+    static const int EMPTY = -1;
 
-    const Map<KeyType, ValueType>* bigger;
-    const Map<KeyType, ValueType>* smaller;
-    if (m1.size() >= m2.size())
+    std::vector<Entry> m_entries;
+    std::vector<int>   m_slots;
+
+    static size_t hashOf(const KeyType& key)
     {
-        bigger = &m1;
-        smaller = &m2;
+          // std::hash of an integer is often the integer itself; mix the
+          // bits so keys with a common stride don't share low bits
+        size_t h = std::hash<KeyType>()(key);
+        h ^= h >> 15;
+        h *= 0x2c1b3c6dU;
+        h ^= h >> 12;
+        return h;
     }
-    else
+    size_t mask() const { return m_slots.size() - 1; }
+    size_t findSlot(const KeyType& key, size_t hash) const;
+      // Return the slot holding key's index, or the EMPTY slot where it
+      // would go
+    size_t findSlotOf(int index) const;
+      // Return the slot holding the given entry index
+    void growSlots();
+    void reserve(size_t n);
+      // Make the table big enough for n entries
+    void insertEntry(const Entry& e);
+      // Add e, whose key must be absent
+    bool joinEntry(const Entry& e);
+      // Add e if its key is absent; if the key is present with a different
+      // value, remove that pair and return false
+    void adopt(std::vector<HashStorage>& parts);
+      // Take the entries of all the parts, which have disjoint keys
+    static size_t partition(size_t hash, int nParts)
     {
-        bigger = &m2;
-        smaller = &m1;
+          // the low bits pick the slot, so use higher ones here
+        return (hash >> 20) % nParts;
     }
+};
 
-      // Guard against the case that result is an alias for m1 or m2
-      // (i.e., that result is a reference to the same map that m1 or m2
-      // refers to) by building the answer in a local variable res.  When
-      // done, swap res with result; the old value of result (now in res) will
-      // be destroyed when res is destroyed.
+template <typename KeyType, typename ValueType>
+template <bool IsConst>
+class HashStorage<KeyType, ValueType>::Iterator
+{
+  public:
+    typedef std::random_access_iterator_tag iterator_category;
+    typedef std::pair<KeyType, ValueType>   value_type;
+    typedef std::ptrdiff_t                  difference_type;
+    typedef MapEntry<KeyType, typename std::conditional<IsConst, const ValueType, ValueType>::type> reference;
+    typedef reference                       pointer;
+
+    Iterator() : m_entry(NULL) {}
+    Iterator(const Iterator<false>& other) : m_entry(other.m_entry) {}  // also makes a const_iterator
+
+    reference operator*() const { return reference(m_entry->m_key, m_entry->m_value); }
+    pointer operator->() const { return **this; }
+    reference operator[](difference_type n) const { return *(*this + n); }
+
+    Iterator& operator++() { ++m_entry; return *this; }
+    Iterator& operator--() { --m_entry; return *this; }
+    Iterator operator++(int) { Iterator old(*this); ++m_entry; return old; }
+    Iterator operator--(int) { Iterator old(*this); --m_entry; return old; }
+    Iterator& operator+=(difference_type n) { m_entry += n; return *this; }
+    Iterator& operator-=(difference_type n) { m_entry -= n; return *this; }
+    Iterator operator+(difference_type n) const { return Iterator(m_entry + n); }
+    Iterator operator-(difference_type n) const { return Iterator(m_entry - n); }
+    friend Iterator operator+(difference_type n, const Iterator& it) { return it + n; }
+    difference_type operator-(const Iterator& other) const { return m_entry - other.m_entry; }
+
+    bool operator==(const Iterator& other) const { return m_entry == other.m_entry; }
+    bool operator!=(const Iterator& other) const { return m_entry != other.m_entry; }
+    bool operator<(const Iterator& other) const  { return m_entry < other.m_entry; }
+    bool operator>(const Iterator& other) const  { return m_entry > other.m_entry; }
+    bool operator<=(const Iterator& other) const { return m_entry <= other.m_entry; }
+    bool operator>=(const Iterator& other) const { return m_entry >= other.m_entry; }
 
-    bool status = true;
-    Map<KeyType, ValueType> res(*bigger);               // res starts as a copy of the bigger map
-    for (int n = 0; n < smaller->size(); n++)  // for each pair in smaller
-    {
-        KeyType k;
-        ValueType vsmall;
-        smaller->get(n, k, vsmall);
-        ValueType vbig;
-        if (!res.get(k, vbig))      // key in smaller doesn't appear in bigger
-            res.insert(k, vsmall);  //     so add it to res
-        else if (vbig != vsmall)    // same key, different value
-        {                           //     so pair shouldn't be in res
-            res.erase(k);      
-            status = false;
-        }
-    }
-    result.swap(res);
-    return status;
+  private:
+    typedef typename std::conditional<IsConst, const Entry*, Entry*>::type EntryPtr;
+
+    EntryPtr m_entry;  // into m_entries, which has no gaps
+
+    explicit Iterator(EntryPtr p) : m_entry(p) {}
+    friend class HashStorage;
+    friend class Iterator<true>;
+};
+
+template <typename KeyType, typename ValueType>
+const int HashStorage<KeyType, ValueType>::EMPTY;
+
+template <typename KeyType, typename ValueType>
+HashStorage<KeyType, ValueType>::HashStorage()
+ : m_slots(16, EMPTY)
+{
 }
 
 template <typename KeyType, typename ValueType>
-void subtract(const Map<KeyType, ValueType>& m1,
-			  const Map<KeyType, ValueType>& m2,
-			  Map<KeyType, ValueType>& result)
+HashStorage<KeyType, ValueType>::HashStorage(HashStorage&& other)
+ : m_entries(std::move(other.m_entries)), m_slots(16, EMPTY)
 {
-      // Guard against the case that result is an alias for m1 or m2
-      // (i.e., that result is a reference to the same map that m1 or m2
-      // refers to) by building the answer in a local variable res.  When
-      // done, swap res with result; the old value of result (now in res) will
-      // be destroyed when res is destroyed.
+      // The other map keeps a fresh empty table, since an empty m_slots
+      // has no mask
+    m_slots.swap(other.m_slots);
+}
 
-    if (m1.size() <= m2.size())
-    {
-          // If m1 is smaller, if an item in m1 should be in the result because
-          // its key is not in m2, add it
+template <typename KeyType, typename ValueType>
+inline
+HashStorage<KeyType, ValueType>& HashStorage<KeyType, ValueType>::operator=(HashStorage&& rhs)
+{
+    swap(rhs);
+    return *this;
+}
 
-        Map<KeyType, ValueType> res;
-        for (int n = 0; n < m1.size(); n++)
-        {
-            KeyType k;
-            ValueType v;
-            m1.get(n, k, v);
-            if (!m2.contains(k))
-                res.insert(k, v);
-        }
-        result.swap(res);
-    }
-    else
-    {
-          // If m1 is larger, copy it to the result and remove from result
-          // keys that are in m2
+template <typename KeyType, typename ValueType>
+inline
+ValueType* HashStorage<KeyType, ValueType>::find(const KeyType& key)
+{
+    int index = m_slots[findSlot(key, hashOf(key))];
+    return index == EMPTY ? NULL : &m_entries[index].m_value;
+}
 
-        Map<KeyType, ValueType> res(m1);
-        for (int n = 0; n < m2.size(); n++)
-        {
-            KeyType k;
-            ValueType v;
-            m2.get(n, k, v);
-            res.erase(k);
+template <typename KeyType, typename ValueType>
+inline
+const ValueType* HashStorage<KeyType, ValueType>::find(const KeyType& key) const
+{
+    int index = m_slots[findSlot(key, hashOf(key))];
+    return index == EMPTY ? NULL : &m_entries[index].m_value;
+}
+
+template <typename KeyType, typename ValueType>
+template <typename K, typename... Args>
+void HashStorage<KeyType, ValueType>::emplace(K&& key, Args&&... args)
+{
+    if (2 * (m_entries.size() + 1) > m_slots.size())
+        growSlots();
+
+      // Build the entry in place first, so the table is untouched if that
+      // throws; the new entry isn't in the table yet, so findSlot won't
+      // find it and returns the slot where it belongs
+    size_t hash = hashOf(key);
+    m_entries.emplace_back(hash, std::forward<K>(key), std::forward<Args>(args)...);
+    m_slots[findSlot(m_entries.back().m_key, hash)] = int(m_entries.size()) - 1;
+}
+
+template <typename KeyType, typename ValueType>
+bool HashStorage<KeyType, ValueType>::erase(const KeyType& key)
+{
+    size_t s = findSlot(key, hashOf(key));
+    int index = m_slots[s];
+    if (index == EMPTY)  // not found
+        return false;
+
+      // Empty the slot, then walk the rest of the probe run, moving back
+      // into the hole any entry whose home slot doesn't lie between the
+      // hole and where the entry sits now
+
+    size_t hole = s;
+    for (size_t t = (s + 1) & mask(); m_slots[t] != EMPTY; t = (t + 1) & mask())
+    {
+        size_t home = m_entries[m_slots[t]].m_hash & mask();
+        if (((t - home) & mask()) >= ((t - hole) & mask()))
+        {
+            m_slots[hole] = m_slots[t];
+            hole = t;
+        }
+    }
+    m_slots[hole] = EMPTY;
+
+      // Fill the gap in m_entries with the last entry
+
+    int last = int(m_entries.size()) - 1;
+    if (index != last)
+    {
+        m_slots[findSlotOf(last)] = index;
+        m_entries[index] = std::move(m_entries[last]);
+    }
+    m_entries.pop_back();
+    return true;
+}
+
+template <typename KeyType, typename ValueType>
+inline
+void HashStorage<KeyType, ValueType>::get(int i, KeyType& key, ValueType& value) const
+{
+    key = m_entries[i].m_key;
+    value = m_entries[i].m_value;
+}
+
+template <typename KeyType, typename ValueType>
+void HashStorage<KeyType, ValueType>::swap(HashStorage& other)
+{
+    m_entries.swap(other.m_entries);
+    m_slots.swap(other.m_slots);
+}
+
+template <typename KeyType, typename ValueType>
+size_t HashStorage<KeyType, ValueType>::findSlot(const KeyType& key, size_t hash) const
+{
+    size_t s = hash & mask();
+    while (m_slots[s] != EMPTY  &&  !(m_entries[m_slots[s]].m_key == key))
+        s = (s + 1) & mask();
+    return s;
+}
+
+template <typename KeyType, typename ValueType>
+size_t HashStorage<KeyType, ValueType>::findSlotOf(int index) const
+{
+    size_t s = m_entries[index].m_hash & mask();
+    while (m_slots[s] != index)
+        s = (s + 1) & mask();
+    return s;
+}
+
+template <typename KeyType, typename ValueType>
+void HashStorage<KeyType, ValueType>::growSlots()
+{
+      // Double the table and put each entry back in its new probe run
+
+    std::vector<int> newSlots(2 * m_slots.size(), EMPTY);
+    m_slots.swap(newSlots);
+    for (size_t k = 0; k != m_entries.size(); k++)
+    {
+        size_t s = m_entries[k].m_hash & mask();
+        while (m_slots[s] != EMPTY)
+            s = (s + 1) & mask();
+        m_slots[s] = int(k);
+    }
+}
+
+template <typename KeyType, typename ValueType>
+void HashStorage<KeyType, ValueType>::reserve(size_t n)
+{
+    while (2 * n > m_slots.size())
+        growSlots();
+    m_entries.reserve(n);
+}
+
+template <typename KeyType, typename ValueType>
+inline
+void HashStorage<KeyType, ValueType>::insertEntry(const Entry& e)
+{
+    if (2 * (m_entries.size() + 1) > m_slots.size())
+        growSlots();
+    m_slots[findSlot(e.m_key, e.m_hash)] = int(m_entries.size());
+    m_entries.push_back(e);
+}
+
+template <typename KeyType, typename ValueType>
+bool HashStorage<KeyType, ValueType>::joinEntry(const Entry& e)
+{
+    int index = m_slots[findSlot(e.m_key, e.m_hash)];
+    if (index == EMPTY)                               // key not here yet
+        insertEntry(e);
+    else if (m_entries[index].m_value != e.m_value)   // same key, different value
+    {
+        erase(e.m_key);
+        return false;
+    }
+    return true;
+}
+
+template <typename KeyType, typename ValueType>
+void HashStorage<KeyType, ValueType>::adopt(std::vector<HashStorage>& parts)
+{
+    size_t total = 0;
+    for (size_t p = 0; p != parts.size(); p++)
+        total += parts[p].m_entries.size();
+    reserve(total);
+    for (size_t p = 0; p != parts.size(); p++)
+    {
+        m_entries.insert(m_entries.end(), std::make_move_iterator(parts[p].m_entries.begin()),
+                                          std::make_move_iterator(parts[p].m_entries.end()));
+        std::vector<Entry>().swap(parts[p].m_entries);  // free it now
+    }
+
+      // Every entry is new to the table, so there's nothing to compare;
+      // just put each index in the first free slot of its probe run
+
+    for (size_t k = 0; k != m_entries.size(); k++)
+    {
+        size_t s = m_entries[k].m_hash & mask();
+        while (m_slots[s] != EMPTY)
+            s = (s + 1) & mask();
+        m_slots[s] = int(k);
+    }
+}
+
+template <typename KeyType, typename ValueType>
+bool HashStorage<KeyType, ValueType>::combine(const HashStorage& m1, const HashStorage& m2, HashStorage& result)
+{
+      // The bigger map is the basis for the result; probe it with each
+      // entry of the smaller one
+
+    const HashStorage* bigger = (m1.size() >= m2.size() ? &m1 : &m2);
+    const HashStorage* smaller = (bigger == &m1 ? &m2 : &m1);
+
+    result = *bigger;
+    result.reserve(bigger->m_entries.size() + smaller->m_entries.size());
+    bool status = true;
+    for (size_t k = 0; k != smaller->m_entries.size(); k++)
+    {
+        if (!result.joinEntry(smaller->m_entries[k]))
+            status = false;
+    }
+    return status;
+}
+
+template <typename KeyType, typename ValueType>
+void HashStorage<KeyType, ValueType>::subtract(const HashStorage& m1, const HashStorage& m2, HashStorage& result)
+{
+    result.reserve(m1.m_entries.size());
+    for (size_t k = 0; k != m1.m_entries.size(); k++)
+    {
+        const Entry& e = m1.m_entries[k];
+        if (m2.m_slots[m2.findSlot(e.m_key, e.m_hash)] == EMPTY)
+            result.insertEntry(e);
+    }
+}
+
+template <typename KeyType, typename ValueType>
+bool HashStorage<KeyType, ValueType>::combineParallel(const HashStorage& m1, const HashStorage& m2,
+                                                      HashStorage& result, int nThreads)
+{
+    if (nThreads <= 1)
+        return combine(m1, m2, result);
+
+      // First each thread s deals the entries of its own slices of m1 and
+      // m2 into buckets by partition, so that between them the threads look
+      // at each entry once.  Then thread t joins the pairs whose keys fall
+      // in partition t:  all its m1 buckets, then all its m2 buckets.
+      // Equal keys have equal hashes, so a conflict can only be found
+      // within one partition.
+
+    typedef std::vector<std::vector<const Entry*> > Buckets;  // by partition
+    std::vector<Buckets> buckets1(nThreads, Buckets(nThreads));
+    std::vector<Buckets> buckets2(nThreads, Buckets(nThreads));
+    std::vector<std::thread> threads;
+    for (int s = 0; s < nThreads; s++)
+    {
+        threads.push_back(std::thread([&, s]() {
+            size_t n1 = m1.m_entries.size();
+            for (size_t k = n1 * s / nThreads; k != n1 * (s+1) / nThreads; k++)
+                buckets1[s][partition(m1.m_entries[k].m_hash, nThreads)].push_back(&m1.m_entries[k]);
+            size_t n2 = m2.m_entries.size();
+            for (size_t k = n2 * s / nThreads; k != n2 * (s+1) / nThreads; k++)
+                buckets2[s][partition(m2.m_entries[k].m_hash, nThreads)].push_back(&m2.m_entries[k]);
+        }));
+    }
+    for (int s = 0; s < nThreads; s++)
+        threads[s].join();
+
+    std::vector<HashStorage> parts(nThreads);
+    std::vector<char> status(nThreads, true);
+    threads.clear();
+    for (int t = 0; t < nThreads; t++)
+    {
+        threads.push_back(std::thread([&, t]() {
+            size_t n = 0;
+            for (int s = 0; s < nThreads; s++)
+                n += buckets1[s][t].size() + buckets2[s][t].size();
+            parts[t].reserve(n);
+            for (int s = 0; s < nThreads; s++)
+            {
+                const std::vector<const Entry*>& b = buckets1[s][t];
+                for (size_t k = 0; k != b.size(); k++)
+                    parts[t].insertEntry(*b[k]);
+            }
+            for (int s = 0; s < nThreads; s++)
+            {
+                const std::vector<const Entry*>& b = buckets2[s][t];
+                for (size_t k = 0; k != b.size(); k++)
+                {
+                    if (!parts[t].joinEntry(*b[k]))
+                        status[t] = false;
+                }
+            }
+        }));
+    }
+    for (int t = 0; t < nThreads; t++)
+        threads[t].join();
+
+    result.adopt(parts);
+    return std::find(status.begin(), status.end(), false) == status.end();
+}
+
+template <typename KeyType, typename ValueType>
+void HashStorage<KeyType, ValueType>::subtractParallel(const HashStorage& m1, const HashStorage& m2,
+                                                       HashStorage& result, int nThreads)
+{
+    if (nThreads <= 1)
+    {
+        subtract(m1, m2, result);
+        return;
+    }
+
+      // m2 is only read, so each thread can probe it directly
+
+    std::vector<HashStorage> parts(nThreads);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < nThreads; t++)
+    {
+        threads.push_back(std::thread([&, t]() {
+            for (size_t k = t; k < m1.m_entries.size(); k += nThreads)
+            {
+                const Entry& e = m1.m_entries[k];
+                if (m2.m_slots[m2.findSlot(e.m_key, e.m_hash)] == EMPTY)
+                    parts[t].m_entries.push_back(e);
+            }
+        }));
+    }
+    for (int t = 0; t < nThreads; t++)
+        threads[t].join();
+
+    result.adopt(parts);
+}
+
+//========================================================================
+// BTreeStorage:  a B-tree (as in Cormen et al., chapter 18) ordered by
+// operator<.  Keys need only operator<; two keys are equal if neither is
+// less than the other.  get(i, ...) returns the pair with the ith smallest
+// key.
+//========================================================================
+
+template <typename KeyType, typename ValueType, typename Allocator>
+class BasicBTreeStorage
+{
+  public:
+    BasicBTreeStorage();
+    ~BasicBTreeStorage();
+    BasicBTreeStorage(const BasicBTreeStorage& other);
+    BasicBTreeStorage(BasicBTreeStorage&& other);
+    BasicBTreeStorage& operator=(const BasicBTreeStorage& rhs);
+    BasicBTreeStorage& operator=(BasicBTreeStorage&& rhs);
+
+    int size() const { return m_size; }
+    ValueType* find(const KeyType& key);
+    const ValueType* find(const KeyType& key) const;
+    template <typename K, typename... Args>
+    void emplace(K&& key, Args&&... args);
+    bool erase(const KeyType& key);
+    void get(int i, KeyType& key, ValueType& value) const;
+    void swap(BasicBTreeStorage& other);
+
+    template <bool IsConst> class Iterator;  // forward, in increasing order of key
+    typedef Iterator<false> iterator;
+    typedef Iterator<true>  const_iterator;
+    iterator begin()             { return iterator(m_root); }
+    iterator end()               { return iterator(); }
+    const_iterator begin() const { return const_iterator(m_root); }
+    const_iterator end() const   { return const_iterator(); }
+
+      // Merges:  the pairs of both maps are listed in key order, merged in
+      // one pass, and the result is built bottom up from the merged list,
+      // so these take time proportional to the sum of the sizes.  The
+      // parallel versions cut the key range into nThreads pieces and merge
+      // each piece in its own thread.
+    static bool combine(const BasicBTreeStorage& m1, const BasicBTreeStorage& m2, BasicBTreeStorage& result)
+    {
+        return combineParallel(m1, m2, result, 1);
+    }
+    static void subtract(const BasicBTreeStorage& m1, const BasicBTreeStorage& m2, BasicBTreeStorage& result)
+    {
+        subtractParallel(m1, m2, result, 1);
+    }
+    static bool combineParallel(const BasicBTreeStorage& m1, const BasicBTreeStorage& m2,
+                                BasicBTreeStorage& result, int nThreads);
+    static void subtractParallel(const BasicBTreeStorage& m1, const BasicBTreeStorage& m2,
+                                 BasicBTreeStorage& result, int nThreads);
+
+  private:
+      // Representation:
+      //   Every node except the root holds between T-1 and 2T-1 keys in
+      //   increasing order, with m_values[k] the value for m_keys[k].  An
+      //   interior node with n keys has n+1 children, and every key in
+      //   m_children[k] lies between m_keys[k-1] and m_keys[k].  All leaves
+      //   are at the same depth.  m_count is the number of keys in the
+      //   subtree rooted at the node, which lets get(i, ...) walk straight
+      //   down to the ith key.
+      //   m_root is NULL iff m_size == 0.
+
+    static const int T = 16;  // minimum degree
+
+    struct Node
+    {
+        std::vector<KeyType>   m_keys;
+        std::vector<ValueType> m_values;
+        std::vector<Node*>     m_children;  // empty for a leaf
+        int                    m_count;
+
+        Node() : m_count(0) {}
+        bool isLeaf() const { return m_children.empty(); }
+        bool isFull() const { return m_keys.size() == 2*T-1; }
+    };
+
+    Node* m_root;
+    int   m_size;
+
+    static size_t position(const Node* x, const KeyType& key);
+      // Return the index of the first key in x that is not less than key
+    static bool matches(const Node* x, size_t k, const KeyType& key)
+    {
+        return k < x->m_keys.size()  &&  !(key < x->m_keys[k]);
+    }
+    ValueType* findValue(const KeyType& key) const;
+    static void splitChild(Node* x, size_t k);
+    template <typename K, typename... Args>
+    static void insertNonFull(Node* x, K&& key, Args&&... args);
+    static void eraseFrom(Node* x, const KeyType& key);
+    static void mergeChildren(Node* x, size_t k);
+    static void fillChild(Node* x, size_t& k);
+    static Node* copyTree(const Node* x);
+    static void destroyTree(Node* x);
+
+    struct Pairs  // the pairs of a map, in increasing order of key
+    {
+        std::vector<KeyType>   m_keys;
+        std::vector<ValueType> m_values;
+    };
+
+    static void listPairs(const Node* x, Pairs& out);
+      // Append the pairs in the subtree rooted at x to out
+    static bool mergePairs(Pairs& a, size_t aBegin, size_t aEnd,
+                           Pairs& b, size_t bBegin, size_t bEnd,
+                           bool keepB, Pairs& out);
+      // Move to out, in order, the pairs of a[aBegin,aEnd) whose keys are
+      // not in b[bBegin,bEnd), the pairs whose keys are in both if their
+      // values agree, and if keepB is true the pairs of b whose keys are not
+      // in a.  Return false if any key is in both with different values.
+    static bool mergeParallel(Pairs& a, Pairs& b, bool keepB,
+                              Pairs& out, int nThreads);
+      // Do a mergePairs of all of a and b, in nThreads pieces
+    void build(Pairs& pairs);
+      // Replace an empty tree with one holding the pairs, moved out of pairs
+    static Node* buildTree(Pairs& pairs, size_t first, size_t n, int height);
+      // Return a subtree of the given height holding the n pairs from
+      // position first on
+
+    typedef typename std::allocator_traits<Allocator>::template rebind_alloc<Node> NodeAllocator;
+    static Node* newNode()
+    {
+        return new (NodeAllocator().allocate(1)) Node;
+    }
+    static void deleteNode(Node* p)
+    {
+        p->~Node();
+        NodeAllocator().deallocate(p, 1);
+    }
+};
+
+template <typename KeyType, typename ValueType>
+using BTreeStorage = BasicBTreeStorage<KeyType, ValueType, PoolAllocator<KeyType> >;
+
+template <typename KeyType, typename ValueType, typename Allocator>
+template <bool IsConst>
+class BasicBTreeStorage<KeyType, ValueType, Allocator>::Iterator
+{
+  public:
+    typedef std::forward_iterator_tag     iterator_category;
+    typedef std::pair<KeyType, ValueType> value_type;
+    typedef std::ptrdiff_t                difference_type;
+    typedef MapEntry<KeyType, typename std::conditional<IsConst, const ValueType, ValueType>::type> reference;
+    typedef reference                     pointer;
+
+    Iterator() : m_depth(0) {}
+    Iterator(const Iterator<false>& other)  // also makes a const_iterator
+     : m_depth(other.m_depth)
+    {
+        std::copy(other.m_path, other.m_path + m_depth, m_path);
+        std::copy(other.m_index, other.m_index + m_depth, m_index);
+    }
+
+    reference operator*() const
+    {
+        NodePtr x = m_path[m_depth-1];
+        return reference(x->m_keys[m_index[m_depth-1]], x->m_values[m_index[m_depth-1]]);
+    }
+    pointer operator->() const { return **this; }
+    Iterator& operator++();
+    Iterator operator++(int) { Iterator old(*this); ++*this; return old; }
+    bool operator==(const Iterator& other) const
+    {
+        return m_depth == other.m_depth  &&
+                (m_depth == 0  ||  (m_path[m_depth-1] == other.m_path[m_depth-1]  &&
+                                    m_index[m_depth-1] == other.m_index[m_depth-1]));
+    }
+    bool operator!=(const Iterator& other) const { return !(*this == other); }
+
+  private:
+    typedef typename std::conditional<IsConst, const Node*, Node*>::type NodePtr;
+
+      // The nodes from the root down to the one holding the current key.
+      // m_index[m_depth-1] is the position of that key in its node; for
+      // each node above it, m_index is the child the path goes through,
+      // which is also the position of the key to visit once that child's
+      // subtree is done.  m_depth is 0 for end().  A tree of height h has
+      // at least 2T^(h-1) - 1 keys, so with T = 16 an int's worth of keys
+      // fits in 8 levels.
+
+    static const int MAX_HEIGHT = 8;
+
+    NodePtr m_path[MAX_HEIGHT];
+    size_t  m_index[MAX_HEIGHT];
+    int     m_depth;
+
+    explicit Iterator(NodePtr root)
+     : m_depth(0)
+    {
+        if (root != NULL)
+            descendLeft(root);
+    }
+    void descendLeft(NodePtr x)
+    {
+          // Extend the path to the smallest key in the subtree rooted at x
+        for (;;)
+        {
+            m_path[m_depth] = x;
+            m_index[m_depth] = 0;
+            m_depth++;
+            if (x->isLeaf())
+                break;
+            x = x->m_children[0];
+        }
+    }
+    friend class BasicBTreeStorage;
+    friend class Iterator<true>;
+};
+
+template <typename KeyType, typename ValueType, typename Allocator>
+template <bool IsConst>
+typename BasicBTreeStorage<KeyType, ValueType, Allocator>::template Iterator<IsConst>&
+BasicBTreeStorage<KeyType, ValueType, Allocator>::Iterator<IsConst>::operator++()
+{
+    NodePtr x = m_path[m_depth-1];
+    size_t& k = m_index[m_depth-1];
+
+      // In an interior node, the next key is the smallest one in the
+      // subtree to the right of this key
+
+    if (!x->isLeaf())
+    {
+        k++;
+        descendLeft(x->m_children[k]);
+        return *this;
+    }
+
+      // In a leaf, it's the next key over, or once the leaf is done, the
+      // key after the child we came from in the nearest ancestor that has
+      // one
+
+    if (++k < x->m_keys.size())
+        return *this;
+    for (m_depth--; m_depth > 0; m_depth--)
+    {
+        if (m_index[m_depth-1] < m_path[m_depth-1]->m_keys.size())
+            break;
+    }
+    return *this;
+}
+
+template <typename KeyType, typename ValueType, typename Allocator>
+BasicBTreeStorage<KeyType, ValueType, Allocator>::BasicBTreeStorage()
+ : m_root(NULL), m_size(0)
+{
+}
+
+template <typename KeyType, typename ValueType, typename Allocator>
+BasicBTreeStorage<KeyType, ValueType, Allocator>::~BasicBTreeStorage()
+{
+    destroyTree(m_root);
+}
+
+template <typename KeyType, typename ValueType, typename Allocator>
+BasicBTreeStorage<KeyType, ValueType, Allocator>::BasicBTreeStorage(const BasicBTreeStorage& other)
+ : m_root(copyTree(other.m_root)), m_size(other.m_size)
+{
+}
+
+template <typename KeyType, typename ValueType, typename Allocator>
+BasicBTreeStorage<KeyType, ValueType, Allocator>::BasicBTreeStorage(BasicBTreeStorage&& other)
+ : m_root(other.m_root), m_size(other.m_size)
+{
+    other.m_root = NULL;
+    other.m_size = 0;
+}
+
+template <typename KeyType, typename ValueType, typename Allocator>
+BasicBTreeStorage<KeyType, ValueType, Allocator>& BasicBTreeStorage<KeyType, ValueType, Allocator>::operator=(const BasicBTreeStorage& rhs)
+{
+    if (this != &rhs)
+    {
+        BasicBTreeStorage temp(rhs);
+        swap(temp);
+    }
+    return *this;
+}
+
+template <typename KeyType, typename ValueType, typename Allocator>
+inline
+BasicBTreeStorage<KeyType, ValueType, Allocator>& BasicBTreeStorage<KeyType, ValueType, Allocator>::operator=(BasicBTreeStorage&& rhs)
+{
+    swap(rhs);
+    return *this;
+}
+
+template <typename KeyType, typename ValueType, typename Allocator>
+inline
+ValueType* BasicBTreeStorage<KeyType, ValueType, Allocator>::find(const KeyType& key)
+{
+    return findValue(key);
+}
+
+template <typename KeyType, typename ValueType, typename Allocator>
+inline
+const ValueType* BasicBTreeStorage<KeyType, ValueType, Allocator>::find(const KeyType& key) const
+{
+    return findValue(key);
+}
+
+template <typename KeyType, typename ValueType, typename Allocator>
+template <typename K, typename... Args>
+void BasicBTreeStorage<KeyType, ValueType, Allocator>::emplace(K&& key, Args&&... args)
+{
+    if (m_root == NULL)
+        m_root = newNode();
+    else if (m_root->isFull())
+    {
+          // Split the root on the way down; this is the only way the tree
+          // grows taller
+        Node* s = newNode();
+        s->m_children.push_back(m_root);
+        s->m_count = m_root->m_count;
+        m_root = s;
+        splitChild(s, 0);
+    }
+    insertNonFull(m_root, std::forward<K>(key), std::forward<Args>(args)...);
+    m_size++;
+}
+
+template <typename KeyType, typename ValueType, typename Allocator>
+bool BasicBTreeStorage<KeyType, ValueType, Allocator>::erase(const KeyType& key)
+{
+      // eraseFrom assumes the key is present, so it can adjust the subtree
+      // counts on the way down
+
+    if (findValue(key) == NULL)
+        return false;
+
+    eraseFrom(m_root, key);
+    m_size--;
+
+      // If the root has run out of keys, the tree gets shorter
+
+    if (m_root->m_keys.empty())
+    {
+        Node* oldRoot = m_root;
+        m_root = oldRoot->isLeaf() ? NULL : oldRoot->m_children[0];
+        oldRoot->m_children.clear();
+        deleteNode(oldRoot);
+    }
+    return true;
+}
+
+template <typename KeyType, typename ValueType, typename Allocator>
+void BasicBTreeStorage<KeyType, ValueType, Allocator>::get(int i, KeyType& key, ValueType& value) const
+{
+    const Node* x = m_root;
+    for (;;)
+    {
+        if (x->isLeaf())
+        {
+            key = x->m_keys[i];
+            value = x->m_values[i];
+            return;
+        }
+
+          // Skip whole subtrees (and the keys between them) until the one
+          // holding position i
+
+        size_t k = 0;
+        for ( ; i >= x->m_children[k]->m_count; k++)
+        {
+            i -= x->m_children[k]->m_count;
+            if (i == 0)
+            {
+                key = x->m_keys[k];
+                value = x->m_values[k];
+                return;
+            }
+            i--;
+        }
+        x = x->m_children[k];
+    }
+}
+
+template <typename KeyType, typename ValueType, typename Allocator>
+void BasicBTreeStorage<KeyType, ValueType, Allocator>::swap(BasicBTreeStorage& other)
+{
+    std::swap(m_root, other.m_root);
+    std::swap(m_size, other.m_size);
+}
+
+template <typename KeyType, typename ValueType, typename Allocator>
+size_t BasicBTreeStorage<KeyType, ValueType, Allocator>::position(const Node* x, const KeyType& key)
+{
+      // Binary search; nodes hold up to 2T-1 keys
+
+    size_t lo = 0;
+    size_t hi = x->m_keys.size();
+    while (lo < hi)
+    {
+        size_t mid = (lo + hi) / 2;
+        if (x->m_keys[mid] < key)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+template <typename KeyType, typename ValueType, typename Allocator>
+ValueType* BasicBTreeStorage<KeyType, ValueType, Allocator>::findValue(const KeyType& key) const
+{
+    Node* x = m_root;
+    while (x != NULL)
+    {
+        size_t k = position(x, key);
+        if (matches(x, k, key))
+            return &x->m_values[k];
+        x = x->isLeaf() ? NULL : x->m_children[k];
+    }
+    return NULL;
+}
+
+template <typename KeyType, typename ValueType, typename Allocator>
+void BasicBTreeStorage<KeyType, ValueType, Allocator>::splitChild(Node* x, size_t k)
+{
+      // x->m_children[k] is full.  Its upper T-1 keys go to a new node z,
+      // and its median key moves up into x between y and z.
+
+    Node* y = x->m_children[k];
+    Node* z = newNode();
+
+    z->m_keys.assign(std::make_move_iterator(y->m_keys.begin() + T),
+                     std::make_move_iterator(y->m_keys.end()));
+    z->m_values.assign(std::make_move_iterator(y->m_values.begin() + T),
+                       std::make_move_iterator(y->m_values.end()));
+    z->m_count = T - 1;
+    if (!y->isLeaf())
+    {
+        z->m_children.assign(y->m_children.begin() + T, y->m_children.end());
+        y->m_children.resize(T);
+        for (size_t c = 0; c != z->m_children.size(); c++)
+            z->m_count += z->m_children[c]->m_count;
+    }
+
+    x->m_keys.insert(x->m_keys.begin() + k, std::move(y->m_keys[T-1]));
+    x->m_values.insert(x->m_values.begin() + k, std::move(y->m_values[T-1]));
+    x->m_children.insert(x->m_children.begin() + k + 1, z);
+
+    y->m_keys.resize(T-1);
+    y->m_values.resize(T-1);
+    y->m_count -= z->m_count + 1;
+}
+
+template <typename KeyType, typename ValueType, typename Allocator>
+template <typename K, typename... Args>
+void BasicBTreeStorage<KeyType, ValueType, Allocator>::insertNonFull(Node* x, K&& key, Args&&... args)
+{
+      // Walk down, splitting any full child before entering it, so there
+      // is always room for the key when we reach a leaf
+
+    for (;;)
+    {
+        x->m_count++;
+        size_t k = position(x, key);
+        if (x->isLeaf())
+        {
+            x->m_keys.emplace(x->m_keys.begin() + k, std::forward<K>(key));
+            x->m_values.emplace(x->m_values.begin() + k, std::forward<Args>(args)...);
+            return;
+        }
+        if (x->m_children[k]->isFull())
+        {
+            splitChild(x, k);
+            if (x->m_keys[k] < key)
+                k++;
+        }
+        x = x->m_children[k];
+    }
+}
+
+template <typename KeyType, typename ValueType, typename Allocator>
+void BasicBTreeStorage<KeyType, ValueType, Allocator>::eraseFrom(Node* x, const KeyType& key)
+{
+      // The key is somewhere in the subtree rooted at x, and x has at least
+      // T keys unless it is the root.  Before stepping into a child, make
+      // sure the child has at least T keys too, so a key can always be
+      // removed from a leaf without underflow.
+
+    for (;;)
+    {
+        x->m_count--;
+        size_t k = position(x, key);
+
+        if (matches(x, k, key))
+        {
+            if (x->isLeaf())
+            {
+                x->m_keys.erase(x->m_keys.begin() + k);
+                x->m_values.erase(x->m_values.begin() + k);
+                return;
+            }
+
+            Node* y = x->m_children[k];
+            Node* z = x->m_children[k+1];
+            if (y->m_keys.size() >= T)
+            {
+                  // Replace the key with its predecessor, then remove the
+                  // predecessor from y's subtree.  The key is needed to
+                  // find it again, so only the value can be moved.
+                Node* p = y;
+                while (!p->isLeaf())
+                    p = p->m_children.back();
+                x->m_keys[k] = p->m_keys.back();
+                x->m_values[k] = std::move(p->m_values.back());
+                eraseFrom(y, x->m_keys[k]);
+                return;
+            }
+            if (z->m_keys.size() >= T)
+            {
+                  // Likewise with the successor from z's subtree
+                Node* p = z;
+                while (!p->isLeaf())
+                    p = p->m_children.front();
+                x->m_keys[k] = p->m_keys.front();
+                x->m_values[k] = std::move(p->m_values.front());
+                eraseFrom(z, x->m_keys[k]);
+                return;
+            }
+
+              // Both neighbours are minimal; merge them around the key and
+              // remove it from the merged node
+            mergeChildren(x, k);
+            x = y;
+            continue;
+        }
+
+        fillChild(x, k);
+        x = x->m_children[k];
+    }
+}
+
+template <typename KeyType, typename ValueType, typename Allocator>
+void BasicBTreeStorage<KeyType, ValueType, Allocator>::mergeChildren(Node* x, size_t k)
+{
+      // Move x->m_keys[k] and everything in x->m_children[k+1] into
+      // x->m_children[k], then destroy the emptied child
+
+    Node* y = x->m_children[k];
+    Node* z = x->m_children[k+1];
+
+    y->m_keys.push_back(std::move(x->m_keys[k]));
+    y->m_values.push_back(std::move(x->m_values[k]));
+    y->m_keys.insert(y->m_keys.end(), std::make_move_iterator(z->m_keys.begin()),
+                                      std::make_move_iterator(z->m_keys.end()));
+    y->m_values.insert(y->m_values.end(), std::make_move_iterator(z->m_values.begin()),
+                                          std::make_move_iterator(z->m_values.end()));
+    y->m_children.insert(y->m_children.end(), z->m_children.begin(), z->m_children.end());
+    y->m_count += 1 + z->m_count;
+
+    x->m_keys.erase(x->m_keys.begin() + k);
+    x->m_values.erase(x->m_values.begin() + k);
+    x->m_children.erase(x->m_children.begin() + k + 1);
+
+    z->m_children.clear();
+    deleteNode(z);
+}
+
+template <typename KeyType, typename ValueType, typename Allocator>
+void BasicBTreeStorage<KeyType, ValueType, Allocator>::fillChild(Node* x, size_t& k)
+{
+      // Make sure x->m_children[k] has at least T keys, by borrowing a key
+      // through x from a sibling that can spare one, or else by merging
+      // with a sibling.  k is adjusted if the child ends up at k-1.
+
+    Node* c = x->m_children[k];
+    if (c->m_keys.size() >= T)
+        return;
+
+    if (k > 0  &&  x->m_children[k-1]->m_keys.size() >= T)
+    {
+        Node* left = x->m_children[k-1];
+        c->m_keys.insert(c->m_keys.begin(), std::move(x->m_keys[k-1]));
+        c->m_values.insert(c->m_values.begin(), std::move(x->m_values[k-1]));
+        x->m_keys[k-1] = std::move(left->m_keys.back());
+        x->m_values[k-1] = std::move(left->m_values.back());
+        left->m_keys.pop_back();
+        left->m_values.pop_back();
+        int moved = 1;
+        if (!left->isLeaf())
+        {
+            Node* sub = left->m_children.back();
+            left->m_children.pop_back();
+            c->m_children.insert(c->m_children.begin(), sub);
+            moved += sub->m_count;
+        }
+        c->m_count += moved;
+        left->m_count -= moved;
+    }
+    else if (k < x->m_keys.size()  &&  x->m_children[k+1]->m_keys.size() >= T)
+    {
+        Node* right = x->m_children[k+1];
+        c->m_keys.push_back(std::move(x->m_keys[k]));
+        c->m_values.push_back(std::move(x->m_values[k]));
+        x->m_keys[k] = std::move(right->m_keys.front());
+        x->m_values[k] = std::move(right->m_values.front());
+        right->m_keys.erase(right->m_keys.begin());
+        right->m_values.erase(right->m_values.begin());
+        int moved = 1;
+        if (!right->isLeaf())
+        {
+            Node* sub = right->m_children.front();
+            right->m_children.erase(right->m_children.begin());
+            c->m_children.push_back(sub);
+            moved += sub->m_count;
+        }
+        c->m_count += moved;
+        right->m_count -= moved;
+    }
+    else if (k < x->m_keys.size())
+        mergeChildren(x, k);
+    else
+    {
+        mergeChildren(x, k-1);
+        k--;
+    }
+}
+
+template <typename KeyType, typename ValueType, typename Allocator>
+void BasicBTreeStorage<KeyType, ValueType, Allocator>::listPairs(const Node* x, Pairs& out)
+{
+    if (x == NULL)
+        return;
+    for (size_t k = 0; k != x->m_keys.size(); k++)
+    {
+        if (!x->isLeaf())
+            listPairs(x->m_children[k], out);
+        out.m_keys.push_back(x->m_keys[k]);
+        out.m_values.push_back(x->m_values[k]);
+    }
+    if (!x->isLeaf())
+        listPairs(x->m_children.back(), out);
+}
+
+template <typename KeyType, typename ValueType, typename Allocator>
+bool BasicBTreeStorage<KeyType, ValueType, Allocator>::mergePairs(Pairs& a, size_t aBegin, size_t aEnd,
+                                                  Pairs& b, size_t bBegin, size_t bEnd,
+                                                  bool keepB, Pairs& out)
+{
+      // a and b are scratch lists, so their pairs are moved rather than
+      // copied
+    bool status = true;
+    size_t i = aBegin;
+    size_t j = bBegin;
+    while (i < aEnd  ||  j < bEnd)
+    {
+        if (j == bEnd  ||  (i < aEnd  &&  a.m_keys[i] < b.m_keys[j]))
+        {
+            out.m_keys.push_back(std::move(a.m_keys[i]));
+            out.m_values.push_back(std::move(a.m_values[i]));
+            i++;
+        }
+        else if (i == aEnd  ||  b.m_keys[j] < a.m_keys[i])
+        {
+            if (keepB)
+            {
+                out.m_keys.push_back(std::move(b.m_keys[j]));
+                out.m_values.push_back(std::move(b.m_values[j]));
+            }
+            j++;
+        }
+        else  // same key
+        {
+            if (a.m_values[i] != b.m_values[j])
+                status = false;
+            else if (keepB)
+            {
+                out.m_keys.push_back(std::move(a.m_keys[i]));
+                out.m_values.push_back(std::move(a.m_values[i]));
+            }
+            i++;
+            j++;
+        }
+    }
+    return status;
+}
+
+template <typename KeyType, typename ValueType, typename Allocator>
+bool BasicBTreeStorage<KeyType, ValueType, Allocator>::mergeParallel(Pairs& a, Pairs& b, bool keepB,
+                                                     Pairs& out, int nThreads)
+{
+    if (nThreads <= 1  ||  a.m_keys.size() < size_t(nThreads))
+        return mergePairs(a, 0, a.m_keys.size(), b, 0, b.m_keys.size(), keepB, out);
+
+      // Cut a into nThreads equal pieces, and cut b at the same keys, so
+      // equal keys always land in the same piece
+
+    std::vector<size_t> aCut(nThreads + 1);
+    std::vector<size_t> bCut(nThreads + 1);
+    for (int t = 0; t <= nThreads; t++)
+    {
+        aCut[t] = a.m_keys.size() * t / nThreads;
+        if (t == 0)
+            bCut[t] = 0;
+        else if (t == nThreads)
+            bCut[t] = b.m_keys.size();
+        else
+            bCut[t] = std::lower_bound(b.m_keys.begin(), b.m_keys.end(), a.m_keys[aCut[t]])
+                                                                        - b.m_keys.begin();
+    }
+
+    std::vector<Pairs> parts(nThreads);
+    std::vector<char> status(nThreads, true);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < nThreads; t++)
+    {
+        threads.push_back(std::thread([&, t]() {
+            status[t] = mergePairs(a, aCut[t], aCut[t+1], b, bCut[t], bCut[t+1], keepB, parts[t]);
+        }));
+    }
+    for (int t = 0; t < nThreads; t++)
+        threads[t].join();
+
+    for (int t = 0; t < nThreads; t++)
+    {
+        out.m_keys.insert(out.m_keys.end(), std::make_move_iterator(parts[t].m_keys.begin()),
+                                            std::make_move_iterator(parts[t].m_keys.end()));
+        out.m_values.insert(out.m_values.end(), std::make_move_iterator(parts[t].m_values.begin()),
+                                                std::make_move_iterator(parts[t].m_values.end()));
+    }
+    return std::find(status.begin(), status.end(), false) == status.end();
+}
+
+template <typename KeyType, typename ValueType, typename Allocator>
+bool BasicBTreeStorage<KeyType, ValueType, Allocator>::combineParallel(const BasicBTreeStorage& m1, const BasicBTreeStorage& m2,
+                                                       BasicBTreeStorage& result, int nThreads)
+{
+    Pairs a;
+    Pairs b;
+    listPairs(m1.m_root, a);
+    listPairs(m2.m_root, b);
+    Pairs merged;
+    bool status = mergeParallel(a, b, true /* keep pairs only in m2 */, merged, nThreads);
+    result.build(merged);
+    return status;
+}
+
+template <typename KeyType, typename ValueType, typename Allocator>
+void BasicBTreeStorage<KeyType, ValueType, Allocator>::subtractParallel(const BasicBTreeStorage& m1, const BasicBTreeStorage& m2,
+                                                        BasicBTreeStorage& result, int nThreads)
+{
+      // A pair of m1 survives exactly when its key isn't in m2; a key in
+      // both is dropped whether or not the values agree
+
+    Pairs a;
+    Pairs b;
+    listPairs(m1.m_root, a);
+    listPairs(m2.m_root, b);
+    Pairs difference;
+    mergeParallel(a, b, false /* drop pairs only in m2 */, difference, nThreads);
+    result.build(difference);
+}
+
+template <typename KeyType, typename ValueType, typename Allocator>
+void BasicBTreeStorage<KeyType, ValueType, Allocator>::build(Pairs& pairs)
+{
+      // Find the lowest tree that can hold all the pairs:  one of height h
+      // holds at most (2T)^(h+1) - 1 keys
+
+    size_t n = pairs.m_keys.size();
+    if (n == 0)
+        return;
+    int height = 0;
+    for (double capacity = 2*T - 1; capacity < n; capacity = capacity * 2*T + 2*T - 1)
+        height++;
+    m_root = buildTree(pairs, 0, n, height);
+    m_size = int(n);
+}
+
+template <typename KeyType, typename ValueType, typename Allocator>
+typename BasicBTreeStorage<KeyType, ValueType, Allocator>::Node* BasicBTreeStorage<KeyType, ValueType, Allocator>::buildTree(
+                              Pairs& pairs, size_t first, size_t n, int height)
+{
+    Node* x = newNode();
+    x->m_count = int(n);
+    if (height == 0)
+    {
+        x->m_keys.assign(std::make_move_iterator(pairs.m_keys.begin() + first),
+                         std::make_move_iterator(pairs.m_keys.begin() + first + n));
+        x->m_values.assign(std::make_move_iterator(pairs.m_values.begin() + first),
+                           std::make_move_iterator(pairs.m_values.begin() + first + n));
+        return x;
+    }
+
+      // A non-root subtree of height h-1 holds at least T^h - 1 keys.  Use
+      // as many children as we can (up to 2T) while giving each child at
+      // least that many, then share the keys out as evenly as possible.
+      // Each child then gets fewer than 2 T^h keys, which fits, and each
+      // gets at least T^h - 1, so its own children can be filled the same
+      // way.
+
+    double minChild = 1;
+    for (int h = 0; h < height; h++)
+        minChild *= T;
+    size_t nChildren = size_t((n + 1) / minChild);
+    if (nChildren > size_t(2*T))
+        nChildren = 2*T;
+
+    size_t childKeys = n - (nChildren - 1);
+    size_t base = childKeys / nChildren;
+    size_t extra = childKeys % nChildren;
+    for (size_t c = 0; c != nChildren; c++)
+    {
+        size_t m = base + (c < extra ? 1 : 0);
+        x->m_children.push_back(buildTree(pairs, first, m, height - 1));
+        first += m;
+        if (c + 1 != nChildren)
+        {
+            x->m_keys.push_back(std::move(pairs.m_keys[first]));
+            x->m_values.push_back(std::move(pairs.m_values[first]));
+            first++;
+        }
+    }
+    return x;
+}
+
+template <typename KeyType, typename ValueType, typename Allocator>
+typename BasicBTreeStorage<KeyType, ValueType, Allocator>::Node* BasicBTreeStorage<KeyType, ValueType, Allocator>::copyTree(const Node* x)
+{
+    if (x == NULL)
+        return NULL;
+    Node* n = newNode();
+    n->m_keys = x->m_keys;
+    n->m_values = x->m_values;
+    n->m_count = x->m_count;
+    for (size_t c = 0; c != x->m_children.size(); c++)
+        n->m_children.push_back(copyTree(x->m_children[c]));
+    return n;
+}
+
+template <typename KeyType, typename ValueType, typename Allocator>
+void BasicBTreeStorage<KeyType, ValueType, Allocator>::destroyTree(Node* x)
+{
+    if (x == NULL)
+        return;
+    for (size_t c = 0; c != x->m_children.size(); c++)
+        destroyTree(x->m_children[c]);
+    deleteNode(x);
+}
+
+//========================================================================
+// PersistentStorage:  an AVL tree ordered by operator<, whose nodes can be
+// shared by many maps.  Keys need only operator<; two keys are equal if
+// neither is less than the other.  get(i, ...) returns the pair with the
+// ith smallest key.
+//
+// Copying a map copies no nodes, just a pointer to the root, so a copy is
+// a snapshot taken in constant time.  A change copies only the nodes on
+// the path from the root to the pair changed (and any a rotation touches)
+// that are still shared with another map; a node only one map can reach
+// is changed in place.  Updating a snapshot therefore costs O(log n)
+// copied nodes, and a map with no snapshots is changed as cheaply as a
+// plain tree.  Maps sharing nodes may be used in different threads at
+// once; the counts that track the sharing are atomic.
+//
+// A value may be shared, so it can't be changed through an iterator; both
+// iterator types are const_iterators.
+//========================================================================
+
+template <typename KeyType, typename ValueType, typename Allocator>
+class BasicPersistentStorage
+{
+  public:
+    BasicPersistentStorage() : m_root(NULL) {}
+    ~BasicPersistentStorage() { release(m_root); }
+    BasicPersistentStorage(const BasicPersistentStorage& other);
+    BasicPersistentStorage(BasicPersistentStorage&& other);
+    BasicPersistentStorage& operator=(const BasicPersistentStorage& rhs);
+    BasicPersistentStorage& operator=(BasicPersistentStorage&& rhs);
+
+    int size() const { return count(m_root); }
+    ValueType* find(const KeyType& key);
+    const ValueType* find(const KeyType& key) const;
+    template <typename K, typename... Args>
+    void emplace(K&& key, Args&&... args);
+    bool erase(const KeyType& key);
+    void get(int i, KeyType& key, ValueType& value) const;
+    void swap(BasicPersistentStorage& other) { std::swap(m_root, other.m_root); }
+
+    class const_iterator;  // forward, in increasing order of key
+    typedef const_iterator iterator;
+    const_iterator begin() const;
+    const_iterator end() const;
+
+      // The result starts as a snapshot of one map, and the pairs of the
+      // other are looked up in it one at a time, so these take time
+      // proportional to the smaller size times the log of the larger, and
+      // the result shares whatever it didn't change.  The parallel
+      // versions just call them.
+    static bool combine(const BasicPersistentStorage& m1, const BasicPersistentStorage& m2,
+                        BasicPersistentStorage& result);
+    static void subtract(const BasicPersistentStorage& m1, const BasicPersistentStorage& m2,
+                         BasicPersistentStorage& result);
+    static bool combineParallel(const BasicPersistentStorage& m1, const BasicPersistentStorage& m2,
+                                BasicPersistentStorage& result, int)
+    {
+        return combine(m1, m2, result);
+    }
+    static void subtractParallel(const BasicPersistentStorage& m1, const BasicPersistentStorage& m2,
+                                 BasicPersistentStorage& result, int)
+    {
+        subtract(m1, m2, result);
+    }
+
+  private:
+      // Representation:
+      //   A binary search tree in which the heights of the two subtrees of
+      //   every node differ by at most 1.  m_count is the number of pairs
+      //   in the subtree rooted at the node, which lets get(i, ...) walk
+      //   straight down to the ith key.  m_refs is the number of pointers
+      //   to the node, from parents and from maps' m_root; a node whose
+      //   m_refs is 1, reached through nodes whose m_refs are all 1, is
+      //   reachable from only one map and may be changed.  Any other node
+      //   is never changed; own() gives the map a copy of it first.
+      //   m_root is NULL iff the map is empty.
+
+    struct Node
+    {
+        KeyType          m_key;
+        ValueType        m_value;
+        Node*            m_left;
+        Node*            m_right;
+        int              m_height;  // 1 for a leaf
+        int              m_count;
+        std::atomic<int> m_refs;
+
+        template <typename K, typename... Args>
+        Node(K&& key, Args&&... args)
+         : m_key(std::forward<K>(key)), m_value(std::forward<Args>(args)...),
+           m_left(NULL), m_right(NULL), m_height(1), m_count(1), m_refs(1)
+        {}
+        Node(const Node& other)  // a copy to change; it shares the children
+         : m_key(other.m_key), m_value(other.m_value),
+           m_left(other.m_left), m_right(other.m_right),
+           m_height(other.m_height), m_count(other.m_count), m_refs(1)
+        {
+            retain(m_left);
+            retain(m_right);
+        }
+    };
+
+    Node* m_root;
+
+    static int height(const Node* x) { return x == NULL ? 0 : x->m_height; }
+    static int count(const Node* x) { return x == NULL ? 0 : x->m_count; }
+    static void retain(Node* x)
+    {
+        if (x != NULL)
+            x->m_refs.fetch_add(1, std::memory_order_relaxed);
+    }
+    static void release(Node* x);
+      // Drop one pointer to x, destroying it (and dropping its pointers to
+      // its children) if that was the last
+    static void own(Node*& x);
+      // Make x point to a node only this map can reach:  x itself if it
+      // already is one, otherwise a copy.  x's parent must already be owned.
+    static const Node* findNode(const Node* x, const KeyType& key);
+    static void fix(Node* x)
+    {
+        x->m_height = 1 + std::max(height(x->m_left), height(x->m_right));
+        x->m_count = 1 + count(x->m_left) + count(x->m_right);
+    }
+    static void rotateLeft(Node*& x);
+    static void rotateRight(Node*& x);
+    static void rebalance(Node*& x);
+      // x is owned and its subtrees are balanced, with heights differing
+      // by at most 2; restore the balance at x and fix its fields
+    template <typename K, typename... Args>
+    static void insertAt(Node*& x, K&& key, Args&&... args);
+    static void eraseAt(Node*& x, const KeyType& key);
+      // key must be in the subtree rooted at x
+    static Node* removeMin(Node*& x);
+      // Unlink the node with the smallest key in the nonempty subtree
+      // rooted at x and return it, owned
+
+    typedef typename std::allocator_traits<Allocator>::template rebind_alloc<Node> NodeAllocator;
+    template <typename... Args>
+    static Node* newNode(Args&&... args)
+    {
+        Node* p = NodeAllocator().allocate(1);
+        try
+        {
+            return new (p) Node(std::forward<Args>(args)...);
+        }
+        catch (...)
+        {
+            NodeAllocator().deallocate(p, 1);
+            throw;
+        }
+    }
+    static void deleteNode(Node* p)
+    {
+        p->~Node();
+        NodeAllocator().deallocate(p, 1);
+    }
+};
+
+template <typename KeyType, typename ValueType>
+using PersistentStorage = BasicPersistentStorage<KeyType, ValueType, PoolAllocator<KeyType> >;
+
+template <typename KeyType, typename ValueType, typename Allocator>
+class BasicPersistentStorage<KeyType, ValueType, Allocator>::const_iterator
+{
+  public:
+    typedef std::forward_iterator_tag      iterator_category;
+    typedef std::pair<KeyType, ValueType>  value_type;
+    typedef std::ptrdiff_t                 difference_type;
+    typedef MapEntry<KeyType, const ValueType> reference;
+    typedef reference                      pointer;
+
+    const_iterator() : m_depth(0) {}
+
+    reference operator*() const
+    {
+        const Node* x = m_stack[m_depth-1];
+        return reference(x->m_key, x->m_value);
+    }
+    pointer operator->() const { return **this; }
+    const_iterator& operator++()
+    {
+          // The next key is the smallest in the right subtree, or if there
+          // is none, the nearest ancestor still waiting on the stack
+        const Node* x = m_stack[--m_depth];
+        pushLeft(x->m_right);
+        return *this;
+    }
+    const_iterator operator++(int) { const_iterator old(*this); ++*this; return old; }
+    bool operator==(const const_iterator& other) const
+    {
+        return m_depth == other.m_depth  &&
+                (m_depth == 0  ||  m_stack[m_depth-1] == other.m_stack[m_depth-1]);
+    }
+    bool operator!=(const const_iterator& other) const { return !(*this == other); }
+
+  private:
+      // m_stack[m_depth-1] is the current node; below it are the ancestors
+      // whose keys are still to come, nearest last.  m_depth is 0 for
+      // end().  An AVL tree of height h has at least F(h+2) - 1 nodes,
+      // where F is the Fibonacci sequence, so an int's worth of pairs fits
+      // in 44 levels.
+
+    static const int MAX_HEIGHT = 44;
+
+    const Node* m_stack[MAX_HEIGHT];
+    int         m_depth;
+
+    explicit const_iterator(const Node* root) : m_depth(0) { pushLeft(root); }
+    void pushLeft(const Node* x)
+    {
+        for ( ; x != NULL; x = x->m_left)
+            m_stack[m_depth++] = x;
+    }
+    friend class BasicPersistentStorage;
+};
+
+template <typename KeyType, typename ValueType, typename Allocator>
+inline
+BasicPersistentStorage<KeyType, ValueType, Allocator>::BasicPersistentStorage(const BasicPersistentStorage& other)
+ : m_root(other.m_root)
+{
+    retain(m_root);  // a snapshot:  share every node
+}
+
+template <typename KeyType, typename ValueType, typename Allocator>
+inline
+BasicPersistentStorage<KeyType, ValueType, Allocator>::BasicPersistentStorage(BasicPersistentStorage&& other)
+ : m_root(other.m_root)
+{
+    other.m_root = NULL;
+}
+
+template <typename KeyType, typename ValueType, typename Allocator>
+inline
+BasicPersistentStorage<KeyType, ValueType, Allocator>& BasicPersistentStorage<KeyType, ValueType, Allocator>::operator=(const BasicPersistentStorage& rhs)
+{
+    BasicPersistentStorage temp(rhs);  // safe even if rhs is this map
+    swap(temp);
+    return *this;
+}
+
+template <typename KeyType, typename ValueType, typename Allocator>
+inline
+BasicPersistentStorage<KeyType, ValueType, Allocator>& BasicPersistentStorage<KeyType, ValueType, Allocator>::operator=(BasicPersistentStorage&& rhs)
+{
+    swap(rhs);
+    return *this;
+}
+
+template <typename KeyType, typename ValueType, typename Allocator>
+ValueType* BasicPersistentStorage<KeyType, ValueType, Allocator>::find(const KeyType& key)
+{
+      // The caller may change the value, so the path to it must be owned.
+      // Search first, so a miss copies nothing.
+
+    if (findNode(m_root, key) == NULL)
+        return NULL;
+    Node** link = &m_root;
+    for (;;)
+    {
+        own(*link);
+        Node* x = *link;
+        if (key < x->m_key)
+            link = &x->m_left;
+        else if (x->m_key < key)
+            link = &x->m_right;
+        else
+            return &x->m_value;
+    }
+}
+
+template <typename KeyType, typename ValueType, typename Allocator>
+inline
+const ValueType* BasicPersistentStorage<KeyType, ValueType, Allocator>::find(const KeyType& key) const
+{
+    const Node* x = findNode(m_root, key);
+    return x == NULL ? NULL : &x->m_value;
+}
+
+template <typename KeyType, typename ValueType, typename Allocator>
+template <typename K, typename... Args>
+inline
+void BasicPersistentStorage<KeyType, ValueType, Allocator>::emplace(K&& key, Args&&... args)
+{
+    insertAt(m_root, std::forward<K>(key), std::forward<Args>(args)...);
+}
+
+template <typename KeyType, typename ValueType, typename Allocator>
+bool BasicPersistentStorage<KeyType, ValueType, Allocator>::erase(const KeyType& key)
+{
+    if (findNode(m_root, key) == NULL)  // not found; copy nothing
+        return false;
+    eraseAt(m_root, key);
+    return true;
+}
+
+template <typename KeyType, typename ValueType, typename Allocator>
+void BasicPersistentStorage<KeyType, ValueType, Allocator>::get(int i, KeyType& key, ValueType& value) const
+{
+      // Walk down, using the sizes of the left subtrees to decide which
+      // way the ith key lies
+
+    const Node* x = m_root;
+    for (;;)
+    {
+        int nLeft = count(x->m_left);
+        if (i < nLeft)
+            x = x->m_left;
+        else if (i == nLeft)
+            break;
+        else
+        {
+            i -= nLeft + 1;
+            x = x->m_right;
+        }
+    }
+    key = x->m_key;
+    value = x->m_value;
+}
+
+template <typename KeyType, typename ValueType, typename Allocator>
+inline
+typename BasicPersistentStorage<KeyType, ValueType, Allocator>::const_iterator BasicPersistentStorage<KeyType, ValueType, Allocator>::begin() const
+{
+    return const_iterator(m_root);
+}
+
+template <typename KeyType, typename ValueType, typename Allocator>
+inline
+typename BasicPersistentStorage<KeyType, ValueType, Allocator>::const_iterator BasicPersistentStorage<KeyType, ValueType, Allocator>::end() const
+{
+    return const_iterator();
+}
+
+template <typename KeyType, typename ValueType, typename Allocator>
+void BasicPersistentStorage<KeyType, ValueType, Allocator>::release(Node* x)
+{
+    if (x != NULL  &&  x->m_refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        release(x->m_left);
+        release(x->m_right);
+        deleteNode(x);
+    }
+}
+
+template <typename KeyType, typename ValueType, typename Allocator>
+inline
+void BasicPersistentStorage<KeyType, ValueType, Allocator>::own(Node*& x)
+{
+      // The acquire pairs with the release in another map's release(), so
+      // if that map has just let go of x, its reads of x are done before
+      // this map changes it
+    if (x != NULL  &&  x->m_refs.load(std::memory_order_acquire) != 1)
+    {
+        Node* copy = newNode(static_cast<const Node&>(*x));
+        release(x);
+        x = copy;
+    }
+}
+
+template <typename KeyType, typename ValueType, typename Allocator>
+inline
+const typename BasicPersistentStorage<KeyType, ValueType, Allocator>::Node* BasicPersistentStorage<KeyType, ValueType, Allocator>::findNode(const Node* x, const KeyType& key)
+{
+    while (x != NULL)
+    {
+        if (key < x->m_key)
+            x = x->m_left;
+        else if (x->m_key < key)
+            x = x->m_right;
+        else
+            break;
+    }
+    return x;
+}
+
+template <typename KeyType, typename ValueType, typename Allocator>
+void BasicPersistentStorage<KeyType, ValueType, Allocator>::rotateLeft(Node*& x)
+{
+      // x's right child y takes x's place, and x becomes y's left child.
+      // Both change, so both must be owned.
+
+    own(x);
+    own(x->m_right);
+    Node* y = x->m_right;
+    x->m_right = y->m_left;
+    y->m_left = x;
+    fix(x);
+    fix(y);
+    x = y;
+}
+
+template <typename KeyType, typename ValueType, typename Allocator>
+void BasicPersistentStorage<KeyType, ValueType, Allocator>::rotateRight(Node*& x)
+{
+    own(x);
+    own(x->m_left);
+    Node* y = x->m_left;
+    x->m_left = y->m_right;
+    y->m_right = x;
+    fix(x);
+    fix(y);
+    x = y;
+}
+
+template <typename KeyType, typename ValueType, typename Allocator>
+void BasicPersistentStorage<KeyType, ValueType, Allocator>::rebalance(Node*& x)
+{
+    fix(x);
+    int balance = height(x->m_left) - height(x->m_right);
+    if (balance > 1)
+    {
+        if (height(x->m_left->m_left) < height(x->m_left->m_right))
+            rotateLeft(x->m_left);  // left-right case
+        rotateRight(x);
+    }
+    else if (balance < -1)
+    {
+        if (height(x->m_right->m_right) < height(x->m_right->m_left))
+            rotateRight(x->m_right);  // right-left case
+        rotateLeft(x);
+    }
+}
+
+template <typename KeyType, typename ValueType, typename Allocator>
+template <typename K, typename... Args>
+void BasicPersistentStorage<KeyType, ValueType, Allocator>::insertAt(Node*& x, K&& key, Args&&... args)
+{
+    if (x == NULL)
+    {
+        x = newNode(std::forward<K>(key), std::forward<Args>(args)...);
+        return;
+    }
+
+      // If building the node throws, the nodes copied on the way down hold
+      // what the originals did, so the tree is unchanged
+
+    own(x);
+    if (key < x->m_key)
+        insertAt(x->m_left, std::forward<K>(key), std::forward<Args>(args)...);
+    else
+        insertAt(x->m_right, std::forward<K>(key), std::forward<Args>(args)...);
+    rebalance(x);
+}
+
+template <typename KeyType, typename ValueType, typename Allocator>
+void BasicPersistentStorage<KeyType, ValueType, Allocator>::eraseAt(Node*& x, const KeyType& key)
+{
+    own(x);
+    if (key < x->m_key)
+        eraseAt(x->m_left, key);
+    else if (x->m_key < key)
+        eraseAt(x->m_right, key);
+    else
+    {
+          // With at most one child, the child (which may be shared, and is
+          // balanced already) takes x's place.  Otherwise x's successor is
+          // unlinked from the right subtree and takes x's children.  Either
+          // way x's pointers to its children are handed over, not dropped.
+
+        Node* gone = x;
+        bool twoChildren = (x->m_left != NULL  &&  x->m_right != NULL);
+        if (x->m_left == NULL)
+            x = x->m_right;
+        else if (x->m_right == NULL)
+            x = x->m_left;
+        else
+        {
+            Node* successor = removeMin(x->m_right);
+            successor->m_left = x->m_left;
+            successor->m_right = x->m_right;
+            x = successor;
+        }
+        gone->m_left = NULL;
+        gone->m_right = NULL;
+        release(gone);
+        if (!twoChildren)
+            return;
+    }
+    rebalance(x);
+}
+
+template <typename KeyType, typename ValueType, typename Allocator>
+typename BasicPersistentStorage<KeyType, ValueType, Allocator>::Node* BasicPersistentStorage<KeyType, ValueType, Allocator>::removeMin(Node*& x)
+{
+    own(x);
+    if (x->m_left == NULL)
+    {
+        Node* min = x;
+        x = x->m_right;  // hand over min's pointer to its right child
+        min->m_right = NULL;
+        return min;
+    }
+    Node* min = removeMin(x->m_left);
+    rebalance(x);
+    return min;
+}
+
+template <typename KeyType, typename ValueType, typename Allocator>
+bool BasicPersistentStorage<KeyType, ValueType, Allocator>::combine(const BasicPersistentStorage& m1, const BasicPersistentStorage& m2,
+                                                                    BasicPersistentStorage& result)
+{
+      // Start from a snapshot of the bigger map and look up each pair of
+      // the smaller one.  Take the snapshots first, in case result is m1
+      // or m2.
+
+    BasicPersistentStorage bigger(m1.size() >= m2.size() ? m1 : m2);
+    BasicPersistentStorage smaller(m1.size() >= m2.size() ? m2 : m1);
+
+    bool status = true;
+    for (const_iterator p = smaller.begin(); p != smaller.end(); ++p)
+    {
+        const ValueType* vbig = static_cast<const BasicPersistentStorage&>(bigger).find(p->first);
+        if (vbig == NULL)               // key in smaller doesn't appear in bigger
+            bigger.emplace(p->first, p->second);
+        else if (*vbig != p->second)    // same key, different value
+        {
+            bigger.erase(p->first);
+            status = false;
+        }
+    }
+    result.swap(bigger);
+    return status;
+}
+
+template <typename KeyType, typename ValueType, typename Allocator>
+void BasicPersistentStorage<KeyType, ValueType, Allocator>::subtract(const BasicPersistentStorage& m1, const BasicPersistentStorage& m2,
+                                                                     BasicPersistentStorage& result)
+{
+      // Erase m2's keys from a snapshot of m1, or if m1 is the smaller,
+      // build the result from the pairs of m1 that m2 lacks
+
+    BasicPersistentStorage a(m1);
+    BasicPersistentStorage b(m2);
+    BasicPersistentStorage res;
+    if (a.size() <= b.size())
+    {
+        for (const_iterator p = a.begin(); p != a.end(); ++p)
+        {
+            if (static_cast<const BasicPersistentStorage&>(b).find(p->first) == NULL)
+                res.emplace(p->first, p->second);
+        }
+    }
+    else
+    {
+        res.swap(a);
+        for (const_iterator p = b.begin(); p != b.end(); ++p)
+            res.erase(p->first);
+    }
+    result.swap(res);
+}
+
+//========================================================================
+// CowStorage:  another storage whose copies share it until one of them
+// changes.  Keys need whatever the other storage needs, and get(i, ...)
+// and iteration visit the pairs in its order.
+//
+// Copying a map just counts one more map sharing the pairs, so passing
+// maps around by value or assigning them costs constant time.  The first
+// change to a map that shares its pairs (insert, update, erase, and so on)
+// copies them all, and later changes to that map are made in place.
+// Lookups never copy, and neither do changes that turn out to do nothing,
+// such as erasing a key that isn't there.  Maps sharing pairs may be used
+// in different threads at once; the count of sharers is atomic.  Unlike
+// PersistentStorage, which copies only a path, a change after a copy costs
+// time proportional to the size of the map, so this suits maps that are
+// copied often and changed rarely.
+//
+// The pairs may be shared, so values can't be changed through an
+// iterator; both iterator types are the other storage's const_iterator.
+//========================================================================
+
+template <typename KeyType, typename ValueType,
+          template <typename, typename> class Storage>
+class BasicCowStorage
+{
+  public:
+    BasicCowStorage() : m_shared(NULL) {}
+    ~BasicCowStorage() { release(m_shared); }
+    BasicCowStorage(const BasicCowStorage& other) : m_shared(other.m_shared) { retain(m_shared); }
+    BasicCowStorage(BasicCowStorage&& other) : m_shared(other.m_shared) { other.m_shared = NULL; }
+    BasicCowStorage& operator=(const BasicCowStorage& rhs);
+    BasicCowStorage& operator=(BasicCowStorage&& rhs);
+
+    int size() const { return pairs().size(); }
+    ValueType* find(const KeyType& key);
+    const ValueType* find(const KeyType& key) const { return pairs().find(key); }
+    template <typename K, typename... Args>
+    void emplace(K&& key, Args&&... args)
+    {
+        own().emplace(std::forward<K>(key), std::forward<Args>(args)...);
+    }
+    bool erase(const KeyType& key);
+    void get(int i, KeyType& key, ValueType& value) const { pairs().get(i, key, value); }
+    void swap(BasicCowStorage& other) { std::swap(m_shared, other.m_shared); }
+
+    typedef typename Storage<KeyType, ValueType>::const_iterator const_iterator;
+    typedef const_iterator iterator;
+    const_iterator begin() const { return pairs().begin(); }
+    const_iterator end() const { return pairs().end(); }
+
+      // These hand the work to the other storage, except that when one map
+      // is empty (or both share the same pairs), the result just shares
+      // the pairs of the answer.
+    static bool combine(const BasicCowStorage& m1, const BasicCowStorage& m2,
+                        BasicCowStorage& result)
+    {
+        return combineParallel(m1, m2, result, 1);
+    }
+    static void subtract(const BasicCowStorage& m1, const BasicCowStorage& m2,
+                         BasicCowStorage& result)
+    {
+        subtractParallel(m1, m2, result, 1);
+    }
+    static bool combineParallel(const BasicCowStorage& m1, const BasicCowStorage& m2,
+                                BasicCowStorage& result, int nThreads);
+    static void subtractParallel(const BasicCowStorage& m1, const BasicCowStorage& m2,
+                                 BasicCowStorage& result, int nThreads);
+
+  private:
+      // Representation:
+      //   m_shared points to the pairs and the number of maps sharing them,
+      //   or is NULL if the map is empty.  Pairs whose m_refs is 1 belong
+      //   to this map alone and may be changed; any others are never
+      //   changed, and own() gives the map a copy of them first.
+
+    struct Shared
+    {
+        Storage<KeyType, ValueType> m_pairs;
+        std::atomic<int>            m_refs;
+
+        Shared() : m_refs(1) {}
+        Shared(const Storage<KeyType, ValueType>& pairs) : m_pairs(pairs), m_refs(1) {}
+    };
+
+    Shared* m_shared;
+
+    static void retain(Shared* p)
+    {
+        if (p != NULL)
+            p->m_refs.fetch_add(1, std::memory_order_relaxed);
+    }
+    static void release(Shared* p)
+    {
+          // The last map to let go deletes the pairs, after every change
+          // the others made to them is visible
+        if (p != NULL  &&  p->m_refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            delete p;
+    }
+    const Storage<KeyType, ValueType>& pairs() const
+    {
+        static const Storage<KeyType, ValueType> none;
+        return m_shared == NULL ? none : m_shared->m_pairs;
+    }
+    Storage<KeyType, ValueType>& own();
+      // Return the pairs, first copying them if another map shares them
+};
+
+template <typename KeyType, typename ValueType>
+using CowHashStorage = BasicCowStorage<KeyType, ValueType, HashStorage>;
+template <typename KeyType, typename ValueType>
+using CowBTreeStorage = BasicCowStorage<KeyType, ValueType, BTreeStorage>;
+
+template <typename KeyType, typename ValueType,
+          template <typename, typename> class Storage>
+inline
+BasicCowStorage<KeyType, ValueType, Storage>& BasicCowStorage<KeyType, ValueType, Storage>::operator=(const BasicCowStorage& rhs)
+{
+    retain(rhs.m_shared);  // before the release, in case this is rhs
+    release(m_shared);
+    m_shared = rhs.m_shared;
+    return *this;
+}
+
+template <typename KeyType, typename ValueType,
+          template <typename, typename> class Storage>
+inline
+BasicCowStorage<KeyType, ValueType, Storage>& BasicCowStorage<KeyType, ValueType, Storage>::operator=(BasicCowStorage&& rhs)
+{
+    swap(rhs);
+    return *this;
+}
+
+template <typename KeyType, typename ValueType,
+          template <typename, typename> class Storage>
+Storage<KeyType, ValueType>& BasicCowStorage<KeyType, ValueType, Storage>::own()
+{
+      // The acquire load makes the changes of a map that just let go of
+      // the pairs visible before this one changes them in place
+
+    if (m_shared == NULL)
+        m_shared = new Shared;
+    else if (m_shared->m_refs.load(std::memory_order_acquire) != 1)
+    {
+        Shared* copy = new Shared(m_shared->m_pairs);
+        release(m_shared);
+        m_shared = copy;
+    }
+    return m_shared->m_pairs;
+}
+
+template <typename KeyType, typename ValueType,
+          template <typename, typename> class Storage>
+inline
+ValueType* BasicCowStorage<KeyType, ValueType, Storage>::find(const KeyType& key)
+{
+      // The caller may change the value, so the pairs must be owned.
+      // Search first, so a miss copies nothing.
+
+    if (pairs().find(key) == NULL)
+        return NULL;
+    return own().find(key);
+}
+
+template <typename KeyType, typename ValueType,
+          template <typename, typename> class Storage>
+inline
+bool BasicCowStorage<KeyType, ValueType, Storage>::erase(const KeyType& key)
+{
+    if (pairs().find(key) == NULL)  // not found; copy nothing
+        return false;
+    return own().erase(key);
+}
+
+template <typename KeyType, typename ValueType,
+          template <typename, typename> class Storage>
+bool BasicCowStorage<KeyType, ValueType, Storage>::combineParallel(const BasicCowStorage& m1, const BasicCowStorage& m2,
+                                                                   BasicCowStorage& result, int nThreads)
+{
+      // result is empty and is neither m1 nor m2
+
+    if (m2.size() == 0  ||  m1.m_shared == m2.m_shared)
+        result = m1;
+    else if (m1.size() == 0)
+        result = m2;
+    else
+        return Storage<KeyType, ValueType>::combineParallel(m1.pairs(), m2.pairs(), result.own(), nThreads);
+    return true;
+}
+
+template <typename KeyType, typename ValueType,
+          template <typename, typename> class Storage>
+void BasicCowStorage<KeyType, ValueType, Storage>::subtractParallel(const BasicCowStorage& m1, const BasicCowStorage& m2,
+                                                                    BasicCowStorage& result, int nThreads)
+{
+    if (m1.m_shared == m2.m_shared  ||  m1.size() == 0)
+        return;  // nothing is left
+    if (m2.size() == 0)
+        result = m1;
+    else
+        Storage<KeyType, ValueType>::subtractParallel(m1.pairs(), m2.pairs(), result.own(), nThreads);
+}
+
+//========================================================================
+// Map
+//========================================================================
+
+  // The third template parameter chooses how the pairs are stored:
+  //   ListStorage   a linked list; keys need only operator!=.  Every lookup
+  //                 is a linear search, but get(i, ...) takes constant
+  //                 time.  (The default.)
+  //   HashStorage   a hash table; keys need std::hash and operator==.
+  //                 Lookups take constant expected time.
+  //   BTreeStorage  a B-tree ordered by operator<.  Lookups take
+  //                 logarithmic time, and get(i, ...) visits the keys in
+  //                 increasing order.
+  //   PersistentStorage
+  //                 a balanced binary tree ordered by operator<, whose
+  //                 nodes copies of the map share.  Lookups and changes
+  //                 take logarithmic time, copying takes constant time, and
+  //                 get(i, ...) visits the keys in increasing order.
+  //   CowHashStorage, CowBTreeStorage
+  //                 a hash table or B-tree that copies of the map share
+  //                 until one of them changes.  Copying takes constant
+  //                 time, and the first change after a copy copies every
+  //                 pair.  (BasicCowStorage makes any storage work this
+  //                 way.)
+  // The public interface is the same whichever storage is chosen.
+
+template <typename KeyType, typename ValueType,
+          template <typename, typename> class Storage = ListStorage>
+class Map
+{
+  public:
+    Map();               // Create an empty map.
+
+    bool empty() const;  // Return true if the map is empty, otherwise false.
+
+    int size() const;    // Return the number of key/value pairs in the map.
+
+    bool insert(const KeyType& key, const ValueType& value);
+    bool insert(KeyType&& key, ValueType&& value);
+      // If key is not equal to any key currently in the map, and if the
+      // key/value pair can be added to the map, then do so and return true.
+      // Otherwise, make no change to the map and return false (indicating
+      // that either the key is already in the map, or the map has a fixed
+      // capacity and is full.  (The second form moves the key and value
+      // into the map instead of copying them.)
+
+    template <typename... Args>
+    bool emplace(const KeyType& key, Args&&... args);
+    template <typename... Args>
+    bool emplace(KeyType&& key, Args&&... args);
+      // The same as insert, except that the value is constructed in the
+      // map from args, so it is never copied or moved.  If the key is
+      // already in the map, args are left untouched.
+
+    bool update(const KeyType& key, const ValueType& value);
+    bool update(const KeyType& key, ValueType&& value);
+      // If key is equal to a key currently in the map, then make that key no
+      // longer map to the value it currently maps to, but instead map to
+      // the value of the second parameter; return true in this case.
+      // Otherwise, make no change to the map and return false.
+
+    bool insertOrUpdate(const KeyType& key, const ValueType& value);
+    bool insertOrUpdate(KeyType&& key, ValueType&& value);
+      // If key is equal to a key currently in the map, then make that key no
+      // longer map to the value it currently maps to, but instead map to
+      // the value of the second parameter; return true in this case.
+      // If key is not equal to any key currently in the map, and if the
+      // key/value pair can be added to the map, then do so and return true.
+      // Otherwise, make no change to the map and return false (indicating
+      // that the key is not already in the map and the map has a fixed
+      // capacity and is full.
+
+    bool erase(const KeyType& key);
+      // If key is equal to a key currently in the map, remove the key/value
+      // pair with that key from the map and return true.  Otherwise, make
+      // no change to the map and return false.
+     
+    bool contains(const KeyType& key) const;
+      // Return true if key is equal to a key currently in the map, otherwise
+      // false.
+     
+    bool get(const KeyType& key, ValueType& value) const;
+      // If key is equal to a key currently in the map, set value to the
+      // value in the map that that key maps to and return true.  Otherwise,
+      // make no change to the value parameter of this function and return
+      // false.
+     
+    bool get(int i, KeyType& key, ValueType& value) const;
+      // If 0 <= i < size(), copy into the key and value parameters the
+      // key and value of one of the key/value pairs in the map and return
+      // true.  Otherwise, leave the key and value parameters unchanged and
+      // return false.
+
+    void swap(Map& other);
+      // Exchange the contents of this map with the other one.
+
+    typedef typename Storage<KeyType, ValueType>::iterator       iterator;
+    typedef typename Storage<KeyType, ValueType>::const_iterator const_iterator;
+    iterator begin();
+    iterator end();
+    const_iterator begin() const;
+    const_iterator end() const;
+      // Iterators visit each pair once, in the order get(i, ...) does for
+      // i = 0, 1, 2, ...  *it is a MapEntry whose first member is a
+      // reference to the key and whose second is a reference to the value,
+      // which can be changed through an iterator but not a const_iterator:
+      //     for (auto e : m)
+      //         e.second += 1;
+      // Inserting or erasing a pair invalidates every iterator (and with
+      // PersistentStorage or a CowStorage, so does updating one).  How
+      // strong an iterator is depends on the storage:  random access for
+      // HashStorage, bidirectional for ListStorage, and forward (in
+      // increasing order of key) for BTreeStorage and PersistentStorage; a
+      // CowStorage's are those of the storage it wraps.  The values of
+      // PersistentStorage and the CowStorages may be shared with copies of
+      // the map, so their iterators can't change them; use update.
+
+      // Housekeeping functions (copying, moving, assignment and destruction
+      // are done by the storage; a map that has been moved from is usable,
+      // empty after a move construction and holding the target's old pairs
+      // after a move assignment, which swaps)
+
+  private:
+    Storage<KeyType, ValueType> m_storage;
+
+      // combine and subtract hand the work to the storage
+    template <typename K, typename V, template <typename, typename> class S>
+    friend bool combineParallel(const Map<K, V, S>& m1, const Map<K, V, S>& m2,
+                                Map<K, V, S>& result, int nThreads);
+    template <typename K, typename V, template <typename, typename> class S>
+    friend void subtractParallel(const Map<K, V, S>& m1, const Map<K, V, S>& m2,
+                                 Map<K, V, S>& result, int nThreads);
+
+    template <typename K, typename V>
+    bool doInsertOrUpdate(K&& key, V&& value, bool mayInsert, bool mayUpdate);
+      // If the key is not present in the map and if mayInsert is true, insert
+      // the pair if there is room.  If the key is present and mayUpdate is
+      // true, update the pair with the given key.
+};
+
+// Declarations of non-member functions
+template <typename KeyType, typename ValueType,
+          template <typename, typename> class Storage>
+bool combine(const Map<KeyType, ValueType, Storage>& m1,
+			 const Map<KeyType, ValueType, Storage>& m2,
+			 Map<KeyType, ValueType, Storage>& result); 
+      // If a key/value pair occurs in m1 or m2 or both, then it will occur in
+      // result upon return from this function.  Return true unless m1 and m2
+      // have a pair with the same key but different values; neither such pair
+      // will occur in result upon return.
+
+template <typename KeyType, typename ValueType,
+          template <typename, typename> class Storage>
+void subtract(const Map<KeyType, ValueType, Storage>& m1,
+			  const Map<KeyType, ValueType, Storage>& m2,
+			  Map<KeyType, ValueType, Storage>& result); 
+      // Upon return, result contains those pairs in m1 whose keys don't
+      // appear in m2.
+
+template <typename KeyType, typename ValueType,
+          template <typename, typename> class Storage>
+bool combineParallel(const Map<KeyType, ValueType, Storage>& m1,
+                     const Map<KeyType, ValueType, Storage>& m2,
+                     Map<KeyType, ValueType, Storage>& result,
+                     int nThreads = std::thread::hardware_concurrency());
+template <typename KeyType, typename ValueType,
+          template <typename, typename> class Storage>
+void subtractParallel(const Map<KeyType, ValueType, Storage>& m1,
+                      const Map<KeyType, ValueType, Storage>& m2,
+                      Map<KeyType, ValueType, Storage>& result,
+                      int nThreads = std::thread::hardware_concurrency());
+      // The same as combine and subtract, but using up to nThreads threads.
+      // With HashStorage or BTreeStorage, combine and subtract take time
+      // proportional to m1.size() + m2.size(); with ListStorage, to
+      // m1.size() * m2.size(), and the parallel versions use one thread.
+
+// implementations
+
+template <typename KeyType, typename ValueType,
+          template <typename, typename> class Storage>
+inline
+Map<KeyType, ValueType, Storage>::Map()
+{
+}
+
+template <typename KeyType, typename ValueType,
+          template <typename, typename> class Storage>
+inline
+int Map<KeyType, ValueType, Storage>::size() const
+{
+    return m_storage.size();
+}
+
+template <typename KeyType, typename ValueType,
+          template <typename, typename> class Storage>
+inline
+bool Map<KeyType, ValueType, Storage>::empty() const
+{
+    return size() == 0;
+}
+
+template <typename KeyType, typename ValueType,
+          template <typename, typename> class Storage>
+inline
+bool Map<KeyType, ValueType, Storage>::contains(const KeyType& key) const
+{
+    return m_storage.find(key) != NULL;
+}
+
+template <typename KeyType, typename ValueType,
+          template <typename, typename> class Storage>
+inline
+bool Map<KeyType, ValueType, Storage>::insert(const KeyType& key, const ValueType& value)
+{
+    return doInsertOrUpdate(key, value, true /* insert */, false /* no update */);
+}
+
+template <typename KeyType, typename ValueType,
+          template <typename, typename> class Storage>
+inline
+bool Map<KeyType, ValueType, Storage>::insert(KeyType&& key, ValueType&& value)
+{
+    return doInsertOrUpdate(std::move(key), std::move(value), true /* insert */, false /* no update */);
+}
+
+template <typename KeyType, typename ValueType,
+          template <typename, typename> class Storage>
+template <typename... Args>
+bool Map<KeyType, ValueType, Storage>::emplace(const KeyType& key, Args&&... args)
+{
+    if (contains(key))  // found; the const search copies no shared pairs
+        return false;
+    m_storage.emplace(key, std::forward<Args>(args)...);
+    return true;
+}
+
+template <typename KeyType, typename ValueType,
+          template <typename, typename> class Storage>
+template <typename... Args>
+bool Map<KeyType, ValueType, Storage>::emplace(KeyType&& key, Args&&... args)
+{
+    if (contains(key))  // found; the const search copies no shared pairs
+        return false;
+    m_storage.emplace(std::move(key), std::forward<Args>(args)...);
+    return true;
+}
+
+template <typename KeyType, typename ValueType,
+          template <typename, typename> class Storage>
+inline
+bool Map<KeyType, ValueType, Storage>::update(const KeyType& key, const ValueType& value)
+{
+    return doInsertOrUpdate(key, value, false /* no insert */, true /* update */);
+}
+
+template <typename KeyType, typename ValueType,
+          template <typename, typename> class Storage>
+inline
+bool Map<KeyType, ValueType, Storage>::update(const KeyType& key, ValueType&& value)
+{
+    return doInsertOrUpdate(key, std::move(value), false /* no insert */, true /* update */);
+}
+
+template <typename KeyType, typename ValueType,
+          template <typename, typename> class Storage>
+inline
+bool Map<KeyType, ValueType, Storage>::insertOrUpdate(const KeyType& key, const ValueType& value)
+{
+    return doInsertOrUpdate(key, value, true /* insert */, true /* update */);
+}
+
+template <typename KeyType, typename ValueType,
+          template <typename, typename> class Storage>
+inline
+bool Map<KeyType, ValueType, Storage>::insertOrUpdate(KeyType&& key, ValueType&& value)
+{
+    return doInsertOrUpdate(std::move(key), std::move(value), true /* insert */, true /* update */);
+}
+
+template <typename KeyType, typename ValueType,
+          template <typename, typename> class Storage>
+inline
+bool Map<KeyType, ValueType, Storage>::erase(const KeyType& key)
+{
+    return m_storage.erase(key);
+}
+
+template <typename KeyType, typename ValueType,
+          template <typename, typename> class Storage>
+bool Map<KeyType, ValueType, Storage>::get(const KeyType& key, ValueType& value) const
+{
+    const ValueType* p = m_storage.find(key);
+    if (p == NULL)  // not found
+        return false;
+    value = *p;
+    return true;
+}
+
+template <typename KeyType, typename ValueType,
+          template <typename, typename> class Storage>
+inline
+bool Map<KeyType, ValueType, Storage>::get(int i, KeyType& key, ValueType& value) const
+{
+    if (i < 0  ||  i >= size())
+        return false;
+    m_storage.get(i, key, value);
+    return true;
+}
+
+template <typename KeyType, typename ValueType,
+          template <typename, typename> class Storage>
+inline
+void Map<KeyType, ValueType, Storage>::swap(Map& other)
+{
+    m_storage.swap(other.m_storage);
+}
+
+template <typename KeyType, typename ValueType,
+          template <typename, typename> class Storage>
+inline
+typename Map<KeyType, ValueType, Storage>::iterator Map<KeyType, ValueType, Storage>::begin()
+{
+    return m_storage.begin();
+}
+
+template <typename KeyType, typename ValueType,
+          template <typename, typename> class Storage>
+inline
+typename Map<KeyType, ValueType, Storage>::iterator Map<KeyType, ValueType, Storage>::end()
+{
+    return m_storage.end();
+}
+
+template <typename KeyType, typename ValueType,
+          template <typename, typename> class Storage>
+inline
+typename Map<KeyType, ValueType, Storage>::const_iterator Map<KeyType, ValueType, Storage>::begin() const
+{
+    return m_storage.begin();
+}
+
+template <typename KeyType, typename ValueType,
+          template <typename, typename> class Storage>
+inline
+typename Map<KeyType, ValueType, Storage>::const_iterator Map<KeyType, ValueType, Storage>::end() const
+{
+    return m_storage.end();
+}
+
+template <typename KeyType, typename ValueType,
+          template <typename, typename> class Storage>
+template <typename K, typename V>
+bool Map<KeyType, ValueType, Storage>::doInsertOrUpdate(K&& key, V&& value,
+                           bool mayInsert, bool mayUpdate)
+{
+      // K and V are KeyType and ValueType, each either a const lvalue
+      // reference (copy it in) or an rvalue (move it in)
+
+      // Only search for a value to change when it may be changed:  for
+      // storage shared with other maps, the non-const find copies what it
+      // shares, which a failed insert mustn't do.
+
+    if (mayUpdate)
+    {
+        ValueType* p = m_storage.find(key);
+        if (p != NULL)  // found
+        {
+            *p = std::forward<V>(value);
+            return true;
         }
-        result.swap(res);
     }
+    else if (contains(key))  // found, and not allowed to update
+        return false;
+    if (!mayInsert)  // not found, and not allowed to insert
+        return false;
+
+    m_storage.emplace(std::forward<K>(key), std::forward<V>(value));
+    return true;
+}
+
+template <typename KeyType, typename ValueType,
+          template <typename, typename> class Storage>
+inline
+bool combine(const Map<KeyType, ValueType, Storage>& m1,
+			 const Map<KeyType, ValueType, Storage>& m2,
+			 Map<KeyType, ValueType, Storage>& result)
+{
+    return combineParallel(m1, m2, result, 1);
+}
+
+template <typename KeyType, typename ValueType,
+          template <typename, typename> class Storage>
+inline
+void subtract(const Map<KeyType, ValueType, Storage>& m1,
+			  const Map<KeyType, ValueType, Storage>& m2,
+			  Map<KeyType, ValueType, Storage>& result)
+{
+    subtractParallel(m1, m2, result, 1);
+}
+
+template <typename KeyType, typename ValueType,
+          template <typename, typename> class Storage>
+bool combineParallel(const Map<KeyType, ValueType, Storage>& m1,
+                     const Map<KeyType, ValueType, Storage>& m2,
+                     Map<KeyType, ValueType, Storage>& result,
+                     int nThreads)
+{
+      // Guard against the case that result is an alias for m1 or m2
+      // (i.e., that result is a reference to the same map that m1 or m2
+      // refers to) by building the answer in a local variable res.  When
+      // done, swap res with result; the old value of result (now in res) will
+      // be destroyed when res is destroyed.
+
+    Map<KeyType, ValueType, Storage> res;
+    bool status = Storage<KeyType, ValueType>::combineParallel(m1.m_storage, m2.m_storage,
+                                                               res.m_storage, nThreads);
+    result.swap(res);
+    return status;
+}
+
+template <typename KeyType, typename ValueType,
+          template <typename, typename> class Storage>
+void subtractParallel(const Map<KeyType, ValueType, Storage>& m1,
+                      const Map<KeyType, ValueType, Storage>& m2,
+                      Map<KeyType, ValueType, Storage>& result,
+                      int nThreads)
+{
+      // As in combineParallel, build the answer in res in case result is
+      // an alias for m1 or m2
+
+    Map<KeyType, ValueType, Storage> res;
+    Storage<KeyType, ValueType>::subtractParallel(m1.m_storage, m2.m_storage,
+                                                  res.m_storage, nThreads);
+    result.swap(res);
 }
 
 #endif // MAP_INCLUDED
\ No newline at end of file
@@ -0,0 +1,184 @@
+#ifndef _MAPPEDFILE_H_
+#define _MAPPEDFILE_H_
+
+// The service this header provides:
+//
+//  MappedFile f;
+//  f.open(path)
+//    Map the whole file read-only into memory and return true, or return
+//    false if the file can't be opened or is empty.  f.data() then points
+//    at the first byte of the file and f.size() is its length; the pages
+//    are only read from disk when they are first touched.  The mapping is
+//    released by f.close() or when f is destroyed.
+//
+//  f.swap(other)
+//    Exchange the mappings held by f and other.
+//
+//  MappedFile::replace(from, to)
+//    Move the file at from over the file at to in one step and return
+//    true, or return false, leaving both as they were, if that can't be
+//    done.  Write a new version of a file that may be mapped to a
+//    temporary file and replace the old one with it, rather than
+//    truncating and rewriting the old one in place:  a mapping of the old
+//    file keeps its bytes on Mac OS X and Linux, where the replacement
+//    unlinks it, and on Windows the replacement fails while it is mapped.
+
+#ifdef _MSC_VER  // Windows
+
+#include <windows.h>
+
+#else  //  Mac OS X and LINUX
+
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#endif
+
+#include <string>
+#include <cstddef>
+#include <algorithm>
+
+class MappedFile
+{
+public:
+    MappedFile();
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    bool open(const std::string& path);
+    void close();
+    void swap(MappedFile& other);
+    static bool replace(const std::string& from, const std::string& to);
+    const char* data() const { return m_data; }
+    size_t size() const { return m_size; }
+
+private:
+    const char* m_data;
+    size_t      m_size;
+#ifdef _MSC_VER
+    HANDLE      m_file;
+    HANDLE      m_mapping;
+#endif
+};
+
+#ifdef _MSC_VER  // Windows
+
+inline MappedFile::MappedFile()
+ : m_data(NULL), m_size(0), m_file(INVALID_HANDLE_VALUE), m_mapping(NULL)
+{}
+
+inline bool MappedFile::open(const std::string& path)
+{
+    close();
+    m_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                         OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (m_file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(m_file, &fileSize)  ||  fileSize.QuadPart == 0)
+    {
+        close();
+        return false;
+    }
+
+    m_mapping = CreateFileMappingA(m_file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (m_mapping == NULL)
+    {
+        close();
+        return false;
+    }
+
+    m_data = static_cast<const char*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+    if (m_data == NULL)
+    {
+        close();
+        return false;
+    }
+    m_size = size_t(fileSize.QuadPart);
+    return true;
+}
+
+inline void MappedFile::close()
+{
+    if (m_data != NULL)
+        UnmapViewOfFile(m_data);
+    if (m_mapping != NULL)
+        CloseHandle(m_mapping);
+    if (m_file != INVALID_HANDLE_VALUE)
+        CloseHandle(m_file);
+    m_data = NULL;
+    m_size = 0;
+    m_mapping = NULL;
+    m_file = INVALID_HANDLE_VALUE;
+}
+
+inline bool MappedFile::replace(const std::string& from, const std::string& to)
+{
+    return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+}
+
+#else  //  Mac OS X and LINUX
+
+inline MappedFile::MappedFile()
+ : m_data(NULL), m_size(0)
+{}
+
+inline bool MappedFile::open(const std::string& path)
+{
+    close();
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0  ||  info.st_size == 0)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    void* p = mmap(NULL, size_t(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);  // the mapping stays valid after the descriptor is closed
+    if (p == MAP_FAILED)
+        return false;
+
+    m_data = static_cast<const char*>(p);
+    m_size = size_t(info.st_size);
+    return true;
+}
+
+inline void MappedFile::close()
+{
+    if (m_data != NULL)
+        munmap(const_cast<char*>(m_data), m_size);
+    m_data = NULL;
+    m_size = 0;
+}
+
+inline bool MappedFile::replace(const std::string& from, const std::string& to)
+{
+    return rename(from.c_str(), to.c_str()) == 0;
+}
+
+#endif // _MSC_VER
+
+inline void MappedFile::swap(MappedFile& other)
+{
+    std::swap(m_data, other.m_data);
+    std::swap(m_size, other.m_size);
+#ifdef _MSC_VER
+    std::swap(m_file, other.m_file);
+    std::swap(m_mapping, other.m_mapping);
+#endif
+}
+
+inline MappedFile::~MappedFile()
+{
+    close();
+}
+
+#endif // #ifndef _MAPPEDFILE_H_
@@ -0,0 +1,451 @@
+#ifndef MAPPEDMAP_INCLUDED
+#define MAPPEDMAP_INCLUDED
+
+// The services this header provides:
+//
+//  MappedMap<ValueType>::save(path, source)
+//    Write the pairs of source, which is a Map<std::string, ValueType,
+//    Storage> with any storage, a StringMapper<ValueType>, or a
+//    FrozenMap<std::string, ValueType>, to the file at path in the format
+//    below, and return true, or return false if the file can't be written.
+//    The pairs go to a new file that then replaces any old one at path, so
+//    a MappedMap that has the old file open keeps its bytes.
+//    ValueType is std::string or a trivially copyable type such as double.
+//    As with FrozenMap, if a StringMapper holds a key more than once, the
+//    first pair it lists wins.
+//  MappedMap<ValueType> m;
+//  m.open(path)
+//    Map the file read-only and return true, or return false if it isn't a
+//    file written by save for this ValueType, by this version of the
+//    format, on a machine with the same byte order.  Nothing is read or
+//    built:  lookups search the mapped image where it lies, so opening
+//    takes the same time for any size of file, and a search only reads in
+//    the pages it touches.  open checks the header and the length of the
+//    file, not every offset in it, so a file changed by anything but save
+//    may give wrong answers.
+//  m.size(), m.empty(), m.contains(key), m.get(key, value)
+//  m.get(i, key, value)
+//    The same as the Map functions of those names.  get(i, ...) visits the
+//    pairs in no particular order.
+//  m.find(key)
+//    Return a pointer to the value for key in the mapped image, or NULL if
+//    key isn't there.  Only for trivially copyable values; get copies a
+//    string value out.
+//  m.close(), m.swap(other)
+//    Release the mapping (the destructor does too), or exchange it with
+//    other's.  Pointers from find stay good across a swap.
+//
+// The file, in the byte order of the machine that wrote it, is
+//
+//   header       a MappedMapHeader
+//   key index    count+2 MappedMapKeyEntrys, in the Eytzinger order of
+//                FrozenMap (entry 0 is unused).  The key at position k is
+//                the key text from offset index[k].offset up to
+//                index[k+1].offset; index[count+1] only marks the end.
+//                Each entry also holds the key's first 8 bytes, big end
+//                first, so most comparisons never touch the key text.
+//   values       for trivially copyable values, count+1 of them, value k
+//                for key k (value 0 is unused); for string values,
+//                count+2 offsets into the value text laid out like the
+//                key index's.  Padded to a multiple of 8 bytes.
+//   key text     every key, back to back, in position order
+//   value text   every string value the same way (empty for other values)
+
+#include "MappedFile.h"
+#include "FrozenMap.h"
+#include <cstddef>
+#include <cstring>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+#include <type_traits>
+
+struct MappedMapHeader
+{
+    char               magic[4];
+    unsigned           version;
+    unsigned           byteOrder;   // BYTE_ORDER_MARK on the machine that wrote it
+    unsigned           valueSize;   // sizeof(ValueType), or 0 for string values
+    unsigned long long count;       // number of pairs
+    unsigned long long keyBytes;    // length of the key text
+    unsigned long long valueBytes;  // length of the value text
+};
+
+struct MappedMapKeyEntry
+{
+    unsigned long long prefix;  // first 8 bytes of the key, big end first, 0-padded
+    unsigned long long offset;  // where the key starts in the key text
+};
+
+template <typename ValueType>
+class MappedMap
+{
+  public:
+    MappedMap();  // holds no file, so it acts as an empty map
+    MappedMap(const MappedMap&) = delete;
+    MappedMap& operator=(const MappedMap&) = delete;
+
+    template <template <typename, typename> class Storage>
+    static bool save(const std::string& path, const Map<std::string, ValueType, Storage>& source);
+    template <typename Allocator>
+    static bool save(const std::string& path, const StringMapper<ValueType, Allocator>& source);
+    static bool save(const std::string& path, const FrozenMap<std::string, ValueType>& source);
+
+    bool open(const std::string& path);
+    void close();
+    void swap(MappedMap& other);
+
+    bool empty() const { return m_size == 0; }
+    int size() const { return int(m_size); }
+    const ValueType* find(const std::string& key) const;
+    bool contains(const std::string& key) const { return position(key) != 0; }
+    bool get(const std::string& key, ValueType& value) const;
+    bool get(int i, std::string& key, ValueType& value) const;
+
+  private:
+      // Representation:
+      //   m_file holds the mapping, and the other members point into it:
+      //   m_index at the key index, m_values at the values block,
+      //   m_keyText and m_valueText at the texts.  With no file open,
+      //   m_size is 0 and the pointers are NULL.
+
+    static const char     MAGIC[4];
+    static const unsigned VERSION = 1;      // bump whenever the layout changes
+    static const unsigned BYTE_ORDER_MARK = 0x01020304;
+    static const unsigned VALUE_SIZE = std::is_same<ValueType, std::string>::value ? 0 : sizeof(ValueType);
+
+    static_assert(std::is_same<ValueType, std::string>::value  ||
+                  (std::is_trivially_copyable<ValueType>::value  &&  alignof(ValueType) <= 8),
+                  "values must be strings or trivially copyable");
+
+      // The 16 entries four levels below position k start at 16k; they
+      // fill four cache lines, and the first of those is the one fetched
+    static const size_t PREFETCH_STRIDE = 16;
+
+    MappedFile               m_file;
+    const MappedMapKeyEntry* m_index;
+    const char*              m_values;
+    const char*              m_keyText;
+    const char*              m_valueText;
+    size_t                   m_size;
+
+    static unsigned long long prefixOf(const char* key, size_t len);
+    static unsigned long long roundUp(unsigned long long n) { return (n + 7) & ~7ULL; }
+    static unsigned long long valuesBytes(unsigned long long count);
+      // Size of the values block, padding included
+
+    size_t position(const std::string& key) const;
+      // Return the position of key, or 0 if it isn't there
+    bool keyLess(size_t k, unsigned long long prefix, const std::string& key) const;
+      // Return whether the key at position k is less than key, whose
+      // prefix is given
+
+    void readValue(size_t k, std::string& value) const;
+    template <typename T>
+    void readValue(size_t k, T& value) const;
+
+    static void writeValues(std::ostream& out, const std::vector<std::string>& values,
+                            unsigned long long& textBytes);
+    template <typename T>
+    static void writeValues(std::ostream& out, const std::vector<T>& values,
+                            unsigned long long& textBytes);
+      // Write the values block for values[0..count] and set textBytes to
+      // the length of the value text
+    static void writeValueText(std::ostream& out, const std::vector<std::string>& values);
+    template <typename T>
+    static void writeValueText(std::ostream& /* out */, const std::vector<T>& /* values */) {}
+};
+
+template <typename ValueType>
+const char MappedMap<ValueType>::MAGIC[4] = { 'C', 'S', 'M', 'M' };
+template <typename ValueType>
+const unsigned MappedMap<ValueType>::VERSION;
+template <typename ValueType>
+const unsigned MappedMap<ValueType>::BYTE_ORDER_MARK;
+template <typename ValueType>
+const unsigned MappedMap<ValueType>::VALUE_SIZE;
+template <typename ValueType>
+const size_t MappedMap<ValueType>::PREFETCH_STRIDE;
+
+template <typename ValueType>
+MappedMap<ValueType>::MappedMap()
+ : m_index(NULL), m_values(NULL), m_keyText(NULL), m_valueText(NULL), m_size(0)
+{
+}
+
+template <typename ValueType>
+template <template <typename, typename> class Storage>
+bool MappedMap<ValueType>::save(const std::string& path, const Map<std::string, ValueType, Storage>& source)
+{
+    return save(path, FrozenMap<std::string, ValueType>(source));
+}
+
+template <typename ValueType>
+template <typename Allocator>
+bool MappedMap<ValueType>::save(const std::string& path, const StringMapper<ValueType, Allocator>& source)
+{
+    return save(path, FrozenMap<std::string, ValueType>(source));
+}
+
+template <typename ValueType>
+bool MappedMap<ValueType>::save(const std::string& path, const FrozenMap<std::string, ValueType>& source)
+{
+      // The FrozenMap has already sorted the pairs, dropped duplicate keys,
+      // and laid them out in Eytzinger order, so its positions are written
+      // as they are
+
+    size_t count = source.m_size;
+    const std::vector<std::string>& keys = source.m_keys;
+
+    std::vector<MappedMapKeyEntry> index(count + 2);
+    unsigned long long keyBytes = 0;
+    for (size_t k = 1; k <= count; k++)
+    {
+        index[k].prefix = prefixOf(keys[k].data(), keys[k].size());
+        index[k].offset = keyBytes;
+        keyBytes += keys[k].size();
+    }
+    index[count+1].prefix = 0;
+    index[count+1].offset = keyBytes;
+
+      // path may be mapped by a MappedMap, and truncating it would pull the
+      // bytes out from under the mapping; so write a new file and swap it in
+
+    std::string tempPath = path + ".tmp";
+    std::ofstream out(tempPath.c_str(), std::ios::binary | std::ios::trunc);
+    if (!out)
+        return false;
+
+    MappedMapHeader header;
+    memcpy(header.magic, MAGIC, 4);
+    header.version = VERSION;
+    header.byteOrder = BYTE_ORDER_MARK;
+    header.valueSize = VALUE_SIZE;
+    header.count = count;
+    header.keyBytes = keyBytes;
+    header.valueBytes = 0;
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));  // rewritten below
+    out.write(reinterpret_cast<const char*>(index.data()), sizeof(MappedMapKeyEntry) * index.size());
+    writeValues(out, source.m_values, header.valueBytes);
+    for (size_t k = 1; k <= count; k++)
+        out.write(keys[k].data(), keys[k].size());
+    writeValueText(out, source.m_values);
+
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.close();
+    if (!out  ||  !MappedFile::replace(tempPath, path))
+    {
+        std::remove(tempPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+template <typename ValueType>
+bool MappedMap<ValueType>::open(const std::string& path)
+{
+    MappedFile file;
+    if (!file.open(path)  ||  file.size() < sizeof(MappedMapHeader))
+        return false;
+
+    MappedMapHeader header;
+    memcpy(&header, file.data(), sizeof(header));
+    if (memcmp(header.magic, MAGIC, 4) != 0  ||  header.version != VERSION  ||
+        header.byteOrder != BYTE_ORDER_MARK  ||  header.valueSize != VALUE_SIZE)
+        return false;  // not ours, an incompatible version, or other values
+    if (header.count > file.size() / sizeof(MappedMapKeyEntry))
+        return false;  // so the sizes below can't overflow
+
+    unsigned long long indexBytes = sizeof(MappedMapKeyEntry) * (header.count + 2);
+    unsigned long long expectedSize = sizeof(MappedMapHeader) + indexBytes + valuesBytes(header.count) +
+                                      header.keyBytes + header.valueBytes;
+    if (header.keyBytes > file.size()  ||  header.valueBytes > file.size()  ||  file.size() != expectedSize)
+        return false;  // truncated or padded
+
+    const char* p = file.data() + sizeof(MappedMapHeader);
+    const MappedMapKeyEntry* index = reinterpret_cast<const MappedMapKeyEntry*>(p);
+    const unsigned long long* valueOffsets = reinterpret_cast<const unsigned long long*>(p + indexBytes);
+    if (index[header.count+1].offset != header.keyBytes  ||
+        (VALUE_SIZE == 0  &&  valueOffsets[header.count+1] != header.valueBytes))
+        return false;
+
+    close();
+    m_index = index;
+    m_values = p + indexBytes;
+    m_keyText = m_values + valuesBytes(header.count);
+    m_valueText = m_keyText + header.keyBytes;
+    m_size = size_t(header.count);
+    m_file.swap(file);
+    return true;
+}
+
+template <typename ValueType>
+void MappedMap<ValueType>::close()
+{
+    m_file.close();
+    m_index = NULL;
+    m_values = NULL;
+    m_keyText = NULL;
+    m_valueText = NULL;
+    m_size = 0;
+}
+
+template <typename ValueType>
+void MappedMap<ValueType>::swap(MappedMap& other)
+{
+    m_file.swap(other.m_file);
+    std::swap(m_index, other.m_index);
+    std::swap(m_values, other.m_values);
+    std::swap(m_keyText, other.m_keyText);
+    std::swap(m_valueText, other.m_valueText);
+    std::swap(m_size, other.m_size);
+}
+
+template <typename ValueType>
+inline
+unsigned long long MappedMap<ValueType>::prefixOf(const char* key, size_t len)
+{
+      // Comparing these as numbers orders keys the way std::string does
+      // (byte by byte, as unsigned char) as far as their first 8 bytes go
+    unsigned long long prefix = 0;
+    for (size_t i = 0; i < 8; i++)
+        prefix = (prefix << 8) | (i < len ? static_cast<unsigned char>(key[i]) : 0);
+    return prefix;
+}
+
+template <typename ValueType>
+inline
+unsigned long long MappedMap<ValueType>::valuesBytes(unsigned long long count)
+{
+    if (VALUE_SIZE == 0)
+        return sizeof(unsigned long long) * (count + 2);
+    return roundUp(VALUE_SIZE * (count + 1));
+}
+
+template <typename ValueType>
+inline
+bool MappedMap<ValueType>::keyLess(size_t k, unsigned long long prefix, const std::string& key) const
+{
+      // Keys whose prefixes differ compare as their prefixes do.  Equal
+      // prefixes (say "cat" and "cat\0") need the text.
+    if (m_index[k].prefix != prefix)
+        return m_index[k].prefix < prefix;
+    const char* text = m_keyText + m_index[k].offset;
+    size_t len = size_t(m_index[k+1].offset - m_index[k].offset);
+    int c = memcmp(text, key.data(), std::min(len, key.size()));
+    return c < 0  ||  (c == 0  &&  len < key.size());
+}
+
+template <typename ValueType>
+size_t MappedMap<ValueType>::position(const std::string& key) const
+{
+      // The same walk as FrozenMap::lowerBound, on the mapped index
+
+    unsigned long long prefix = prefixOf(key.data(), key.size());
+    size_t k = 1;
+    while (k <= m_size)
+    {
+        FrozenMap<std::string, ValueType>::prefetch(m_index + std::min(PREFETCH_STRIDE * k, m_size));
+        k = 2*k + keyLess(k, prefix, key);
+    }
+    k >>= FrozenMap<std::string, ValueType>::trailingOnes(k) + 1;
+
+      // k is the smallest key not less than key; it's key if it's not
+      // greater
+    if (k == 0  ||  m_index[k].prefix != prefix)
+        return 0;
+    size_t len = size_t(m_index[k+1].offset - m_index[k].offset);
+    if (len != key.size()  ||  memcmp(m_keyText + m_index[k].offset, key.data(), len) != 0)
+        return 0;
+    return k;
+}
+
+template <typename ValueType>
+inline
+const ValueType* MappedMap<ValueType>::find(const std::string& key) const
+{
+    static_assert(VALUE_SIZE != 0, "find needs values stored in place; use get");
+    size_t k = position(key);
+    if (k == 0)
+        return NULL;
+    return reinterpret_cast<const ValueType*>(m_values) + k;
+}
+
+template <typename ValueType>
+inline
+bool MappedMap<ValueType>::get(const std::string& key, ValueType& value) const
+{
+    size_t k = position(key);
+    if (k == 0)
+        return false;
+    readValue(k, value);
+    return true;
+}
+
+template <typename ValueType>
+inline
+bool MappedMap<ValueType>::get(int i, std::string& key, ValueType& value) const
+{
+    if (i < 0  ||  size_t(i) >= m_size)
+        return false;
+    size_t k = i + 1;
+    key.assign(m_keyText + m_index[k].offset, size_t(m_index[k+1].offset - m_index[k].offset));
+    readValue(k, value);
+    return true;
+}
+
+template <typename ValueType>
+inline
+void MappedMap<ValueType>::readValue(size_t k, std::string& value) const
+{
+    const unsigned long long* offsets = reinterpret_cast<const unsigned long long*>(m_values);
+    value.assign(m_valueText + offsets[k], size_t(offsets[k+1] - offsets[k]));
+}
+
+template <typename ValueType>
+template <typename T>
+inline
+void MappedMap<ValueType>::readValue(size_t k, T& value) const
+{
+    memcpy(&value, m_values + sizeof(T) * k, sizeof(T));
+}
+
+template <typename ValueType>
+void MappedMap<ValueType>::writeValues(std::ostream& out, const std::vector<std::string>& values,
+                                       unsigned long long& textBytes)
+{
+    size_t count = values.size() - 1;
+    std::vector<unsigned long long> offsets(count + 2);
+    textBytes = 0;
+    for (size_t k = 1; k <= count; k++)
+    {
+        offsets[k] = textBytes;
+        textBytes += values[k].size();
+    }
+    offsets[count+1] = textBytes;
+    out.write(reinterpret_cast<const char*>(offsets.data()), sizeof(unsigned long long) * offsets.size());
+}
+
+template <typename ValueType>
+template <typename T>
+void MappedMap<ValueType>::writeValues(std::ostream& out, const std::vector<T>& values,
+                                       unsigned long long& textBytes)
+{
+    static const char padding[8] = { 0 };
+    unsigned long long bytes = sizeof(T) * values.size();
+    out.write(reinterpret_cast<const char*>(values.data()), bytes);
+    out.write(padding, roundUp(bytes) - bytes);
+    textBytes = 0;
+}
+
+template <typename ValueType>
+void MappedMap<ValueType>::writeValueText(std::ostream& out, const std::vector<std::string>& values)
+{
+    for (size_t k = 1; k < values.size(); k++)
+        out.write(values[k].data(), values[k].size());
+}
+
+#endif // MAPPEDMAP_INCLUDED
@@ -0,0 +1,331 @@
+// Timing tests for Map with each storage policy.  Build it on its own (it has
+// its own main) and run it as
+//     mapbench [maxEntries]
+// For each size from 1000 up to maxEntries (default 10000000), by factors of
+// 10, it reports the average time per call, in nanoseconds, of insert, get
+// of a key in the map, get of a key not in the map, a loop of get(i, ...)
+// over every position, the same loop with iterators, and erase.  It then times combine and subtract of two
+// maps of that size sharing half their keys, using one thread and then every
+// core (reported per pair of the two maps).  Last, it times insert/erase
+// churn on the node-based storages, with nodes from a PoolAllocator and
+// straight from the heap, and times get on a FrozenMap made from a map of
+// each size.
+
+#include "Map.h"
+#include "FrozenMap.h"
+#include <iostream>
+#include <algorithm>
+#include <vector>
+#include <string>
+#include <cstdlib>  // for std::rand, std::atoi
+#include <cassert>
+#include <thread>
+#include <memory>
+
+using namespace std;
+
+//========================================================================
+//  Every ListStorage operation searches the whole list, so filling a list
+//  of n entries takes time proportional to n squared.  Sizes above this
+//  limit skip the list tests; raise it if you're willing to wait.
+
+const int MAX_LIST_ENTRIES = 20000;
+//========================================================================
+
+//========================================================================
+// TimerType            - a type to hold a timer reading
+// TimerType getTimer() - get the current timer reading
+// double interval(TimerType start, TimerType end) - milliseconds between
+//                                                   two readings
+//========================================================================
+
+#ifdef _MSC_VER  // If we're compiling for Windows
+
+#include <windows.h>
+
+typedef LARGE_INTEGER TimerType;
+inline TimerType getTimer()
+{
+    LARGE_INTEGER t;
+    QueryPerformanceCounter(&t);
+    return t;
+}
+
+inline double interval(TimerType start, TimerType end)
+{
+    LARGE_INTEGER ticksPerSecond;
+    QueryPerformanceFrequency(&ticksPerSecond);
+    return (1000.0 * (end.QuadPart - start.QuadPart)) / ticksPerSecond.QuadPart;
+}
+
+#else // If we're not compiling for Windows, use Standard C
+
+#include <ctime>
+
+typedef clock_t TimerType;
+inline TimerType getTimer() { return clock(); }
+inline double interval(TimerType start, TimerType end)
+{
+    return (1000.0 * (end - start)) / CLOCKS_PER_SEC;
+}
+
+#endif  // ifdef _MSC_VER
+
+//========================================================================
+
+  // Return a random number; rand() alone may only produce 15 bits
+
+unsigned bigRand()
+{
+    return (unsigned(rand()) << 15) ^ unsigned(rand());
+}
+
+  // Report the results of a timing test
+
+void report(string storage, int n, string operation, double ms, int calls)
+{
+    cout << storage << "," << n << "," << operation << ","
+         << (ms * 1e6 / calls) << endl;
+}
+
+  // Time each operation on a map of n entries.  keys holds n distinct even
+  // keys in random order; odd keys are never in the map.
+
+template <template <typename, typename> class Storage>
+void timeStorage(string storage, const vector<int>& keys)
+{
+    int n = int(keys.size());
+    Map<int, int, Storage> m;
+    TimerType start;
+    TimerType end;
+
+    start = getTimer();
+    for (int k = 0; k < n; k++)
+        m.insert(keys[k], k);
+    end = getTimer();
+    report(storage, n, "insert", interval(start, end), n);
+    assert(m.size() == n);
+
+    long long sum = 0;  // use the results so the loops aren't optimized away
+    start = getTimer();
+    for (int k = 0; k < n; k++)
+    {
+        int v;
+        if (m.get(keys[k], v))
+            sum += v;
+    }
+    end = getTimer();
+    report(storage, n, "get hit", interval(start, end), n);
+
+    int misses = 0;
+    start = getTimer();
+    for (int k = 0; k < n; k++)
+    {
+        int v;
+        if (!m.get(keys[k] + 1, v))
+            misses++;
+    }
+    end = getTimer();
+    report(storage, n, "get miss", interval(start, end), n);
+    assert(misses == n);
+
+    start = getTimer();
+    for (int i = 0; i < n; i++)
+    {
+        int key;
+        int v = 0;
+        m.get(i, key, v);
+        sum -= v;
+    }
+    end = getTimer();
+    report(storage, n, "get(i)", interval(start, end), n);
+    assert(sum == 0);
+
+    start = getTimer();
+    for (auto e : m)
+        sum += e.second;
+    end = getTimer();
+    report(storage, n, "iterate", interval(start, end), n);
+    assert(sum == (long long)(n) * (n-1) / 2);
+
+    start = getTimer();
+    for (int k = n-1; k >= 0; k--)
+        m.erase(keys[k]);
+    end = getTimer();
+    report(storage, n, "erase", interval(start, end), n);
+    assert(m.empty());
+}
+
+  // Time combine and subtract of two maps of n entries.  Half the keys of
+  // the second map are also in the first, and a tenth of those have a
+  // different value there.
+
+template <template <typename, typename> class Storage>
+void timeJoins(string storage, const vector<int>& keys)
+{
+    int n = int(keys.size());
+    Map<int, int, Storage> m1;
+    Map<int, int, Storage> m2;
+    for (int k = 0; k < n; k++)
+    {
+        m1.insert(keys[k], k);
+        if (k % 2 == 0)
+            m2.insert(keys[k], (k % 20 == 0 ? -1-k : k));
+        else
+            m2.insert(keys[k] + 1, k);
+    }
+
+    int nThreads = std::thread::hardware_concurrency();
+    if (nThreads < 1)
+        nThreads = 1;
+    TimerType start;
+    TimerType end;
+    Map<int, int, Storage> result;
+
+    start = getTimer();
+    bool status = combine(m1, m2, result);
+    end = getTimer();
+    report(storage, n, "combine", interval(start, end), 2*n);
+    assert(!status  &&  result.size() == n + n/2 - (n+19)/20);
+
+    start = getTimer();
+    status = combineParallel(m1, m2, result, nThreads);
+    end = getTimer();
+    report(storage, n, "combine parallel", interval(start, end), 2*n);
+    assert(!status  &&  result.size() == n + n/2 - (n+19)/20);
+
+    start = getTimer();
+    subtract(m1, m2, result);
+    end = getTimer();
+    report(storage, n, "subtract", interval(start, end), 2*n);
+    assert(result.size() == n/2);
+
+    start = getTimer();
+    subtractParallel(m1, m2, result, nThreads);
+    end = getTimer();
+    report(storage, n, "subtract parallel", interval(start, end), 2*n);
+    assert(result.size() == n/2);
+}
+
+  // Time freezing a map of n entries, then get on the FrozenMap, to compare
+  // with the get times of the mutable maps
+
+void timeFrozen(const vector<int>& keys)
+{
+    int n = int(keys.size());
+    Map<int, int, HashStorage> m;
+    for (int k = 0; k < n; k++)
+        m.insert(keys[k], k);
+
+    TimerType start = getTimer();
+    FrozenMap<int, int> f(m);
+    TimerType end = getTimer();
+    report("frozen", n, "freeze", interval(start, end), n);
+    assert(f.size() == n);
+
+    long long sum = 0;
+    start = getTimer();
+    for (int k = 0; k < n; k++)
+    {
+        int v;
+        if (f.get(keys[k], v))
+            sum += v;
+    }
+    end = getTimer();
+    report("frozen", n, "get hit", interval(start, end), n);
+    assert(sum == (long long)(n) * (n-1) / 2);
+
+    int misses = 0;
+    start = getTimer();
+    for (int k = 0; k < n; k++)
+    {
+        int v;
+        if (!f.get(keys[k] + 1, v))
+            misses++;
+    }
+    end = getTimer();
+    report("frozen", n, "get miss", interval(start, end), n);
+    assert(misses == n);
+}
+
+  // The node-based storages with nodes straight from the heap, for
+  // comparison with ListStorage and BTreeStorage, which use a PoolAllocator
+
+template <typename KeyType, typename ValueType>
+using HeapListStorage = BasicListStorage<KeyType, ValueType, std::allocator<KeyType> >;
+template <typename KeyType, typename ValueType>
+using HeapBTreeStorage = BasicBTreeStorage<KeyType, ValueType, std::allocator<KeyType> >;
+
+  // Fill a map with the keys, then repeatedly erase a random key and insert
+  // it back, so every erase frees a node and every insert allocates one.
+  // Copying and destroying the map is timed too.
+
+template <template <typename, typename> class Storage>
+void timeChurn(string storage, const vector<int>& keys)
+{
+    int n = int(keys.size());
+    const int rounds = 4 * n;
+    Map<int, int, Storage> m;
+    for (int k = 0; k < n; k++)
+        m.insert(keys[k], k);
+
+    TimerType start = getTimer();
+    for (int r = 0; r < rounds; r++)
+    {
+        int key = keys[bigRand() % n];
+        m.erase(key);
+        m.insert(key, r);
+    }
+    TimerType end = getTimer();
+    report(storage, n, "erase+insert churn", interval(start, end), rounds);
+    assert(m.size() == n);
+
+    start = getTimer();
+    {
+        Map<int, int, Storage> copy(m);
+        assert(copy.size() == n);
+    }
+    end = getTimer();
+    report(storage, n, "copy+destroy", interval(start, end), n);
+}
+
+int main(int argc, char* argv[])
+{
+    int maxEntries = (argc > 1 ? atoi(argv[1]) : 10000000);
+    if (maxEntries <= 0)
+    {
+        cout << "usage: " << argv[0] << " [maxEntries]" << endl;
+        return 1;
+    }
+
+    cout << "storage,entries,operation,ns per call" << endl;
+    for (int n = 1000; n <= maxEntries; n *= 10)
+    {
+          // n distinct even keys in random order
+        srand(n);
+        vector<int> keys;
+        for (int k = 0; k < n; k++)
+            keys.push_back(2 * k);
+        for (int k = n-1; k > 0; k--)
+            swap(keys[k], keys[bigRand() % (k+1)]);
+
+        if (n <= MAX_LIST_ENTRIES)
+        {
+            timeStorage<ListStorage>("list", keys);
+            timeJoins<ListStorage>("list", keys);
+        }
+        timeStorage<HashStorage>("hash", keys);
+        timeJoins<HashStorage>("hash", keys);
+        timeStorage<BTreeStorage>("btree", keys);
+        timeJoins<BTreeStorage>("btree", keys);
+        timeFrozen(keys);
+
+        if (n <= MAX_LIST_ENTRIES)
+        {
+            timeChurn<ListStorage>("list pool", keys);
+            timeChurn<HeapListStorage>("list heap", keys);
+        }
+        timeChurn<BTreeStorage>("btree pool", keys);
+        timeChurn<HeapBTreeStorage>("btree heap", keys);
+    }
+}
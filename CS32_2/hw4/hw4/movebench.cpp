@@ -0,0 +1,195 @@
+// Allocation counts for filling a Map<string, vector<int> > by copying the
+// pairs in, by moving them in, and by emplace, with each storage policy.
+// Build it on its own (it has its own main) and run it as
+//     movebench [entries]
+// Every call to operator new is counted.  The keys and values are built
+// before the clock starts, so a copy shows up as the two allocations it
+// takes to duplicate the key and the vector; moving them in allocates
+// nothing but the node (or the entry array and table growth).  It also
+// counts what it costs to copy a whole map and to move one.
+
+#include "Map.h"
+#include <iostream>
+#include <vector>
+#include <string>
+#include <utility>
+#include <cstdlib>  // for std::atoi, std::malloc, std::free
+#include <cassert>
+#include <new>
+
+using namespace std;
+
+//========================================================================
+//  Every ListStorage insert searches the whole list, so filling a list of
+//  n entries takes time proportional to n squared.  Sizes above this limit
+//  skip the list tests; raise it if you're willing to wait.
+
+const int MAX_LIST_ENTRIES = 20000;
+//========================================================================
+
+const int VALUE_SIZE = 8;  // ints in each value
+
+//========================================================================
+// TimerType            - a type to hold a timer reading
+// TimerType getTimer() - get the current timer reading
+// double interval(TimerType start, TimerType end) - milliseconds between
+//                                                   two readings
+//========================================================================
+
+#ifdef _MSC_VER  // If we're compiling for Windows
+
+#include <windows.h>
+
+typedef LARGE_INTEGER TimerType;
+inline TimerType getTimer()
+{
+    LARGE_INTEGER t;
+    QueryPerformanceCounter(&t);
+    return t;
+}
+
+inline double interval(TimerType start, TimerType end)
+{
+    LARGE_INTEGER ticksPerSecond;
+    QueryPerformanceFrequency(&ticksPerSecond);
+    return (1000.0 * (end.QuadPart - start.QuadPart)) / ticksPerSecond.QuadPart;
+}
+
+#else // If we're not compiling for Windows, use Standard C
+
+#include <ctime>
+
+typedef clock_t TimerType;
+inline TimerType getTimer() { return clock(); }
+inline double interval(TimerType start, TimerType end)
+{
+    return (1000.0 * (end - start)) / CLOCKS_PER_SEC;
+}
+
+#endif  // ifdef _MSC_VER
+
+//========================================================================
+// Count every allocation the program makes
+//========================================================================
+
+static size_t allocations = 0;
+
+void* operator new(size_t size)
+{
+    allocations++;
+    void* p = malloc(size > 0 ? size : 1);
+    if (p == NULL)
+        throw bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    free(p);
+}
+
+//========================================================================
+
+typedef vector<int> Value;
+
+  // Report the results of a test
+
+void report(string storage, int n, string operation, double ms, size_t allocs)
+{
+    cout << storage << "," << n << "," << operation << "," << ms << ","
+         << double(allocs) / n << endl;
+}
+
+  // Long enough that no implementation keeps it in the string object itself
+
+string makeKey(int k)
+{
+    return "a key long enough to need the heap #" + to_string(k);
+}
+
+template <template <typename, typename> class Storage>
+void countStorage(string storage, int n)
+{
+    vector<string> keys;
+    vector<Value> values;
+    for (int k = 0; k < n; k++)
+    {
+        keys.push_back(makeKey(k));
+        values.push_back(Value(VALUE_SIZE, k));
+    }
+
+      // insert(const KeyType&, const ValueType&) copies both into the map
+
+    Map<string, Value, Storage> copied;
+    size_t before = allocations;
+    TimerType start = getTimer();
+    for (int k = 0; k < n; k++)
+        copied.insert(keys[k], values[k]);
+    TimerType end = getTimer();
+    report(storage, n, "insert copy", interval(start, end), allocations - before);
+
+      // insert(KeyType&&, ValueType&&) takes over their buffers
+
+    Map<string, Value, Storage> moved;
+    before = allocations;
+    start = getTimer();
+    for (int k = 0; k < n; k++)
+        moved.insert(std::move(keys[k]), std::move(values[k]));
+    end = getTimer();
+    report(storage, n, "insert move", interval(start, end), allocations - before);
+    assert(moved.size() == n  &&  keys[0].empty()  &&  values[0].empty());
+
+      // emplace builds each value inside the map; the one allocation per
+      // pair that's left is the value's own buffer
+
+    for (int k = 0; k < n; k++)
+        keys[k] = makeKey(k);
+    Map<string, Value, Storage> emplaced;
+    before = allocations;
+    start = getTimer();
+    for (int k = 0; k < n; k++)
+        emplaced.emplace(std::move(keys[k]), VALUE_SIZE, k);
+    end = getTimer();
+    report(storage, n, "emplace", interval(start, end), allocations - before);
+    assert(emplaced.size() == n);
+
+      // Copying a map duplicates every key and value; moving one takes
+      // them over
+
+    before = allocations;
+    start = getTimer();
+    Map<string, Value, Storage> copy(emplaced);
+    end = getTimer();
+    report(storage, n, "copy map", interval(start, end), allocations - before);
+
+    before = allocations;
+    start = getTimer();
+    Map<string, Value, Storage> taken(std::move(copy));
+    end = getTimer();
+    report(storage, n, "move map", interval(start, end), allocations - before);
+    assert(taken.size() == n  &&  copy.empty());
+}
+
+int main(int argc, char* argv[])
+{
+    int maxEntries = (argc > 1 ? atoi(argv[1]) : 1000000);
+    if (maxEntries <= 0)
+    {
+        cout << "usage: " << argv[0] << " [entries]" << endl;
+        return 1;
+    }
+
+    cout << "storage,entries,operation,ms,allocations per entry" << endl;
+    for (int n = 1000; n <= maxEntries; n *= 10)
+    {
+        if (n <= MAX_LIST_ENTRIES)
+            countStorage<ListStorage>("list", n);
+        countStorage<HashStorage>("hash", n);
+        countStorage<BTreeStorage>("btree", n);
+    }
+}
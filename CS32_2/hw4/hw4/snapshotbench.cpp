@@ -0,0 +1,177 @@
+// Timing tests for taking snapshots of a Map, comparing PersistentStorage,
+// whose copies share nodes, and the CowStorages, whose copies share
+// everything until a change, with the storages whose copies are deep.  Build
+// it on its own (it has its own main) and run it as
+//     snapshotbench [maxEntries]
+// For each size from 1000 up to maxEntries (default 1000000), by factors of
+// 10, it reports the average time, in nanoseconds, of
+//   snapshot        copying a map of that size and destroying the copy
+//   request         a request that takes a snapshot of the map, makes
+//                   READS_PER_REQUEST gets on the snapshot, and, every
+//                   UPDATE_INTERVAL requests, updates a pair of the live
+//                   map; the last SNAPSHOTS_KEPT snapshots are kept alive,
+//                   as if slow readers still held them
+//   snapshot+update taking a snapshot and then updating the live map, so
+//                   with PersistentStorage the update has to copy the path
+//                   it changes, and with a CowStorage the whole map
+//   get             a get on a snapshot
+
+#include "Map.h"
+#include <iostream>
+#include <algorithm>
+#include <vector>
+#include <string>
+#include <cstdlib>  // for std::rand, std::atoi
+#include <cassert>
+
+using namespace std;
+
+const int READS_PER_REQUEST = 8;
+const int UPDATE_INTERVAL = 4;
+const int SNAPSHOTS_KEPT = 16;
+
+  // Deep copies of big maps are slow, so the number of snapshots taken at
+  // each size is about this many entries' worth (but at least MIN_ROUNDS)
+
+const long long ENTRIES_COPIED = 50000000;
+const int MIN_ROUNDS = 20;
+
+//========================================================================
+// TimerType            - a type to hold a timer reading
+// TimerType getTimer() - get the current timer reading
+// double interval(TimerType start, TimerType end) - milliseconds between
+//                                                   two readings
+//========================================================================
+
+#ifdef _MSC_VER  // If we're compiling for Windows
+
+#include <windows.h>
+
+typedef LARGE_INTEGER TimerType;
+inline TimerType getTimer()
+{
+    LARGE_INTEGER t;
+    QueryPerformanceCounter(&t);
+    return t;
+}
+
+inline double interval(TimerType start, TimerType end)
+{
+    LARGE_INTEGER ticksPerSecond;
+    QueryPerformanceFrequency(&ticksPerSecond);
+    return (1000.0 * (end.QuadPart - start.QuadPart)) / ticksPerSecond.QuadPart;
+}
+
+#else // If we're not compiling for Windows, use Standard C
+
+#include <ctime>
+
+typedef clock_t TimerType;
+inline TimerType getTimer() { return clock(); }
+inline double interval(TimerType start, TimerType end)
+{
+    return (1000.0 * (end - start)) / CLOCKS_PER_SEC;
+}
+
+#endif  // ifdef _MSC_VER
+
+//========================================================================
+
+  // Return a random number; rand() alone may only produce 15 bits
+
+unsigned bigRand()
+{
+    return (unsigned(rand()) << 15) ^ unsigned(rand());
+}
+
+  // Report the results of a timing test
+
+void report(string storage, int n, string workload, double ms, int calls)
+{
+    cout << storage << "," << n << "," << workload << ","
+         << (ms * 1e6 / calls) << endl;
+}
+
+template <template <typename, typename> class Storage>
+void timeSnapshots(string storage, int n)
+{
+    typedef Map<int, string, Storage> ConfigMap;
+
+    ConfigMap live;
+    for (int k = 0; k < n; k++)
+        live.insert(k, "setting " + to_string(k));
+    int rounds = int(max<long long>(MIN_ROUNDS, ENTRIES_COPIED / n));
+
+    TimerType start = getTimer();
+    for (int r = 0; r < rounds; r++)
+    {
+        ConfigMap snapshot(live);
+        assert(snapshot.size() == n);
+    }
+    TimerType end = getTimer();
+    report(storage, n, "snapshot", interval(start, end), rounds);
+
+      // Requests, with the last SNAPSHOTS_KEPT snapshots kept in a ring
+
+    vector<ConfigMap> kept(SNAPSHOTS_KEPT);
+    size_t found = 0;  // use the results so the reads aren't optimized away
+    start = getTimer();
+    for (int r = 0; r < rounds; r++)
+    {
+        ConfigMap& snapshot = kept[r % SNAPSHOTS_KEPT];
+        snapshot = live;
+        for (int k = 0; k < READS_PER_REQUEST; k++)
+        {
+            string v;
+            if (snapshot.get(int(bigRand() % n), v))
+                found += v.size();
+        }
+        if (r % UPDATE_INTERVAL == 0)
+            live.update(int(bigRand() % n), "request " + to_string(r));
+    }
+    end = getTimer();
+    report(storage, n, "request", interval(start, end), rounds);
+    assert(found > 0);
+
+    start = getTimer();
+    for (int r = 0; r < rounds; r++)
+    {
+        kept[r % SNAPSHOTS_KEPT] = live;
+        live.update(int(bigRand() % n), "update " + to_string(r));
+    }
+    end = getTimer();
+    report(storage, n, "snapshot+update", interval(start, end), rounds);
+
+    const ConfigMap& reader = kept[0];
+    int reads = READS_PER_REQUEST * rounds;
+    start = getTimer();
+    for (int k = 0; k < reads; k++)
+    {
+        string v;
+        if (reader.get(int(bigRand() % n), v))
+            found += v.size();
+    }
+    end = getTimer();
+    report(storage, n, "get", interval(start, end), reads);
+}
+
+int main(int argc, char* argv[])
+{
+    int maxEntries = (argc > 1 ? atoi(argv[1]) : 1000000);
+    if (maxEntries <= 0)
+    {
+        cout << "usage: " << argv[0] << " [maxEntries]" << endl;
+        return 1;
+    }
+
+    cout << "storage,entries,workload,ns per call" << endl;
+    for (int n = 1000; n <= maxEntries; n *= 10)
+    {
+        srand(n);
+        timeSnapshots<HashStorage>("hash", n);
+        timeSnapshots<BTreeStorage>("btree", n);
+        timeSnapshots<PersistentStorage>("persistent", n);
+        timeSnapshots<CowHashStorage>("cow hash", n);
+        timeSnapshots<CowBTreeStorage>("cow btree", n);
+    }
+}
@@ -5,6 +5,10 @@
 #include <string>
 #include <cstdlib>  // for std::rand
 #include <cassert>
+#include <cstdint>  // for uint64_t, uint32_t
+#include <cstring>  // for std::memcpy
+#include <thread>
+#include <iterator>  // for std::make_move_iterator
 
 using namespace std;
 
@@ -21,6 +25,9 @@ const bool TEST_INSERTION_SORT = false;
 // TimerType getTimer() - get the current timer reading
 // double interval(TimerType start, TimerType end) - milliseconds between
 //                                                   two readings
+//
+// The parallel sort runs threads at the same time, so this needs elapsed
+// time; clock() would add up the processor time of every thread.
 //========================================================================
 
 #ifdef _MSC_VER  // If we're compiling for Windows
@@ -42,15 +49,15 @@ inline double interval(TimerType start, TimerType end)
     return (1000.0 * (end.QuadPart - start.QuadPart)) / ticksPerSecond.QuadPart;
 }
 
-#else // If we're not compiling for Windows, use Standard C
+#else // If we're not compiling for Windows, use the standard steady clock
 
-#include <ctime>
+#include <chrono>
 
-typedef clock_t TimerType;
-inline TimerType getTimer() { return clock(); }
+typedef std::chrono::steady_clock::time_point TimerType;
+inline TimerType getTimer() { return std::chrono::steady_clock::now(); }
 inline double interval(TimerType start, TimerType end)
 {
-    return (1000.0 * (end - start)) / CLOCKS_PER_SEC;
+    return std::chrono::duration<double, std::milli>(end - start).count();
 }
 
 #endif  // ifdef _MSC_VER
@@ -67,6 +74,8 @@ inline double interval(TimerType start, TimerType end)
 
 typedef int IdType;
 
+const size_t NGRADES = 10;
+
 struct Student
 {
     IdType id;
@@ -75,7 +84,7 @@ struct Student
     Student(IdType i) : id(i)
     {
           // create ten random grades (from 0 to 4)
-        for (size_t k = 0; k < 10; k++)
+        for (size_t k = 0; k < NGRADES; k++)
             grades.push_back(rand() % 5);
           // (accumulate computes 0.0 + grades[0] + grades[1] + ...)
         gpa = accumulate(grades.begin(), grades.end(), 0.0) / grades.size();
@@ -149,6 +158,336 @@ void insertion_sort(vector<Student>& s, bool comp(const Student&, const Student&
 
   
 
+  // A stable merge sort that uses nThreads threads.  Each thread stable-
+  // sorts one slice of s in place; then rounds of merges combine the
+  // sorted runs pairwise, ping-ponging between s and a buffer, until one
+  // run is left.  Each merge is itself split among threads (see
+  // mergeSlices below), so the last rounds, with only a run or two left,
+  // still keep every thread busy.  Students are only ever moved, never
+  // copied, so their grades vectors are never reallocated.
+
+typedef bool StudentCompare(const Student&, const Student&);
+
+struct MergeSlice  // merge from[a1,a2) and from[b1,b2) into to at out
+{
+    size_t a1, a2, b1, b2, out;
+};
+
+  // Split the merge of the sorted runs from[first,mid) and from[mid,last)
+  // into nSlices independent merges, appending them to slices.  Slice i
+  // starts at the i-th equal division of the first run; the second run is
+  // split before its first Student that isn't less than the one there.  So
+  // on a tie the Student from the first run comes first, keeping the sort
+  // stable, and Students equal to a split point all land on the same side.
+
+void mergeSlices(const vector<Student>& from, size_t first, size_t mid, size_t last,
+                 int nSlices, StudentCompare comp, vector<MergeSlice>& slices)
+{
+    size_t prevA = first;
+    size_t prevB = mid;
+    for (int i = 1; i <= nSlices; i++)
+    {
+        size_t a = (i == nSlices ? mid : first + (mid - first) * i / nSlices);
+        size_t b = (i == nSlices ? last :
+                    size_t(lower_bound(from.begin() + mid, from.begin() + last, from[a], comp) - from.begin()));
+        MergeSlice m = { prevA, a, prevB, b, prevA + (prevB - mid) };
+        slices.push_back(m);
+        prevA = a;
+        prevB = b;
+    }
+}
+
+void parallel_stable_sort(vector<Student>& s, StudentCompare comp, int nThreads)
+{
+    size_t n = s.size();
+    if (nThreads < 1)
+        nThreads = 1;
+    if (size_t(nThreads) > n / 2)  // leave every slice at least 2 Students
+        nThreads = int(max(n / 2, size_t(1)));
+
+    if (nThreads == 1)  // no threads to start, so this is a fair baseline
+    {
+        stable_sort(s.begin(), s.end(), comp);
+        return;
+    }
+
+      // Sort nThreads slices in place; runStart[k] is where run k begins
+
+    vector<size_t> runStart;
+    for (int t = 0; t <= nThreads; t++)
+        runStart.push_back(n * t / nThreads);
+    vector<thread> threads;
+    for (int t = 0; t < nThreads; t++)
+        threads.push_back(thread([&s, &runStart, comp, t]() {
+            stable_sort(s.begin() + runStart[t], s.begin() + runStart[t+1], comp);
+        }));
+    for (size_t t = 0; t < threads.size(); t++)
+        threads[t].join();
+
+      // The buffer starts out holding the sorted runs, moved out of s, so
+      // every merge can move-assign into Students that already exist
+
+    vector<Student> buffer(make_move_iterator(s.begin()), make_move_iterator(s.end()));
+    vector<Student>* from = &buffer;
+    vector<Student>* to = &s;
+    while (runStart.size() > 2)
+    {
+          // Pair up the runs, giving each pair's merge its share of the
+          // threads; an odd run out is moved across as it is
+
+        size_t nPairs = (runStart.size() - 1) / 2;
+        int slicesPerPair = max(1, int(nThreads / nPairs));
+        vector<MergeSlice> slices;
+        vector<size_t> nextStart;
+        for (size_t r = 0; r + 1 < runStart.size(); r += 2)
+        {
+            nextStart.push_back(runStart[r]);
+            if (r + 2 < runStart.size())
+                mergeSlices(*from, runStart[r], runStart[r+1], runStart[r+2],
+                            slicesPerPair, comp, slices);
+            else
+            {
+                MergeSlice m = { runStart[r], runStart[r+1], runStart[r+1], runStart[r+1], runStart[r] };
+                slices.push_back(m);
+            }
+        }
+        nextStart.push_back(n);
+
+        threads.clear();
+        for (size_t i = 0; i < slices.size(); i++)
+            threads.push_back(thread([from, to, &slices, comp, i]() {
+                const MergeSlice& m = slices[i];
+                merge(make_move_iterator(from->begin() + m.a1), make_move_iterator(from->begin() + m.a2),
+                      make_move_iterator(from->begin() + m.b1), make_move_iterator(from->begin() + m.b2),
+                      to->begin() + m.out, comp);
+            }));
+        for (size_t t = 0; t < threads.size(); t++)
+            threads[t].join();
+
+        runStart.swap(nextStart);
+        swap(from, to);
+    }
+    if (from != &s)  // the last merge went into the buffer
+        s.swap(buffer);
+}
+
+  // Order by GPA alone, so that Students with the same GPA tie; a stable
+  // sort must leave them in their original order
+
+inline
+bool compareGpaOnly(const Student& lhs, const Student& rhs)
+{
+    return lhs.gpa > rhs.gpa;
+}
+
+
+  // A radix sort for the same order as compareStudent.  Each Student gets a key
+  // that compares as unsigned integers the way the Student does: the gpa's
+  // bits made to sort in descending order, then the id.  (A double and an
+  // id don't both fit in 64 bits without losing order, so the id is kept
+  // beside the key as four more digits, which the sort takes first.)  An
+  // LSD radix sort orders the small (key, id, index) items a byte at a
+  // time, never touching a Student, and then the Students are moved into their
+  // sorted places once.
+
+struct RadixItem
+{
+    uint64_t key;    // the gpa, encoded for descending order
+    uint32_t id;     // the id, encoded for ascending order
+    uint32_t index;  // where the Student is in the vector being sorted
+};
+
+  // An unsigned integer that is larger for a smaller d, so that sorting
+  // these keys in increasing order sorts the doubles in decreasing order
+
+inline
+uint64_t descendingKey(double d)
+{
+    if (d == 0)  // -0.0 ties with 0.0
+        d = 0;
+    uint64_t bits;
+    memcpy(&bits, &d, sizeof(bits));
+    const uint64_t signBit = uint64_t(1) << 63;
+    uint64_t ascending = (bits & signBit) ? ~bits : (bits | signBit);
+    return ~ascending;
+}
+
+  // Digits 0 to 3 are the bytes of the id, least significant first;
+  // digits 4 to 11 are the bytes of the key
+
+inline
+unsigned radixDigit(const RadixItem& item, int digit)
+{
+    if (digit < 4)
+        return (item.id >> (8 * digit)) & 0xff;
+    return unsigned(item.key >> (8 * (digit - 4))) & 0xff;
+}
+
+void radix_sort(vector<Student>& s)
+{
+    size_t n = s.size();
+    if (n < 2)
+        return;
+    vector<RadixItem> items(n);
+    for (size_t k = 0; k < n; k++)
+    {
+        items[k].key = descendingKey(s[k].gpa);
+        items[k].id = uint32_t(s[k].id) ^ 0x80000000u;  // so negative ids come first
+        items[k].index = uint32_t(k);
+    }
+
+      // Each pass is a stable counting sort on one digit.  A digit that
+      // every item has the same value for (the high bytes of the ids, say)
+      // can't change the order, so its pass is skipped.
+
+    vector<RadixItem> buffer(n);
+    for (int digit = 0; digit < 12; digit++)
+    {
+        size_t count[256] = { 0 };
+        for (size_t k = 0; k < n; k++)
+            count[radixDigit(items[k], digit)]++;
+        if (count[radixDigit(items[0], digit)] == n)
+            continue;
+        size_t next = 0;
+        for (int b = 0; b < 256; b++)
+        {
+            size_t c = count[b];
+            count[b] = next;  // now where the first item with this digit goes
+            next += c;
+        }
+        for (size_t k = 0; k < n; k++)
+            buffer[count[radixDigit(items[k], digit)]++] = items[k];
+        items.swap(buffer);
+    }
+
+      // Move each Student once, into its sorted place
+
+    vector<Student> sorted;
+    sorted.reserve(n);
+    for (size_t k = 0; k < n; k++)
+        sorted.push_back(std::move(s[items[k].index]));
+    s.swap(sorted);
+}
+
+  // The same data as a Student, with the grades stored in the record
+  // itself.  Copying one is a plain copy of its bytes, with no allocation,
+  // and a vector of them is one block of memory.
+
+struct CompactStudent
+{
+    IdType id;
+    double gpa;
+    double grades[NGRADES];
+    CompactStudent(const Student& s) : id(s.id), gpa(s.gpa)
+    {
+        copy(s.grades.begin(), s.grades.end(), grades);
+    }
+};
+
+inline
+bool compareCompactStudent(const CompactStudent& lhs, const CompactStudent& rhs)
+{
+    if (lhs.gpa > rhs.gpa)
+        return true;
+    if (lhs.gpa < rhs.gpa)
+        return false;
+    return lhs.id < rhs.id;
+}
+
+  // The same data again, a column at a time: the ids, the GPAs, and the
+  // grades with each Student's NGRADES of them together.  Sorting only
+  // compares the ids and GPAs, which are packed densely, then rearranges
+  // each column once.
+
+class StudentColumns
+{
+  public:
+    StudentColumns(const vector<Student>& s)
+    {
+        for (size_t k = 0; k < s.size(); k++)
+        {
+            m_ids.push_back(s[k].id);
+            m_gpas.push_back(s[k].gpa);
+            m_grades.insert(m_grades.end(), s[k].grades.begin(), s[k].grades.end());
+        }
+    }
+    size_t size() const { return m_ids.size(); }
+    IdType id(size_t k) const { return m_ids[k]; }
+    double gpa(size_t k) const { return m_gpas[k]; }
+    const double* grades(size_t k) const { return &m_grades[k * NGRADES]; }
+
+      // Sort in compareStudent's order: sort small (GPA, id, position)
+      // entries, which carry what a comparison needs so that it reads
+      // nothing else, then put each column in the entries' order
+
+    void sort()
+    {
+        vector<SortEntry> order(size());
+        for (size_t k = 0; k < order.size(); k++)
+        {
+            order[k].gpa = m_gpas[k];
+            order[k].id = m_ids[k];
+            order[k].position = k;
+        }
+        std::sort(order.begin(), order.end(), [](const SortEntry& lhs, const SortEntry& rhs) {
+            if (lhs.gpa != rhs.gpa)
+                return lhs.gpa > rhs.gpa;
+            return lhs.id < rhs.id;
+        });
+
+        vector<IdType> sortedIds(order.size());
+        vector<double> sortedGpas(order.size());
+        vector<double> sortedGrades(m_grades.size());
+        for (size_t k = 0; k < order.size(); k++)
+        {
+            sortedIds[k] = order[k].id;
+            sortedGpas[k] = order[k].gpa;
+            const double* g = grades(order[k].position);
+            copy(g, g + NGRADES, &sortedGrades[k * NGRADES]);
+        }
+        m_ids.swap(sortedIds);
+        m_gpas.swap(sortedGpas);
+        m_grades.swap(sortedGrades);
+    }
+
+  private:
+    struct SortEntry
+    {
+        double gpa;
+        IdType id;
+        size_t position;
+    };
+    vector<IdType> m_ids;
+    vector<double> m_gpas;
+    vector<double> m_grades;
+};
+
+  // Return true iff c holds the same Students as s in the same order
+
+bool sameOrder(const vector<CompactStudent>& c, const vector<Student>& s)
+{
+    if (c.size() != s.size())
+        return false;
+    for (size_t k = 0; k < s.size(); k++)
+    {
+        if (c[k].id != s[k].id  ||  !equal(s[k].grades.begin(), s[k].grades.end(), c[k].grades))
+            return false;
+    }
+    return true;
+}
+
+bool sameOrder(const StudentColumns& c, const vector<Student>& s)
+{
+    if (c.size() != s.size())
+        return false;
+    for (size_t k = 0; k < s.size(); k++)
+    {
+        if (c.id(k) != s[k].id  ||  !equal(s[k].grades.begin(), s[k].grades.end(), c.grades(k)))
+            return false;
+    }
+    return true;
+}
+
   // Report the results of a timing test
 
 void report(string caption, double t, const vector<Student>& s)
@@ -163,6 +502,30 @@ void report(string caption, double t, const vector<Student>& s)
     cout << endl;
 }
 
+void report(string caption, double t, const vector<CompactStudent>& s)
+{
+    cout << t << " milliseconds; " << caption
+             << "; first few students are\n\t";
+    size_t n = s.size();
+    if (n > 5)
+        n = 5;
+    for (size_t k = 0; k < n; k++)
+        cout << " (" << s[k].id << ", " << s[k].gpa << ")";
+    cout << endl;
+}
+
+void report(string caption, double t, const StudentColumns& s)
+{
+    cout << t << " milliseconds; " << caption
+             << "; first few students are\n\t";
+    size_t n = s.size();
+    if (n > 5)
+        n = 5;
+    for (size_t k = 0; k < n; k++)
+        cout << " (" << s.id(k) << ", " << s.gpa(k) << ")";
+    cout << endl;
+}
+
 int main()
 {
     size_t nstudents;
@@ -272,4 +635,62 @@ int main()
     endSort = getTimer();
     report("STL sort of pointers", interval(startSort, endSort), studs);
     assert(isSorted(studs));
+
+      // The radix sort on encoded keys.  It compares no Students at all.
+
+    studs = unorderedStuds;
+    startSort = getTimer();
+    radix_sort(studs);
+    endSort = getTimer();
+    report("radix sort of encoded keys", interval(startSort, endSort), studs);
+    assert(isSorted(studs));
+
+      // The same Students with their grades inline, so sorting them moves
+      // no dynamic memory, and then a column at a time.  (Making them from
+      // the Students isn't timed, just as making the Students isn't.)  Each
+      // must end up in the same order as studs.
+
+    vector<CompactStudent> unorderedCompact(unorderedStuds.begin(), unorderedStuds.end());
+    vector<CompactStudent> compact(unorderedCompact);
+    startSort = getTimer();
+    sort(compact.begin(), compact.end(), compareCompactStudent);
+    endSort = getTimer();
+    report("STL sort of compact students", interval(startSort, endSort), compact);
+    assert(sameOrder(compact, studs));
+
+    StudentColumns columns(unorderedStuds);
+    startSort = getTimer();
+    columns.sort();
+    endSort = getTimer();
+    report("sort of student columns by index", interval(startSort, endSort), columns);
+    assert(sameOrder(columns, studs));
+
+      // The parallel stable sort, first with one thread (where it's just
+      // the STL stable_sort) and then with twice as many each time, up to
+      // twice the number of cores.  The speedup is against one thread.
+      // Students with equal GPAs must come out in the same order as the
+      // STL stable_sort leaves them.
+
+    int maxThreads = 2 * max(1, int(thread::hardware_concurrency()));
+    double oneThread = 0;
+    for (int nThreads = 1; nThreads <= maxThreads; nThreads *= 2)
+    {
+        studs = unorderedStuds;
+        startSort = getTimer();
+        parallel_stable_sort(studs, compareStudent, nThreads);
+        endSort = getTimer();
+        double t = interval(startSort, endSort);
+        if (nThreads == 1)
+            oneThread = t;
+        report("parallel stable sort, " + to_string(nThreads) + " threads (speedup " +
+               to_string(oneThread / t) + ")", t, studs);
+        assert(isSorted(studs));
+    }
+
+    vector<Student> stable(unorderedStuds);
+    stable_sort(stable.begin(), stable.end(), compareGpaOnly);
+    studs = unorderedStuds;
+    parallel_stable_sort(studs, compareGpaOnly, maxThreads);
+    for (size_t k = 0; k < studs.size(); k++)
+        assert(studs[k].id == stable[k].id);
 }
\ No newline at end of file
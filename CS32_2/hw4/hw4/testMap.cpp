@@ -1,7 +1,17 @@
 #include "Map.h"
+#include "FrozenMap.h"
+#include "MappedMap.h"
 #include <cassert>
 #include <string>
+#include <vector>
+#include <utility>
 #include <iostream>
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <cstdio>
+#include <fstream>
+#include <thread>
 
 using namespace std;
 
@@ -31,8 +41,452 @@ void test()
 	subtract(mid,mid,mid);
 }
 
+template <template <typename, typename> class Storage>
+void testStorage()
+{
+	Map<string, int, Storage> m;
+	assert(m.empty());
+	for (int i = 0; i < 1000; i++)
+		assert(m.insert(to_string(i), i));
+	assert(!m.insert("7", 70));	//already there
+	assert(m.size() == 1000);
+	assert(m.update("7", 70));
+	assert(!m.update("1000", 0));
+	int v;
+	assert(m.get("7", v) && v == 70);
+	assert(!m.get("1000", v) && v == 70);
+	for (int i = 0; i < 1000; i += 2)
+		assert(m.erase(to_string(i)));
+	assert(!m.erase("0"));
+	assert(m.size() == 500);
+	//every position gives a different pair, and all of them are odd
+	Map<string, int, Storage> seen;
+	for (int i = 0; i < m.size(); i++)
+	{
+		string k;
+		assert(m.get(i, k, v));
+		assert(v % 2 == 1 || k == "7");
+		assert(seen.insert(k, v));
+	}
+	//iterating visits them in the order of get(i)
+	int pos = 0;
+	for (auto e : m)
+	{
+		string k;
+		assert(m.get(pos++, k, v) && k == e.first && v == e.second);
+	}
+	assert(pos == 500);
+	//several threads can call get(i) on a const map at once
+	const Map<string, int, Storage>& cm = m;
+	vector<int> sums(4, 0);
+	vector<thread> readers;
+	for (int t = 0; t < 4; t++)
+		readers.push_back(thread([&cm, &sums, t]() {
+			for (int i = 0; i < cm.size(); i++)
+			{
+				string k;
+				int v;
+				cm.get(i, k, v);
+				sums[t] += v;
+			}
+		}));
+	for (int t = 0; t < 4; t++)
+	{
+		readers[t].join();
+		assert(sums[t] == sums[0]);
+	}
+	string k = "x";
+	assert(!m.get(500, k, v) && k == "x");
+	assert(!m.get(-1, k, v) && k == "x");
+
+	Map<string, int, Storage> m2(m);
+	assert(m2.erase("1") && m.contains("1"));
+	m2 = m;
+	assert(m2.size() == 500);
+	m2.update("3", 33);	//conflicts with m
+	m2.insert("2", 2);
+	Map<string, int, Storage> res;
+	assert(!combine(m, m2, res));
+	assert(res.size() == 500 && !res.contains("3") && res.contains("2"));
+	subtract(m2, m, res);
+	assert(res.size() == 1 && res.contains("2"));
+	//the parallel versions give the same answers
+	assert(!combineParallel(m, m2, res, 4));
+	assert(res.size() == 500 && !res.contains("3") && res.contains("2"));
+	subtractParallel(m2, m, res, 4);
+	assert(res.size() == 1 && res.contains("2"));
+	assert(combineParallel(m, m, m, 3) && m.size() == 500);	//aliasing
+	while (!m.empty())
+	{
+		assert(m.get(0, k, v));
+		assert(m.erase(k));
+	}
+}
+
+//a value that counts how often it's copied (its moves are noexcept, as
+//vector needs them to be to move rather than copy when it grows)
+struct Counted
+{
+	static int copies;
+	vector<int> data;
+	Counted() {}
+	Counted(int n, int x) : data(n, x) {}
+	Counted(const Counted& other) : data(other.data) { copies++; }
+	Counted(Counted&& other) noexcept : data(move(other.data)) {}
+	Counted& operator=(const Counted& other) { data = other.data; copies++; return *this; }
+	Counted& operator=(Counted&& other) noexcept { data = move(other.data); return *this; }
+	bool operator!=(const Counted& other) const { return data != other.data; }
+};
+int Counted::copies = 0;
+
+template <template <typename, typename> class Storage>
+void testMoves()
+{
+	Map<string, Counted, Storage> m;
+	Counted::copies = 0;
+	for (int i = 0; i < 1000; i++)
+	{
+		string key = "key " + to_string(i);
+		Counted value(3, i);
+		assert(m.insert(move(key), move(value)));
+		assert(key.empty() && value.data.empty());	//both were moved in
+	}
+	for (int i = 1000; i < 2000; i++)
+		assert(m.emplace("key " + to_string(i), 3, i));
+	assert(!m.emplace("key 5", 4, 4));	//already there
+	assert(m.update("key 5", Counted(2, 50)));
+	assert(m.insertOrUpdate(string("key 6"), Counted(2, 60)));
+	assert(Counted::copies == 0);	//growing and splitting move pairs too
+	for (int i = 0; i < 2000; i += 3)
+		assert(m.erase("key " + to_string(i)));
+	assert(Counted::copies == 0);
+	Counted c;
+	assert(m.get("key 1999", c) && c.data == vector<int>(3, 1999));
+	assert(m.get("key 5", c) && c.data == vector<int>(2, 50));
+
+	//moving a map takes its pairs and leaves it empty but usable
+	int n = m.size();
+	Counted::copies = 0;
+	Map<string, Counted, Storage> m2(move(m));
+	assert(m2.size() == n && m.empty() && !m.contains("key 1"));
+	assert(m.insert("key 1", Counted(1, 1)) && m.size() == 1);
+	m = move(m2);
+	assert(m.size() == n && m.contains("key 1999"));
+	assert(m2.size() == 1 && m2.contains("key 1"));	//move assignment swaps, so m2 has m's old pair
+	assert(m2.insert("key 2", Counted(1, 2)) && m2.size() == 2);
+	Map<string, Counted, Storage> m3;
+	m3 = Map<string, Counted, Storage>(m);	//one copy, then a move
+	assert(m3.size() == n && Counted::copies == n);
+}
+
+template <template <typename, typename> class Storage>
+void testFrozen()
+{
+	//every tree shape up to 100 pairs: present keys are found and absent
+	//ones (below, between and above them) are not
+	for (int n = 0; n <= 100; n++)
+	{
+		Map<int, int, Storage> m;
+		for (int i = 0; i < n; i++)
+			m.insert((i * 7919) % n * 2 + 1, i);	//the odd numbers below 2n, shuffled
+		FrozenMap<int, int> f(m);
+		assert(f.size() == n && f.empty() == (n == 0));
+		for (int k = 0; k <= 2 * n + 1; k++)
+		{
+			int v = -1;
+			assert(f.contains(k) == (k % 2 == 1 && k < 2 * n));
+			assert(f.get(k, v) == f.contains(k));
+			if (f.contains(k))
+				assert(v == (m.get(k, v), v) && *f.find(k) == v);
+			else
+				assert(f.find(k) == NULL && v == -1);
+		}
+		Map<int, int, Storage> seen;
+		for (int i = 0; i < n; i++)
+		{
+			int k, v;
+			assert(f.get(i, k, v) && m.get(k, v) && seen.insert(k, v));
+		}
+		int k = 7;
+		assert(!f.get(n, k, k) && k == 7);
+	}
+	Map<string, double, Storage> ms;
+	ms.insert("Fred", 2.956);
+	ms.insert("Ethel", 3.538);
+	FrozenMap<string, double> fs(ms);
+	double d;
+	assert(fs.get("Fred", d) && d == 2.956 && !fs.contains("Lucy"));
+}
+
+template <template <typename, typename> class Storage>
+void testIterators()
+{
+	//iterators visit the pairs in the order of get(i), and values can be
+	//changed through them
+	Map<string, int, Storage> m;
+	assert(m.begin() == m.end());
+	for (int i = 0; i < 1000; i++)
+		m.insert("key " + to_string((i * 7919) % 1000), i);
+	for (int i = 0; i < 1000; i += 7)
+		m.erase("key " + to_string(i));
+	for (auto e : m)
+		e.second = -e.second;
+	const Map<string, int, Storage>& cm = m;
+	int i = 0;
+	for (typename Map<string, int, Storage>::const_iterator it = cm.begin(); it != cm.end(); it++, i++)
+	{
+		string k;
+		int v;
+		assert(cm.get(i, k, v) && it->first == k && (*it).second == v && v <= 0);
+		pair<string, int> p = *it;	//copies the pair out
+		assert(p.first == k && p.second == v);
+	}
+	assert(i == m.size());
+	typename Map<string, int, Storage>::const_iterator first = m.begin();	//an iterator converts to a const one
+	assert(first == cm.begin() && distance(m.begin(), m.end()) == m.size());
+
+	//standard algorithms work on them
+	int total = 0;
+	for_each(cm.begin(), cm.end(), [&total](MapEntry<string, const int> e) { total -= e.second; });
+	int expected = 0;
+	for (int j = 0; j < 1000; j++)
+		if (((j * 7919) % 1000) % 7 != 0)
+			expected += j;
+	assert(total == expected);
+	assert(find_if(m.begin(), m.end(), [](MapEntry<string, int> e) { return e.first == "key 7"; }) == m.end());
+	assert(count_if(cm.begin(), cm.end(), [](MapEntry<string, const int> e) { return e.first.size() == 5; }) == 8);	//1-9, less 7
+}
+
+//an allocator that counts the nodes it hands out (of any type, since
+//the storage rebinds it to its node type)
+int allocatedNodes = 0;
+template <typename T>
+struct CountingAllocator
+{
+	typedef T value_type;
+	CountingAllocator() {}
+	template <typename U>
+	CountingAllocator(const CountingAllocator<U>&) {}
+	T* allocate(size_t n) { allocatedNodes += int(n); return std::allocator<T>().allocate(n); }
+	void deallocate(T* p, size_t n) { allocatedNodes -= int(n); std::allocator<T>().deallocate(p, n); }
+	bool operator==(const CountingAllocator&) const { return true; }
+	bool operator!=(const CountingAllocator&) const { return false; }
+};
+template <typename KeyType, typename ValueType>
+using CountingPersistentStorage = BasicPersistentStorage<KeyType, ValueType, CountingAllocator<KeyType> >;
+
+void testPersistent()
+{
+	//copies are snapshots: changing one map leaves its copies alone
+	typedef Map<int, string, CountingPersistentStorage> PMap;
+	int& nodes = allocatedNodes;
+	{
+		PMap m;
+		for (int i = 0; i < 1000; i++)
+			assert(m.insert(i, to_string(i)));
+		assert(nodes == 1000);
+		PMap snap(m);	//shares every node
+		assert(nodes == 1000 && snap.size() == 1000);
+		assert(m.update(500, "five hundred") && m.erase(7) && m.insert(1000, "1000"));
+		string v;
+		assert(snap.get(500, v) && v == "500" && snap.contains(7) && !snap.contains(1000));
+		assert(m.get(500, v) && v == "five hundred" && !m.contains(7));
+		assert(nodes < 1000 + 3 * 30);	//only the changed paths were copied
+		int before = nodes;
+		assert(m.update(500, "again") && nodes == before);	//that path is no longer shared
+		assert(!m.update(5000, "x") && !m.erase(5000) && nodes == before);	//misses copy nothing
+		PMap shared(m);
+		assert(!shared.insert(500, "x") && !shared.emplace(500, "x") && nodes == before);	//nor do failed inserts
+		PMap snaps[10];
+		for (int s = 0; s < 10; s++)
+		{
+			snaps[s] = m;
+			m.update(10 + s, "changed");
+		}
+		for (int s = 0; s < 10; s++)
+			for (int i = 10; i < 20; i++)
+				assert(snaps[s].get(i, v) && v == (i < 10 + s ? "changed" : to_string(i)));
+		int i = 0;
+		for (auto e : snap)	//in increasing order of key
+			assert(e.first == i++);
+		snap = m;
+		assert(snap.contains(1000));
+	}
+	assert(nodes == 0);	//every node is freed once no map holds it
+}
+
+template <typename KeyType, typename ValueType>
+using CountingBTreeStorage = BasicBTreeStorage<KeyType, ValueType, CountingAllocator<KeyType> >;
+template <typename KeyType, typename ValueType>
+using CountingCowStorage = BasicCowStorage<KeyType, ValueType, CountingBTreeStorage>;
+
+void testCopyOnWrite()
+{
+	//copies share the pairs until one of them changes
+	typedef Map<int, string, CountingCowStorage> CMap;
+	int& nodes = allocatedNodes;
+	{
+		CMap m;
+		for (int i = 0; i < 1000; i++)
+			assert(m.insert(i, to_string(i)));
+		int one = nodes;
+		CMap copies[5] = { m, m, m, m, m };
+		CMap passed = copies[2];
+		assert(nodes == one && passed.size() == 1000);	//nothing was copied
+		string v;
+		assert(passed.get(7, v) && v == "7" && passed.contains(999) && nodes == one);	//lookups copy nothing
+		assert(!passed.update(5000, "x") && !passed.erase(5000) && nodes == one);	//nor do misses
+		assert(!passed.insert(7, "x") && !passed.emplace(7, "x") && nodes == one);	//nor do failed inserts
+		assert(passed.get(7, v) && v == "7");
+		assert(passed.update(7, "seven") && nodes == 2 * one);	//the first change copies
+		assert(passed.erase(8) && passed.insert(1000, "1000") && nodes <= 2 * one + 1);	//later ones don't
+		assert(m.get(7, v) && v == "7" && m.contains(8) && !copies[4].contains(1000));
+		int i = 0;
+		for (auto e : passed)	//in the b-tree's order
+		{
+			if (i == 8)
+				i++;
+			assert(e.first == i++);
+		}
+		CMap res;
+		combine(m, CMap(), res);	//shares the answer
+		assert(res.size() == 1000 && nodes <= 2 * one + 1);
+		subtract(m, passed, res);
+		assert(res.size() == 1 && res.contains(8));
+	}
+	assert(nodes == 0);	//the last map to let go frees the pairs
+}
+
+void testMapped()
+{
+	//keys that tie on their first 8 bytes, hold '\0' or bytes above 127,
+	//or are prefixes of each other, so the full comparison gets used
+	const char* path = "testMapped.bin";
+	const char* stringPath = "testMappedStrings.bin";
+	const char* cutPath = "testMappedCut.bin";
+	vector<string> keys = { "", "a", "ab", "abcdefgh", "abcdefghi", "abcdefgha",
+		string("cat"), string("cat\0", 4), string("cat\0\0", 5), "\xff", "\xff\x01", "zebra" };
+	for (int i = 0; i < 300; i++)
+		keys.push_back("key number " + to_string(i * 7919 % 300));
+	Map<string, double, HashStorage> m;
+	Map<string, string, BTreeStorage> ms;
+	for (size_t i = 0; i < keys.size(); i++)
+	{
+		m.insert(keys[i], i + 0.5);
+		ms.insert(keys[i], "value " + keys[i]);
+	}
+
+	MappedMap<double> md;
+	assert(md.empty() && !md.contains("a") && md.find("a") == NULL);
+	assert(MappedMap<double>::save(path, m) && md.open(path));
+	assert(md.size() == m.size());
+	for (size_t i = 0; i < keys.size(); i++)
+	{
+		double d = -1;
+		assert(md.contains(keys[i]) && md.get(keys[i], d) && d == i + 0.5 && *md.find(keys[i]) == d);
+	}
+	for (const char* absent : { "b", "abcdefg", "abcdefghj", "cat\x01", "\xfe", "zebras", "key number 300" })
+	{
+		double d = -1;
+		assert(!md.contains(absent) && !md.get(absent, d) && d == -1 && md.find(absent) == NULL);
+	}
+	Map<string, double, HashStorage> seen;	//get(i) visits every pair once
+	for (int i = 0; i < md.size(); i++)
+	{
+		string k;
+		double d, v;
+		assert(md.get(i, k, d) && m.get(k, v) && v == d && seen.insert(k, d));
+	}
+	string k = "x";
+	double d = 7;
+	assert(!md.get(md.size(), k, d) && k == "x" && d == 7);
+
+	//a file for the wrong values, or a cut-off file, doesn't open, and an
+	//open map keeps the file it had
+	MappedMap<string> mstr;
+	assert(!mstr.open(path));
+	MappedMap<string> other;
+	assert(MappedMap<string>::save(stringPath, ms) && other.open(stringPath));
+	mstr.swap(other);
+	assert(other.empty() && mstr.size() == ms.size());
+	for (size_t i = 0; i < keys.size(); i++)
+	{
+		string v;
+		assert(mstr.get(keys[i], v) && v == "value " + keys[i]);
+	}
+	string head;
+	{
+		ifstream in(path, ios::binary);
+		head.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+	}
+	{
+		ofstream out(cutPath, ios::binary | ios::trunc);
+		out.write(head.data(), head.size() - 1);
+	}
+	assert(!md.open(cutPath) && md.size() == m.size() && md.contains("zebra"));
+
+	//saving over the open file leaves the open map reading the old pairs
+	//(Windows won't replace a mapped file, so there the save just fails)
+	Map<string, double, HashStorage> small;
+	small.insert("only", 1);
+	bool saved = MappedMap<double>::save(path, small);
+	double zebra;
+	assert(md.size() == m.size() && md.get("zebra", d) && m.get("zebra", zebra) && d == zebra);
+	MappedMap<double> fresh;
+	assert(fresh.open(path) && fresh.size() == (saved ? 1 : m.size()));
+	fresh.close();
+
+	//an empty map saves and opens
+	md.close();
+	assert(MappedMap<double>::save(path, Map<string, double, HashStorage>()) && md.open(path));
+	assert(md.empty() && !md.contains("") && md.find("a") == NULL);
+	md.close();
+	mstr.close();
+	remove(path);
+	remove(stringPath);
+	remove(cutPath);
+}
+
+void testBTreeOrder()
+{
+	//get(i) visits the keys of a b-tree in increasing order
+	Map<int, int, BTreeStorage> m;
+	for (int i = 0; i < 5000; i++)
+		m.insert((i * 7919) % 5000, i);
+	for (int i = 0; i < 5000; i++)
+	{
+		int k, v;
+		assert(m.get(i, k, v) && k == i);
+	}
+	int next = 0;	//and so does iterating
+	for (auto e : m)
+		assert(e.first == next++);
+	assert(next == 5000);
+}
+
 int main()
 {
         test();
+	testStorage<ListStorage>();
+	testStorage<HashStorage>();
+	testStorage<BTreeStorage>();
+	testMoves<ListStorage>();
+	testMoves<HashStorage>();
+	testMoves<BTreeStorage>();
+	testFrozen<ListStorage>();
+	testFrozen<HashStorage>();
+	testFrozen<BTreeStorage>();
+	testIterators<ListStorage>();
+	testIterators<HashStorage>();
+	testIterators<BTreeStorage>();
+	testStorage<PersistentStorage>();
+	testFrozen<PersistentStorage>();
+	testPersistent();
+	testStorage<CowHashStorage>();
+	testStorage<CowBTreeStorage>();
+	testFrozen<CowHashStorage>();
+	testCopyOnWrite();
+	testBTreeOrder();
+	testMapped();
 	cout << "Passed all tests" << endl;
 }
\ No newline at end of file
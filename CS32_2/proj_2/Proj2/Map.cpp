@@ -1,140 +1,80 @@
 #include "Map.h"
+#include <functional> //for std::hash
 
 using namespace std;
 
 
 //Map implementations
+const int Map::EMPTY;
+
 Map::Map()
+	: m_slots(16, EMPTY)
 {
-	m_head = NULL;
-	m_tail = NULL;
-	m_count = 0;
 }
 
 Map::~Map()
-{	//need to clear the dynamically allocated memory holding Nodes
-	while (m_head != NULL) //until we reach the end
-	{
-		Node* next = m_head->next;
-		delete m_head;
-		m_head = next;
-	}
+{	//the vectors free their own memory
 }
 
 Map::Map(const Map& src) //copy constructor
-{	
-	Node* curr_src = src.m_head; //points to the first value of src
-	Node* prev = NULL; //used later
-
-	m_count = 0;
-
-	while (curr_src != NULL) 
-	{
-		Node* a = new Node;
-		a->k = curr_src->k;
-		a->v = curr_src->v; //copy the key/value
-		a->next = NULL;
-
-		a->prev = prev; //tracks the previous node in the list
-		if (prev != NULL)
-			a->prev->next = a; //goes to previous node and inserts this as the "next"
-		
-		m_count++;
-
-		if (m_count == 1) //this must be the first item if count ==1
-			m_head = a;
-		if (m_count == src.m_count) //this must be the last item
-			m_tail = a;
-
-		prev = a; //sets prev to this node so we can track it when we make the next one
-		curr_src = curr_src->next;
-	}
+	: m_entries(src.m_entries), m_slots(src.m_slots)
+{	//indices in the slots still match since the entries keep their order
 }
 	
 Map& Map::operator=(const Map& src) //overloaded = operator
 {
-	if (src.m_head == m_head)
+	if (&src == this)
 		return (*this); //aliasing check
 
-	Node* curr_src = src.m_head;
-	
-	//erase all of this list
-	while (m_head != NULL)
-	{
-		Node* next = m_head->next;
-		delete m_head;
-		m_head = next;
-	}
-
-	m_tail = NULL;
-	m_count = 0;
-
-	while (curr_src != NULL)
-	{
-		insert(curr_src->k, curr_src->v); //inserts a new Node with src's current values
-		curr_src = curr_src->next;
-	}
+	m_entries = src.m_entries;
+	m_slots = src.m_slots;
 	return (*this);
 }
 
 
 bool Map::empty() const
 {
-	return (m_count == 0);
+	return (m_entries.empty());
 }
 
 int Map::size() const
 {
-	return (m_count);
+	return (int(m_entries.size()));
 }
 bool Map::insert(const KeyType& key, const ValueType& value)
 {
-	if (contains(key)) //if the key is present already
+	size_t h = hashOf(key);
+	size_t s = findSlot(key, h);
+	if (m_slots[s] != EMPTY) //if the key is present already
 		return false; //can't have 2 of the same key in the map
 
-	Node* A = new Node;
-	A->k = key;
-	A->v = value;
-	A->next = NULL;
-
-
-	if (empty()) //very easy to implement if the list is empty, so I check for it
+	if (2 * (m_entries.size() + 1) > m_slots.size()) //table would be over half full
 	{
-		A->prev = NULL;
-		m_head = A;
-		m_tail = A;
-		m_count++;
-		return true;
+		growSlots();
+		s = findSlot(key, h); //the slot moved
 	}
-	//else, the list has some elements in it
-	A->prev = m_tail;
-	if (m_tail != NULL)
-		m_tail->next = A;
 
-	m_tail = A; //we are adding it at the end
-	
-	m_count++;
+	Entry e;
+	e.k = key;
+	e.v = value;
+	e.hash = h;
+	m_slots[s] = int(m_entries.size()); //new entry goes at the end
+	m_entries.push_back(e);
 	return true;
 }
 bool Map::update(const KeyType& key, const ValueType& value)
 {
-	Node* curr = m_head;
-	while (curr != NULL)
-	{
-		if (curr->k == key) //if the key is found
-		{
-			curr->v = value;
-			return true;
-		}
-		curr = curr->next;
-	}
-	return false; //didnt find the key
+	int index = m_slots[findSlot(key, hashOf(key))];
+	if (index == EMPTY)
+		return false; //didnt find the key
+	m_entries[index].v = value;
+	return true;
 }
 
 bool Map::insertOrUpdate(const KeyType& key, const ValueType& value)
 {
-	if (!(insert(key, value))) //if the update function fails
-		update(key, value); //run the insert function
+	if (!(update(key, value))) //if the update function fails
+		insert(key, value); //run the insert function
 	return true;
 	//this function never returns false because there is no
 	//size limit for the map
@@ -142,57 +82,50 @@ bool Map::insertOrUpdate(const KeyType& key, const ValueType& value)
 
 bool Map::erase(const KeyType& key)
 {
-	if (!contains(key)) //if the item isn't in the list
+	size_t s = findSlot(key, hashOf(key));
+	int index = m_slots[s];
+	if (index == EMPTY) //if the item isn't in the map
 		return false;
 
-	Node* curr = m_head;
-	while (curr->k != key) //tracks until it reaches the Node to be deleted
-		curr = curr->next;
-
-	Node* p = curr->prev;
-	Node* n = curr->next; //keeps track of what curr was pointing to
-
-	delete curr;
-
-	if (p == NULL) //this means it was the first item in the list
-		m_head = n; //adjust m_head to compensate for this
-	else //if it was not the first item, adjust the pointers
-		p->next = n;
+	size_t mask = m_slots.size() - 1;
 
-	if (n == NULL) //if it was the last item in the list
-		m_tail = p; //adjust the tail to compensate
-	else //it was not the last item, so adjust the pointers
-		n->prev = p;
+	//empty the slot, then pull back any later entry in the same run
+	//that would otherwise be cut off from its home slot by the hole
+	size_t hole = s;
+	for (size_t t = (s + 1) & mask; m_slots[t] != EMPTY; t = (t + 1) & mask)
+	{
+		size_t home = m_entries[m_slots[t]].hash & mask;
+		if (((t - home) & mask) >= ((t - hole) & mask))
+		{
+			m_slots[hole] = m_slots[t];
+			hole = t;
+		}
+	}
+	m_slots[hole] = EMPTY;
 
-	m_count--;
+	//move the last entry into the gap so m_entries stays dense
+	int last = int(m_entries.size()) - 1;
+	if (index != last)
+	{
+		m_slots[findSlotOf(last)] = index;
+		m_entries[index] = m_entries[last];
+	}
+	m_entries.pop_back();
 	return true;
 }
 
 bool Map::contains(const KeyType& key) const
 {
-	Node* curr = m_head;
-	while (curr != NULL)
-	{
-		if (curr->k == key) //found the key in the list
-			return true;
-		curr = curr->next;
-	}
-	return false;
+	return (m_slots[findSlot(key, hashOf(key))] != EMPTY);
 }
 
 bool Map::get(const KeyType& key, ValueType& value) const
 {
-	Node* curr = m_head;
-	while (curr != NULL)
-	{
-		if (key == curr->k) //if there is a key match
-		{
-			value = curr->v;
-			return true;
-		}
-		curr = curr->next;
-	}
-	return false;
+	int index = m_slots[findSlot(key, hashOf(key))];
+	if (index == EMPTY)
+		return false;
+	value = m_entries[index].v;
+	return true;
 }
 
 bool Map::get(int i, KeyType& key, ValueType& value) const
@@ -200,31 +133,54 @@ bool Map::get(int i, KeyType& key, ValueType& value) const
 	if (i < 0 || i >= size())
 		return false; //i is invalid
 
-	Node* curr = m_head;
-	for (int x = 0; x < i; x++) //loops i times
-		curr = curr->next;
-
-	key = curr->k;
-	value = curr->v;
+	key = m_entries[i].k;
+	value = m_entries[i].v;
 	return true;
 }
 
 void Map::swap(Map& other)
 {
-	//swap the counts
-	int temp = other.m_count;
-	other.m_count = m_count;
-	m_count = temp;
-
-	//swap the head ptrs
-	Node* h = other.m_head;
-	other.m_head = m_head;
-	m_head = h;
-
-	//swap the tail ptrs
-	Node* t = other.m_tail;
-	other.m_tail = m_tail;
-	m_tail = t;
+	//swapping vectors just swaps their pointers
+	m_entries.swap(other.m_entries);
+	m_slots.swap(other.m_slots);
+}
+
+size_t Map::hashOf(const KeyType& key)
+{
+	return std::hash<KeyType>()(key);
+}
+
+size_t Map::findSlot(const KeyType& key, size_t hash) const
+{
+	size_t mask = m_slots.size() - 1;
+	size_t s = hash & mask;
+	while (m_slots[s] != EMPTY && m_entries[m_slots[s]].k != key)
+		s = (s + 1) & mask; //keep probing until we find it or hit an empty slot
+	return s;
+}
+
+size_t Map::findSlotOf(int index) const
+{
+	size_t mask = m_slots.size() - 1;
+	size_t s = m_entries[index].hash & mask;
+	while (m_slots[s] != index)
+		s = (s + 1) & mask;
+	return s;
+}
+
+void Map::growSlots()
+{
+	std::vector<int> bigger(2 * m_slots.size(), EMPTY);
+	m_slots.swap(bigger);
+
+	size_t mask = m_slots.size() - 1;
+	for (size_t i = 0; i < m_entries.size(); i++) //put every entry back in the new table
+	{
+		size_t s = m_entries[i].hash & mask;
+		while (m_slots[s] != EMPTY)
+			s = (s + 1) & mask;
+		m_slots[s] = int(i);
+	}
 }
 
 //Public implementations using Map functions
@@ -2,6 +2,7 @@
 #define MAP_H
 
 #include <string>
+#include <vector>
 
 typedef std::string		KeyType;
 typedef double			ValueType;
@@ -26,17 +27,27 @@ class Map
     void swap(Map& other);
 
 private:
-	struct Node //holds the data for one entry in the Map linked list
+	//the pairs live in m_entries with no gaps, so get(i) is just m_entries[i].
+	//erasing moves the last entry into the gap.
+	//m_slots is a linear probing hash table over m_entries: each slot is
+	//EMPTY or the index of an entry, its size is a power of 2 and it is
+	//always at least twice as big as m_entries.
+	struct Entry //holds the data for one entry in the Map
 	{
 		KeyType		k;
 		ValueType	v;
-		Node*		prev;
-		Node*		next;
+		size_t		hash; //saved so growing the table doesn't rehash the key
 	};
-	
-	Node*	m_head; //points at the first value in the list
-	Node*	m_tail; //points to the last value in the list
-	int		m_count; //stores the amount of elements in the list
+
+	static const int EMPTY = -1;
+
+	std::vector<Entry>	m_entries;
+	std::vector<int>	m_slots;
+
+	static size_t hashOf(const KeyType& key);
+	size_t findSlot(const KeyType& key, size_t hash) const; //slot holding key, or the EMPTY slot where it would go
+	size_t findSlotOf(int index) const; //slot holding this entry index
+	void growSlots(); //doubles the table
 };
 
 #endif
\ No newline at end of file
@@ -29,20 +29,13 @@ DocumentImpl::DocumentImpl(string url, const string& text) : m_map()
 	Tokenizer t(text, " ,!.\"\t\n\\/{}()[]+-<>:;=_@#$%&*?~!^'"); //lots of different seperators
 	while (t.getNextToken(s))
 	{
-			//convert to all lower case to make things simple
-		transform(s.begin(), s.end(), s.begin(), tolower);
-		int total;
+		//the map ignores case, so the word goes in as it is
 		int* m = m_map.find(s);
-		if (m == NULL)
-			total = 0;
+		if (m != NULL)
+			(*m)++; //seen before: increment its occurance counter in place
 		else
-			total = *m;
-		//gets the value in the map so it isn't overwritten accidentally
-
-		m_map.associate(s, total+1);
-		//pushes all words onto the hash map, and increments 
-		//their occurance counter if they already exist in the map
-
+			m_map.associate(s, 1);
+		//pushes all words onto the hash map (lowercased)
 	}
 }
 
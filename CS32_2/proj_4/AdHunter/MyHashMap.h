@@ -3,8 +3,14 @@
 
 const int DEFAULT_NUM_BUCKETS = 1000000;
 
+#include <cstddef>
+#include <cstring>
 #include <string>
+#include <string_view>
 #include <algorithm>
+#include <iterator>
+#include <utility>
+#include <type_traits>
 
 template <typename ValueType>
 class MyHashMap
@@ -18,6 +24,7 @@ public:
 			m_table[i] = NULL;
 
 		m_linkedListHead = NULL; //no items yet
+		m_linkedListTail = NULL;
 		m_linkedListIter = NULL;
 
 		m_tableSizeUsed = 0;
@@ -34,89 +41,58 @@ public:
 			delete curr;
 			delete currListItem;
 		}
-		delete m_table;
+		delete [] m_table;
     }
 
-    void associate(std::string key, const ValueType& value)
+	//keys are case insensitive: the map keeps them lowercased, and folds the
+	//case of the key it is given as it hashes and compares it, so neither
+	//function copies or lowercases the key first. only ASCII letters fold,
+	//the same as tolower in the "C" locale
+    void associate(std::string_view key, const ValueType& value)
     {
-		unsigned keyValue = 0;
-		std::string lowKey = key;
-		transform(lowKey.begin(), lowKey.end(), lowKey.begin(), tolower);
+		unsigned keyValue = bucketOf(key); //generate the key to place the record
 
-		for (unsigned i = 0; i < lowKey.size(); i++)
+		Record* curr = findInBucket(keyValue, key);
+		if (curr != NULL) //key already exists and just needs update
 		{
-			keyValue += (i+3) * lowKey[i]; //use the ASCII value to gen key
+			curr->val = value;
+			return;
 		}
 
-		keyValue %= m_numBuckets; //generate the key to place the record
-		
-		Record* curr = m_table[keyValue];
-		Record* prev = NULL;
-		
-		while (curr != NULL) //checking for collisions
-		{
-			if (curr->key == lowKey) //key already exists and just needs update
-			{
-				curr->val = value;
-				return;
-			}
-			prev = curr;
-			curr = curr->next;
-		}
-
-		//if it doesn't return in the while loop, new key in the hash
+		//new key in the hash
 		m_tableSizeUsed++;
 
 		curr = new Record;
-		curr->key = lowKey;
+		curr->key.resize(key.size());
+		for (size_t i = 0; i < key.size(); i++)
+			curr->key[i] = foldChar(key[i]); //the only copy, made lowercase
 		curr->val = value; //package the information into a record object
-		curr->next = prev;
+		curr->next = m_table[keyValue];
 		m_table[keyValue] = curr;
-		//if this is the first item with the keyvalue, places it in the hash
-		//if this is the 2nd+, moves it to the "first" and slides the others back
+		//the new record goes at the front of its bucket's chain
 
 
 		//have to also insert into the linked list to keep track
 		RecordListItem* currListItem = new RecordListItem;
-		currListItem->item = m_table[keyValue];
+		currListItem->item = curr;
 		currListItem->next = NULL;
 		if (m_linkedListHead == NULL) //if it is the first item in the map
 			m_linkedListHead = currListItem;
 		else //put it at the end of the linked list
-		{
-			RecordListItem* prevListItem = m_linkedListHead;
-			while (prevListItem->next != NULL)
-				prevListItem = prevListItem->next;
-			prevListItem->next = currListItem;
-		}
+			m_linkedListTail->next = currListItem;
+		m_linkedListTail = currListItem;
 	}
 
 
-    const ValueType* find(std::string key) const
+    const ValueType* find(std::string_view key) const
     {
-		unsigned keyValue = 0;
-		std::string lowKey = key;
-		transform(lowKey.begin(), lowKey.end(), lowKey.begin(), tolower);
-		
-		for (unsigned i = 0; i < lowKey.size(); i++)
-		{
-			keyValue += (i+3) * lowKey[i]; //use the ASCII value to gen key
-		}
-
-		keyValue %= m_numBuckets; //generate the key to find the record
-
-		Record* checkThis = m_table[keyValue];
-		while (checkThis != NULL)
-		{
-			if (checkThis->key == lowKey) //found the key
-				return &(checkThis->val); //return ptr to the value
-			else
-				checkThis = checkThis->next;
-		}
-		return NULL; 
+		Record* checkThis = findInBucket(bucketOf(key), key);
+		if (checkThis == NULL)
+			return NULL;
+		return &(checkThis->val); //return ptr to the value
     }
 
-    ValueType* find(std::string key)
+    ValueType* find(std::string_view key)
     {
 		// Do not change the implementation of this overload of find
         const MyHashMap<ValueType>* constThis = this;
@@ -168,7 +144,125 @@ private:
 	int m_numBuckets;
 	Record** m_table; //the start of the table
 	RecordListItem* m_linkedListHead; //the head of the parallel linked list	
+	RecordListItem* m_linkedListTail; //the last item, so adding one doesn't walk the list
 	RecordListItem* m_linkedListIter; //used for getFirst, getNext
+
+	//case folding works on 8 characters at a time in a 64 bit word: the
+	//bytes from 'A' to 'Z' get their 0x20 bit set and every other byte is
+	//left alone, with no branch per character
+	typedef unsigned long long Word;
+	static const Word ONES = 0x0101010101010101ULL; //1 in every byte
+
+	static char foldChar(char c)
+	{
+		return (c >= 'A' && c <= 'Z') ? char(c + ('a' - 'A')) : c;
+	}
+
+	static Word foldWord(Word w)
+	{
+		Word low7 = w & (0x7f * ONES); //each byte without its high bit, so the adds can't carry
+		Word atLeastA = low7 + (0x80 - 'A') * ONES; //high bit set where the byte is >= 'A'
+		Word pastZ = low7 + (0x80 - 'Z' - 1) * ONES; //high bit set where the byte is > 'Z'
+		Word upper = (atLeastA ^ pastZ) & ~w & (0x80 * ONES); //'A' to 'Z', and not a byte >= 0x80
+		return w | (upper >> 2); //0x80 >> 2 is 0x20
+	}
+
+	static Word loadWord(const char* p, size_t n) //the first n (at most 8) bytes at p, zero filled
+	{
+		Word w = 0;
+		memcpy(&w, p, n);
+		return w;
+	}
+
+	unsigned bucketOf(std::string_view key) const
+	{
+		//multiply and shift each folded word into the hash, so keys that only
+		//differ in case land in the same bucket
+		Word h = key.size();
+		size_t i = 0;
+		for (; i + 8 <= key.size(); i += 8)
+			h = (h ^ foldWord(loadWord(key.data() + i, 8))) * 0x9E3779B97F4A7C15ULL;
+		if (i < key.size())
+			h = (h ^ foldWord(loadWord(key.data() + i, key.size() - i))) * 0x9E3779B97F4A7C15ULL;
+		h ^= h >> 32;
+		return unsigned(h % unsigned(m_numBuckets));
+	}
+
+	static bool sameKey(const std::string& stored, std::string_view key) //stored is already lowercase
+	{
+		if (stored.size() != key.size())
+			return false;
+		size_t i = 0;
+		for (; i + 8 <= key.size(); i += 8)
+		{
+			if (foldWord(loadWord(key.data() + i, 8)) != loadWord(stored.data() + i, 8))
+				return false;
+		}
+		return i == key.size() ||
+			foldWord(loadWord(key.data() + i, key.size() - i)) == loadWord(stored.data() + i, key.size() - i);
+	}
+
+	Record* findInBucket(unsigned keyValue, std::string_view key) const
+	{
+		for (Record* checkThis = m_table[keyValue]; checkThis != NULL; checkThis = checkThis->next)
+		{
+			if (sameKey(checkThis->key, key)) //found the key
+				return checkThis;
+		}
+		return NULL;
+	}
+
+public:
+	//iterators walk the parallel linked list, so they visit the items in the
+	//order they were first associated, the same as getFirst/getNext but
+	//without touching their position. *it refers to the item in the map:
+	//it->first is the (lowercased) key and it->second the value, which can
+	//be changed through an iterator but not a const_iterator. associating a
+	//new key adds to the end of the list, so it leaves iterators valid
+	template <bool IsConst>
+	class Iterator
+	{
+	public:
+		typedef typename std::conditional<IsConst, const ValueType, ValueType>::type Value;
+		struct reference
+		{
+			const std::string& first;
+			Value& second;
+
+			reference(const std::string& key, Value& val) : first(key), second(val) {}
+			const reference* operator->() const { return this; } //lets it->first reach through the iterator
+			operator std::pair<std::string, ValueType>() const { return std::pair<std::string, ValueType>(first, second); } //copies the item out
+		};
+
+		typedef std::forward_iterator_tag iterator_category;
+		typedef std::pair<std::string, ValueType> value_type;
+		typedef std::ptrdiff_t difference_type;
+		typedef reference pointer;
+
+		Iterator() : m_item(NULL) {}
+		Iterator(const Iterator<false>& other) : m_item(other.m_item) {} //also turns an iterator into a const_iterator
+
+		reference operator*() const { return reference(m_item->item->key, m_item->item->val); }
+		pointer operator->() const { return **this; }
+		Iterator& operator++() { m_item = m_item->next; return *this; }
+		Iterator operator++(int) { Iterator old(*this); m_item = m_item->next; return old; }
+		bool operator==(const Iterator& other) const { return m_item == other.m_item; }
+		bool operator!=(const Iterator& other) const { return m_item != other.m_item; }
+
+	private:
+		const RecordListItem* m_item; //NULL once past the last item
+
+		explicit Iterator(const RecordListItem* item) : m_item(item) {}
+		friend class MyHashMap;
+		friend class Iterator<true>;
+	};
+	typedef Iterator<false> iterator;
+	typedef Iterator<true> const_iterator;
+
+	iterator begin() { return iterator(m_linkedListHead); }
+	iterator end() { return iterator(NULL); }
+	const_iterator begin() const { return const_iterator(m_linkedListHead); }
+	const_iterator end() const { return const_iterator(NULL); }
 };
 
 #endif // MYHASHMAP_INCLUDED
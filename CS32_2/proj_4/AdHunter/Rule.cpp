@@ -104,11 +104,7 @@ bool RuleImpl::match(const Document& doc) const
 			string secondOperand = operationStack.top();
 			operationStack.pop();
 
-			//convert to all lower case before operation
-			transform(firstOperand.begin(), firstOperand.end(), 
-						firstOperand.begin(), tolower);
-			transform(secondOperand.begin(), secondOperand.end(), 
-				secondOperand.begin(), tolower);
+			//no need to lowercase the operands: Document::contains ignores case
 
 			if (firstOperand == "" || secondOperand == "") //invalid expression
 				return false; //check this later, should set the rule to invalid
@@ -0,0 +1,236 @@
+// Timing tests for MyHashMap on the AdHunter workload.  Build it on its own
+// (it has its own main), e.g.
+//     g++ -O2 adhunterbench.cpp
+// and run it as
+//     adhunterbench [pages] [wordsPerPage]
+// It makes pages (default 200) of words (default 5000 per page) in mixed
+// case, drawn from a vocabulary of short and long words, and counts the
+// words of each page the way a Document does.  Then it looks up rule words,
+// also in mixed case and half of them on no page, the way a Rule's match
+// does.  Each is timed three ways:
+//   fold       the key goes to MyHashMap as it is, and the map folds its case
+//   lowercase  the key is copied and lowercased with transform first, as
+//              Document and Rule used to do before every call
+//   std        the lowercased copy goes to a std::unordered_map
+// Building and destroying the maps isn't timed.
+
+#include "provided.h"
+#include "MyHashMap.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>  // for std::rand, std::srand, std::atoi
+#include <cassert>
+
+using namespace std;
+
+const int VOCABULARY_SIZE = 20000;
+const int RULE_WORDS = 100000;
+const int BUCKETS_PER_PAGE = 20011;  // a prime a bit over the distinct words on a page
+const char* SEPARATORS = " ,!.\"\t\n\\/{}()[]+-<>:;=_@#$%&*?~!^'";  // Document's
+
+//========================================================================
+// TimerType            - a type to hold a timer reading
+// TimerType getTimer() - get the current timer reading
+// double interval(TimerType start, TimerType end) - milliseconds between
+//                                                   two readings
+//========================================================================
+
+#ifdef _MSC_VER  // If we're compiling for Windows
+
+#include <windows.h>
+
+typedef LARGE_INTEGER TimerType;
+inline TimerType getTimer()
+{
+    LARGE_INTEGER t;
+    QueryPerformanceCounter(&t);
+    return t;
+}
+
+inline double interval(TimerType start, TimerType end)
+{
+    LARGE_INTEGER ticksPerSecond;
+    QueryPerformanceFrequency(&ticksPerSecond);
+    return (1000.0 * (end.QuadPart - start.QuadPart)) / ticksPerSecond.QuadPart;
+}
+
+#else // If we're not compiling for Windows, use Standard C
+
+#include <ctime>
+
+typedef clock_t TimerType;
+inline TimerType getTimer() { return clock(); }
+inline double interval(TimerType start, TimerType end)
+{
+    return (1000.0 * (end - start)) / CLOCKS_PER_SEC;
+}
+
+#endif  // ifdef _MSC_VER
+
+//========================================================================
+
+  // Report the results of a timing test
+
+void report(string way, string phase, double ms)
+{
+    cout << way << "," << phase << "," << ms << endl;
+}
+
+  // A random word of 2 to 20 letters, a few of them capitals
+
+string makeWord()
+{
+    int length = 2 + rand() % 19;
+    string w;
+    for (int k = 0; k < length; k++)
+    {
+        char c = char('a' + rand() % 26);
+        if (rand() % 4 == 0)
+            c = char(toupper(c));
+        w += c;
+    }
+    return w;
+}
+
+  // The word with the case of each letter flipped at random, as a rule or
+  // another page might spell it
+
+string recase(const string& word)
+{
+    string w = word;
+    for (size_t k = 0; k < w.size(); k++)
+    {
+        if (rand() % 2 == 0)
+            w[k] = char(isupper(w[k]) ? tolower(w[k]) : toupper(w[k]));
+    }
+    return w;
+}
+
+string lowercased(string s)
+{
+    transform(s.begin(), s.end(), s.begin(), ::tolower);
+    return s;
+}
+
+int main(int argc, char* argv[])
+{
+    int nPages = (argc > 1 ? atoi(argv[1]) : 200);
+    int wordsPerPage = (argc > 2 ? atoi(argv[2]) : 5000);
+    if (nPages <= 0  ||  wordsPerPage <= 0)
+    {
+        cout << "usage: " << argv[0] << " [pages] [wordsPerPage]" << endl;
+        return 1;
+    }
+
+    srand(12345);  // same pages every run
+    vector<string> vocabulary;
+    for (int k = 0; k < VOCABULARY_SIZE; k++)
+        vocabulary.push_back(makeWord());
+    vector<string> pages(nPages);
+    for (int p = 0; p < nPages; p++)
+    {
+        for (int k = 0; k < wordsPerPage; k++)
+        {
+            pages[p] += recase(vocabulary[rand() % (VOCABULARY_SIZE / 2)]);
+            pages[p] += (k % 12 == 11 ? ". " : " ");
+        }
+    }
+    vector<string> ruleWords;
+    for (int k = 0; k < RULE_WORDS; k++)
+        ruleWords.push_back(recase(vocabulary[rand() % VOCABULARY_SIZE]));  // half never on a page
+
+    cout << "way,phase,ms" << endl;
+    long long checks[3] = { 0, 0, 0 };  // what each way found, which must agree
+
+    vector<MyHashMap<int>*> folded;
+    vector<MyHashMap<int>*> lowered;
+    vector<unordered_map<string, int> > stdMaps(nPages);
+    for (int p = 0; p < nPages; p++)
+    {
+        folded.push_back(new MyHashMap<int>(BUCKETS_PER_PAGE));
+        lowered.push_back(new MyHashMap<int>(BUCKETS_PER_PAGE));
+    }
+
+      // Count the words of every page
+
+    TimerType start = getTimer();
+    for (int p = 0; p < nPages; p++)
+    {
+        Tokenizer t(pages[p], SEPARATORS);
+        string s;
+        while (t.getNextToken(s))
+        {
+            int* m = folded[p]->find(s);
+            if (m != NULL)
+                (*m)++;
+            else
+                folded[p]->associate(s, 1);
+        }
+    }
+    TimerType end = getTimer();
+    report("fold", "count words", interval(start, end));
+
+    start = getTimer();
+    for (int p = 0; p < nPages; p++)
+    {
+        Tokenizer t(pages[p], SEPARATORS);
+        string s;
+        while (t.getNextToken(s))
+        {
+            string low = lowercased(s);
+            int* m = lowered[p]->find(low);
+            lowered[p]->associate(low, m == NULL ? 1 : *m + 1);
+        }
+    }
+    end = getTimer();
+    report("lowercase", "count words", interval(start, end));
+
+    start = getTimer();
+    for (int p = 0; p < nPages; p++)
+    {
+        Tokenizer t(pages[p], SEPARATORS);
+        string s;
+        while (t.getNextToken(s))
+            stdMaps[p][lowercased(s)]++;
+    }
+    end = getTimer();
+    report("std", "count words", interval(start, end));
+
+      // Look up rule words, spread over the pages
+
+    start = getTimer();
+    for (int k = 0; k < RULE_WORDS; k++)
+        checks[0] += (folded[k % nPages]->find(ruleWords[k]) != NULL);
+    end = getTimer();
+    report("fold", "find rule words", interval(start, end));
+
+    start = getTimer();
+    for (int k = 0; k < RULE_WORDS; k++)
+        checks[1] += (lowered[k % nPages]->find(lowercased(ruleWords[k])) != NULL);
+    end = getTimer();
+    report("lowercase", "find rule words", interval(start, end));
+
+    start = getTimer();
+    for (int k = 0; k < RULE_WORDS; k++)
+        checks[2] += stdMaps[k % nPages].count(lowercased(ruleWords[k]));
+    end = getTimer();
+    report("std", "find rule words", interval(start, end));
+
+      // Every way must have counted the same words
+
+    for (int p = 0; p < nPages; p++)
+    {
+        assert(folded[p]->numItems() == int(stdMaps[p].size()));
+        for (MyHashMap<int>::const_iterator it = folded[p]->begin(); it != folded[p]->end(); ++it)
+            assert(stdMaps[p][it->first] == it->second  &&  *lowered[p]->find(it->first) == it->second);
+        delete folded[p];
+        delete lowered[p];
+    }
+    assert(checks[0] == checks[1]  &&  checks[1] == checks[2]);
+    if (checks[0] == 0  ||  checks[0] == RULE_WORDS)
+        cerr << "warning: every rule word was found, or none" << endl;
+}